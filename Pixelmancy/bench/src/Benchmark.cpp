@@ -0,0 +1,134 @@
+#include "Benchmark.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <numeric>
+#include <profiler/Json.hpp>
+
+#include <fmt/format.h>
+
+namespace pixelmancy::bench {
+
+namespace {
+
+std::string formatParameters(const Parameters& parameters)
+{
+    std::string text;
+    for (const auto& [key, value] : parameters)
+    {
+        text += fmt::format("{}{}={}", text.empty() ? "" : " ", key, value);
+    }
+    return text;
+}
+
+std::string formatDuration(double ns)
+{
+    if (ns >= 1e9)
+    {
+        return fmt::format("{:.3f} s", ns / 1e9);
+    }
+    if (ns >= 1e6)
+    {
+        return fmt::format("{:.3f} ms", ns / 1e6);
+    }
+    if (ns >= 1e3)
+    {
+        return fmt::format("{:.3f} us", ns / 1e3);
+    }
+    return fmt::format("{:.0f} ns", ns);
+}
+
+} // namespace
+
+std::vector<Benchmark>& registeredBenchmarks()
+{
+    static std::vector<Benchmark> benchmarks;
+    return benchmarks;
+}
+
+Runner::Runner(Options options) : m_options(std::move(options))
+{
+}
+
+void Runner::measure(const std::string& name, const Parameters& parameters, const std::function<void()>& body,
+                     std::uint64_t itemsPerSample, const std::function<void()>& setup)
+{
+    using Clock = std::chrono::steady_clock;
+    auto runSample = [&]() {
+        if (setup)
+        {
+            setup();
+        }
+        const auto start = Clock::now();
+        body();
+        return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    };
+
+    runSample();
+    std::vector<double> samples;
+    double elapsedNs = 0.0;
+    const double minTimeNs = m_options.minTimeMs * 1e6;
+    while (samples.size() < m_options.maxSamples && (samples.size() < m_options.minSamples || elapsedNs < minTimeNs))
+    {
+        samples.push_back(runSample());
+        elapsedNs += samples.back();
+    }
+
+    Result result;
+    result.name = name;
+    result.parameters = parameters;
+    result.samples = samples.size();
+    result.meanNs = elapsedNs / static_cast<double>(samples.size());
+    std::sort(samples.begin(), samples.end());
+    const std::size_t middle = samples.size() / 2;
+    result.medianNs = samples.size() % 2 == 1 ? samples[middle] : (samples[middle - 1] + samples[middle]) / 2.0;
+    result.minNs = samples.front();
+    result.maxNs = samples.back();
+    const double squares = std::accumulate(samples.begin(), samples.end(), 0.0, [&result](double sum, double sample) {
+        return sum + (sample - result.meanNs) * (sample - result.meanNs);
+    });
+    result.stddevNs = std::sqrt(squares / static_cast<double>(samples.size()));
+    if (itemsPerSample > 0 && result.medianNs > 0.0)
+    {
+        result.itemsPerSecond = static_cast<double>(itemsPerSample) * 1e9 / result.medianNs;
+    }
+    m_results.push_back(std::move(result));
+}
+
+void Runner::writeTable(std::ostream& stream) const
+{
+    stream << fmt::format("{:<36}{:<32}{:>8}{:>14}{:>14}{:>14}{:>16}\n", "Benchmark", "Parameters", "Samples", "Median", "Mean", "Stddev",
+                          "Items/s");
+    for (const Result& result : m_results)
+    {
+        const std::string items = result.itemsPerSecond > 0.0 ? fmt::format("{:.4g}", result.itemsPerSecond) : "-";
+        stream << fmt::format("{:<36}{:<32}{:>8}{:>14}{:>14}{:>14}{:>16}\n", result.name, formatParameters(result.parameters),
+                              result.samples, formatDuration(result.medianNs), formatDuration(result.meanNs),
+                              formatDuration(result.stddevNs), items);
+    }
+}
+
+void Runner::writeJson(std::ostream& stream) const
+{
+    stream << "{\n  \"benchmarks\": [";
+    const char* separator = "\n";
+    for (const Result& result : m_results)
+    {
+        std::string parameters;
+        for (const auto& [key, value] : result.parameters)
+        {
+            parameters += fmt::format("{}\"{}\": {}", parameters.empty() ? "" : ", ", profiler::escapeJson(key), value);
+        }
+        stream << separator
+               << fmt::format("    {{\"name\": \"{}\", \"parameters\": {{{}}}, \"samples\": {}, \"median_ns\": {:.1f}, "
+                              "\"mean_ns\": {:.1f}, \"min_ns\": {:.1f}, \"max_ns\": {:.1f}, \"stddev_ns\": {:.1f}, "
+                              "\"items_per_second\": {:.1f}}}",
+                              profiler::escapeJson(result.name), parameters, result.samples, result.medianNs, result.meanNs, result.minNs,
+                              result.maxNs, result.stddevNs, result.itemsPerSecond);
+        separator = ",\n";
+    }
+    stream << "\n  ]\n}\n";
+}
+
+} // namespace pixelmancy::bench
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace pixelmancy::bench {
+
+/**
+ * Parameters of a benchmark run, every benchmark picks the lists it uses
+ */
+struct Options
+{
+    std::vector<int> imageSizes = {64, 256, 1024};
+    std::vector<int> paletteSizes = {16, 256, 4096};
+    std::vector<int> frameCounts = {4, 16};
+    std::vector<int> threadCounts = {1, 4};
+    // benchmarks whose name does not contain the filter are skipped
+    std::string filter;
+    double minTimeMs = 200.0;
+    std::size_t minSamples = 5;
+    std::size_t maxSamples = 1000;
+    std::string inputFolder;
+    std::string outputFolder;
+};
+
+using Parameters = std::vector<std::pair<std::string, std::int64_t>>;
+
+/**
+ * Timing statistics of one benchmark with one set of parameters
+ */
+struct Result
+{
+    std::string name;
+    Parameters parameters;
+    std::size_t samples = 0;
+    double meanNs = 0.0;
+    double medianNs = 0.0;
+    double minNs = 0.0;
+    double maxNs = 0.0;
+    double stddevNs = 0.0;
+    // 0 when the benchmark does not count items
+    double itemsPerSecond = 0.0;
+};
+
+/**
+ * Runs the measured functions and collects their results
+ */
+class Runner
+{
+public:
+    explicit Runner(Options options);
+
+    const Options& options() const
+    {
+        return m_options;
+    }
+
+    /**
+     * Time a function. It runs once to warm up, then until both minSamples
+     * and minTimeMs are reached (or maxSamples), each call is one sample.
+     * @param name name of the benchmark
+     * @param parameters parameters shown with the result
+     * @param body function to time
+     * @param itemsPerSample items processed by one call of body, used for the throughput
+     * @param setup called before every sample, not timed
+     */
+    void measure(const std::string& name, const Parameters& parameters, const std::function<void()>& body,
+                 std::uint64_t itemsPerSample = 0, const std::function<void()>& setup = {});
+
+    const std::vector<Result>& results() const
+    {
+        return m_results;
+    }
+
+    /**
+     * Write the results as an aligned table
+     */
+    void writeTable(std::ostream& stream) const;
+
+    /**
+     * Write the results as JSON, the format is stable so runs can be compared
+     */
+    void writeJson(std::ostream& stream) const;
+
+private:
+    Options m_options;
+    std::vector<Result> m_results;
+};
+
+using BenchmarkFunction = void (*)(Runner&);
+
+struct Benchmark
+{
+    const char* name;
+    BenchmarkFunction function;
+};
+
+/**
+ * Get the benchmarks registered with PIXELMANCY_BENCHMARK
+ */
+std::vector<Benchmark>& registeredBenchmarks();
+
+struct Registrar
+{
+    Registrar(const char* name, BenchmarkFunction function)
+    {
+        registeredBenchmarks().push_back({name, function});
+    }
+};
+
+/**
+ * Keep the compiler from removing a computation whose result is unused
+ */
+template <typename T>
+void doNotOptimize(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const T* sink;
+    sink = &value;
+#endif
+}
+
+} // namespace pixelmancy::bench
+
+#define PIXELMANCY_BENCHMARK_CONCAT_IMPL(a, b) a##b
+#define PIXELMANCY_BENCHMARK_CONCAT(a, b) PIXELMANCY_BENCHMARK_CONCAT_IMPL(a, b)
+
+// define a benchmark function taking a Runner& named runner
+#define PIXELMANCY_BENCHMARK(name)                                                                                          \
+    static void PIXELMANCY_BENCHMARK_CONCAT(benchmark, __LINE__)(::pixelmancy::bench::Runner & runner);                     \
+    static const ::pixelmancy::bench::Registrar PIXELMANCY_BENCHMARK_CONCAT(registrar, __LINE__)(                           \
+        name, &PIXELMANCY_BENCHMARK_CONCAT(benchmark, __LINE__));                                                           \
+    static void PIXELMANCY_BENCHMARK_CONCAT(benchmark, __LINE__)(::pixelmancy::bench::Runner & runner)
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <Image.hpp>
+#include <colors/Color.hpp>
+
+namespace pixelmancy::bench {
+
+/**
+ * Get a color that is different for every index below 65536
+ */
+inline Color syntheticColor(int index)
+{
+    return Color(index & 0xFF, (index >> 8) & 0xFF, (index * 97) & 0xFF);
+}
+
+/**
+ * Create a square image that uses paletteSize colors in diagonal stripes
+ * @param size width and height of the image
+ * @param paletteSize number of distinct colors
+ */
+inline Image syntheticImage(int size, int paletteSize)
+{
+    Image image(size, size, syntheticColor(0));
+    std::vector<uint16_t> indices;
+    indices.reserve(static_cast<std::size_t>(paletteSize));
+    for (int i = 0; i < paletteSize; i++)
+    {
+        indices.push_back(image.resolveColor(syntheticColor(i)));
+    }
+    for (int row = 0; row < size; row++)
+    {
+        for (int column = 0; column < size; column++)
+        {
+            image.setPixel(row, column, indices[static_cast<std::size_t>((row + column) % paletteSize)]);
+        }
+    }
+    return image;
+}
+
+} // namespace pixelmancy::bench
@@ -0,0 +1,194 @@
+#include <Animation.hpp>
+#include <Apng.hpp>
+#include <CircleObject.hpp>
+#include <FramePool.hpp>
+#include <Gif.hpp>
+#include <GifDecoder.hpp>
+#include <Image.hpp>
+#include <ThreadPool.hpp>
+#include <cmath>
+#include <colors/ColorMatcher.hpp>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "Benchmark.hpp"
+#include "Synthetic.hpp"
+
+namespace {
+
+constexpr int GIF_PALETTE_SIZE = 64;
+constexpr int ANIMATION_SIZE = 256;
+constexpr int CIRCLES_PER_FRAME = 36;
+
+void drawCircles(int frameIndex, pixelmancy::Image& image)
+{
+    pixelmancy::graphics::CircleObject circle(image.getWidth() / 25, 2, pixelmancy::MAGENTA, pixelmancy::GREEN);
+    const int center = image.getWidth() / 2;
+    const int radius = image.getWidth() * 2 / 5;
+    for (int i = 0; i < CIRCLES_PER_FRAME; i++)
+    {
+        const double theta = (frameIndex * 5 + i * 10) * 3.14159265358979323846 / 180;
+        circle.setPosition({center + static_cast<int>(radius * std::cos(theta)), center + static_cast<int>(radius * std::sin(theta))});
+        circle.drawOn(image);
+    }
+}
+
+// a smooth gradient with a little noise, where lossless LZW finds only short codes
+pixelmancy::Image noisyGradient(int size, int frameIndex)
+{
+    pixelmancy::Image image(size, size);
+    unsigned state = 12345u + static_cast<unsigned>(frameIndex);
+    for (int row = 0; row < size; row++)
+    {
+        for (int column = 0; column < size; column++)
+        {
+            state = state * 1103515245u + 12345u;
+            // 240 colors, so the palette is not reduced
+            const int noise = static_cast<int>((state >> 16) % 3) * 8;
+            image(row, column) = pixelmancy::Color(column * 10 / size * 20 + noise, row * 8 / size * 20, 96, 255);
+        }
+    }
+    return image;
+}
+
+} // namespace
+
+PIXELMANCY_BENCHMARK("Gif::save")
+{
+    auto colorMatcher = std::make_shared<pixelmancy::ColorMatcher>();
+    const std::string path = runner.options().outputFolder + "/bench.gif";
+    for (int threadCount : runner.options().threadCounts)
+    {
+        pixelmancy::ThreadPool pool(static_cast<std::size_t>(threadCount));
+        for (int size : runner.options().imageSizes)
+        {
+            const pixelmancy::Image frame = pixelmancy::bench::syntheticImage(size, GIF_PALETTE_SIZE);
+            for (int frameCount : runner.options().frameCounts)
+            {
+                // saving changes the palette of the gif, so every sample saves a new one
+                std::optional<pixelmancy::Gif> gif;
+                runner.measure(
+                    "Gif::save", {{"size", size}, {"frames", frameCount}, {"threads", threadCount}},
+                    [&gif, &path]() { gif->save(path); }, static_cast<std::uint64_t>(frameCount) * frame.size(),
+                    [&]() {
+                        gif.emplace(colorMatcher);
+                        gif->setThreadPool(pool);
+                        for (int i = 0; i < frameCount; i++)
+                        {
+                            gif->addFrame(frame);
+                        }
+                    });
+            }
+        }
+    }
+}
+
+PIXELMANCY_BENCHMARK("Gif::save lossy")
+{
+    auto colorMatcher = std::make_shared<pixelmancy::ColorMatcher>();
+    const std::string path = runner.options().outputFolder + "/bench_lossy.gif";
+    pixelmancy::ThreadPool pool(1);
+    const int frameCount = runner.options().frameCounts.front();
+    for (int size : runner.options().imageSizes)
+    {
+        std::vector<pixelmancy::Image> frames;
+        for (int i = 0; i < frameCount; i++)
+        {
+            frames.push_back(noisyGradient(size, i));
+        }
+        std::optional<pixelmancy::Gif> gif;
+        auto addFrames = [&]() {
+            gif.emplace(colorMatcher);
+            gif->setThreadPool(pool);
+            for (const pixelmancy::Image& frame : frames)
+            {
+                gif->addFrame(frame);
+            }
+        };
+        for (int quality : {pixelmancy::LOSSLESS_QUALITY, 80, 50})
+        {
+            // the file size is shown with the timing
+            addFrames();
+            gif->save(path, quality);
+            const auto bytes = static_cast<std::int64_t>(gif->saveStats().compressedBytes);
+            runner.measure(
+                "Gif::save lossy", {{"size", size}, {"frames", frameCount}, {"quality", quality}, {"bytes", bytes}},
+                [&gif, &path, quality]() { gif->save(path, quality); },
+                static_cast<std::uint64_t>(frameCount) * static_cast<std::uint64_t>(size * size), addFrames);
+        }
+    }
+}
+
+PIXELMANCY_BENCHMARK("Apng::save")
+{
+    const std::string path = runner.options().outputFolder + "/bench_apng.png";
+    const int frameCount = runner.options().frameCounts.front();
+    for (int threadCount : runner.options().threadCounts)
+    {
+        pixelmancy::ThreadPool pool(static_cast<std::size_t>(threadCount));
+        for (int size : runner.options().imageSizes)
+        {
+            pixelmancy::Apng apng;
+            apng.setThreadPool(pool);
+            for (int i = 0; i < frameCount; i++)
+            {
+                apng.addFrame(noisyGradient(size, i));
+            }
+            apng.save(path);
+            const auto bytes = static_cast<std::int64_t>(apng.savedBytes());
+            runner.measure(
+                "Apng::save", {{"size", size}, {"frames", frameCount}, {"threads", threadCount}, {"bytes", bytes}},
+                [&apng, &path]() { apng.save(path); }, static_cast<std::uint64_t>(frameCount) * static_cast<std::uint64_t>(size * size));
+        }
+    }
+}
+
+PIXELMANCY_BENCHMARK("GifDecoder")
+{
+    auto colorMatcher = std::make_shared<pixelmancy::ColorMatcher>();
+    const std::string path = runner.options().outputFolder + "/bench_decode.gif";
+    const int frameCount = runner.options().frameCounts.front();
+    for (int size : runner.options().imageSizes)
+    {
+        pixelmancy::Gif gif(colorMatcher);
+        for (int i = 0; i < frameCount; i++)
+        {
+            gif.addFrame(noisyGradient(size, i));
+        }
+        gif.save(path);
+        runner.measure(
+            "GifDecoder", {{"size", size}, {"frames", frameCount}},
+            [&path]() {
+                pixelmancy::GifDecoder decoder(path);
+                for (const pixelmancy::Frame& frame : decoder)
+                {
+                    pixelmancy::bench::doNotOptimize(frame.image.rowIndices(0));
+                }
+            },
+            static_cast<std::uint64_t>(frameCount) * static_cast<std::uint64_t>(size * size));
+    }
+}
+
+PIXELMANCY_BENCHMARK("Animation::renderTo")
+{
+    auto colorMatcher = std::make_shared<pixelmancy::ColorMatcher>();
+    for (int threadCount : runner.options().threadCounts)
+    {
+        pixelmancy::ThreadPool pool(static_cast<std::size_t>(threadCount));
+        for (int frameCount : runner.options().frameCounts)
+        {
+            auto framePool = std::make_shared<pixelmancy::FramePool>(ANIMATION_SIZE, ANIMATION_SIZE);
+            runner.measure(
+                "Animation::renderTo", {{"size", ANIMATION_SIZE}, {"frames", frameCount}, {"threads", threadCount}},
+                [&]() {
+                    pixelmancy::Gif gif(colorMatcher);
+                    gif.setFramePool(framePool);
+                    pixelmancy::Animation animation(frameCount, framePool, drawCircles);
+                    animation.renderTo(gif, pool);
+                },
+                static_cast<std::uint64_t>(frameCount));
+        }
+    }
+}
@@ -0,0 +1,156 @@
+#include <AssetCache.hpp>
+#include <Dither.hpp>
+#include <Filters.hpp>
+#include <Image.hpp>
+#include <ImageHandle.hpp>
+#include <algorithm>
+#include <PNG.hpp>
+#include <ThreadPool.hpp>
+#include <functional>
+#include <string>
+
+#include "Benchmark.hpp"
+#include "Synthetic.hpp"
+
+namespace {
+constexpr int IMAGE_PALETTE_SIZE = 256;
+constexpr int REDUCTION_FACTOR = 4;
+constexpr float BLUR_SIGMA = 2.0f;
+constexpr int BLUR_RADIUS = 4;
+constexpr int DITHER_PALETTE_SIZE = 64;
+constexpr int THUMBNAIL_SIZE = 128;
+} // namespace
+
+PIXELMANCY_BENCHMARK("Image::loadFromFile")
+{
+    for (const char* name : {"tree", "dog", "naruto"})
+    {
+        const std::string path = runner.options().inputFolder + "/" + name + ".png";
+        const pixelmancy::Image probe = pixelmancy::Image::loadFromFile(path);
+        runner.measure(std::string("Image::loadFromFile/") + name, {{"width", probe.getWidth()}, {"height", probe.getHeight()}},
+                       [&path]() { pixelmancy::bench::doNotOptimize(pixelmancy::Image::loadFromFile(path)); }, probe.size());
+    }
+}
+
+PIXELMANCY_BENCHMARK("AssetCache::load")
+{
+    pixelmancy::AssetCache cache;
+    for (const char* name : {"tree", "dog", "naruto"})
+    {
+        const std::string path = runner.options().inputFolder + "/" + name + ".png";
+        const auto probe = cache.load(path);
+        // every sample after the first is a hit
+        runner.measure(std::string("AssetCache::load/") + name, {{"width", probe->getWidth()}, {"height", probe->getHeight()}},
+                       [&cache, &path]() { pixelmancy::bench::doNotOptimize(cache.load(path)); }, probe->size());
+    }
+}
+
+PIXELMANCY_BENCHMARK("Image::open")
+{
+    for (const char* name : {"tree", "dog", "naruto"})
+    {
+        const std::string path = runner.options().inputFolder + "/" + name + ".png";
+        const pixelmancy::ImageHandle probe = pixelmancy::Image::open(path);
+        const auto pixels = static_cast<std::uint64_t>(probe.getWidth()) * static_cast<std::uint64_t>(probe.getHeight());
+        runner.measure(std::string("Image::open/") + name, {{"width", probe.getWidth()}, {"height", probe.getHeight()}},
+                       [&path]() { pixelmancy::bench::doNotOptimize(pixelmancy::Image::open(path).getWidth()); }, pixels);
+        runner.measure(std::string("ImageHandle::decodeToSize/") + name, {{"width", probe.getWidth()}, {"height", probe.getHeight()}},
+                       [&probe]() { pixelmancy::bench::doNotOptimize(probe.decodeToSize(THUMBNAIL_SIZE, THUMBNAIL_SIZE)); }, pixels);
+    }
+}
+
+PIXELMANCY_BENCHMARK("Image::resize")
+{
+    for (int size : runner.options().imageSizes)
+    {
+        const pixelmancy::Image image = pixelmancy::bench::syntheticImage(size, IMAGE_PALETTE_SIZE);
+        runner.measure("Image::resize", {{"size", size}, {"percent", 50}},
+                       [&image]() { pixelmancy::bench::doNotOptimize(image.resize(0.5)); }, image.size() / 4);
+    }
+}
+
+PIXELMANCY_BENCHMARK("Image::reduceColorPalette")
+{
+    for (int size : runner.options().imageSizes)
+    {
+        for (int paletteSize : runner.options().paletteSizes)
+        {
+            const pixelmancy::Image original = pixelmancy::bench::syntheticImage(size, paletteSize);
+            pixelmancy::Image image = original;
+            const auto reducedSize = static_cast<std::size_t>(std::max(paletteSize / REDUCTION_FACTOR, 2));
+            runner.measure(
+                "Image::reduceColorPalette", {{"size", size}, {"palette", paletteSize}},
+                [&image, reducedSize]() { pixelmancy::bench::doNotOptimize(image.reduceColorPalette(reducedSize)); }, image.size(),
+                [&image, &original]() { image = original; });
+        }
+    }
+}
+
+PIXELMANCY_BENCHMARK("PNG::save")
+{
+    for (int size : runner.options().imageSizes)
+    {
+        const pixelmancy::Image image = pixelmancy::bench::syntheticImage(size, IMAGE_PALETTE_SIZE);
+        const std::string path = runner.options().outputFolder + "/bench.png";
+        runner.measure("PNG::save", {{"size", size}}, [&image, &path]() { pixelmancy::PNG(image).save(path); }, image.size());
+        runner.measure(
+            "PNG::save by usage", {{"size", size}},
+            [&image, &path]() { pixelmancy::PNG(image).save(path, pixelmancy::PaletteOrder::ByUsage); }, image.size());
+    }
+}
+
+PIXELMANCY_BENCHMARK("filters")
+{
+    using Filter = std::function<void(pixelmancy::Image&, pixelmancy::ThreadPool&)>;
+    const std::pair<const char*, Filter> filters[] = {
+        {"filters::gaussianBlur",
+         [](pixelmancy::Image& image, pixelmancy::ThreadPool& pool) { pixelmancy::filters::gaussianBlur(image, BLUR_SIGMA, pool); }},
+        {"filters::boxBlur",
+         [](pixelmancy::Image& image, pixelmancy::ThreadPool& pool) { pixelmancy::filters::boxBlur(image, BLUR_RADIUS, pool); }},
+        {"filters::sobel", [](pixelmancy::Image& image, pixelmancy::ThreadPool& pool) { pixelmancy::filters::sobel(image, pool); }}};
+    for (int threadCount : runner.options().threadCounts)
+    {
+        pixelmancy::ThreadPool pool(static_cast<std::size_t>(threadCount));
+        for (int size : runner.options().imageSizes)
+        {
+            const pixelmancy::Image original = pixelmancy::bench::syntheticImage(size, IMAGE_PALETTE_SIZE);
+            pixelmancy::Image image = original;
+            for (const auto& [name, filter] : filters)
+            {
+                runner.measure(
+                    name, {{"size", size}, {"threads", threadCount}}, [&image, &pool, &filter]() { filter(image, pool); },
+                    image.size(), [&image, &original]() { image = original; });
+            }
+        }
+    }
+}
+
+PIXELMANCY_BENCHMARK("dither::remap")
+{
+    const std::pair<const char*, pixelmancy::Dither> methods[] = {{"dither::remap none", pixelmancy::Dither::None},
+                                                                  {"dither::remap floyd-steinberg", pixelmancy::Dither::FloydSteinberg},
+                                                                  {"dither::remap atkinson", pixelmancy::Dither::Atkinson},
+                                                                  {"dither::remap bayer", pixelmancy::Dither::Bayer}};
+    std::vector<pixelmancy::Color> palette;
+    for (int i = 0; i < DITHER_PALETTE_SIZE; i++)
+    {
+        palette.push_back(pixelmancy::bench::syntheticColor(i));
+    }
+    for (int threadCount : runner.options().threadCounts)
+    {
+        pixelmancy::ThreadPool pool(static_cast<std::size_t>(threadCount));
+        for (int size : runner.options().imageSizes)
+        {
+            const pixelmancy::Image image = pixelmancy::bench::syntheticImage(size, IMAGE_PALETTE_SIZE);
+            for (const auto& [name, method] : methods)
+            {
+                runner.measure(
+                    name, {{"size", size}, {"threads", threadCount}},
+                    [&image, &palette, &pool, method = method]() {
+                        pixelmancy::bench::doNotOptimize(pixelmancy::dither::remap(image, palette.data(), palette.size(), method, pool));
+                    },
+                    image.size());
+            }
+        }
+    }
+}
@@ -0,0 +1,83 @@
+#include <algorithm>
+#include <kernels/Kernels.hpp>
+#include <vector>
+
+#include "Benchmark.hpp"
+
+namespace {
+
+constexpr int KERNEL_PALETTE_SIZE = 256;
+
+std::vector<const pixelmancy::kernels::KernelTable*> supportedKernels()
+{
+    std::vector<const pixelmancy::kernels::KernelTable*> tables;
+    for (auto isa : {pixelmancy::kernels::Isa::SCALAR, pixelmancy::kernels::Isa::SSE42, pixelmancy::kernels::Isa::AVX2})
+    {
+        if (const auto* table = pixelmancy::kernels::forIsa(isa))
+        {
+            tables.push_back(table);
+        }
+    }
+    return tables;
+}
+
+// the instruction set is reported as its position in Isa
+std::int64_t isaParameter(const pixelmancy::kernels::KernelTable& table)
+{
+    return static_cast<std::int64_t>(table.isa);
+}
+
+} // namespace
+
+PIXELMANCY_BENCHMARK("kernels")
+{
+    std::vector<uint32_t> palette(KERNEL_PALETTE_SIZE);
+    for (std::size_t i = 0; i < palette.size(); i++)
+    {
+        palette[i] = pixelmancy::kernels::packRgba(static_cast<uint8_t>(i), static_cast<uint8_t>(i * 7),
+                                                   static_cast<uint8_t>(i * 13), static_cast<uint8_t>(i * 29));
+    }
+    for (const auto* table : supportedKernels())
+    {
+        for (int size : runner.options().imageSizes)
+        {
+            const auto count = static_cast<std::size_t>(size) * static_cast<std::size_t>(size);
+            std::vector<uint16_t> indices(count);
+            std::vector<int32_t> positions(count);
+            for (std::size_t i = 0; i < count; i++)
+            {
+                indices[i] = static_cast<uint16_t>((i * 31) % KERNEL_PALETTE_SIZE);
+                positions[i] = static_cast<int32_t>((i * 7) % count);
+            }
+            std::vector<uint32_t> colors(count);
+            std::vector<uint32_t> otherColors(count);
+            std::vector<uint16_t> words(count);
+            std::vector<uint8_t> bytes(count);
+            const pixelmancy::bench::Parameters parameters = {{"pixels", static_cast<std::int64_t>(count)},
+                                                              {"isa", isaParameter(*table)}};
+
+            runner.measure(
+                "kernels::expandIndices", parameters,
+                [&]() { table->expandIndices(indices.data(), count, palette.data(), colors.data()); }, count);
+            runner.measure(
+                "kernels::remapIndices", parameters,
+                [&]() { table->remapIndices(indices.data(), count, palette.data(), palette.size(), bytes.data()); }, count);
+            runner.measure(
+                "kernels::fillIndices", parameters, [&]() { table->fillIndices(words.data(), count, 5); }, count);
+            runner.measure(
+                "kernels::gatherIndices", parameters,
+                [&]() { table->gatherIndices(indices.data(), count, positions.data(), count, words.data()); }, count);
+            runner.measure(
+                "kernels::premultiplyAlpha", parameters, [&]() { table->premultiplyAlpha(colors.data(), count); }, count,
+                [&]() { table->expandIndices(indices.data(), count, palette.data(), colors.data()); });
+            table->expandIndices(indices.data(), count, palette.data(), colors.data());
+            std::rotate_copy(colors.begin(), colors.begin() + 1, colors.end(), otherColors.begin());
+            runner.measure(
+                "kernels::colorDistance", parameters,
+                [&]() {
+                    pixelmancy::bench::doNotOptimize(table->colorDistance(colors.data(), otherColors.data(), count, bytes.data()));
+                },
+                count);
+        }
+    }
+}
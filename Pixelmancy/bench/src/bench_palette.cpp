@@ -0,0 +1,75 @@
+#include <ColorPalette.hpp>
+#include <colors/ColorMatcher.hpp>
+#include <vector>
+
+#include "Benchmark.hpp"
+#include "Synthetic.hpp"
+
+namespace {
+constexpr int NEAREST_COLOR_QUERIES = 4096;
+} // namespace
+
+PIXELMANCY_BENCHMARK("ColorPallette::addColor")
+{
+    for (int paletteSize : runner.options().paletteSizes)
+    {
+        std::vector<pixelmancy::Color> colors;
+        for (int i = 0; i < paletteSize; i++)
+        {
+            colors.push_back(pixelmancy::bench::syntheticColor(i));
+        }
+        // every color is added twice, so half of the calls find an existing color
+        runner.measure(
+            "ColorPallette::addColor", {{"palette", paletteSize}},
+            [&colors]() {
+                pixelmancy::ColorPallette palette;
+                for (int pass = 0; pass < 2; pass++)
+                {
+                    for (const pixelmancy::Color& color : colors)
+                    {
+                        pixelmancy::bench::doNotOptimize(palette.addColor(color));
+                    }
+                }
+            },
+            2 * colors.size());
+    }
+}
+
+PIXELMANCY_BENCHMARK("ColorPallette::merge")
+{
+    for (int paletteSize : runner.options().paletteSizes)
+    {
+        // the palettes share half of their colors
+        pixelmancy::ColorPallette first;
+        pixelmancy::ColorPallette second;
+        for (int i = 0; i < paletteSize; i++)
+        {
+            first.addColor(pixelmancy::bench::syntheticColor(i));
+            second.addColor(pixelmancy::bench::syntheticColor(i + paletteSize / 2));
+        }
+        pixelmancy::ColorPallette merged;
+        runner.measure(
+            "ColorPallette::merge", {{"palette", paletteSize}},
+            [&merged, &second]() { pixelmancy::bench::doNotOptimize(merged.merge(second)); }, second.size(),
+            [&merged, &first]() { merged = first; });
+    }
+}
+
+PIXELMANCY_BENCHMARK("ColorMatcher::getNearestColor")
+{
+    const pixelmancy::ColorMatcher matcher;
+    std::vector<pixelmancy::Color> queries;
+    for (int i = 0; i < NEAREST_COLOR_QUERIES; i++)
+    {
+        queries.push_back(pixelmancy::bench::syntheticColor(i * 16));
+    }
+    runner.measure(
+        "ColorMatcher::getNearestColor", {{"queries", NEAREST_COLOR_QUERIES}},
+        [&matcher, &queries]() {
+            for (const pixelmancy::Color& color : queries)
+            {
+                pixelmancy::bench::doNotOptimize(matcher.getNearestColor(color));
+            }
+        },
+        queries.size());
+}
@@ -0,0 +1,39 @@
+#include <CircleObject.hpp>
+#include <Image.hpp>
+#include <SquareObject.hpp>
+
+#include "Benchmark.hpp"
+
+namespace {
+constexpr int OUTLINE_WIDTH = 2;
+} // namespace
+
+PIXELMANCY_BENCHMARK("CircleObject::drawOn")
+{
+    for (int size : runner.options().imageSizes)
+    {
+        pixelmancy::Image image(size, size, pixelmancy::WHITE);
+        pixelmancy::graphics::CircleObject circle(size / 3, OUTLINE_WIDTH, pixelmancy::MAGENTA, pixelmancy::GREEN);
+        circle.setPosition({size / 2, size / 2});
+        const auto covered = static_cast<std::uint64_t>(circle.getBoundingBox().intersected(image.bounds()).area());
+        runner.measure("CircleObject::drawOn", {{"size", size}, {"radius", size / 3}}, [&circle, &image]() { circle.drawOn(image); },
+                       covered);
+    }
+}
+
+PIXELMANCY_BENCHMARK("SquareObject::drawOn")
+{
+    for (int size : runner.options().imageSizes)
+    {
+        pixelmancy::Image image(size, size, pixelmancy::WHITE);
+        pixelmancy::graphics::SquareObject square({size / 2, size / 2}, OUTLINE_WIDTH, pixelmancy::BLUE, pixelmancy::RED);
+        square.setPosition({size / 4, size / 4});
+        for (int angle : {0, 30})
+        {
+            square.setAngle(static_cast<float>(angle));
+            const auto covered = static_cast<std::uint64_t>(square.getBoundingBox().intersected(image.bounds()).area());
+            runner.measure("SquareObject::drawOn", {{"size", size}, {"angle", angle}}, [&square, &image]() { square.drawOn(image); },
+                           covered);
+        }
+    }
+}
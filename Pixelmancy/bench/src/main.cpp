@@ -0,0 +1,108 @@
+#include <cxxopts.hpp>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "Benchmark.hpp"
+#include "bench_config.hpp"
+
+int main(int argc, char* argv[])
+{
+    cxxopts::Options options("PixelmancyBench", "Micro-benchmarks of the Pixelmancy kernels");
+    // clang-format off
+    options.add_options()
+        ("h,help", "Print help")
+        ("l,list", "List the benchmarks")
+        ("f,filter", "Run only benchmarks whose name contains the text", cxxopts::value<std::string>()->default_value(""))
+        ("sizes", "Image widths and heights", cxxopts::value<std::vector<int>>()->default_value("64,256,1024"))
+        ("palette-sizes", "Palette sizes", cxxopts::value<std::vector<int>>()->default_value("16,256,4096"))
+        ("frames", "Frame counts", cxxopts::value<std::vector<int>>()->default_value("4,16"))
+        ("threads", "Thread counts", cxxopts::value<std::vector<int>>()->default_value("1,4"))
+        ("min-time", "Minimum time per benchmark in milliseconds", cxxopts::value<double>()->default_value("200"))
+        ("min-samples", "Minimum samples per benchmark", cxxopts::value<std::size_t>()->default_value("5"))
+        ("max-samples", "Maximum samples per benchmark", cxxopts::value<std::size_t>()->default_value("1000"))
+        ("json", "Write the results as JSON to a file, - writes to stdout", cxxopts::value<std::string>())
+        ("input", "Folder of the bundled PNG images", cxxopts::value<std::string>()->default_value(BENCH_INPUT_FOLDER))
+        ("output", "Folder for the files written by the benchmarks", cxxopts::value<std::string>()->default_value(BENCH_OUTPUT_FOLDER));
+    // clang-format on
+
+    cxxopts::ParseResult result;
+    try
+    {
+        result = options.parse(argc, argv);
+    }
+    catch (const cxxopts::exceptions::exception& e)
+    {
+        std::cerr << e.what() << "\n\n" << options.help() << std::endl;
+        return 1;
+    }
+    if (result.count("help") == 1)
+    {
+        std::cout << options.help() << std::endl;
+        return 0;
+    }
+
+    if (result.count("list") == 1)
+    {
+        for (const auto& benchmark : pixelmancy::bench::registeredBenchmarks())
+        {
+            std::cout << benchmark.name << "\n";
+        }
+        return 0;
+    }
+
+    pixelmancy::bench::Options benchOptions;
+    benchOptions.filter = result["filter"].as<std::string>();
+    benchOptions.imageSizes = result["sizes"].as<std::vector<int>>();
+    benchOptions.paletteSizes = result["palette-sizes"].as<std::vector<int>>();
+    benchOptions.frameCounts = result["frames"].as<std::vector<int>>();
+    benchOptions.threadCounts = result["threads"].as<std::vector<int>>();
+    benchOptions.minTimeMs = result["min-time"].as<double>();
+    benchOptions.minSamples = result["min-samples"].as<std::size_t>();
+    benchOptions.maxSamples = result["max-samples"].as<std::size_t>();
+    benchOptions.inputFolder = result["input"].as<std::string>();
+    benchOptions.outputFolder = result["output"].as<std::string>();
+
+    pixelmancy::bench::Runner runner(benchOptions);
+    for (const auto& benchmark : pixelmancy::bench::registeredBenchmarks())
+    {
+        if (std::string(benchmark.name).find(benchOptions.filter) == std::string::npos)
+        {
+            continue;
+        }
+        // progress goes to stderr, so the JSON on stdout stays valid
+        std::cerr << "Running " << benchmark.name << "\n";
+        try
+        {
+            benchmark.function(runner);
+        }
+        catch (const std::exception& e)
+        {
+            // a missing or unreadable --input image
+            std::cerr << benchmark.name << " failed: " << e.what() << std::endl;
+            return 1;
+        }
+    }
+
+    if (result.count("json") == 0)
+    {
+        runner.writeTable(std::cout);
+        return 0;
+    }
+    const auto jsonPath = result["json"].as<std::string>();
+    if (jsonPath == "-")
+    {
+        runner.writeJson(std::cout);
+        return 0;
+    }
+    std::ofstream file(jsonPath);
+    if (!file)
+    {
+        std::cerr << "Failed to open " << jsonPath << "\n";
+        return 1;
+    }
+    runner.writeJson(file);
+    runner.writeTable(std::cout);
+    return 0;
+}
@@ -0,0 +1,86 @@
+#include "Animation.hpp"
+
+#include <chrono>
+#include <deque>
+#include <future>
+
+#include "FramePool.hpp"
+#include "Gif.hpp"
+#include "ThreadPool.hpp"
+#include "profiler/Profiler.hpp"
+
+namespace pixelmancy {
+
+Animation::Animation(int frameCount, FrameGenerator generator, uint16_t delay)
+ : m_frameCount(frameCount), m_generator(std::move(generator)), m_delay(delay)
+{
+}
+
+Animation::Animation(int frameCount, std::shared_ptr<FramePool> framePool, FrameRenderer renderer, uint16_t delay)
+ : m_frameCount(frameCount), m_delay(delay)
+{
+    m_generator = [framePool = std::move(framePool), renderer = std::move(renderer)](int frameIndex) {
+        Image frame = framePool->acquire();
+        renderer(frameIndex, frame);
+        return frame;
+    };
+}
+
+void Animation::setMaxFramesInFlight(std::size_t maxFramesInFlight)
+{
+    m_maxFramesInFlight = maxFramesInFlight;
+}
+
+void Animation::renderTo(Gif& gif) const
+{
+    renderTo(gif, ThreadPool::global());
+}
+
+void Animation::renderTo(Gif& gif, ThreadPool& pool) const
+{
+    P_PROFILE_SCOPE("Animation::renderTo");
+    const std::size_t window = m_maxFramesInFlight > 0 ? m_maxFramesInFlight : 2 * pool.size();
+
+    // futures are kept in frame order, so waiting on the oldest one reorders
+    // frames that finish early
+    std::deque<std::future<Image>> inFlight;
+    int nextFrame = 0;
+    auto submitFrames = [&]() {
+        while (nextFrame < m_frameCount && inFlight.size() < window)
+        {
+            const int frameIndex = nextFrame++;
+            inFlight.push_back(pool.submit([this, frameIndex]() {
+                P_PROFILE_SCOPE("Animation::renderFrame");
+                return m_generator(frameIndex);
+            }));
+        }
+    };
+
+    submitFrames();
+    try
+    {
+        while (!inFlight.empty())
+        {
+            std::future<Image> oldest = std::move(inFlight.front());
+            inFlight.pop_front();
+            // the waiting thread renders queued frames instead of idling
+            while (oldest.wait_for(std::chrono::seconds(0)) != std::future_status::ready && pool.runPendingTask())
+            {
+            }
+            Image frame = oldest.get();
+            submitFrames();
+            gif.addFrame(std::move(frame), m_delay);
+        }
+    }
+    catch (...)
+    {
+        // the queued frames still use the generator
+        for (auto& frame : inFlight)
+        {
+            frame.wait();
+        }
+        throw;
+    }
+}
+
+} // namespace pixelmancy
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+
+#include "CommonConfig.hpp"
+#include "Image.hpp"
+
+namespace pixelmancy {
+class FramePool;
+class Gif;
+class ThreadPool;
+
+/**
+ * Animation class that renders independent frames in parallel. The frame
+ * generator is called from the worker threads, so it must not change state
+ * shared between frames. Finished frames are added to the gif in order while
+ * the next frames are still rendering.
+ */
+class Animation
+{
+public:
+    using FrameGenerator = std::function<Image(int frameIndex)>;
+    using FrameRenderer = std::function<void(int frameIndex, Image& frame)>;
+
+    /**
+     * @param frameCount number of frames
+     * @param generator callable that renders the frame with the given index
+     * @param delay delay of every frame in milliseconds
+     */
+    Animation(int frameCount, FrameGenerator generator, uint16_t delay = DEFAULT_FRAME_DELAY);
+
+    /**
+     * Render into blank frames taken from a pool, give the same pool to
+     * Gif::setFramePool() to recycle the frames after saving
+     * @param frameCount number of frames
+     * @param framePool pool that provides the blank frames
+     * @param renderer callable that draws the frame with the given index
+     * @param delay delay of every frame in milliseconds
+     */
+    Animation(int frameCount, std::shared_ptr<FramePool> framePool, FrameRenderer renderer, uint16_t delay = DEFAULT_FRAME_DELAY);
+
+    /**
+     * Limit the number of frames that are rendered or waiting to be added at
+     * the same time, this bounds the memory used for the frames
+     * @param maxFramesInFlight window size, 0 uses twice the number of threads of the pool
+     */
+    void setMaxFramesInFlight(std::size_t maxFramesInFlight);
+
+    /**
+     * Render every frame and add it to the gif
+     * @param gif gif to add the frames to
+     * @param pool pool to render the frames with
+     */
+    void renderTo(Gif& gif, ThreadPool& pool) const;
+
+    /**
+     * Render every frame with the global pool
+     * @param gif gif to add the frames to
+     */
+    void renderTo(Gif& gif) const;
+
+private:
+    int m_frameCount = 0;
+    FrameGenerator m_generator;
+    uint16_t m_delay = DEFAULT_FRAME_DELAY;
+    std::size_t m_maxFramesInFlight = 0;
+};
+
+} // namespace pixelmancy
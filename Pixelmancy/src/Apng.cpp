@@ -0,0 +1,332 @@
+#include "Apng.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <future>
+
+#include "ByteSink.hpp"
+#include "ImageCompare.hpp"
+#include "Log.hpp"
+#include "Parallel.hpp"
+#include "kernels/Kernels.hpp"
+#include "lodepng.h"
+#include "profiler/Profiler.hpp"
+
+namespace pixelmancy {
+
+namespace {
+
+constexpr unsigned char PNG_SIGNATURE[] = {137, 80, 78, 71, 13, 10, 26, 10};
+// frame delays are hundredths of a second
+constexpr uint16_t DELAY_DENOMINATOR = 100;
+// frames compressed ahead of the one being written, per thread
+constexpr std::size_t FRAMES_PER_THREAD = 2;
+// bytes of the length and the type before the data of a chunk
+constexpr std::size_t CHUNK_HEADER = 8;
+
+void appendUint32(std::vector<unsigned char>& data, uint32_t value)
+{
+    data.push_back(static_cast<unsigned char>(value >> 24));
+    data.push_back(static_cast<unsigned char>(value >> 16));
+    data.push_back(static_cast<unsigned char>(value >> 8));
+    data.push_back(static_cast<unsigned char>(value));
+}
+
+void appendUint16(std::vector<unsigned char>& data, uint16_t value)
+{
+    data.push_back(static_cast<unsigned char>(value >> 8));
+    data.push_back(static_cast<unsigned char>(value));
+}
+
+} // namespace
+
+Apng::Apng(std::pmr::memory_resource* resource)
+ : m_resource(resource),
+   m_frames(resource)
+{
+}
+
+Apng::~Apng() = default;
+
+void Apng::addFrame(const Image& frame, uint16_t delay)
+{
+    updateSize(frame);
+    m_frames.push_back({delay, Image(frame, m_resource)});
+}
+
+void Apng::addFrame(Image&& frame, uint16_t delay)
+{
+    updateSize(frame);
+    m_frames.push_back({delay, std::move(frame)});
+}
+
+void Apng::addFrame(const Image& frame, uint16_t delay, const graphics::Rect& changedRegion)
+{
+    addFrame(frame, delay);
+    m_frames.back().changedRegion = changedRegion;
+}
+
+void Apng::setThreadPool(ThreadPool& threadPool)
+{
+    m_threadPool = &threadPool;
+}
+
+std::uintmax_t Apng::savedBytes() const
+{
+    return m_savedBytes;
+}
+
+void Apng::updateSize(const Image& frame)
+{
+    m_width = std::max(m_width, frame.getWidth());
+    m_height = std::max(m_height, frame.getHeight());
+}
+
+ThreadPool& Apng::threadPool() const
+{
+    return m_threadPool != nullptr ? *m_threadPool : ThreadPool::global();
+}
+
+// Area of every frame that differs from the frame before it, the first frame
+// covers the canvas
+std::vector<graphics::Rect> Apng::changedRegions() const
+{
+    P_PROFILE_SCOPE("Apng::changedRegions");
+    std::vector<graphics::Rect> regions(m_frames.size());
+    parallelFor(
+        graphics::Rect(0, 0, static_cast<int>(m_frames.size()), 1), Grain{1, 0},
+        [this, &regions](const graphics::Rect& range) {
+            for (int i = range.minX; i < range.maxX; i++)
+            {
+                const Frame& frame = m_frames[static_cast<std::size_t>(i)];
+                if (i == 0)
+                {
+                    regions[0] = graphics::Rect(0, 0, m_height, m_width);
+                }
+                else if (frame.changedRegion)
+                {
+                    regions[static_cast<std::size_t>(i)] = frame.changedRegion->intersected(frame.image.bounds());
+                }
+                else
+                {
+                    const CompareResult difference = compare(m_frames[static_cast<std::size_t>(i - 1)].image, frame.image);
+                    regions[static_cast<std::size_t>(i)] = difference.sizeMismatch ? frame.image.bounds() : difference.diffBounds;
+                }
+            }
+        },
+        threadPool());
+    return regions;
+}
+
+// PNG of the region of a frame, its IDAT chunks hold the frame data. Pixels
+// of the region outside the frame are transparent black.
+Apng::EncodedFrame Apng::encodeFrame(const Frame& frame, const graphics::Rect& region, bool opaque) const
+{
+    P_PROFILE_SCOPE("Apng::encodeFrame");
+    const Image& image = frame.image;
+    const auto width = static_cast<std::size_t>(region.maxY - region.minY);
+    const auto height = static_cast<std::size_t>(region.maxX - region.minX);
+    // RGBA bytes of every pixel, packed as by kernels::packRgba
+    std::vector<uint32_t> rgba(width * height, 0);
+    std::vector<uint32_t> palette;
+    palette.reserve(image.getColorPalette().size());
+    for (const Color& color : image.getColorPalette().getColors())
+    {
+        palette.push_back(kernels::packRgba(color.red, color.green, color.blue, color.alpha));
+    }
+    const graphics::Rect inside = region.intersected(image.bounds());
+    const kernels::KernelTable& kernel = kernels::active();
+    for (int row = inside.minX; row < inside.maxX; row++)
+    {
+        kernel.expandIndices(image.rowIndices(row) + inside.minY, static_cast<std::size_t>(inside.maxY - inside.minY), palette.data(),
+                             rgba.data() + static_cast<std::size_t>(row - region.minX) * width +
+                                 static_cast<std::size_t>(inside.minY - region.minY));
+    }
+
+    EncodedFrame encoded;
+    encoded.region = region;
+    encoded.delay = frame.delay;
+    // every frame has the color type of the header, so nothing is chosen per frame
+    lodepng::State state;
+    state.encoder.auto_convert = 0;
+    state.info_png.color.colortype = opaque ? LCT_RGB : LCT_RGBA;
+    state.info_png.color.bitdepth = 8;
+    encoded.error = lodepng::encode(encoded.png, reinterpret_cast<const unsigned char*>(rgba.data()), static_cast<unsigned>(width),
+                                    static_cast<unsigned>(height), state);
+    P_PROFILE_COUNTER("apng.pixelsEncoded", rgba.size());
+    return encoded;
+}
+
+bool Apng::writeChunk(const char* type, const std::vector<unsigned char>& data)
+{
+    std::vector<unsigned char> chunk;
+    chunk.reserve(CHUNK_HEADER + data.size() + 4);
+    appendUint32(chunk, static_cast<uint32_t>(data.size()));
+    chunk.insert(chunk.end(), type, type + 4);
+    chunk.insert(chunk.end(), data.begin(), data.end());
+    // the CRC covers the type and the data
+    appendUint32(chunk, lodepng_crc32(chunk.data() + 4, chunk.size() - 4));
+    return m_sink->write(chunk.data(), chunk.size());
+}
+
+// fcTL of the frame, then its IDAT chunks as they are for the first frame
+// and as fdAT chunks for the others
+bool Apng::writeFrame(const EncodedFrame& frame, bool first)
+{
+    std::vector<unsigned char> control;
+    appendUint32(control, m_sequence++);
+    appendUint32(control, static_cast<uint32_t>(frame.region.maxY - frame.region.minY));
+    appendUint32(control, static_cast<uint32_t>(frame.region.maxX - frame.region.minX));
+    appendUint32(control, static_cast<uint32_t>(frame.region.minY));
+    appendUint32(control, static_cast<uint32_t>(frame.region.minX));
+    appendUint16(control, frame.delay);
+    appendUint16(control, DELAY_DENOMINATOR);
+    // the canvas is kept as it is and the region replaced, not blended
+    control.push_back(0);
+    control.push_back(0);
+    if (!writeChunk("fcTL", control))
+    {
+        return false;
+    }
+
+    const unsigned char* end = frame.png.data() + frame.png.size();
+    for (const unsigned char* chunk = frame.png.data() + sizeof(PNG_SIGNATURE); chunk + CHUNK_HEADER <= end;
+         chunk = lodepng_chunk_next_const(chunk, end))
+    {
+        if (!lodepng_chunk_type_equals(chunk, "IDAT"))
+        {
+            continue;
+        }
+        const unsigned char* data = lodepng_chunk_data_const(chunk);
+        std::vector<unsigned char> frameData;
+        if (!first)
+        {
+            appendUint32(frameData, m_sequence++);
+        }
+        frameData.insert(frameData.end(), data, data + lodepng_chunk_length(chunk));
+        if (!writeChunk(first ? "IDAT" : "fdAT", frameData))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Apng::save(const std::string& filePath)
+{
+    std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        P_LOGF_ERROR("Cannot open {} for writing\n", filePath);
+        return false;
+    }
+    ByteSink sink(file);
+    const bool saved = save(sink);
+    file.close();
+    return saved && !file.fail();
+}
+
+std::vector<uint8_t> Apng::saveToBuffer()
+{
+    std::vector<uint8_t> buffer;
+    ByteSink sink(buffer);
+    if (!save(sink))
+    {
+        buffer.clear();
+    }
+    return buffer;
+}
+
+bool Apng::save(ByteSink& sink)
+{
+    P_PROFILE_SCOPE("Apng::save");
+    m_savedBytes = 0;
+    m_sequence = 0;
+    if (m_frames.empty())
+    {
+        P_LOG_ERROR() << "No frames to save\n";
+        return false;
+    }
+
+    // frames without changes only lengthen the frame before them
+    const std::vector<graphics::Rect> regions = changedRegions();
+    std::vector<std::size_t> written;
+    std::vector<uint16_t> delays;
+    for (std::size_t i = 0; i < m_frames.size(); i++)
+    {
+        if (regions[i].isEmpty() && !written.empty())
+        {
+            delays.back() = static_cast<uint16_t>(std::min<uint32_t>(uint32_t{delays.back()} + m_frames[i].delay, UINT16_MAX));
+            continue;
+        }
+        written.push_back(i);
+        delays.push_back(m_frames[i].delay);
+    }
+
+    bool opaque = true;
+    for (const Frame& frame : m_frames)
+    {
+        const std::pmr::vector<Color>& colors = frame.image.getColorPalette().getColors();
+        opaque = opaque && std::all_of(colors.begin(), colors.end(), [](const Color& color) { return color.alpha == 255; });
+    }
+
+    m_sink = &sink;
+    const std::uintmax_t start = sink.bytesWritten();
+    bool ok = sink.write(PNG_SIGNATURE, sizeof(PNG_SIGNATURE));
+    std::vector<unsigned char> header;
+    appendUint32(header, static_cast<uint32_t>(m_width));
+    appendUint32(header, static_cast<uint32_t>(m_height));
+    // 8 bits per channel, deflate, adaptive filters, no interlacing
+    header.push_back(8);
+    header.push_back(opaque ? LCT_RGB : LCT_RGBA);
+    header.push_back(0);
+    header.push_back(0);
+    header.push_back(0);
+    std::vector<unsigned char> animation;
+    appendUint32(animation, static_cast<uint32_t>(written.size()));
+    // played forever, like the gifs
+    appendUint32(animation, 0);
+    ok = ok && writeChunk("IHDR", header) && writeChunk("acTL", animation);
+
+    // frames are compressed a window at a time and written in order, so
+    // only the compressed frames of the window are kept
+    ThreadPool& pool = threadPool();
+    const std::size_t window = std::max<std::size_t>(pool.size(), 1) * FRAMES_PER_THREAD;
+    for (std::size_t begin = 0; ok && begin < written.size(); begin += window)
+    {
+        const std::size_t end = std::min(begin + window, written.size());
+        std::vector<std::future<EncodedFrame>> encoded;
+        TaskGroup group(pool);
+        for (std::size_t i = begin; i < end; i++)
+        {
+            encoded.push_back(group.run([this, &regions, &written, opaque, i]() {
+                return encodeFrame(m_frames[written[i]], regions[written[i]], opaque);
+            }));
+        }
+        group.wait();
+        for (std::size_t i = begin; ok && i < end; i++)
+        {
+            EncodedFrame frame = encoded[i - begin].get();
+            if (frame.error)
+            {
+                P_LOGF_ERROR("encoder error {}: {}\n", frame.error, lodepng_error_text(frame.error));
+                ok = false;
+                break;
+            }
+            frame.delay = delays[i];
+            ok = writeFrame(frame, i == 0);
+        }
+    }
+    ok = ok && writeChunk("IEND", {});
+    m_sink = nullptr;
+    m_savedBytes = sink.bytesWritten() - start;
+    if (!ok)
+    {
+        P_LOG_ERROR() << "Failed to write the animated png\n";
+        return false;
+    }
+    P_PROFILE_COUNTER("apng.bytesEncoded", m_savedBytes);
+    return true;
+}
+
+} // namespace pixelmancy
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "Common.hpp"
+#include "Image.hpp"
+
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace pixelmancy {
+class ByteSink;
+class ThreadPool;
+
+/**
+ * Animated PNG writer. Frames keep all their colors, there is no palette
+ * merging or reduction as in Gif. Every frame after the first one is cropped
+ * to the area that differs from the frame before it, and the frames are
+ * compressed in parallel and written in order.
+ */
+class Apng
+{
+public:
+    /**
+     *   @param resource resource for the frames, it must outlive the apng
+     */
+    explicit Apng(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+    ~Apng();
+
+    /**
+     *   Save the animation to the file path. Frames that do not differ from
+     *   the frame before them are merged into it.
+     *   @param filePath path to save the png
+     */
+    bool save(const std::string& filePath);
+
+    /**
+     *   Save the animation to a sink instead of a file
+     *   @param sink destination of the bytes, they are written as the frames are compressed
+     */
+    bool save(ByteSink& sink);
+
+    /**
+     *   Save the animation to memory
+     *   @return bytes of the png, empty if it could not be saved
+     */
+    std::vector<uint8_t> saveToBuffer();
+
+    /**
+     *   Add a frame to the animation
+     *   @param frame image to add as a frame
+     *   @param delay delay in hundredths of a second
+     */
+    void addFrame(const Image& frame, uint16_t delay = DEFAULT_FRAME_DELAY);
+
+    /**
+     *   Add a frame to the animation without copying the image
+     *   @param frame image to add as a frame
+     *   @param delay delay in hundredths of a second
+     */
+    void addFrame(Image&& frame, uint16_t delay = DEFAULT_FRAME_DELAY);
+
+    /**
+     *   Add a frame that differs from the previous frame only inside a region,
+     *   the frames are not compared and only that region is written
+     *   @param frame image to add as a frame
+     *   @param delay delay in hundredths of a second
+     *   @param changedRegion area that changed since the previous frame (see FrameBuilder::changedRegion())
+     */
+    void addFrame(const Image& frame, uint16_t delay, const graphics::Rect& changedRegion);
+
+    /**
+     *   Compare and compress the frames on a pool of its own instead of the
+     *   global pool, the file does not depend on the pool
+     *   @param threadPool pool to use, it must outlive the apng
+     */
+    void setThreadPool(ThreadPool& threadPool);
+
+    /**
+     *   Size of the last save() in bytes
+     */
+    std::uintmax_t savedBytes() const;
+
+private:
+    // one fcTL chunk and the data of the frame
+    struct EncodedFrame
+    {
+        graphics::Rect region;
+        uint16_t delay = 0;
+        std::vector<unsigned char> png;
+        unsigned error = 0;
+    };
+
+    void updateSize(const Image& frame);
+    ThreadPool& threadPool() const;
+    std::vector<graphics::Rect> changedRegions() const;
+    EncodedFrame encodeFrame(const Frame& frame, const graphics::Rect& region, bool opaque) const;
+    bool writeChunk(const char* type, const std::vector<unsigned char>& data);
+    bool writeFrame(const EncodedFrame& frame, bool first);
+
+    std::pmr::memory_resource* m_resource;
+    std::pmr::vector<Frame> m_frames;
+    int m_width = 0;
+    int m_height = 0;
+    ThreadPool* m_threadPool = nullptr;
+    // destination of the save() in progress
+    ByteSink* m_sink = nullptr;
+    // sequence number of the next fcTL or fdAT chunk
+    uint32_t m_sequence = 0;
+    std::uintmax_t m_savedBytes = 0;
+};
+
+} // namespace pixelmancy
@@ -0,0 +1,182 @@
+#include "AssetCache.hpp"
+
+#include <exception>
+#include <iterator>
+#include <system_error>
+
+#include "profiler/Profiler.hpp"
+
+namespace pixelmancy {
+
+namespace {
+
+// pixels and palette, the parts of an image that grow with it
+std::size_t imageBytes(const Image& image)
+{
+    return sizeof(Image) + image.size() * sizeof(uint16_t) + image.getColorPalette().size() * sizeof(Color);
+}
+
+} // namespace
+
+AssetCache::AssetCache(std::size_t byteBudget)
+ : m_byteBudget(byteBudget)
+{
+}
+
+AssetCache& AssetCache::global()
+{
+    static AssetCache cache;
+    return cache;
+}
+
+std::shared_ptr<const Image> AssetCache::load(const std::string& filePath)
+{
+    P_PROFILE_SCOPE("AssetCache::load");
+    std::error_code error;
+    const std::filesystem::path canonical = std::filesystem::canonical(filePath, error);
+    // a file that cannot be found fails in the decode with the usual error
+    const std::string key = error ? filePath : canonical.string();
+    const std::uintmax_t fileSize = std::filesystem::file_size(key, error);
+    const std::filesystem::file_time_type modified = std::filesystem::last_write_time(key, error);
+
+    std::promise<std::shared_ptr<const Image>> promise;
+    std::uint64_t generation = 0;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        auto entry = m_entries.find(key);
+        if (entry != m_entries.end())
+        {
+            if (entry->second.fileSize == fileSize && entry->second.modified == modified)
+            {
+                m_stats.hits++;
+                m_recent.splice(m_recent.begin(), m_recent, entry->second.recent);
+                const ImageFuture image = entry->second.image;
+                lock.unlock();
+                P_PROFILE_COUNTER("assetCache.hits", 1);
+                // waits if the image is still being decoded
+                return image.get();
+            }
+            m_stats.reloads++;
+            erase(entry);
+        }
+        m_stats.misses++;
+        generation = m_nextGeneration++;
+        m_recent.push_front(key);
+        Entry loading;
+        loading.fileSize = fileSize;
+        loading.modified = modified;
+        loading.image = promise.get_future().share();
+        loading.recent = m_recent.begin();
+        loading.generation = generation;
+        m_entries.emplace(key, std::move(loading));
+    }
+
+    P_PROFILE_COUNTER("assetCache.misses", 1);
+    try
+    {
+        auto image = std::make_shared<const Image>(Image::loadFromFile(key));
+        promise.set_value(image);
+        finishLoad(key, generation, image);
+        return image;
+    }
+    catch (...)
+    {
+        // the loads waiting for this one fail too, the next load tries again
+        promise.set_exception(std::current_exception());
+        abandonLoad(key, generation);
+        throw;
+    }
+}
+
+void AssetCache::finishLoad(const std::string& key, std::uint64_t generation, const std::shared_ptr<const Image>& image)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto entry = m_entries.find(key);
+    // cleared or replaced by a newer file while decoding
+    if (entry == m_entries.end() || entry->second.generation != generation)
+    {
+        return;
+    }
+    entry->second.bytes = imageBytes(*image);
+    m_bytesUsed += entry->second.bytes;
+    evict();
+}
+
+void AssetCache::abandonLoad(const std::string& key, std::uint64_t generation)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto entry = m_entries.find(key);
+    if (entry != m_entries.end() && entry->second.generation == generation)
+    {
+        erase(entry);
+    }
+}
+
+void AssetCache::erase(std::unordered_map<std::string, Entry>::iterator entry)
+{
+    m_bytesUsed -= entry->second.bytes;
+    m_recent.erase(entry->second.recent);
+    m_entries.erase(entry);
+}
+
+// Drop the least recently loaded images until the budget holds, images being
+// decoded are skipped
+void AssetCache::evict()
+{
+    for (auto recent = m_recent.end(); recent != m_recent.begin() && m_bytesUsed > m_byteBudget;)
+    {
+        --recent;
+        auto entry = m_entries.find(*recent);
+        if (entry->second.bytes == 0)
+        {
+            continue;
+        }
+        const auto newer = std::next(recent);
+        erase(entry);
+        recent = newer;
+        m_stats.evictions++;
+        P_PROFILE_COUNTER("assetCache.evictions", 1);
+    }
+}
+
+void AssetCache::setByteBudget(std::size_t byteBudget)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_byteBudget = byteBudget;
+    evict();
+}
+
+std::size_t AssetCache::byteBudget() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_byteBudget;
+}
+
+std::size_t AssetCache::bytesUsed() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_bytesUsed;
+}
+
+std::size_t AssetCache::size() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.size();
+}
+
+AssetCacheStats AssetCache::stats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void AssetCache::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.clear();
+    m_recent.clear();
+    m_bytesUsed = 0;
+    m_stats = {};
+}
+
+} // namespace pixelmancy
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "Image.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace pixelmancy {
+
+/**
+ * Counters of an AssetCache since it was made or cleared
+ */
+struct AssetCacheStats
+{
+    // loads answered from the cache, also by waiting for a load in flight
+    std::size_t hits = 0;
+    // loads that decoded the file
+    std::size_t misses = 0;
+    // images dropped to stay within the byte budget
+    std::size_t evictions = 0;
+    // decoded images dropped because the file changed
+    std::size_t reloads = 0;
+};
+
+/**
+ * Decoded PNG images shared between everyone who loads the same file. Files
+ * are keyed by their canonical path, and a cached image is decoded again
+ * when the size or the modification time of the file changes. The images
+ * are immutable, copy one to change it. The decoded images are kept within a
+ * byte budget, the least recently loaded ones are dropped first, and images
+ * still in use stay alive through their shared pointers. Loads of the same
+ * file that come while it is being decoded wait for that decode.
+ */
+class AssetCache
+{
+public:
+    static constexpr std::size_t DEFAULT_BYTE_BUDGET = std::size_t{256} << 20;
+
+    /**
+     * @param byteBudget bytes of pixels and palettes to keep decoded
+     */
+    explicit AssetCache(std::size_t byteBudget = DEFAULT_BYTE_BUDGET);
+
+    AssetCache(const AssetCache&) = delete;
+    AssetCache& operator=(const AssetCache&) = delete;
+
+    /**
+     * Cache shared by the whole process
+     */
+    static AssetCache& global();
+
+    /**
+     * Get the decoded image of a PNG, decoding it only if it is not cached
+     * @param filePath path of the png
+     * @throws std::runtime_error if the PNG cannot be decoded, like Image::loadFromFile()
+     */
+    std::shared_ptr<const Image> load(const std::string& filePath);
+
+    /**
+     * Change the budget, images are dropped at once if it is exceeded
+     */
+    void setByteBudget(std::size_t byteBudget);
+    std::size_t byteBudget() const;
+
+    /**
+     * Bytes of the decoded images in the cache
+     */
+    std::size_t bytesUsed() const;
+
+    std::size_t size() const;
+    AssetCacheStats stats() const;
+
+    /**
+     * Drop every decoded image and reset the counters, loads in flight finish
+     * without being cached
+     */
+    void clear();
+
+private:
+    using ImageFuture = std::shared_future<std::shared_ptr<const Image>>;
+
+    struct Entry
+    {
+        std::uintmax_t fileSize = 0;
+        std::filesystem::file_time_type modified;
+        ImageFuture image;
+        // 0 while the image is being decoded
+        std::size_t bytes = 0;
+        // position in m_recent, the front was loaded last
+        std::list<std::string>::iterator recent;
+        // identifies the load that made the entry
+        std::uint64_t generation = 0;
+    };
+
+    void finishLoad(const std::string& key, std::uint64_t generation, const std::shared_ptr<const Image>& image);
+    void abandonLoad(const std::string& key, std::uint64_t generation);
+    void erase(std::unordered_map<std::string, Entry>::iterator entry);
+    void evict();
+
+    mutable std::mutex m_mutex;
+    std::size_t m_byteBudget;
+    std::size_t m_bytesUsed = 0;
+    std::unordered_map<std::string, Entry> m_entries;
+    std::list<std::string> m_recent;
+    std::uint64_t m_nextGeneration = 0;
+    AssetCacheStats m_stats;
+};
+
+} // namespace pixelmancy
@@ -0,0 +1,58 @@
+#include "ByteSink.hpp"
+
+#include <utility>
+
+namespace pixelmancy {
+
+ByteSink::ByteSink(std::vector<uint8_t>& buffer)
+ : m_write([&buffer](const uint8_t* data, std::size_t size) {
+       buffer.insert(buffer.end(), data, data + size);
+       return true;
+   })
+{
+}
+
+ByteSink::ByteSink(std::ostream& stream)
+ : m_write([&stream](const uint8_t* data, std::size_t size) {
+       stream.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+       return static_cast<bool>(stream);
+   })
+{
+}
+
+ByteSink::ByteSink(WriteFunction write)
+ : m_write(std::move(write))
+{
+}
+
+bool ByteSink::write(const uint8_t* data, std::size_t size)
+{
+    if (m_failed)
+    {
+        return false;
+    }
+    if (size > 0 && !m_write(data, size))
+    {
+        m_failed = true;
+        return false;
+    }
+    m_bytesWritten += size;
+    return true;
+}
+
+int ByteSink::writeCallback(void* context, const uint8_t* data, std::size_t size)
+{
+    return static_cast<ByteSink*>(context)->write(data, size) ? 0 : -1;
+}
+
+bool ByteSink::failed() const
+{
+    return m_failed;
+}
+
+std::uintmax_t ByteSink::bytesWritten() const
+{
+    return m_bytesWritten;
+}
+
+} // namespace pixelmancy
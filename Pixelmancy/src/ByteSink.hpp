@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <vector>
+
+namespace pixelmancy {
+
+/**
+ * Destination of the bytes of an encoder: a growable buffer, a stream or a
+ * callback. The encoders write to a sink in pieces as they go, saving to a
+ * file path is a sink over a file stream.
+ */
+class ByteSink
+{
+public:
+    /**
+     * Called with every piece of the output in order
+     * @return false to stop the encoder
+     */
+    using WriteFunction = std::function<bool(const uint8_t* data, std::size_t size)>;
+
+    /**
+     * Append to a buffer, the bytes already in it are kept
+     */
+    explicit ByteSink(std::vector<uint8_t>& buffer);
+
+    /**
+     * Write to a stream, a stream in a failed state fails the encoder
+     */
+    explicit ByteSink(std::ostream& stream);
+
+    explicit ByteSink(WriteFunction write);
+
+    ByteSink(const ByteSink&) = delete;
+    ByteSink& operator=(const ByteSink&) = delete;
+
+    /**
+     * Pass bytes on, nothing is written after a write has failed
+     * @return false if this or an earlier write failed
+     */
+    bool write(const uint8_t* data, std::size_t size);
+
+    /**
+     * Write function for cgif_write_fn, the context is the sink
+     * @return 0 on success like cgif expects
+     */
+    static int writeCallback(void* context, const uint8_t* data, std::size_t size);
+
+    bool failed() const;
+
+    /**
+     * Bytes written since the sink was made
+     */
+    std::uintmax_t bytesWritten() const;
+
+private:
+    WriteFunction m_write;
+    std::uintmax_t m_bytesWritten = 0;
+    bool m_failed = false;
+};
+
+} // namespace pixelmancy
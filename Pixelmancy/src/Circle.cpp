@@ -1,40 +1,213 @@
 #include "Circle.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
 #include <logger/Log.hpp>
 
 namespace pixelmancy::graphics {
 
-Circle::Circle(const Point& center, int radius, const Color& color) : LineArt(std::move(color)), m_center(std::move(center)), m_radius(radius)
+namespace {
+
+/**
+ * One of the eight symmetric parts of a circle. The midpoint loop walks the
+ * octant where the row offset (x) is smaller than the column offset (y),
+ * every other octant is a mirror or a swap of it.
+ */
+struct Octant
+{
+    int rowSign;
+    int columnSign;
+    bool swapped;
+};
+
+constexpr std::array<Octant, 8> OCTANTS = {{{1, -1, false},
+                                            {-1, -1, false},
+                                            {1, 1, false},
+                                            {-1, 1, false},
+                                            {-1, 1, true},
+                                            {-1, -1, true},
+                                            {1, 1, true},
+                                            {1, -1, true}}};
+
+constexpr double SQRT1_2 = 0.70710678118654752440;
+
+enum class Visibility
+{
+    HIDDEN,
+    PARTIAL,
+    VISIBLE
+};
+
+// classify the closed range [low, high] against [0, size)
+Visibility classifyRange(int low, int high, int size)
 {
+    if (high < 0 || low >= size)
+    {
+        return Visibility::HIDDEN;
+    }
+    if (low >= 0 && high < size)
+    {
+        return Visibility::VISIBLE;
+    }
+    return Visibility::PARTIAL;
+}
+
+Visibility classifyOctant(const Octant& octant, const Point& center, int radius, const Image& image)
+{
+    // conservative offsets reached by the midpoint loop: the short offset stays
+    // below radius / sqrt(2) and the long offset stays above it
+    const int shortMax = std::min(radius, static_cast<int>(std::ceil(radius * SQRT1_2)) + 1);
+    const int longMin = std::max(0, static_cast<int>(std::floor(radius * SQRT1_2)) - 1);
+
+    const int rowLow = octant.swapped ? longMin : 0;
+    const int rowHigh = octant.swapped ? radius : shortMax;
+    const int columnLow = octant.swapped ? 0 : longMin;
+    const int columnHigh = octant.swapped ? shortMax : radius;
+
+    const int firstRow = center.x + octant.rowSign * (octant.rowSign > 0 ? rowLow : rowHigh);
+    const int lastRow = center.x + octant.rowSign * (octant.rowSign > 0 ? rowHigh : rowLow);
+    const int firstColumn = center.y + octant.columnSign * (octant.columnSign > 0 ? columnLow : columnHigh);
+    const int lastColumn = center.y + octant.columnSign * (octant.columnSign > 0 ? columnHigh : columnLow);
+
+    const Visibility rows = classifyRange(firstRow, lastRow, image.getHeight());
+    const Visibility columns = classifyRange(firstColumn, lastColumn, image.getWidth());
+    if (rows == Visibility::HIDDEN || columns == Visibility::HIDDEN)
+    {
+        return Visibility::HIDDEN;
+    }
+    if (rows == Visibility::VISIBLE && columns == Visibility::VISIBLE)
+    {
+        return Visibility::VISIBLE;
+    }
+    return Visibility::PARTIAL;
+}
+
+int integerSqrt(int value)
+{
+    if (value <= 0)
+    {
+        return 0;
+    }
+    int root = static_cast<int>(std::sqrt(static_cast<double>(value)));
+    while (root * root > value)
+    {
+        root--;
+    }
+    while ((root + 1) * (root + 1) <= value)
+    {
+        root++;
+    }
+    return root;
+}
+
+} // namespace
+
+Circle::Circle(const Point& center, int radius, const Color& color, int thickness)
+ : LineArt(std::move(color)), m_center(std::move(center)), m_radius(radius), m_thickness(std::max(thickness, 1))
+{
+}
+
+void Circle::setThickness(int thickness)
+{
+    m_thickness = std::max(thickness, 1);
+}
+
+int Circle::getThickness() const
+{
+    return m_thickness;
 }
 
-// mid point circle drawing algorithm
 void Circle::drawOn(Image& image) const
 {
+    if (m_radius <= 0 || image.isEmpty())
+    {
+        return;
+    }
+    // nothing to draw, and the color stays out of the palette
+    const Rect box(m_center.x - m_radius, m_center.y - m_radius, m_center.x + m_radius + 1, m_center.y + m_radius + 1);
+    if (!box.intersects(image.bounds()))
+    {
+        return;
+    }
+    const uint16_t colorIndex = image.resolveColor(*m_lineColor);
+    if (m_thickness > 1)
+    {
+        drawAnnulus(image, colorIndex);
+        return;
+    }
+    drawOutline(image, colorIndex);
+}
+
+// mid point circle drawing algorithm
+void Circle::drawOutline(Image& image, uint16_t colorIndex) const
+{
+    std::array<Visibility, OCTANTS.size()> visibility{};
+    bool anyVisible = false;
+    for (std::size_t i = 0; i < OCTANTS.size(); i++)
+    {
+        visibility[i] = classifyOctant(OCTANTS[i], m_center, m_radius, image);
+        anyVisible = anyVisible || visibility[i] != Visibility::HIDDEN;
+    }
+    if (!anyVisible)
+    {
+        return;
+    }
+
     int x = 0;
-    int y = -m_radius;
+    int y = m_radius;
     int p = -m_radius;
-    while (x < -y)
+    while (x < y)
     {
         if (p > 0)
         {
-            y += 1;
-            p += 2 * (x + y) + 1;
+            y -= 1;
+            p += 2 * (x - y) + 1;
         }
         else
         {
             p += 2 * x + 1;
         }
-        image(m_center.x + x, m_center.y + y) = *m_lineColor;
-        image(m_center.x - x, m_center.y + y) = *m_lineColor;
-        image(m_center.x + x, m_center.y - y) = *m_lineColor;
-        image(m_center.x - x, m_center.y - y) = *m_lineColor;
+        for (std::size_t i = 0; i < OCTANTS.size(); i++)
+        {
+            if (visibility[i] == Visibility::HIDDEN)
+            {
+                continue;
+            }
+            const Octant& octant = OCTANTS[i];
+            const int row = m_center.x + octant.rowSign * (octant.swapped ? y : x);
+            const int column = m_center.y + octant.columnSign * (octant.swapped ? x : y);
+            if (visibility[i] == Visibility::VISIBLE || image.contains(row, column))
+            {
+                image.setPixel(row, column, colorIndex);
+            }
+        }
+        x += 1;
+    }
+}
 
-        image(m_center.x + y, m_center.y + x) = *m_lineColor;
-        image(m_center.x + y, m_center.y - x) = *m_lineColor;
-        image(m_center.x - y, m_center.y + x) = *m_lineColor;
-        image(m_center.x - y, m_center.y - x) = *m_lineColor;
+// ring between the radius and radius - thickness, filled one row span at a time
+void Circle::drawAnnulus(Image& image, uint16_t colorIndex) const
+{
+    const int innerRadius = m_radius - m_thickness;
+    const int outerSquared = m_radius * m_radius;
+    const int innerSquared = innerRadius * innerRadius;
 
-        x += 1;
+    const int firstRow = std::max(-m_radius, -m_center.x);
+    const int lastRow = std::min(m_radius, image.getHeight() - 1 - m_center.x);
+    for (int dx = firstRow; dx <= lastRow; dx++)
+    {
+        const int row = m_center.x + dx;
+        const int outerHalfWidth = integerSqrt(outerSquared - dx * dx);
+        if (innerRadius < 0 || std::abs(dx) > innerRadius)
+        {
+            image.fillRow(row, m_center.y - outerHalfWidth, m_center.y + outerHalfWidth, colorIndex);
+            continue;
+        }
+        const int innerHalfWidth = integerSqrt(innerSquared - dx * dx);
+        image.fillRow(row, m_center.y - outerHalfWidth, m_center.y - innerHalfWidth - 1, colorIndex);
+        image.fillRow(row, m_center.y + innerHalfWidth + 1, m_center.y + outerHalfWidth, colorIndex);
     }
 }
 
@@ -12,25 +12,42 @@ namespace graphics {
 /**
  * Circle class that draws a circle on an image
  * Users can provide the center, radius and color of the circle line
- * to draw a circle on an image
+ * to draw a circle on an image. A thickness larger than one draws an
+ * annulus that grows inwards from the radius.
  */
 class Circle : public LineArt
 {
 public:
-    Circle(const Point& center, int radius, const Color& color);
+    Circle(const Point& center, int radius, const Color& color, int thickness = 1);
 
     /**
-     * Draw a circle based on Bresenham algorithm
+     * Draw a circle based on Bresenham algorithm, pixels outside of the
+     * image are clipped
      * @param image circle will be drawn on this image
      */
     void drawOn(Image& image) const override;
 
+    /**
+     * Set the thickness of the circle line
+     * @param thickness line thickness in pixels, values below one are treated as one
+     */
+    void setThickness(int thickness);
+
+    /**
+     * Get the thickness of the circle line
+     */
+    int getThickness() const;
+
 private:
+    void drawOutline(Image& image, uint16_t colorIndex) const;
+    void drawAnnulus(Image& image, uint16_t colorIndex) const;
+
     Point m_center;
     int m_radius;
+    int m_thickness;
 };
 
 } // namespace graphics
 } // namespace pixelmancy
 
-#endif // CIRCLE_HPP
\ No newline at end of file
+#endif // CIRCLE_HPP
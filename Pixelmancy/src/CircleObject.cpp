@@ -61,4 +61,9 @@ void CircleObject::drawOn(Image& image) const
     }
 }
 
+Rect CircleObject::getBoundingBox() const
+{
+    return {m_position.x - m_radius, m_position.y - m_radius, m_position.x + m_radius, m_position.y + m_radius};
+}
+
 } // namespace pixelmancy::graphics
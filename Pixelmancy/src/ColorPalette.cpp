@@ -3,6 +3,10 @@
 #include "Log.hpp"
 
 #include "colors/Color.hpp"
+#include "kernels/Kernels.hpp"
+
+#include <cstring>
+#include <vector>
 
 namespace pixelmancy {
 
@@ -12,6 +16,16 @@ ColorPallette::ColorPallette(std::vector<Color> &colors) {
   }
 };
 
+ColorPallette::ColorPallette(std::pmr::memory_resource *resource)
+    : m_Colors(resource), m_foundColors(resource),
+      m_ColorToIndexMap(resource) {}
+
+ColorPallette::ColorPallette(const ColorPallette &other,
+                             std::pmr::memory_resource *resource)
+    : m_Colors(other.m_Colors, resource),
+      m_foundColors(other.m_foundColors, resource),
+      m_ColorToIndexMap(other.m_ColorToIndexMap, resource) {}
+
 ColorPallette &ColorPallette::operator=(const ColorPallette &other) {
   if (this != &other) {
     m_Colors = other.m_Colors;
@@ -50,7 +64,7 @@ ColorPallette &ColorPallette::operator=(ColorPallette &&other) {
 
 uint16_t ColorPallette::addColor(const Color &clr) {
   if (!m_foundColors.insert(clr).second) {
-    return getColorIndex(clr);
+    return findColorIndex(clr);
   }
   m_Colors.push_back(clr);
   auto index = static_cast<uint16_t>(m_Colors.size() - 1);
@@ -60,7 +74,7 @@ uint16_t ColorPallette::addColor(const Color &clr) {
 
 uint16_t ColorPallette::addColor(Color &&clr) {
   if (!m_foundColors.insert(clr).second) {
-    return getColorIndex(clr);
+    return findColorIndex(clr);
   }
   m_Colors.push_back(clr);
   auto index = static_cast<uint16_t>(m_Colors.size() - 1);
@@ -92,7 +106,7 @@ std::vector<int> ColorPallette::reduceColors(std::size_t count) {
   unsigned char maskBit = 0xFF;
   maskBit = maskBit << (8 - numBits);
 
-  std::vector<Color> newColors;
+  std::pmr::vector<Color> newColors(resource());
   newColors.reserve(count);
   for (std::size_t i = 0; i < totalColors; i++) {
     Color &color = m_Colors[i];
@@ -122,6 +136,10 @@ uint16_t ColorPallette::addColor(const uint8_t red, const uint8_t green,
 }
 
 uint16_t ColorPallette::getColorIndex(const Color &clr) {
+  return findColorIndex(clr);
+}
+
+uint16_t ColorPallette::findColorIndex(const Color &clr) const {
   auto found = m_ColorToIndexMap.find(clr);
   if (found != m_ColorToIndexMap.end()) {
     return found->second;
@@ -129,9 +147,10 @@ uint16_t ColorPallette::getColorIndex(const Color &clr) {
   return 0;
 }
 
-IndexMapPtr ColorPallette::merge(const ColorPallette &other) {
+IndexMapPtr ColorPallette::merge(const ColorPallette &other,
+                                 std::pmr::memory_resource *resource) {
   uint16_t index = 0;
-  IndexMapPtr localToGlobalIndexMapPtr = std::make_unique<IndexMap>();
+  IndexMapPtr localToGlobalIndexMapPtr = std::make_unique<IndexMap>(resource);
   for (const Color &clr : other.m_Colors) {
     auto mergedIndex = addColor(clr);
     localToGlobalIndexMapPtr->insert(std::make_pair(index, mergedIndex));
@@ -141,8 +160,9 @@ IndexMapPtr ColorPallette::merge(const ColorPallette &other) {
   return localToGlobalIndexMapPtr;
 }
 
-std::vector<uint8_t> ColorPallette::getPaletteData() const {
-  std::vector<uint8_t> paletteData;
+std::pmr::vector<uint8_t>
+ColorPallette::getPaletteData(std::pmr::memory_resource *resource) const {
+  std::pmr::vector<uint8_t> paletteData(resource);
   paletteData.reserve(size() * 3);
   for (auto &clr : m_Colors) {
     paletteData.push_back(clr.red);
@@ -163,21 +183,61 @@ void ColorPallette::reset() {
   m_Colors.clear();
 }
 
+std::vector<uint16_t>
+ColorPallette::replaceColors(std::pmr::vector<Color> &&colors) {
+  partialReset();
+  m_foundColors.reserve(colors.size());
+  m_ColorToIndexMap.reserve(colors.size());
+  // filled from the first merged color on, indices before it keep their place
+  std::vector<uint16_t> oldToNewIndex;
+  std::size_t kept = 0;
+  for (std::size_t i = 0; i < colors.size(); i++) {
+    const auto [found, inserted] =
+        m_ColorToIndexMap.try_emplace(colors[i], static_cast<uint16_t>(kept));
+    if (inserted) {
+      m_foundColors.insert(colors[i]);
+      colors[kept] = colors[i];
+      kept++;
+    } else if (oldToNewIndex.empty()) {
+      oldToNewIndex.resize(colors.size());
+      for (std::size_t j = 0; j < i; j++) {
+        oldToNewIndex[j] = static_cast<uint16_t>(j);
+      }
+    }
+    if (!oldToNewIndex.empty()) {
+      oldToNewIndex[i] = found->second;
+    }
+  }
+  colors.resize(kept);
+  m_Colors = std::move(colors);
+  return oldToNewIndex;
+}
+
 void ColorPallette::convertToRGBfromRGBA() {
-  std::vector<Color> newColors;
+  std::vector<uint32_t> packed;
+  packed.reserve(m_Colors.size());
+  for (const Color &color : m_Colors) {
+    packed.push_back(
+        kernels::packRgba(color.red, color.green, color.blue, color.alpha));
+  }
+  kernels::active().premultiplyAlpha(packed.data(), packed.size());
+
+  std::pmr::vector<Color> newColors(resource());
   newColors.reserve(m_Colors.size());
   partialReset();
   for (size_t i = 0; i < m_Colors.size(); i++) {
-    auto newColor = m_Colors[i].getColorPreMultipliedByAlpha();
+    uint8_t channels[4];
+    std::memcpy(channels, &packed[i], sizeof(channels));
+    const Color newColor(channels[0], channels[1], channels[2], channels[3]);
     newColors.push_back(newColor);
     m_ColorToIndexMap.insert(std::make_pair(newColor, i));
     m_foundColors.insert(newColor);
   }
-  m_Colors = newColors;
+  m_Colors = std::move(newColors);
 }
 
 void ColorPallette::blueShift() {
-  std::vector<Color> newColors;
+  std::pmr::vector<Color> newColors(resource());
   newColors.reserve(m_Colors.size());
   partialReset();
   for (size_t i = 0; i < m_Colors.size(); i++) {
@@ -187,7 +247,7 @@ void ColorPallette::blueShift() {
     m_ColorToIndexMap.insert(std::make_pair(newColor, i));
     m_foundColors.insert(newColor);
   }
-  m_Colors = newColors;
+  m_Colors = std::move(newColors);
 }
 
 } // namespace pixelmancy
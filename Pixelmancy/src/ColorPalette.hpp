@@ -1,7 +1,10 @@
 #pragma once
 
 #include <memory>
+#include <memory_resource>
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
 #include "CommonConfig.hpp"
 #include "Log.hpp"
 #include "colors/ColorHash.hpp"
@@ -10,7 +13,7 @@ namespace pixelmancy {
 
 struct Color;
 
-using IndexMap = std::unordered_map<uint16_t, uint16_t>;
+using IndexMap = std::pmr::unordered_map<uint16_t, uint16_t>;
 using IndexMapPtr = std::unique_ptr<IndexMap>;
 
 /**
@@ -22,6 +25,19 @@ public:
     ColorPallette() = default;
     explicit ColorPallette(std::vector<Color>& colors);
 
+    /**
+     * Create an empty pallette that allocates from a memory resource
+     * @param resource resource for the color tables, it must outlive the pallette
+     */
+    explicit ColorPallette(std::pmr::memory_resource* resource);
+
+    /**
+     * Copy a pallette into another memory resource
+     * @param other pallette to copy
+     * @param resource resource for the color tables, it must outlive the pallette
+     */
+    ColorPallette(const ColorPallette& other, std::pmr::memory_resource* resource);
+
     ~ColorPallette() = default;
 
     ColorPallette(const ColorPallette& other) = default;
@@ -63,7 +79,7 @@ public:
         const auto index = getColorIndex(originalColor);
         if (index == 0)
         {
-            P_LOG_ERROR() << fmt::format("Color : {} not found in the pallette\n", originalColor.toString());
+            P_LOGF_ERROR("Color : {} not found in the pallette\n", originalColor.toString());
             return;
         }
         m_Colors[static_cast<std::size_t>(index)] = newColor;
@@ -90,16 +106,17 @@ public:
     /**
      * Get the colors in the pallette
      */
-    const std::vector<Color>& getColors() const
+    const std::pmr::vector<Color>& getColors() const
     {
         return m_Colors;
     }
 
     /**
      * Get the colors in the pallette as a vector of uint8_t, RGBRGBRGB...
+     * @param resource resource for the returned data
      * @return pallette data
      */
-    std::vector<uint8_t> getPaletteData() const;
+    std::pmr::vector<uint8_t> getPaletteData(std::pmr::memory_resource* resource = std::pmr::get_default_resource()) const;
 
     /**
      * Get the index of the color
@@ -125,9 +142,26 @@ public:
     /**
      * Merge the colors from another pallette
      * @param other other pallette to merge
+     * @param resource resource for the returned index map
      * @return index map of the merged pallette
      */
-    IndexMapPtr merge(const ColorPallette& other);
+    IndexMapPtr merge(const ColorPallette& other, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    /**
+     * Get the memory resource the color tables allocate from
+     */
+    std::pmr::memory_resource* resource() const
+    {
+        return m_Colors.get_allocator().resource();
+    }
+
+    /**
+     * Replace every color at once and rebuild the lookup tables in one pass.
+     * Colors that become equal are merged into the first of them.
+     * @param colors new color of every index, as many as size()
+     * @return old to new index map, empty when no colors were merged
+     */
+    std::vector<uint16_t> replaceColors(std::pmr::vector<Color>&& colors);
 
     /**
      * Remove alpha channel from the colors
@@ -155,10 +189,12 @@ public:
 private:
     uint16_t addColor(uint8_t red, uint8_t green, uint8_t blue, uint8_t transparency = DEFAULT_ALPHA);
     void partialReset();
+    // lookup in the index map without counting the probe
+    uint16_t findColorIndex(const Color& clr) const;
 
-    std::vector<Color> m_Colors;
-    std::unordered_set<Color> m_foundColors;
-    std::unordered_map<Color, uint16_t> m_ColorToIndexMap;
+    std::pmr::vector<Color> m_Colors;
+    std::pmr::unordered_set<Color> m_foundColors;
+    std::pmr::unordered_map<Color, uint16_t> m_ColorToIndexMap;
 };
 
 } // namespace pixelmancy
@@ -0,0 +1,140 @@
+#include "ColorTransforms.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "Image.hpp"
+
+namespace pixelmancy::transforms {
+
+namespace {
+
+constexpr double PI = 3.14159265358979323846;
+
+int luma(const Color& color)
+{
+    return static_cast<int>(std::lround(0.299 * color.red + 0.587 * color.green + 0.114 * color.blue));
+}
+
+std::array<uint8_t, 256> equalizeChannel(const std::array<uint64_t, 256>& histogram, uint64_t total)
+{
+    std::array<uint8_t, 256> table{};
+    uint64_t cumulative = 0;
+    uint64_t firstCount = 0;
+    for (std::size_t value = 0; value < histogram.size(); value++)
+    {
+        cumulative += histogram[value];
+        if (firstCount == 0)
+        {
+            firstCount = cumulative;
+        }
+        // a single used value has nothing to spread
+        table[value] = total == firstCount ? static_cast<uint8_t>(value)
+                                           : static_cast<uint8_t>(std::lround(static_cast<double>(cumulative - firstCount) * 255.0 /
+                                                                              static_cast<double>(total - firstCount)));
+    }
+    return table;
+}
+
+} // namespace
+
+ChannelLut ChannelLut::fromFunction(const std::function<int(int)>& function)
+{
+    ChannelLut table;
+    for (int value = 0; value < 256; value++)
+    {
+        const auto mapped = static_cast<uint8_t>(std::clamp(function(value), 0, COLOR_CLAMP_VALUE));
+        table.red[static_cast<std::size_t>(value)] = mapped;
+        table.green[static_cast<std::size_t>(value)] = mapped;
+        table.blue[static_cast<std::size_t>(value)] = mapped;
+    }
+    return table;
+}
+
+ColorFunction tint(const Color& tintColor, double amount)
+{
+    return [tintColor, amount](const Color& color) {
+        auto mix = [amount](int from, int to) { return static_cast<int>(std::lround(from + (to - from) * amount)); };
+        return Color(mix(color.red, tintColor.red), mix(color.green, tintColor.green), mix(color.blue, tintColor.blue),
+                     color.alpha);
+    };
+}
+
+ChannelLut brightness(int offset)
+{
+    return ChannelLut::fromFunction([offset](int value) { return value + offset; });
+}
+
+ChannelLut contrast(double factor)
+{
+    return ChannelLut::fromFunction(
+        [factor](int value) { return static_cast<int>(std::lround((value - 128) * factor + 128)); });
+}
+
+ChannelLut gamma(double gamma)
+{
+    return ChannelLut::fromFunction([gamma](int value) {
+        return static_cast<int>(std::lround(std::pow(value / 255.0, 1.0 / gamma) * 255.0));
+    });
+}
+
+ColorFunction threshold(int level)
+{
+    return [level](const Color& color) {
+        const int value = luma(color) >= level ? COLOR_CLAMP_VALUE : 0;
+        return Color(value, value, value, color.alpha);
+    };
+}
+
+// the hue rotation matrix of the CSS filter effects
+ColorFunction hueRotate(double degrees)
+{
+    const double c = std::cos(degrees * PI / 180.0);
+    const double s = std::sin(degrees * PI / 180.0);
+    const std::array<double, 9> m = {0.213 + 0.787 * c - 0.213 * s, 0.715 - 0.715 * c - 0.715 * s, 0.072 - 0.072 * c + 0.928 * s,
+                                     0.213 - 0.213 * c + 0.143 * s, 0.715 + 0.285 * c + 0.140 * s, 0.072 - 0.072 * c - 0.283 * s,
+                                     0.213 - 0.213 * c - 0.787 * s, 0.715 - 0.715 * c + 0.715 * s, 0.072 + 0.928 * c + 0.072 * s};
+    return [m](const Color& color) {
+        auto channel = [&m, &color](int row) {
+            return static_cast<int>(
+                std::lround(m[static_cast<std::size_t>(row * 3)] * color.red + m[static_cast<std::size_t>(row * 3 + 1)] * color.green +
+                            m[static_cast<std::size_t>(row * 3 + 2)] * color.blue));
+        };
+        return Color(channel(0), channel(1), channel(2), color.alpha);
+    };
+}
+
+ChannelLut histogramEqualization(const Image& image)
+{
+    const ColorPallette& palette = image.getColorPalette();
+    std::vector<uint64_t> indexCounts(palette.size());
+    for (int row = 0; row < image.getHeight(); row++)
+    {
+        const uint16_t* indices = image.rowIndices(row);
+        for (int column = 0; column < image.getWidth(); column++)
+        {
+            indexCounts[indices[column]]++;
+        }
+    }
+
+    std::array<uint64_t, 256> red{};
+    std::array<uint64_t, 256> green{};
+    std::array<uint64_t, 256> blue{};
+    for (std::size_t index = 0; index < indexCounts.size(); index++)
+    {
+        const Color& color = palette.getColor(static_cast<int>(index));
+        red[color.red] += indexCounts[index];
+        green[color.green] += indexCounts[index];
+        blue[color.blue] += indexCounts[index];
+    }
+
+    const auto total = static_cast<uint64_t>(image.size());
+    ChannelLut table;
+    table.red = equalizeChannel(red, total);
+    table.green = equalizeChannel(green, total);
+    table.blue = equalizeChannel(blue, total);
+    return table;
+}
+
+} // namespace pixelmancy::transforms
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "colors/Color.hpp"
+
+#include <array>
+#include <cstdint>
+#include <functional>
+
+namespace pixelmancy {
+class Image;
+}
+
+namespace pixelmancy::transforms {
+
+/**
+ * Color function for Image::mapColors
+ */
+using ColorFunction = std::function<Color(const Color&)>;
+
+/**
+ * Lookup table per color channel, alpha is kept
+ */
+struct ChannelLut
+{
+    std::array<uint8_t, 256> red{};
+    std::array<uint8_t, 256> green{};
+    std::array<uint8_t, 256> blue{};
+
+    /**
+     * Create a table that maps every channel through the same function
+     * @param function called once for every channel value 0-255
+     */
+    static ChannelLut fromFunction(const std::function<int(int)>& function);
+
+    Color operator()(const Color& color) const
+    {
+        return Color(red[color.red], green[color.green], blue[color.blue], color.alpha);
+    }
+};
+
+/**
+ * Mix every color with a tint
+ * @param tintColor color to mix in
+ * @param amount 0 keeps the colors, 1 replaces them with the tint
+ */
+ColorFunction tint(const Color& tintColor, double amount);
+
+/**
+ * Add an offset to the red, green and blue channels
+ * @param offset value added to every channel, negative darkens
+ */
+ChannelLut brightness(int offset);
+
+/**
+ * Scale the channels around the middle gray
+ * @param factor 1 keeps the colors, above 1 increases the contrast
+ */
+ChannelLut contrast(double factor);
+
+/**
+ * Apply a gamma curve to the channels
+ * @param gamma values above 1 brighten the mid tones
+ */
+ChannelLut gamma(double gamma);
+
+/**
+ * Turn colors white when their luma reaches a level and black otherwise,
+ * alpha is kept
+ * @param level luma level 0-255
+ */
+ColorFunction threshold(int level);
+
+/**
+ * Rotate the hue of the colors, luma stays about the same
+ * @param degrees rotation angle
+ */
+ColorFunction hueRotate(double degrees);
+
+/**
+ * Create a table that spreads the channel values of an image evenly over
+ * 0-255. The histogram is counted per palette index, so it takes one pass
+ * over the pixels and one over the palette.
+ * @param image image to equalize
+ */
+ChannelLut histogramEqualization(const Image& image);
+
+} // namespace pixelmancy::transforms
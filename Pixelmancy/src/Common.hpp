@@ -1,6 +1,9 @@
 #pragma once
 
 #include "Image.hpp"
+#include "Rect.hpp"
+
+#include <optional>
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -9,8 +12,20 @@
 namespace pixelmancy {
 
 struct Frame {
+  Frame(uint16_t a_delay, Image a_image,
+        std::optional<graphics::Rect> a_changedRegion = std::nullopt)
+      : delay(a_delay), image(std::move(a_image)),
+        changedRegion(a_changedRegion) {}
+
+  // copy the image into a memory resource
+  Frame(uint16_t a_delay, const Image &a_image,
+        std::pmr::memory_resource *resource)
+      : delay(a_delay), image(a_image, resource) {}
+
   uint16_t delay = DEFAULT_FRAME_DELAY; // 0.01 seconds
   Image image;
+  // area that differs from the previous frame, std::nullopt when unknown
+  std::optional<graphics::Rect> changedRegion;
 };
 
 namespace graphics {
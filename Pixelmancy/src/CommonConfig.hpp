@@ -11,5 +11,6 @@ constexpr int DEFAULT_ALPHA = 255;
 constexpr int MAX_ALPHA = 255;
 constexpr int MIN_ALPHA = 0;
 constexpr int DEFAULT_OUTLINE_WIDTH = 1;
+constexpr int DIRTY_TILE_SIZE = 16;
 
 } // namespace pixelmancy
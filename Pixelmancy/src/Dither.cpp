@@ -0,0 +1,282 @@
+#include "Dither.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+#include "Image.hpp"
+#include "Parallel.hpp"
+#include "kernels/Kernels.hpp"
+#include "profiler/Profiler.hpp"
+
+namespace pixelmancy::dither {
+
+namespace {
+
+constexpr int CELL_BITS = 6;
+constexpr uint32_t CELL_MASK = (1u << CELL_BITS) - 1;
+constexpr std::size_t CELL_COUNT = std::size_t{1} << (3 * CELL_BITS);
+// errors are kept in sixteenths, the weights of both diffusions add up to 16
+constexpr int ERROR_SCALE = 16;
+// pixels a row stays behind the row above, the diffusions reach two pixels
+// ahead of the pixel and one behind it, so the rows never touch the same error
+constexpr int WAVEFRONT_LAG = 3;
+// pixels diffused between two updates of the progress of a row
+constexpr int WAVEFRONT_STEP = 64;
+// rows of the ordered dither in one task
+constexpr int THRESHOLD_GRAIN_ROWS = 16;
+
+constexpr int BAYER_SIZE = 8;
+static_assert(BAYER_SIZE == kernels::DITHER_THRESHOLDS, "a matrix row is one set of kernel thresholds");
+constexpr int BAYER[BAYER_SIZE][BAYER_SIZE] = {
+    {0, 32, 8, 40, 2, 34, 10, 42},  {48, 16, 56, 24, 50, 18, 58, 26}, {12, 44, 4, 36, 14, 46, 6, 38},
+    {60, 28, 52, 20, 62, 30, 54, 22}, {3, 35, 11, 43, 1, 33, 9, 41},  {51, 19, 59, 27, 49, 17, 57, 25},
+    {15, 47, 7, 39, 13, 45, 5, 37},  {63, 31, 55, 23, 61, 29, 53, 21}};
+
+// share of the error a neighbour gets, in sixteenths
+struct Diffusion
+{
+    int column;
+    int row;
+    int weight;
+};
+
+constexpr Diffusion FLOYD_STEINBERG[] = {{1, 0, 7}, {-1, 1, 3}, {0, 1, 5}, {1, 1, 1}};
+// an eighth each, the last quarter of the error is dropped
+constexpr Diffusion ATKINSON[] = {{1, 0, 2}, {2, 0, 2}, {-1, 1, 2}, {0, 1, 2}, {1, 1, 2}, {0, 2, 2}};
+
+uint32_t cellOf(int red, int green, int blue)
+{
+    constexpr int shift = 8 - CELL_BITS;
+    return static_cast<uint32_t>(red >> shift) << (2 * CELL_BITS) | static_cast<uint32_t>(green >> shift) << CELL_BITS |
+           static_cast<uint32_t>(blue >> shift);
+}
+
+// Nearest palette color of every cell, searched for the center of the cell
+// the first time a pixel falls in it. Threads may search the same cell at
+// once, they find the same color.
+class NearestColors
+{
+public:
+    NearestColors(const Color* palette, std::size_t paletteSize)
+     : m_palette(palette),
+       m_paletteSize(paletteSize),
+       m_cells(CELL_COUNT)
+    {
+    }
+
+    uint16_t operator()(uint32_t cell)
+    {
+        // 0 is a cell not searched yet, the rest are the index plus one
+        uint32_t known = m_cells[cell].load(std::memory_order_relaxed);
+        if (known == 0)
+        {
+            known = search(cell) + 1u;
+            m_cells[cell].store(known, std::memory_order_relaxed);
+        }
+        return static_cast<uint16_t>(known - 1);
+    }
+
+    const Color& color(uint16_t index) const
+    {
+        return m_palette[index];
+    }
+
+private:
+    uint32_t search(uint32_t cell) const
+    {
+        constexpr int half = 1 << (7 - CELL_BITS);
+        const int red = static_cast<int>((cell >> (2 * CELL_BITS) & CELL_MASK) << (8 - CELL_BITS)) + half;
+        const int green = static_cast<int>((cell >> CELL_BITS & CELL_MASK) << (8 - CELL_BITS)) + half;
+        const int blue = static_cast<int>((cell & CELL_MASK) << (8 - CELL_BITS)) + half;
+        uint32_t nearest = 0;
+        int nearestDistance = -1;
+        for (std::size_t i = 0; i < m_paletteSize; i++)
+        {
+            const int dr = m_palette[i].red - red;
+            const int dg = m_palette[i].green - green;
+            const int db = m_palette[i].blue - blue;
+            const int distance = dr * dr + dg * dg + db * db;
+            if (nearestDistance < 0 || distance < nearestDistance)
+            {
+                nearest = static_cast<uint32_t>(i);
+                nearestDistance = distance;
+            }
+        }
+        P_PROFILE_COUNTER("dither.cellSearches", 1);
+        return nearest;
+    }
+
+    const Color* m_palette;
+    std::size_t m_paletteSize;
+    std::vector<std::atomic<uint32_t>> m_cells;
+};
+
+std::vector<uint32_t> packedPalette(const Image& image)
+{
+    std::vector<uint32_t> packed;
+    packed.reserve(image.getColorPalette().size());
+    for (const Color& color : image.getColorPalette().getColors())
+    {
+        packed.push_back(kernels::packRgba(color.red, color.green, color.blue, color.alpha));
+    }
+    return packed;
+}
+
+using Thresholds = std::array<std::array<int32_t, BAYER_SIZE>, BAYER_SIZE>;
+
+// The Bayer matrix around 0, scaled to the distance between the levels of a
+// palette spread evenly over the RGB cube
+Thresholds bayerThresholds(std::size_t paletteSize)
+{
+    const float levels = std::cbrt(static_cast<float>(paletteSize));
+    const float spread = 255.0f / std::max(levels - 1.0f, 1.0f);
+    Thresholds thresholds{};
+    for (int row = 0; row < BAYER_SIZE; row++)
+    {
+        for (int column = 0; column < BAYER_SIZE; column++)
+        {
+            const float level = (static_cast<float>(BAYER[row][column]) + 0.5f) / (BAYER_SIZE * BAYER_SIZE) - 0.5f;
+            thresholds[row][column] = static_cast<int32_t>(std::lround(level * spread));
+        }
+    }
+    return thresholds;
+}
+
+// Every pixel on its own, the thresholds are added to the rows by the kernel
+void thresholded(const Image& image, NearestColors& nearest, const Thresholds& thresholds, uint16_t* indices, ThreadPool& pool)
+{
+    const std::vector<uint32_t> palette = packedPalette(image);
+    const auto width = static_cast<std::size_t>(image.getWidth());
+    parallelFor(
+        image.bounds(), Grain{THRESHOLD_GRAIN_ROWS, 0},
+        [&](const graphics::Rect& tile) {
+            const kernels::KernelTable& kernel = kernels::active();
+            std::vector<uint32_t> rgba(width);
+            std::vector<uint32_t> cells(width);
+            for (int row = tile.minX; row < tile.maxX; row++)
+            {
+                kernel.expandIndices(image.rowIndices(row), width, palette.data(), rgba.data());
+                kernel.ditherCells(rgba.data(), width, thresholds[static_cast<std::size_t>(row % BAYER_SIZE)].data(), cells.data());
+                uint16_t* out = indices + static_cast<std::size_t>(row) * width;
+                for (std::size_t column = 0; column < width; column++)
+                {
+                    out[column] = nearest(cells[column]);
+                }
+            }
+        },
+        pool);
+}
+
+// Rows are taken in order by whichever task is free, and a row only waits
+// for the row above it, which was taken earlier and is being diffused, so
+// the wavefront moves on with any number of threads.
+template <std::size_t N>
+void diffused(const Image& image, NearestColors& nearest, const Diffusion (&diffusion)[N], uint16_t* indices, ThreadPool& pool)
+{
+    const std::vector<uint32_t> palette = packedPalette(image);
+    const int width = image.getWidth();
+    const int height = image.getHeight();
+    // error of every channel of every pixel, added by the pixels before it
+    std::vector<int16_t> errors(static_cast<std::size_t>(width) * static_cast<std::size_t>(height) * 3, 0);
+    // pixels done in every row
+    std::vector<std::atomic<int>> progress(static_cast<std::size_t>(height));
+    std::atomic<int> nextRow{0};
+
+    auto diffuseRows = [&]() {
+        std::vector<uint32_t> rgba(static_cast<std::size_t>(width));
+        for (int row = nextRow.fetch_add(1); row < height; row = nextRow.fetch_add(1))
+        {
+            kernels::active().expandIndices(image.rowIndices(row), rgba.size(), palette.data(), rgba.data());
+            uint16_t* out = indices + static_cast<std::size_t>(row) * static_cast<std::size_t>(width);
+            for (int begin = 0; begin < width; begin += WAVEFRONT_STEP)
+            {
+                const int end = std::min(begin + WAVEFRONT_STEP, width);
+                if (row > 0)
+                {
+                    const int needed = std::min(end + WAVEFRONT_LAG, width);
+                    while (progress[static_cast<std::size_t>(row - 1)].load(std::memory_order_acquire) < needed)
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+                for (int column = begin; column < end; column++)
+                {
+                    const std::size_t pixel = static_cast<std::size_t>(row) * static_cast<std::size_t>(width) + static_cast<std::size_t>(column);
+                    const uint32_t color = rgba[static_cast<std::size_t>(column)];
+                    int wanted[3];
+                    for (int channel = 0; channel < 3; channel++)
+                    {
+                        const int value = static_cast<int>(color >> (8 * channel) & 0xFF);
+                        const int error = errors[pixel * 3 + static_cast<std::size_t>(channel)];
+                        // rounded to nearest, the same for negative errors
+                        const int rounded = (error + (error >= 0 ? ERROR_SCALE / 2 : -ERROR_SCALE / 2)) / ERROR_SCALE;
+                        wanted[channel] = std::clamp(value + rounded, 0, 255);
+                    }
+                    const uint16_t index = nearest(cellOf(wanted[0], wanted[1], wanted[2]));
+                    out[column] = index;
+                    const Color& chosen = nearest.color(index);
+                    const int residual[3] = {wanted[0] - chosen.red, wanted[1] - chosen.green, wanted[2] - chosen.blue};
+                    for (const Diffusion& neighbour : diffusion)
+                    {
+                        const int targetColumn = column + neighbour.column;
+                        const int targetRow = row + neighbour.row;
+                        if (targetColumn < 0 || targetColumn >= width || targetRow >= height)
+                        {
+                            continue;
+                        }
+                        int16_t* target = errors.data() + (static_cast<std::size_t>(targetRow) * static_cast<std::size_t>(width) +
+                                                           static_cast<std::size_t>(targetColumn)) * 3;
+                        for (int channel = 0; channel < 3; channel++)
+                        {
+                            target[channel] = static_cast<int16_t>(target[channel] + residual[channel] * neighbour.weight);
+                        }
+                    }
+                }
+                progress[static_cast<std::size_t>(row)].store(end, std::memory_order_release);
+            }
+        }
+    };
+
+    const std::size_t tasks = std::min(pool.size(), static_cast<std::size_t>(height));
+    TaskGroup group(pool);
+    for (std::size_t task = 0; task < tasks; task++)
+    {
+        group.run(diffuseRows);
+    }
+    group.wait();
+}
+
+} // namespace
+
+std::vector<uint16_t> remap(const Image& image, const Color* palette, std::size_t paletteSize, Dither method, ThreadPool& pool)
+{
+    P_PROFILE_SCOPE("dither::remap");
+    std::vector<uint16_t> indices(image.size(), 0);
+    if (paletteSize == 0 || indices.empty())
+    {
+        return indices;
+    }
+    NearestColors nearest(palette, std::min<std::size_t>(paletteSize, 65536));
+    switch (method)
+    {
+    case Dither::FloydSteinberg:
+        diffused(image, nearest, FLOYD_STEINBERG, indices.data(), pool);
+        break;
+    case Dither::Atkinson:
+        diffused(image, nearest, ATKINSON, indices.data(), pool);
+        break;
+    case Dither::Bayer:
+        thresholded(image, nearest, bayerThresholds(paletteSize), indices.data(), pool);
+        break;
+    case Dither::None:
+        thresholded(image, nearest, Thresholds{}, indices.data(), pool);
+        break;
+    }
+    P_PROFILE_COUNTER("dither.pixels", indices.size());
+    return indices;
+}
+
+} // namespace pixelmancy::dither
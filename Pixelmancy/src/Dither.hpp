@@ -0,0 +1,48 @@
+#pragma once
+
+#include "ThreadPool.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace pixelmancy {
+class Image;
+struct Color;
+
+/**
+ * Dithering of a remap to a smaller palette
+ */
+enum class Dither
+{
+    // every pixel takes its nearest color
+    None,
+    // error diffusion to four neighbours
+    FloydSteinberg,
+    // diffuses three quarters of the error to six neighbours, keeps more contrast
+    Atkinson,
+    // ordered 8 x 8 threshold matrix, no error is carried between pixels
+    Bayer,
+};
+
+namespace dither {
+
+/**
+ * Map every pixel of an image to the nearest color of a palette. Colors are
+ * matched by red, green and blue through a table of 64 levels per channel,
+ * which fills in as the pixels need it. Floyd-Steinberg and Atkinson run on
+ * a wavefront, every row trails the row above it by a few pixels, so rows
+ * are diffused in parallel and the result does not depend on the threads.
+ * @param image pixels to map
+ * @param palette colors to map to
+ * @param paletteSize number of colors, 1 to 65536
+ * @param method dithering to use
+ * @param pool pool to run the rows on
+ * @return palette index of every pixel, row by row
+ */
+std::vector<uint16_t> remap(const Image& image, const Color* palette, std::size_t paletteSize, Dither method,
+                            ThreadPool& pool = ThreadPool::global());
+
+} // namespace dither
+
+} // namespace pixelmancy
@@ -38,4 +38,9 @@ ObjectType DrawableObject::getObjectType() const
     return ObjectType::CIRCLE;
 }
 
+Rect DrawableObject::getBoundingBox() const
+{
+    return {};
+}
+
 } // namespace pixelmancy::graphics
@@ -49,6 +49,12 @@ public:
     */
     virtual ObjectType getObjectType() const;
 
+    /**
+     * Get the area that drawOn() may touch, in drawing coordinates
+     * @return bounding box of the object, empty if the object draws nothing
+     */
+    virtual Rect getBoundingBox() const;
+
 protected:
     Point m_position = {0, 0};
     float m_angle = 0.0f;
@@ -0,0 +1,370 @@
+#include "Filters.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "Image.hpp"
+#include "Log.hpp"
+#include "Parallel.hpp"
+#include "kernels/Kernels.hpp"
+#include "profiler/Profiler.hpp"
+
+namespace pixelmancy::filters {
+
+namespace {
+
+constexpr int CHANNELS = 4;
+
+// a tile and the float rows around it stay in the L2 cache while the passes
+// run over them
+constexpr Grain TILE{64, 256};
+
+// buffers of the thread filtering a tile, reused between tiles
+struct Scratch
+{
+    std::vector<uint32_t> colors;
+    std::vector<float> source;
+    std::vector<float> rows;
+    std::vector<float> sums;
+    std::vector<float> gradient;
+};
+
+Scratch& scratch()
+{
+    thread_local Scratch buffers;
+    return buffers;
+}
+
+std::vector<uint32_t> packedPalette(const Image& image)
+{
+    std::vector<uint32_t> palette;
+    palette.reserve(image.getColorPalette().size());
+    for (const Color& color : image.getColorPalette().getColors())
+    {
+        palette.push_back(kernels::packRgba(color.red, color.green, color.blue, color.alpha));
+    }
+    return palette;
+}
+
+std::size_t length(int colors)
+{
+    return static_cast<std::size_t>(colors * CHANNELS);
+}
+
+// Load the columns [begin - radius, end + radius) of a source row as
+// channels. Rows and columns outside the image repeat the nearest edge.
+void loadRow(const Image& image, const std::vector<uint32_t>& palette, int row, int begin, int end, int radius,
+             Scratch& buffers)
+{
+    const kernels::KernelTable& kernel = kernels::active();
+    row = std::clamp(row, 0, image.getHeight() - 1);
+    const int width = end - begin + 2 * radius;
+    const int first = std::max(begin - radius, 0);
+    const int last = std::min(end + radius, image.getWidth());
+    const int offset = first - (begin - radius);
+
+    buffers.colors.resize(static_cast<std::size_t>(width));
+    uint32_t* colors = buffers.colors.data();
+    kernel.expandIndices(image.rowIndices(row) + first, static_cast<std::size_t>(last - first), palette.data(), colors + offset);
+    std::fill(colors, colors + offset, colors[offset]);
+    std::fill(colors + offset + (last - first), colors + width, colors[offset + (last - first) - 1]);
+
+    buffers.source.resize(length(width));
+    kernel.rgbaToChannels(colors, static_cast<std::size_t>(width), buffers.source.data());
+}
+
+// put the alpha of the source pixels back into filtered colors
+void keepAlpha(const Image& image, const std::vector<uint32_t>& palette, int row, int begin, int end, uint32_t* colors)
+{
+    const uint32_t alphaMask = kernels::packRgba(0, 0, 0, 255);
+    const uint16_t* indices = image.rowIndices(row);
+    for (int column = begin; column < end; column++)
+    {
+        uint32_t& color = colors[column - begin];
+        color = (color & ~alphaMask) | (palette[indices[column]] & alphaMask);
+    }
+}
+
+// Filter every tile into a buffer of colors and import it into the image,
+// the tiles only read the image
+template <typename F>
+void filterTiles(Image& image, ThreadPool& pool, F&& filterTile)
+{
+    if (image.isEmpty())
+    {
+        return;
+    }
+    const std::vector<uint32_t> palette = packedPalette(image);
+    std::vector<uint32_t> colors(image.size());
+    parallelFor(
+        image.bounds(), TILE,
+        [&](const graphics::Rect& tile) {
+            filterTile(palette, tile, colors.data());
+            P_PROFILE_COUNTER("filters.tiles", 1);
+        },
+        pool);
+
+    Image filtered(image.getWidth(), image.getHeight(), BLACK, image.resource());
+    filtered.importRgba(reinterpret_cast<const uint8_t*>(colors.data()));
+    image = std::move(filtered);
+}
+
+uint32_t* tileRow(uint32_t* colors, const Image& image, int row, int column)
+{
+    return colors + static_cast<std::size_t>(row) * static_cast<std::size_t>(image.getWidth()) +
+           static_cast<std::size_t>(column);
+}
+
+// the same symmetric weights along the rows and the columns
+void separableTile(const Image& image, const std::vector<uint32_t>& palette, const std::vector<float>& weights,
+                   const graphics::Rect& tile, uint32_t* colors)
+{
+    const kernels::KernelTable& kernel = kernels::active();
+    const int radius = static_cast<int>(weights.size() / 2);
+    const int width = tile.maxY - tile.minY;
+    const std::size_t rowLength = length(width);
+    const int sourceRows = tile.maxX - tile.minX + 2 * radius;
+    Scratch& buffers = scratch();
+
+    buffers.rows.assign(static_cast<std::size_t>(sourceRows) * rowLength, 0.0f);
+    for (int i = 0; i < sourceRows; i++)
+    {
+        loadRow(image, palette, tile.minX - radius + i, tile.minY, tile.maxY, radius, buffers);
+        float* row = buffers.rows.data() + static_cast<std::size_t>(i) * rowLength;
+        for (std::size_t tap = 0; tap < weights.size(); tap++)
+        {
+            kernel.accumulateChannels(row, buffers.source.data() + length(static_cast<int>(tap)), weights[tap], rowLength);
+        }
+    }
+
+    buffers.sums.resize(rowLength);
+    for (int row = tile.minX; row < tile.maxX; row++)
+    {
+        std::fill(buffers.sums.begin(), buffers.sums.end(), 0.0f);
+        const float* window = buffers.rows.data() + static_cast<std::size_t>(row - tile.minX) * rowLength;
+        for (std::size_t tap = 0; tap < weights.size(); tap++)
+        {
+            kernel.accumulateChannels(buffers.sums.data(), window + tap * rowLength, weights[tap], rowLength);
+        }
+        kernel.channelsToRgba(buffers.sums.data(), static_cast<std::size_t>(width), 1.0f,
+                              tileRow(colors, image, row, tile.minY));
+    }
+}
+
+// Channel values are whole numbers, so the window sums are exact and a tile
+// gives the same sums wherever its windows start
+void boxTile(const Image& image, const std::vector<uint32_t>& palette, int radius, const graphics::Rect& tile,
+             uint32_t* colors)
+{
+    const kernels::KernelTable& kernel = kernels::active();
+    const int size = 2 * radius + 1;
+    const int width = tile.maxY - tile.minY;
+    const std::size_t rowLength = length(width);
+    const int sourceRows = tile.maxX - tile.minX + 2 * radius;
+    Scratch& buffers = scratch();
+
+    buffers.rows.resize(static_cast<std::size_t>(sourceRows) * rowLength);
+    for (int i = 0; i < sourceRows; i++)
+    {
+        loadRow(image, palette, tile.minX - radius + i, tile.minY, tile.maxY, radius, buffers);
+        const float* source = buffers.source.data();
+        float* row = buffers.rows.data() + static_cast<std::size_t>(i) * rowLength;
+        float window[CHANNELS] = {};
+        for (int column = 0; column < size; column++)
+        {
+            for (int channel = 0; channel < CHANNELS; channel++)
+            {
+                window[channel] += source[column * CHANNELS + channel];
+            }
+        }
+        for (int column = 0; column < width; column++)
+        {
+            if (column > 0)
+            {
+                for (int channel = 0; channel < CHANNELS; channel++)
+                {
+                    window[channel] += source[(column + size - 1) * CHANNELS + channel] - source[(column - 1) * CHANNELS + channel];
+                }
+            }
+            std::copy(window, window + CHANNELS, row + column * CHANNELS);
+        }
+    }
+
+    const float scale = 1.0f / static_cast<float>(size * size);
+    buffers.sums.assign(rowLength, 0.0f);
+    for (int i = 0; i < size; i++)
+    {
+        kernel.accumulateChannels(buffers.sums.data(), buffers.rows.data() + static_cast<std::size_t>(i) * rowLength, 1.0f,
+                                  rowLength);
+    }
+    for (int row = tile.minX; row < tile.maxX; row++)
+    {
+        const auto offset = static_cast<std::size_t>(row - tile.minX);
+        if (row > tile.minX)
+        {
+            kernel.slideChannels(buffers.sums.data(), buffers.rows.data() + (offset + static_cast<std::size_t>(size) - 1) * rowLength,
+                                 buffers.rows.data() + (offset - 1) * rowLength, rowLength);
+        }
+        kernel.channelsToRgba(buffers.sums.data(), static_cast<std::size_t>(width), scale,
+                              tileRow(colors, image, row, tile.minY));
+    }
+}
+
+// load the padded source rows a square kernel of the given radius reads
+void loadTileRows(const Image& image, const std::vector<uint32_t>& palette, int radius, const graphics::Rect& tile,
+                  Scratch& buffers)
+{
+    const std::size_t paddedLength = length(tile.maxY - tile.minY + 2 * radius);
+    const int sourceRows = tile.maxX - tile.minX + 2 * radius;
+    buffers.rows.resize(static_cast<std::size_t>(sourceRows) * paddedLength);
+    for (int i = 0; i < sourceRows; i++)
+    {
+        loadRow(image, palette, tile.minX - radius + i, tile.minY, tile.maxY, radius, buffers);
+        std::copy(buffers.source.begin(), buffers.source.end(),
+                  buffers.rows.begin() + static_cast<std::ptrdiff_t>(static_cast<std::size_t>(i) * paddedLength));
+    }
+}
+
+// every weight adds a shifted source row, zero weights are skipped
+void convolveRow(const Kernel& filter, const Scratch& buffers, std::size_t paddedLength, int outputRow, std::size_t rowLength,
+                 float* sums)
+{
+    const kernels::KernelTable& kernel = kernels::active();
+    std::fill(sums, sums + rowLength, 0.0f);
+    for (int y = 0; y < filter.size; y++)
+    {
+        const float* source = buffers.rows.data() + static_cast<std::size_t>(outputRow + y) * paddedLength;
+        for (int x = 0; x < filter.size; x++)
+        {
+            const float weight = filter.weights[static_cast<std::size_t>(y * filter.size + x)];
+            if (weight != 0.0f)
+            {
+                kernel.accumulateChannels(sums, source + length(x), weight, rowLength);
+            }
+        }
+    }
+}
+
+bool isValid(const Kernel& kernel)
+{
+    return kernel.size > 0 && kernel.size % 2 == 1 &&
+           kernel.weights.size() == static_cast<std::size_t>(kernel.size) * static_cast<std::size_t>(kernel.size);
+}
+
+} // namespace
+
+Kernel Kernel::sharpen(float amount)
+{
+    return {3, {0.0f, -amount, 0.0f, -amount, 1.0f + 4.0f * amount, -amount, 0.0f, -amount, 0.0f}};
+}
+
+Kernel Kernel::sobelHorizontal()
+{
+    return {3, {-1.0f, 0.0f, 1.0f, -2.0f, 0.0f, 2.0f, -1.0f, 0.0f, 1.0f}};
+}
+
+Kernel Kernel::sobelVertical()
+{
+    return {3, {-1.0f, -2.0f, -1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 2.0f, 1.0f}};
+}
+
+void boxBlur(Image& image, int radius, ThreadPool& pool)
+{
+    P_PROFILE_SCOPE("filters::boxBlur");
+    if (radius > MAX_BOX_RADIUS)
+    {
+        P_LOGF_WARN("Box blur radius {} is larger than {}, using {}\n", radius, MAX_BOX_RADIUS, MAX_BOX_RADIUS);
+        radius = MAX_BOX_RADIUS;
+    }
+    if (radius <= 0)
+    {
+        return;
+    }
+    filterTiles(image, pool, [&image, radius](const std::vector<uint32_t>& palette, const graphics::Rect& tile, uint32_t* colors) {
+        boxTile(image, palette, radius, tile, colors);
+    });
+}
+
+void gaussianBlur(Image& image, float sigma, ThreadPool& pool)
+{
+    P_PROFILE_SCOPE("filters::gaussianBlur");
+    if (sigma <= 0.0f)
+    {
+        return;
+    }
+    const int radius = static_cast<int>(std::ceil(3.0f * sigma));
+    std::vector<float> weights(static_cast<std::size_t>(2 * radius + 1));
+    float total = 0.0f;
+    for (int i = -radius; i <= radius; i++)
+    {
+        const float weight = std::exp(-static_cast<float>(i * i) / (2.0f * sigma * sigma));
+        weights[static_cast<std::size_t>(i + radius)] = weight;
+        total += weight;
+    }
+    for (float& weight : weights)
+    {
+        weight /= total;
+    }
+    filterTiles(image, pool, [&image, &weights](const std::vector<uint32_t>& palette, const graphics::Rect& tile, uint32_t* colors) {
+        separableTile(image, palette, weights, tile, colors);
+    });
+}
+
+void convolve(Image& image, const Kernel& kernel, ThreadPool& pool)
+{
+    P_PROFILE_SCOPE("filters::convolve");
+    if (!isValid(kernel))
+    {
+        P_LOGF_ERROR("Convolution kernel of size {} with {} weights is not an odd square\n", kernel.size, kernel.weights.size());
+        return;
+    }
+    const int radius = kernel.size / 2;
+    filterTiles(image, pool, [&](const std::vector<uint32_t>& palette, const graphics::Rect& tile, uint32_t* colors) {
+        const int width = tile.maxY - tile.minY;
+        const std::size_t paddedLength = length(width + 2 * radius);
+        Scratch& buffers = scratch();
+        loadTileRows(image, palette, radius, tile, buffers);
+        buffers.sums.resize(length(width));
+        for (int row = tile.minX; row < tile.maxX; row++)
+        {
+            convolveRow(kernel, buffers, paddedLength, row - tile.minX, length(width), buffers.sums.data());
+            uint32_t* out = tileRow(colors, image, row, tile.minY);
+            kernels::active().channelsToRgba(buffers.sums.data(), static_cast<std::size_t>(width), 1.0f, out);
+            keepAlpha(image, palette, row, tile.minY, tile.maxY, out);
+        }
+    });
+}
+
+void sharpen(Image& image, float amount, ThreadPool& pool)
+{
+    convolve(image, Kernel::sharpen(amount), pool);
+}
+
+void sobel(Image& image, ThreadPool& pool)
+{
+    P_PROFILE_SCOPE("filters::sobel");
+    const Kernel horizontal = Kernel::sobelHorizontal();
+    const Kernel vertical = Kernel::sobelVertical();
+    filterTiles(image, pool, [&](const std::vector<uint32_t>& palette, const graphics::Rect& tile, uint32_t* colors) {
+        const kernels::KernelTable& kernel = kernels::active();
+        const int width = tile.maxY - tile.minY;
+        const std::size_t rowLength = length(width);
+        const std::size_t paddedLength = length(width + 2);
+        Scratch& buffers = scratch();
+        loadTileRows(image, palette, 1, tile, buffers);
+        buffers.sums.resize(rowLength);
+        buffers.gradient.resize(rowLength);
+        for (int row = tile.minX; row < tile.maxX; row++)
+        {
+            convolveRow(horizontal, buffers, paddedLength, row - tile.minX, rowLength, buffers.sums.data());
+            convolveRow(vertical, buffers, paddedLength, row - tile.minX, rowLength, buffers.gradient.data());
+            kernel.channelMagnitude(buffers.sums.data(), buffers.gradient.data(), rowLength, buffers.sums.data());
+            uint32_t* out = tileRow(colors, image, row, tile.minY);
+            kernel.channelsToRgba(buffers.sums.data(), static_cast<std::size_t>(width), 1.0f, out);
+            keepAlpha(image, palette, row, tile.minY, tile.maxY, out);
+        }
+    });
+}
+
+} // namespace pixelmancy::filters
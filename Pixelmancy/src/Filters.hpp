@@ -0,0 +1,87 @@
+#pragma once
+
+#include "ThreadPool.hpp"
+
+#include <vector>
+
+namespace pixelmancy {
+class Image;
+}
+
+namespace pixelmancy::filters {
+
+/**
+ * Square convolution kernel
+ */
+struct Kernel
+{
+    // odd number of rows and columns
+    int size = 0;
+    // size * size weights, row by row
+    std::vector<float> weights;
+
+    /**
+     * Sharpen by subtracting the four direct neighbours
+     * @param amount 0 keeps the image, larger values sharpen more
+     */
+    static Kernel sharpen(float amount = 1.0f);
+
+    /**
+     * Sobel kernel for the gradient along the columns
+     */
+    static Kernel sobelHorizontal();
+
+    /**
+     * Sobel kernel for the gradient along the rows
+     */
+    static Kernel sobelVertical();
+};
+
+/**
+ * Largest radius boxBlur() accepts, its window sums stay exact in floats
+ */
+constexpr int MAX_BOX_RADIUS = 127;
+
+/**
+ * Replace every pixel with the average of the square around it. The window
+ * sums slide over the rows and columns, so the cost does not grow with the
+ * radius.
+ * @param image image to blur, alpha is blurred too
+ * @param radius pixels on each side of the window, at most MAX_BOX_RADIUS
+ * @param pool pool to run the tiles on
+ */
+void boxBlur(Image& image, int radius, ThreadPool& pool = ThreadPool::global());
+
+/**
+ * Blur with a gaussian in a horizontal and a vertical pass
+ * @param image image to blur, alpha is blurred too
+ * @param sigma standard deviation in pixels, the kernel reaches 3 sigma
+ * @param pool pool to run the tiles on
+ */
+void gaussianBlur(Image& image, float sigma, ThreadPool& pool = ThreadPool::global());
+
+/**
+ * Convolve the red, green and blue channels with a kernel, alpha is kept.
+ * Pixels outside the image repeat the nearest edge pixel.
+ * @param image image to filter
+ * @param kernel kernel with an odd size
+ * @param pool pool to run the tiles on
+ */
+void convolve(Image& image, const Kernel& kernel, ThreadPool& pool = ThreadPool::global());
+
+/**
+ * Convolve with Kernel::sharpen()
+ * @param image image to sharpen
+ * @param amount 0 keeps the image, larger values sharpen more
+ * @param pool pool to run the tiles on
+ */
+void sharpen(Image& image, float amount = 1.0f, ThreadPool& pool = ThreadPool::global());
+
+/**
+ * Replace every channel with its Sobel gradient magnitude, alpha is kept
+ * @param image image to filter
+ * @param pool pool to run the tiles on
+ */
+void sobel(Image& image, ThreadPool& pool = ThreadPool::global());
+
+} // namespace pixelmancy::filters
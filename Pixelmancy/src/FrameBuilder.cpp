@@ -0,0 +1,225 @@
+#include "FrameBuilder.hpp"
+
+#include "Log.hpp"
+#include "profiler/Profiler.hpp"
+
+#include <algorithm>
+
+namespace pixelmancy {
+
+FrameBuilder::FrameBuilder(const Image& background) : m_background(background), m_frame(background)
+{
+}
+
+void FrameBuilder::setBackground(const Image& background)
+{
+    m_background = background;
+    m_fullRedraw = true;
+}
+
+std::size_t FrameBuilder::addObject(std::shared_ptr<graphics::DrawableObject> object)
+{
+    m_objects.push_back(std::move(object));
+    m_drawnBounds.emplace_back();
+    m_invalidated.push_back(true);
+    return m_objects.size() - 1;
+}
+
+void FrameBuilder::invalidate(std::size_t index)
+{
+    if (index >= m_invalidated.size())
+    {
+        P_LOG_WARN() << "Invalid object index " << index << "\n";
+        return;
+    }
+    m_invalidated[index] = true;
+}
+
+const Image& FrameBuilder::frame() const
+{
+    return m_frame;
+}
+
+const std::vector<graphics::Rect>& FrameBuilder::dirtyRects() const
+{
+    return m_dirtyRects;
+}
+
+std::optional<graphics::Rect> FrameBuilder::changedRegion() const
+{
+    if (m_redrewAll)
+    {
+        return std::nullopt;
+    }
+    graphics::Rect region;
+    for (const auto& rect : m_dirtyRects)
+    {
+        region = region.united(rect);
+    }
+    return region;
+}
+
+const Image& FrameBuilder::render()
+{
+    P_PROFILE_SCOPE("FrameBuilder::render");
+    if (m_fullRedraw || m_frame.bounds() != m_background.bounds())
+    {
+        redrawAll();
+        return m_frame;
+    }
+
+    m_redrewAll = false;
+    std::fill(m_dirtyTiles.begin(), m_dirtyTiles.end(), false);
+    std::vector<graphics::Rect> currentBounds;
+    currentBounds.reserve(m_objects.size());
+    for (std::size_t i = 0; i < m_objects.size(); i++)
+    {
+        currentBounds.push_back(m_objects[i]->getBoundingBox());
+        if (m_invalidated[i] || currentBounds[i] != m_drawnBounds[i])
+        {
+            markDirty(m_drawnBounds[i]);
+            markDirty(currentBounds[i]);
+        }
+    }
+
+    // redrawing an object may overwrite objects above it outside of the dirty
+    // area, so keep growing the area until it covers every redrawn object
+    std::vector<bool> redraw(m_objects.size(), false);
+    bool grown = true;
+    while (grown)
+    {
+        grown = false;
+        for (std::size_t i = 0; i < m_objects.size(); i++)
+        {
+            if (!redraw[i] && isDirty(currentBounds[i]))
+            {
+                redraw[i] = true;
+                grown = markDirty(currentBounds[i]) || grown;
+            }
+        }
+    }
+    collectDirtyRects();
+
+    for (const auto& rect : m_dirtyRects)
+    {
+        m_frame.copyRegion(m_background, rect);
+    }
+    for (std::size_t i = 0; i < m_objects.size(); i++)
+    {
+        if (redraw[i])
+        {
+            m_objects[i]->drawOn(m_frame);
+        }
+        m_drawnBounds[i] = currentBounds[i];
+        m_invalidated[i] = false;
+    }
+    return m_frame;
+}
+
+void FrameBuilder::redrawAll()
+{
+    m_frame = m_background;
+    for (std::size_t i = 0; i < m_objects.size(); i++)
+    {
+        m_objects[i]->drawOn(m_frame);
+        m_drawnBounds[i] = m_objects[i]->getBoundingBox();
+        m_invalidated[i] = false;
+    }
+    m_tileRows = (m_frame.getHeight() + DIRTY_TILE_SIZE - 1) / DIRTY_TILE_SIZE;
+    m_tileColumns = (m_frame.getWidth() + DIRTY_TILE_SIZE - 1) / DIRTY_TILE_SIZE;
+    m_dirtyTiles.assign(static_cast<std::size_t>(m_tileRows * m_tileColumns), false);
+    m_dirtyRects.assign(1, m_frame.bounds());
+    m_fullRedraw = false;
+    m_redrewAll = true;
+}
+
+graphics::Rect FrameBuilder::tilesOf(const graphics::Rect& rect) const
+{
+    const graphics::Rect clipped = rect.intersected(m_frame.bounds());
+    if (clipped.isEmpty())
+    {
+        return {};
+    }
+    return {clipped.minX / DIRTY_TILE_SIZE, clipped.minY / DIRTY_TILE_SIZE, (clipped.maxX - 1) / DIRTY_TILE_SIZE + 1,
+            (clipped.maxY - 1) / DIRTY_TILE_SIZE + 1};
+}
+
+// returns true when at least one of the tiles was not dirty before
+bool FrameBuilder::markDirty(const graphics::Rect& rect)
+{
+    const graphics::Rect tiles = tilesOf(rect);
+    bool marked = false;
+    for (int row = tiles.minX; row < tiles.maxX; row++)
+    {
+        for (int column = tiles.minY; column < tiles.maxY; column++)
+        {
+            const auto index = static_cast<std::size_t>(row * m_tileColumns + column);
+            marked = marked || !m_dirtyTiles[index];
+            m_dirtyTiles[index] = true;
+        }
+    }
+    return marked;
+}
+
+bool FrameBuilder::isDirty(const graphics::Rect& rect) const
+{
+    const graphics::Rect tiles = tilesOf(rect);
+    for (int row = tiles.minX; row < tiles.maxX; row++)
+    {
+        for (int column = tiles.minY; column < tiles.maxY; column++)
+        {
+            if (m_dirtyTiles[static_cast<std::size_t>(row * m_tileColumns + column)])
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// turn runs of dirty tiles into rectangles, a run continues the rectangle of
+// the row above when it covers the same columns
+void FrameBuilder::collectDirtyRects()
+{
+    m_dirtyRects.clear();
+    std::vector<std::size_t> openRects;
+    std::vector<std::size_t> rowRects;
+    for (int row = 0; row < m_tileRows; row++)
+    {
+        rowRects.clear();
+        int column = 0;
+        while (column < m_tileColumns)
+        {
+            if (!m_dirtyTiles[static_cast<std::size_t>(row * m_tileColumns + column)])
+            {
+                column++;
+                continue;
+            }
+            const int begin = column;
+            while (column < m_tileColumns && m_dirtyTiles[static_cast<std::size_t>(row * m_tileColumns + column)])
+            {
+                column++;
+            }
+            const graphics::Rect run =
+                graphics::Rect(row * DIRTY_TILE_SIZE, begin * DIRTY_TILE_SIZE, (row + 1) * DIRTY_TILE_SIZE, column * DIRTY_TILE_SIZE)
+                    .intersected(m_frame.bounds());
+
+            auto above = std::find_if(openRects.begin(), openRects.end(), [&](std::size_t index) {
+                return m_dirtyRects[index].minY == run.minY && m_dirtyRects[index].maxY == run.maxY;
+            });
+            if (above != openRects.end())
+            {
+                m_dirtyRects[*above].maxX = run.maxX;
+                rowRects.push_back(*above);
+            }
+            else
+            {
+                m_dirtyRects.push_back(run);
+                rowRects.push_back(m_dirtyRects.size() - 1);
+            }
+        }
+        std::swap(openRects, rowRects);
+    }
+}
+
+} // namespace pixelmancy
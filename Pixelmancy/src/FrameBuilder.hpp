@@ -0,0 +1,90 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "CommonConfig.hpp"
+#include "DrawableObject.hpp"
+#include "Image.hpp"
+#include "Rect.hpp"
+
+namespace pixelmancy {
+
+/**
+ * FrameBuilder class that renders animation frames on a static background.
+ * Instead of copying the whole background for every frame, it remembers where
+ * each object was drawn, restores only the areas that changed and redraws the
+ * objects that overlap them. Moving, rotating or resizing an object is picked
+ * up from its bounding box, other changes (e.g. a new fill color) must be
+ * reported with invalidate(). Dirty areas are tracked on a grid of
+ * DIRTY_TILE_SIZE pixel tiles, so the cost does not grow with the number of
+ * overlapping rectangles.
+ */
+class FrameBuilder
+{
+public:
+    explicit FrameBuilder(const Image& background);
+
+    /**
+     * Replace the background, the next render() redraws the whole frame
+     * @param background new background image
+     */
+    void setBackground(const Image& background);
+
+    /**
+     * Add an object on top of the objects added before
+     * @param object object to draw on every frame
+     * @return index of the object
+     */
+    std::size_t addObject(std::shared_ptr<graphics::DrawableObject> object);
+
+    /**
+     * Mark an object as changed even if its bounding box is the same
+     * @param index index returned by addObject()
+     */
+    void invalidate(std::size_t index);
+
+    /**
+     * Bring the frame up to date with the current state of the objects
+     * @return the rendered frame
+     */
+    const Image& render();
+
+    /**
+     * Get the last rendered frame
+     */
+    const Image& frame() const;
+
+    /**
+     * Get the rectangles that were restored and redrawn by the last render()
+     */
+    const std::vector<graphics::Rect>& dirtyRects() const;
+
+    /**
+     * Get the area that changed in the last render()
+     * @return bounding box of the dirty rectangles, std::nullopt when the whole frame was redrawn
+     */
+    std::optional<graphics::Rect> changedRegion() const;
+
+private:
+    void redrawAll();
+    bool markDirty(const graphics::Rect& rect);
+    bool isDirty(const graphics::Rect& rect) const;
+    graphics::Rect tilesOf(const graphics::Rect& rect) const;
+    void collectDirtyRects();
+
+    Image m_background;
+    Image m_frame;
+    std::vector<std::shared_ptr<graphics::DrawableObject>> m_objects;
+    std::vector<graphics::Rect> m_drawnBounds;
+    std::vector<bool> m_invalidated;
+    std::vector<graphics::Rect> m_dirtyRects;
+    std::vector<bool> m_dirtyTiles;
+    int m_tileRows = 0;
+    int m_tileColumns = 0;
+    bool m_fullRedraw = true;
+    bool m_redrewAll = true;
+};
+
+} // namespace pixelmancy
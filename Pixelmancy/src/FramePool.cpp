@@ -0,0 +1,40 @@
+#include "FramePool.hpp"
+
+namespace pixelmancy {
+
+FramePool::FramePool(int width, int height, const Color& background, std::size_t capacity)
+ : m_width(width), m_height(height), m_background(background), m_capacity(capacity)
+{
+}
+
+Image FramePool::acquire()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_idleFrames.empty())
+        {
+            Image frame = std::move(m_idleFrames.back());
+            m_idleFrames.pop_back();
+            frame.reset(m_width, m_height, m_background);
+            return frame;
+        }
+    }
+    return Image(m_width, m_height, m_background);
+}
+
+void FramePool::release(Image&& frame)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_idleFrames.size() < m_capacity)
+    {
+        m_idleFrames.push_back(std::move(frame));
+    }
+}
+
+std::size_t FramePool::available() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_idleFrames.size();
+}
+
+} // namespace pixelmancy
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <mutex>
+#include <vector>
+
+#include "Image.hpp"
+#include "colors/Color.hpp"
+
+namespace pixelmancy {
+
+/**
+ * FramePool class that recycles frame images of one size. Released images
+ * keep their pixel buffer and palette tables, so acquiring a frame after the
+ * first few does not allocate. The pool can be shared between threads.
+ */
+class FramePool
+{
+public:
+    /**
+     * @param width width of the frames
+     * @param height height of the frames
+     * @param background color of a freshly acquired frame
+     * @param capacity maximum number of idle frames kept, extra frames are freed
+     */
+    FramePool(int width, int height, const Color& background = BLACK, std::size_t capacity = DEFAULT_CAPACITY);
+
+    /**
+     * Get a blank frame, recycled when possible
+     */
+    Image acquire();
+
+    /**
+     * Give a frame back to the pool
+     * @param frame frame that is no longer used
+     */
+    void release(Image&& frame);
+
+    /**
+     * Get the number of idle frames in the pool
+     */
+    std::size_t available() const;
+
+    static constexpr std::size_t DEFAULT_CAPACITY = 64;
+
+private:
+    int m_width = 0;
+    int m_height = 0;
+    Color m_background;
+    std::size_t m_capacity = DEFAULT_CAPACITY;
+    std::vector<Image> m_idleFrames;
+    mutable std::mutex m_mutex;
+};
+
+} // namespace pixelmancy
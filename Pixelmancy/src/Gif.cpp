@@ -1,15 +1,146 @@
 #include "Gif.hpp"
+#include <algorithm>
 #include <cstddef>
+#include <fstream>
+#include <optional>
+#include <unordered_map>
+#include <vector>
 
+#include "ByteSink.hpp"
 #include "Common.hpp"
 #include "CommonConfig.hpp"
+#include "Dither.hpp"
+#include "FramePool.hpp"
+#include "GifStreamWriter.hpp"
 #include "Log.hpp"
+#include "Parallel.hpp"
+#include "ScopedArena.hpp"
 #include "colors/ColorMatcher.hpp"
+#include "kernels/Kernels.hpp"
+#include "profiler/Profiler.hpp"
 
 namespace pixelmancy {
 
-Gif::Gif(std::shared_ptr<ColorMatcher> colorMatcher)
- : m_colorMatcher(colorMatcher), m_globalPallette(std::make_unique<ColorPallette>()), m_globalToReducedColorMap(std::make_unique<IndexMap>())
+namespace {
+// rows remapped by one task, small frames stay on one thread
+constexpr int REMAP_GRAIN_PIXELS = 16384;
+
+uint16_t mappedIndex(const IndexMap& map, uint16_t index)
+{
+    const auto it = map.find(index);
+    return it == map.end() ? 0 : it->second;
+}
+
+constexpr int NOT_IN_TABLE = -1;
+// pixels an LZW code spans on average, only used to compare estimates
+constexpr std::size_t ESTIMATED_PIXELS_PER_CODE = 4;
+constexpr std::size_t MAX_LZW_CODE = 4096;
+
+// bits of an index of a color table, a GIF table has at least two colors
+int tableBits(std::size_t colors)
+{
+    int bits = 1;
+    while ((std::size_t{1} << bits) < colors)
+    {
+        bits++;
+    }
+    return bits;
+}
+
+// Estimated bytes of a frame. The parse of the LZW codes does not depend on
+// the table, but the codes widen from the initial code size to 12 bits in
+// every dictionary, and a local table is written with the frame.
+std::size_t estimatedFrameBytes(std::size_t pixels, std::size_t colors, bool localTable)
+{
+    const int rootBits = std::max(2, tableBits(colors));
+    const std::size_t firstCode = (std::size_t{1} << rootBits) + 2;
+    std::size_t codes = pixels / ESTIMATED_PIXELS_PER_CODE + 1;
+    std::size_t code = firstCode;
+    std::size_t bits = 0;
+    while (codes > 0)
+    {
+        int width = rootBits + 1;
+        while ((std::size_t{1} << width) <= code)
+        {
+            width++;
+        }
+        const std::size_t taken = std::min(codes, std::min(std::size_t{1} << width, MAX_LZW_CODE) - code);
+        bits += taken * static_cast<std::size_t>(width);
+        codes -= taken;
+        code += taken;
+        if (code == MAX_LZW_CODE)
+        {
+            code = firstCode;
+        }
+    }
+    const std::size_t tableBytes = localTable ? 3 * (std::size_t{1} << tableBits(colors)) : 0;
+    return bits / 8 + tableBytes;
+}
+
+// global palette indices of the colors the pixels use, in ascending order
+std::vector<uint16_t> usedColors(const Image& image, const IndexMap& localToGlobal, bool coversCanvas)
+{
+    std::vector<uint8_t> used(image.getColorPalette().size(), 0);
+    for (int row = 0; row < image.getHeight(); row++)
+    {
+        const uint16_t* indices = image.rowIndices(row);
+        for (int column = 0; column < image.getWidth(); column++)
+        {
+            if (indices[column] < used.size())
+            {
+                used[indices[column]] = 1;
+            }
+        }
+    }
+    std::vector<uint16_t> colors;
+    if (!coversCanvas)
+    {
+        // the rest of the canvas is left at index 0
+        colors.push_back(0);
+    }
+    for (std::size_t localIndex = 0; localIndex < used.size(); localIndex++)
+    {
+        if (used[localIndex] != 0)
+        {
+            colors.push_back(mappedIndex(localToGlobal, static_cast<uint16_t>(localIndex)));
+        }
+    }
+    std::sort(colors.begin(), colors.end());
+    colors.erase(std::unique(colors.begin(), colors.end()), colors.end());
+    return colors;
+}
+
+// new index of every table index, indices left out of the order go to 0
+std::vector<uint32_t> newIndices(const std::vector<uint16_t>& order, std::size_t tableColors)
+{
+    std::vector<uint32_t> indices(tableColors, 0);
+    for (std::size_t i = 0; i < order.size(); i++)
+    {
+        indices[order[i]] = static_cast<uint32_t>(i);
+    }
+    return indices;
+}
+
+// the RGB entries of the order, in that order
+template <typename Table>
+Table reorderedTable(const Table& table, const std::vector<uint16_t>& order)
+{
+    Table reordered(table.get_allocator());
+    reordered.reserve(order.size() * 3);
+    for (const uint16_t entry : order)
+    {
+        reordered.insert(reordered.end(), table.begin() + entry * 3, table.begin() + entry * 3 + 3);
+    }
+    return reordered;
+}
+} // namespace
+
+Gif::Gif(std::shared_ptr<ColorMatcher> colorMatcher, std::pmr::memory_resource* resource)
+ : m_resource(resource),
+   m_colorMatcher(colorMatcher),
+   m_localToGlobalMappings(resource),
+   _frames(resource),
+   m_globalPallette(std::make_unique<ColorPallette>(resource))
 {
 }
 
@@ -18,56 +149,90 @@ Gif::~Gif()
     close();
 }
 
-void Gif::close()
+bool Gif::close()
 {
+    bool closed = true;
+    if (m_streamWriter)
+    {
+        P_PROFILE_SCOPE("GifStreamWriter::close");
+        closed = m_streamWriter->close();
+        m_saveStats.error = m_streamWriter->stats();
+        m_streamWriter.reset();
+    }
     if (pGIF)
     {
-        cgif_close(pGIF);
+        P_PROFILE_SCOPE("cgif_close");
+        closed = cgif_close(pGIF) == 0;
         pGIF = nullptr;
     }
-    m_localToGlobalMappings.clear();
+    return closed;
 }
 
-int Gif::init(const std::string& filePath)
+int Gif::init(ByteSink& sink, std::pmr::vector<uint8_t>& globalTable, int quality)
 {
-    char* file_path = const_cast<char*>(filePath.c_str());
+    P_PROFILE_SCOPE("Gif::init");
     CGIF_Config gConfig;
-    auto numColors = static_cast<uint16_t>(m_globalPallette->size());
-    if (numColors > MAX_COLORS_SUPPORTED_IN_GIF)
+    const auto numColors = static_cast<uint16_t>(globalTable.size() / 3);
+    // cgif only encodes lossless
+    if (threadPool().size() > 1 || quality < LOSSLESS_QUALITY)
     {
-        numColors = static_cast<uint16_t>(reduceGlobalColorPalette());
+        m_streamWriter = std::make_unique<GifStreamWriter>(threadPool());
+        if (!m_streamWriter->open(sink, static_cast<uint16_t>(_width), static_cast<uint16_t>(_height), globalTable.data(),
+                                  numColors, quality))
+        {
+            m_streamWriter.reset();
+            P_LOG_ERROR() << "Failed to create gif" << "\n";
+            return -1;
+        }
+        return 0;
     }
-    uint8_t* pallet = getPaletteData();
-    initGIFConfig(&gConfig, file_path, static_cast<uint16_t>(_width), static_cast<uint16_t>(_height), pallet, numColors);
+    initGIFConfig(&gConfig, &sink, static_cast<uint16_t>(_width), static_cast<uint16_t>(_height), globalTable.data(), numColors);
     pGIF = cgif_newgif(&gConfig);
     if (pGIF == nullptr)
     {
         P_LOG_ERROR() << "Failed to create gif" << "\n";
-        delete[] pallet;
         return -1;
     }
-    delete[] pallet;
     return 0;
 }
 
-std::size_t Gif::reduceGlobalColorPalette()
+void Gif::addFrame(const Image& frame, uint16_t delay)
 {
-    std::vector<Color> Colors = m_globalPallette->getColors();
-    m_reducedGlobalPallette = std::make_unique<ColorPallette>();
+    updateSize(frame);
+    _frames.push_back({delay, copyFrame(frame)});
+    _frames.push_back({delay, copyFrame(frame)});
+    mergeFramePalette(frame);
+}
 
-    int index = 0;
-    for (auto& clr : Colors)
-    {
-        auto const& nearestClr = m_colorMatcher->getNearestColor(clr);
-        auto const newMappedIndex = m_reducedGlobalPallette->addColor(nearestClr);
-        m_globalToReducedColorMap->insert(std::make_pair(index, newMappedIndex));
-        index++;
-    }
-    m_colorReduced = true;
-    return m_reducedGlobalPallette->size();
+void Gif::addFrame(Image&& frame, uint16_t delay)
+{
+    updateSize(frame);
+    _frames.push_back({delay, copyFrame(frame)});
+    _frames.push_back({delay, std::move(frame)});
+    mergeFramePalette(_frames.back().image);
 }
 
-void Gif::addFrame(const Image& frame, uint16_t delay)
+void Gif::setFramePool(std::shared_ptr<FramePool> framePool)
+{
+    m_framePool = std::move(framePool);
+}
+
+void Gif::setThreadPool(ThreadPool& threadPool)
+{
+    m_threadPool = &threadPool;
+}
+
+void Gif::setDither(Dither dither)
+{
+    m_dither = dither;
+}
+
+ThreadPool& Gif::threadPool() const
+{
+    return m_threadPool != nullptr ? *m_threadPool : ThreadPool::global();
+}
+
+void Gif::updateSize(const Image& frame)
 {
     if (_width < frame.getWidth())
     {
@@ -77,117 +242,471 @@ void Gif::addFrame(const Image& frame, uint16_t delay)
     {
         _height = frame.getHeight();
     }
-    _frames.push_back({delay, frame});
-    _frames.push_back({delay, frame});
 }
 
-bool Gif::save(const std::string& filePath)
+// merge while the frame is added, so it overlaps with rendering the next frames
+void Gif::mergeFramePalette(const Image& frame)
 {
-    globalColorPaletteGeneration();
-    m_globalPallette->convertToRGBfromRGBA();
-    int result = init(filePath);
-    if (result != 0)
+    P_PROFILE_SCOPE("Gif::mergeFramePalette");
+    IndexMapPtr localToGlobalColorMap = m_globalPallette->merge(frame.getColorPalette(), m_resource);
+    m_localToGlobalMappings.push_back(std::make_unique<IndexMap>(*localToGlobalColorMap, m_resource));
+    m_localToGlobalMappings.push_back(std::move(localToGlobalColorMap));
+}
+
+Image Gif::copyFrame(const Image& frame)
+{
+    if (!m_framePool)
     {
-        P_LOG_ERROR() << "Failed to initialize GIF encoder. Exiting without saving GIF" << "\n";
-        return false;
+        return Image(frame, m_resource);
     }
-    loadFrames();
-    close();
-    return result == 0;
+    // copy assignment reuses the buffers of the recycled image
+    Image copy = m_framePool->acquire();
+    copy = frame;
+    return copy;
 }
 
-void Gif::globalColorPaletteGeneration()
+void Gif::releaseFrames()
 {
     for (auto& frame : _frames)
     {
-        const auto& palette = frame.image.getColorPalette();
-        IndexMapPtr localToGlobalColorMap = m_globalPallette->merge(palette);
-        m_localToGlobalMappings.push_back(std::move(localToGlobalColorMap));
+        // frames handed to the encoder were released by loadFrames()
+        if (frame.image.size() != 0)
+        {
+            m_framePool->release(std::move(frame.image));
+        }
+    }
+    _frames.clear();
+    m_localToGlobalMappings.clear();
+}
+
+void Gif::addFrame(const Image& frame, uint16_t delay, const graphics::Rect& changedRegion)
+{
+    addFrame(frame, delay);
+    // the second copy of the frame is identical to the first one
+    _frames[_frames.size() - 2].changedRegion = changedRegion;
+    _frames.back().changedRegion = graphics::Rect();
+}
+
+bool Gif::save(const std::string& filePath, int quality, PaletteOrder order)
+{
+    std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        P_LOGF_ERROR("Cannot open {} for writing\n", filePath);
+        return false;
     }
+    ByteSink sink(file);
+    const bool saved = save(sink, quality, order);
+    file.close();
+    return saved && !file.fail();
+}
+
+std::vector<uint8_t> Gif::saveToBuffer(int quality, PaletteOrder order)
+{
+    std::vector<uint8_t> buffer;
+    ByteSink sink(buffer);
+    if (!save(sink, quality, order))
+    {
+        buffer.clear();
+    }
+    return buffer;
+}
+
+bool Gif::save(ByteSink& sink, int quality, PaletteOrder order)
+{
+    P_PROFILE_SCOPE("Gif::save");
     P_LOG_DEBUG() << "Global Color palette size: " << m_globalPallette->size() << "\n";
+    {
+        P_PROFILE_SCOPE("Gif::convertPalette");
+        m_globalPallette->convertToRGBfromRGBA();
+    }
+    // palette data and frame buffers are only needed while saving
+    ScopedArena scratch;
+    m_saveStats = {};
+    std::pmr::vector<uint8_t> globalTable(scratch.resource());
+    std::vector<FramePalette> palettes = planPalettes(globalTable);
+    if (order == PaletteOrder::ByUsage)
+    {
+        sortTables(palettes, globalTable);
+    }
+    int result = init(sink, globalTable, quality);
+    if (result != 0)
+    {
+        P_LOG_ERROR() << "Failed to initialize GIF encoder. Exiting without saving GIF" << "\n";
+        return false;
+    }
+    loadFrames(scratch.resource(), palettes);
+    // frames that failed to encode leave the file unfinished
+    const bool closed = close();
+    if (quality >= LOSSLESS_QUALITY)
+    {
+        m_saveStats.error = {};
+    }
+    m_saveStats.compressedBytes = sink.bytesWritten();
+    P_PROFILE_COUNTER("gif.bytesEncoded", m_saveStats.compressedBytes);
+    P_PROFILE_COUNTER("gif.lossyPixels", m_saveStats.error.changedPixels);
+    if (m_framePool)
+    {
+        releaseFrames();
+    }
+    return closed && !sink.failed();
+}
+
+const GifSaveStats& Gif::saveStats() const
+{
+    return m_saveStats;
 }
 
-void Gif::initGIFConfig(CGIF_Config* pConfig, char* path, uint16_t width, uint16_t height, uint8_t* pPalette, uint16_t numColors)
+void Gif::initGIFConfig(CGIF_Config* pConfig, ByteSink* sink, uint16_t width, uint16_t height, uint8_t* pPalette, uint16_t numColors)
 {
     memset(pConfig, 0, sizeof(CGIF_Config));
     pConfig->width = width;
     pConfig->height = height;
     pConfig->pGlobalPalette = pPalette;
     pConfig->numGlobalPaletteEntries = numColors;
-    pConfig->path = path;
+    pConfig->pWriteFn = ByteSink::writeCallback;
+    pConfig->pContext = sink;
     pConfig->attrFlags = CGIF_ATTR_IS_ANIMATED;
 }
 
-uint8_t* Gif::getPaletteData()
+// The global table holds every color if they fit, otherwise the colors of
+// the frames in order as long as they fit. Every frame then takes the global
+// table or a local table of its own colors, whichever is estimated smaller.
+std::vector<Gif::FramePalette> Gif::planPalettes(std::pmr::vector<uint8_t>& globalTable) const
 {
-    uint16_t numColors = static_cast<uint16_t>(m_globalPallette->size());
-    if (m_colorReduced)
+    P_PROFILE_SCOPE("Gif::planPalettes");
+    ThreadPool& pool = threadPool();
+    std::vector<std::vector<uint16_t>> used(_frames.size());
     {
-        numColors = static_cast<uint16_t>(m_reducedGlobalPallette->size());
+        TaskGroup group(pool);
+        for (std::size_t i = 0; i < _frames.size(); i++)
+        {
+            group.run([this, i, &used]() {
+                const Image& image = _frames[i].image;
+                const bool coversCanvas = image.getWidth() == _width && image.getHeight() == _height;
+                used[i] = usedColors(image, *m_localToGlobalMappings[i], coversCanvas);
+            });
+        }
+        group.wait();
     }
-    std::vector<uint8_t> aPalette;
-    if (m_colorReduced)
+
+    const std::pmr::vector<Color>& colors = m_globalPallette->getColors();
+    std::vector<int> tableIndex(colors.size(), NOT_IN_TABLE);
+    std::vector<uint16_t> table;
+    auto addToTable = [&tableIndex, &table](uint16_t globalIndex) {
+        if (tableIndex[globalIndex] == NOT_IN_TABLE)
+        {
+            tableIndex[globalIndex] = static_cast<int>(table.size());
+            table.push_back(globalIndex);
+        }
+    };
+    if (colors.size() <= MAX_COLORS_SUPPORTED_IN_GIF)
     {
-        aPalette = m_reducedGlobalPallette->getPaletteData();
+        for (std::size_t globalIndex = 0; globalIndex < colors.size(); globalIndex++)
+        {
+            addToTable(static_cast<uint16_t>(globalIndex));
+        }
     }
     else
     {
-        aPalette = m_globalPallette->getPaletteData();
+        // frames smaller than the canvas leave the rest at index 0
+        addToTable(0);
+        for (const std::vector<uint16_t>& frameColors : used)
+        {
+            const auto missing = static_cast<std::size_t>(std::count_if(
+                frameColors.begin(), frameColors.end(), [&tableIndex](uint16_t color) { return tableIndex[color] == NOT_IN_TABLE; }));
+            if (table.size() + missing <= MAX_COLORS_SUPPORTED_IN_GIF)
+            {
+                std::for_each(frameColors.begin(), frameColors.end(), addToTable);
+            }
+        }
     }
-    uint8_t* pallet = new uint8_t[numColors * 3];
-    auto endPoint = static_cast<uint16_t>(numColors * 3);
-    for (std::size_t i = 0; i < endPoint; i++)
+    globalTable.clear();
+    for (uint16_t globalIndex : table)
     {
-        pallet[i] = aPalette[i];
+        globalTable.insert(globalTable.end(), {colors[globalIndex].red, colors[globalIndex].green, colors[globalIndex].blue});
     }
-    return pallet;
+
+    std::vector<FramePalette> palettes(_frames.size());
+    TaskGroup group(pool);
+    for (std::size_t i = 0; i < _frames.size(); i++)
+    {
+        group.run([this, i, &used, &tableIndex, &table, &palettes]() {
+            const std::vector<uint16_t>& frameColors = used[i];
+            const bool inTable = std::all_of(frameColors.begin(), frameColors.end(),
+                                             [&tableIndex](uint16_t color) { return tableIndex[color] != NOT_IN_TABLE; });
+            const std::size_t pixels = _frames[i].image.size();
+            if (!inTable || estimatedFrameBytes(pixels, frameColors.size(), true) < estimatedFrameBytes(pixels, table.size(), false))
+            {
+                palettes[i] = localPalette(i, frameColors);
+                return;
+            }
+            const IndexMap& localToGlobal = *m_localToGlobalMappings[i];
+            std::vector<uint32_t>& lookup = palettes[i].lookup;
+            lookup.resize(_frames[i].image.getColorPalette().size());
+            for (std::size_t localIndex = 0; localIndex < lookup.size(); localIndex++)
+            {
+                // colors the pixels do not use may be missing from the table
+                const int index = tableIndex[mappedIndex(localToGlobal, static_cast<uint16_t>(localIndex))];
+                lookup[localIndex] = index == NOT_IN_TABLE ? 0u : static_cast<uint32_t>(index);
+            }
+        });
+    }
+    group.wait();
+    return palettes;
 }
 
-void Gif::initFrameConfig(CGIF_FrameConfig* pConfig, std::vector<uint8_t>& imageDataVec, uint16_t delay)
+// The LZW parse does not depend on the indices, so the order itself only
+// matters to tools that filter or recompress the indices. What makes frames
+// smaller is the global table losing the entries no pixel uses, its codes
+// may get a bit narrower. Every table is then ordered by PaletteUsage, and
+// the lookups are changed with it, so the frames are still remapped in one
+// table pass.
+void Gif::sortTables(std::vector<FramePalette>& palettes, std::pmr::vector<uint8_t>& globalTable) const
+{
+    P_PROFILE_SCOPE("Gif::sortTables");
+    ThreadPool& pool = threadPool();
+    const std::size_t canvasPixels = static_cast<std::size_t>(_width) * static_cast<std::size_t>(_height);
+    auto countFrame = [this, canvasPixels, &palettes](std::size_t i, PaletteUsage& usage) {
+        const Image& image = _frames[i].image;
+        usage.addImage(image, palettes[i].lookup.data());
+        usage.addPixels(palettes[i].background, canvasPixels - image.size());
+    };
+    auto relabel = [](FramePalette& palette, const std::vector<uint32_t>& indices) {
+        for (uint32_t& index : palette.lookup)
+        {
+            index = indices[index];
+        }
+        palette.background = static_cast<uint8_t>(indices[palette.background]);
+    };
+
+    std::vector<std::size_t> globalFrames;
+    TaskGroup group(pool);
+    for (std::size_t i = 0; i < palettes.size(); i++)
+    {
+        if (palettes[i].localTable.empty())
+        {
+            globalFrames.push_back(i);
+            continue;
+        }
+        if (!palettes[i].pixels.empty())
+        {
+            // dithered frames keep the order of their table
+            continue;
+        }
+        group.run([i, &palettes, &countFrame, &relabel]() {
+            FramePalette& palette = palettes[i];
+            const std::size_t localColors = palette.localTable.size() / 3;
+            PaletteUsage usage(localColors);
+            countFrame(i, usage);
+            const std::vector<uint16_t> order = usage.order();
+            palette.localTable = reorderedTable(palette.localTable, order);
+            relabel(palette, newIndices(order, localColors));
+        });
+    }
+    // the frames of the global table are counted in a few parts, which are
+    // added in order afterwards
+    const std::size_t tableColors = globalTable.size() / 3;
+    const std::size_t parts = std::min(pool.size(), globalFrames.size());
+    std::vector<PaletteUsage> partUsage(parts, PaletteUsage(tableColors));
+    for (std::size_t part = 0; part < parts; part++)
+    {
+        group.run([part, parts, &globalFrames, &partUsage, &countFrame]() {
+            for (std::size_t i = part; i < globalFrames.size(); i += parts)
+            {
+                countFrame(globalFrames[i], partUsage[part]);
+            }
+        });
+    }
+    group.wait();
+
+    PaletteUsage usage(tableColors);
+    for (const PaletteUsage& part : partUsage)
+    {
+        usage.add(part);
+    }
+    const std::vector<uint16_t> order = usage.order();
+    if (order.empty())
+    {
+        // no frame uses the global table
+        return;
+    }
+    globalTable = reorderedTable(globalTable, order);
+    const std::vector<uint32_t> indices = newIndices(order, tableColors);
+    for (const std::size_t i : globalFrames)
+    {
+        relabel(palettes[i], indices);
+    }
+}
+
+// A table of the colors of the frame, or of their nearest colors if there
+// are too many of them
+Gif::FramePalette Gif::localPalette(std::size_t frameIndex, const std::vector<uint16_t>& usedColors) const
+{
+    const std::pmr::vector<Color>& colors = m_globalPallette->getColors();
+    const bool quantize = usedColors.size() > MAX_COLORS_SUPPORTED_IN_GIF;
+    // position in the local table of every used color, in the order of usedColors
+    std::vector<uint8_t> position(usedColors.size());
+    FramePalette palette;
+    std::unordered_map<Color, uint8_t> tableColors;
+    for (std::size_t i = 0; i < usedColors.size(); i++)
+    {
+        const Color& color = quantize ? m_colorMatcher->getNearestColor(colors[usedColors[i]]) : colors[usedColors[i]];
+        const auto [it, added] = tableColors.emplace(color, static_cast<uint8_t>(tableColors.size()));
+        if (added)
+        {
+            palette.localTable.insert(palette.localTable.end(), {color.red, color.green, color.blue});
+        }
+        position[i] = it->second;
+    }
+
+    if (quantize && m_dither != Dither::None)
+    {
+        std::vector<Color> table;
+        for (std::size_t i = 0; i < palette.localTable.size(); i += 3)
+        {
+            table.emplace_back(palette.localTable[i], palette.localTable[i + 1], palette.localTable[i + 2]);
+        }
+        const std::vector<uint16_t> indices = dither::remap(_frames[frameIndex].image, table.data(), table.size(), m_dither, threadPool());
+        palette.pixels.assign(indices.begin(), indices.end());
+        return palette;
+    }
+
+    const IndexMap& localToGlobal = *m_localToGlobalMappings[frameIndex];
+    palette.lookup.resize(_frames[frameIndex].image.getColorPalette().size());
+    for (std::size_t localIndex = 0; localIndex < palette.lookup.size(); localIndex++)
+    {
+        const uint16_t globalIndex = mappedIndex(localToGlobal, static_cast<uint16_t>(localIndex));
+        const auto it = std::lower_bound(usedColors.begin(), usedColors.end(), globalIndex);
+        palette.lookup[localIndex] = it != usedColors.end() && *it == globalIndex
+                                         ? position[static_cast<std::size_t>(it - usedColors.begin())]
+                                         : 0;
+    }
+    return palette;
+}
+
+void Gif::initFrameConfig(CGIF_FrameConfig* pConfig, std::pmr::vector<uint8_t>& imageDataVec, uint16_t delay)
 {
     memset(pConfig, 0, sizeof(CGIF_FrameConfig));
     pConfig->delay = delay;
     pConfig->pImageData = imageDataVec.data();
 }
 
-void Gif::loadFrames()
+void Gif::loadFrames(std::pmr::memory_resource* scratch, std::vector<FramePalette>& palettes)
 {
-    if (pGIF == nullptr)
+    P_PROFILE_SCOPE("Gif::loadFrames");
+    if (pGIF == nullptr && !m_streamWriter)
     {
         P_LOG_ERROR() << "GIF not initialized\n";
         return;
     }
+    // the buffer keeps the previous frame, so frames with a known changed
+    // region only need to remap the pixels inside that region
+    std::pmr::vector<uint8_t> imageDataVec(static_cast<std::size_t>(_width * _height), scratch);
+    // bounds of the previous frame, its image may be back in the frame pool
+    std::optional<graphics::Rect> previousBounds;
     size_t frameIndex = 0;
     for (auto& frame : _frames)
     {
-        // load frame pointing to zero index of color palette
-        std::vector<uint8_t> imageDataVec(static_cast<std::size_t>(_width * _height));
-
-        const std::vector<uint8_t>& frameData = frame.image.getImageData();
-        IndexMapPtr& localToGlobalColorMap = m_localToGlobalMappings[frameIndex];
-
-        // load frame data to imageDataVec
-        for (int i = 0; i < frame.image.getHeight(); i++)
+        FramePalette& palette = palettes[frameIndex];
+        const bool local = !palette.localTable.empty();
+        // the indices kept from the previous frame are only valid in the same table
+        const bool incremental = frame.changedRegion.has_value() && previousBounds == frame.image.bounds() && !local &&
+                                 palettes[frameIndex - 1].localTable.empty();
         {
-            for (int j = 0; j < frame.image.getWidth(); j++)
+            P_PROFILE_SCOPE("Gif::remapFrame");
+            if (incremental)
+            {
+                remapRegion(frame, palette, *frame.changedRegion, imageDataVec);
+            }
+            else
             {
-                auto imagePixelIndex = static_cast<std::size_t>(i * frame.image.getWidth() + j);
-                uint16_t globalIndex = static_cast<uint16_t>((*localToGlobalColorMap)[frameData[imagePixelIndex]]);
-                if (m_colorReduced)
+                // the canvas outside the frame keeps the color of global index 0
+                std::fill(imageDataVec.begin(), imageDataVec.end(), palette.background);
+                if (palette.pixels.empty())
+                {
+                    remapRegion(frame, palette, frame.image.bounds(), imageDataVec);
+                }
+                else
                 {
-                    globalIndex = (*m_globalToReducedColorMap)[globalIndex];
+                    const auto frameWidth = static_cast<std::size_t>(frame.image.getWidth());
+                    for (int row = 0; row < frame.image.getHeight(); row++)
+                    {
+                        std::copy_n(palette.pixels.data() + static_cast<std::size_t>(row) * frameWidth, frameWidth,
+                                    imageDataVec.data() + static_cast<std::size_t>(row * _width));
+                    }
                 }
-                const auto index = static_cast<std::size_t>(i * _width + j);
-                imageDataVec[index] = static_cast<uint8_t>(globalIndex);
             }
         }
+        const auto localTableSize = static_cast<uint16_t>(palette.localTable.size() / 3);
+        if (local)
+        {
+            m_saveStats.localPalettes++;
+        }
 
-        CGIF_FrameConfig fConfig;
-        initFrameConfig(&fConfig, imageDataVec, frame.delay);
-        cgif_addframe(pGIF, &fConfig);
+        if (m_streamWriter)
+        {
+            // compressed on the pool while the next frames are remapped
+            P_PROFILE_SCOPE("GifStreamWriter::addFrame");
+            m_streamWriter->addFrame(imageDataVec.data(), frame.delay, incremental, local ? palette.localTable.data() : nullptr,
+                                     localTableSize);
+        }
+        else
+        {
+            CGIF_FrameConfig fConfig;
+            initFrameConfig(&fConfig, imageDataVec, frame.delay);
+            if (incremental)
+            {
+                fConfig.genFlags = CGIF_FRAME_GEN_USE_DIFF_WINDOW;
+            }
+            if (local)
+            {
+                fConfig.attrFlags = CGIF_FRAME_ATTR_USE_LOCAL_TABLE;
+                fConfig.pLocalPalette = palette.localTable.data();
+                fConfig.numLocalPaletteEntries = localTableSize;
+            }
+            P_PROFILE_SCOPE("cgif_addframe");
+            cgif_addframe(pGIF, &fConfig);
+        }
 
+        previousBounds = frame.image.bounds();
         frameIndex++;
+        // the encoder has its own copy of the indices, so the frame can be
+        // rendered into again while the rest are encoded
+        if (m_framePool)
+        {
+            m_framePool->release(std::move(frame.image));
+            frame.image = Image(0, 0, BLACK, m_resource);
+        }
+    }
+}
+
+void Gif::remapRegion(const Frame& frame, const FramePalette& palette, const graphics::Rect& region,
+                      std::pmr::vector<uint8_t>& imageDataVec) const
+{
+    const graphics::Rect clipped = region.intersected(frame.image.bounds());
+    if (clipped.isEmpty())
+    {
+        return;
     }
+    // every palette index of the frame is resolved once by planPalettes(),
+    // the pixels only need a table lookup
+    const std::vector<uint32_t>& lookup = palette.lookup;
+
+    const int grainRows = std::max(1, REMAP_GRAIN_PIXELS / std::max(1, clipped.maxY - clipped.minY));
+    ThreadPool& pool = threadPool();
+    parallelFor(
+        clipped, Grain{grainRows, 0},
+        [&](const graphics::Rect& tile) {
+            const kernels::KernelTable& kernel = kernels::active();
+            for (int i = tile.minX; i < tile.maxX; i++)
+            {
+                kernel.remapIndices(frame.image.rowIndices(i) + tile.minY, static_cast<std::size_t>(tile.maxY - tile.minY),
+                                    lookup.data(), lookup.size(),
+                                    imageDataVec.data() + static_cast<std::size_t>(i * _width + tile.minY));
+            }
+        },
+        pool);
 }
 
 } // namespace pixelmancy
@@ -1,6 +1,10 @@
 #pragma once
 
 #include "Image.hpp"
+#include "LossyLzw.hpp"
+#include "PaletteUsage.hpp"
+
+#include <memory_resource>
 
 extern "C"
 {
@@ -8,21 +12,66 @@ extern "C"
 }
 
 namespace pixelmancy {
+class ByteSink;
 class ColorPallette;
 struct Frame;
 class ColorMatcher;
+class FramePool;
+class GifStreamWriter;
+class ThreadPool;
+
+/**
+ * Result of the last Gif::save()
+ */
+struct GifSaveStats
+{
+    // size of the written file in bytes
+    std::uintmax_t compressedBytes = 0;
+    // color error of the lossy encoding, empty for lossless saves
+    LossyStats error;
+    // frames written with a local color table
+    std::size_t localPalettes = 0;
+};
 
 class Gif
 {
 public:
-    explicit Gif(std::shared_ptr<ColorMatcher> colorMatcher);
+    /**
+     *   @param colorMatcher matcher used for frames that have more colors than a GIF color table holds
+     *   @param resource resource for the frames and palettes, it must outlive the gif.
+     *   Temporaries of save() always come from a ScopedArena of their own.
+     */
+    explicit Gif(std::shared_ptr<ColorMatcher> colorMatcher,
+                 std::pmr::memory_resource* resource = std::pmr::get_default_resource());
     virtual ~Gif();
 
     /**
      *   Save the gif to the file path
      *   @param filePath path to save the gif
+     *   @param quality 0 to 100, below LOSSLESS_QUALITY pixels may change
+     *   color by up to MAX_LOSSY_DISTANCE at quality 0 to make the LZW codes
+     *   longer and the file smaller
+     *   @param order PaletteOrder::ByUsage drops the color table entries the
+     *   pixels do not use and sorts the rest by PaletteUsage
      */
-    bool save(const std::string& filePath);
+    bool save(const std::string& filePath, int quality = LOSSLESS_QUALITY, PaletteOrder order = PaletteOrder::Unchanged);
+
+    /**
+     *   Save the gif to a sink instead of a file, see save(const std::string&, int, PaletteOrder)
+     *   @param sink destination of the bytes, they are written as the frames are compressed
+     */
+    bool save(ByteSink& sink, int quality = LOSSLESS_QUALITY, PaletteOrder order = PaletteOrder::Unchanged);
+
+    /**
+     *   Save the gif to memory
+     *   @return bytes of the gif, empty if it could not be saved
+     */
+    std::vector<uint8_t> saveToBuffer(int quality = LOSSLESS_QUALITY, PaletteOrder order = PaletteOrder::Unchanged);
+
+    /**
+     *   Size and color error of the last save()
+     */
+    const GifSaveStats& saveStats() const;
 
     /**
      *   Add a frame to the gif
@@ -31,30 +80,97 @@ public:
      */
     void addFrame(const Image& frame, uint16_t delay = DEFAULT_FRAME_DELAY);
 
+    /**
+     *   Add a frame to the gif without copying the image
+     *   @param frame image to add as a frame
+     *   @param delay delay in milliseconds
+     */
+    void addFrame(Image&& frame, uint16_t delay = DEFAULT_FRAME_DELAY);
+
+    /**
+     *   Add a frame that differs from the previous frame only inside a region,
+     *   only that region is remapped to the global palette and encoded
+     *   @param frame image to add as a frame
+     *   @param delay delay in milliseconds
+     *   @param changedRegion area that changed since the previous frame (see FrameBuilder::changedRegion())
+     */
+    void addFrame(const Image& frame, uint16_t delay, const graphics::Rect& changedRegion);
+
+    /**
+     *   Recycle frame images through a pool. Frame copies are taken from the
+     *   pool and save() gives every frame back to it as soon as the frame is
+     *   handed to the encoder, so the gif can be saved only once.
+     *   @param framePool pool to take and release frames
+     */
+    void setFramePool(std::shared_ptr<FramePool> framePool);
+
+    /**
+     *   Remap and compress the frames on a pool of its own instead of the
+     *   global pool. A pool of more than one thread compresses frames in
+     *   parallel, the file stays byte-identical.
+     *   @param threadPool pool to use, it must outlive the gif
+     */
+    void setThreadPool(ThreadPool& threadPool);
+
+    /**
+     *   Dither the frames that have more colors than a GIF color table holds
+     *   instead of mapping every color to its nearest ColorMatcher color
+     *   @param dither dithering of those frames, Dither::None by default
+     */
+    void setDither(Dither dither);
+
     /**
      * Close the gif
+     * @return false if a frame or the trailer could not be written
      */
-    void close();
+    bool close();
 
 private:
-    std::size_t reduceGlobalColorPalette();
-    int init(const std::string& filePath);
-    uint8_t* getPaletteData();
-    void initGIFConfig(CGIF_Config* pConfig, char* path, uint16_t width, uint16_t height, uint8_t* pPalette, uint16_t numColors);
-    void initFrameConfig(CGIF_FrameConfig* pConfig, std::vector<uint8_t>& imageDataVec, uint16_t delay);
-    void loadFrames();
-    void globalColorPaletteGeneration();
+    /**
+     *   Color table of one frame, planned on the pool, so it does not come
+     *   from the arena of save()
+     */
+    struct FramePalette
+    {
+        // index in the color table of every palette index of the frame
+        std::vector<uint32_t> lookup;
+        // RGB colors of the local color table, empty for the global table
+        std::vector<uint8_t> localTable;
+        // index in the color table of the canvas outside the frame
+        uint8_t background = 0;
+        // dithered indices of the pixels row by row, the lookup is not used
+        // for them
+        std::vector<uint8_t> pixels;
+    };
+
+    std::vector<FramePalette> planPalettes(std::pmr::vector<uint8_t>& globalTable) const;
+    void sortTables(std::vector<FramePalette>& palettes, std::pmr::vector<uint8_t>& globalTable) const;
+    FramePalette localPalette(std::size_t frameIndex, const std::vector<uint16_t>& usedColors) const;
+    int init(ByteSink& sink, std::pmr::vector<uint8_t>& globalTable, int quality);
+    void initGIFConfig(CGIF_Config* pConfig, ByteSink* sink, uint16_t width, uint16_t height, uint8_t* pPalette, uint16_t numColors);
+    void initFrameConfig(CGIF_FrameConfig* pConfig, std::pmr::vector<uint8_t>& imageDataVec, uint16_t delay);
+    void loadFrames(std::pmr::memory_resource* scratch, std::vector<FramePalette>& palettes);
+    void mergeFramePalette(const Image& frame);
+    void updateSize(const Image& frame);
+    Image copyFrame(const Image& frame);
+    void releaseFrames();
+    ThreadPool& threadPool() const;
+    void remapRegion(const Frame& frame, const FramePalette& palette, const graphics::Rect& region, std::pmr::vector<uint8_t>& imageDataVec) const;
 
+    std::pmr::memory_resource* m_resource;
     std::shared_ptr<ColorMatcher> m_colorMatcher;
-    std::vector<IndexMapPtr> m_localToGlobalMappings;
-    std::vector<Frame> _frames;
+    std::pmr::vector<IndexMapPtr> m_localToGlobalMappings;
+    std::pmr::vector<Frame> _frames;
     int _width = 0;
     int _height = 0;
-    IndexMapPtr m_globalToReducedColorMap;
     CGIF* pGIF = nullptr;
+    // replaces pGIF when frames are compressed in parallel or lossy
+    std::unique_ptr<GifStreamWriter> m_streamWriter;
+    GifSaveStats m_saveStats;
     std::unique_ptr<ColorPallette> m_globalPallette;
-    bool m_colorReduced = false;
-    std::unique_ptr<ColorPallette> m_reducedGlobalPallette;
+    std::shared_ptr<FramePool> m_framePool;
+    ThreadPool* m_threadPool = nullptr;
+    Dither m_dither = Dither::None;
 };
 
 } // namespace pixelmancy
@@ -0,0 +1,490 @@
+#include "GifDecoder.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "Log.hpp"
+#include "profiler/Profiler.hpp"
+
+namespace pixelmancy {
+
+namespace {
+
+constexpr uint8_t EXTENSION_INTRODUCER = 0x21;
+constexpr uint8_t IMAGE_SEPARATOR = 0x2C;
+constexpr uint8_t TRAILER = 0x3B;
+constexpr uint8_t GRAPHIC_CONTROL_LABEL = 0xF9;
+constexpr uint8_t COLOR_TABLE_FLAG = 0x80;
+constexpr uint8_t INTERLACE_FLAG = 0x40;
+constexpr std::size_t MAX_LZW_CODES = 4096;
+constexpr int MAX_LZW_BITS = 12;
+constexpr uint16_t NO_CODE = 0xFFFF;
+
+// rows of an interlaced image are stored in four passes
+struct InterlacePass
+{
+    int first;
+    int step;
+};
+constexpr InterlacePass INTERLACE_PASSES[] = {{0, 8}, {4, 8}, {2, 4}, {1, 2}};
+
+// strings of the LZW dictionary, every code is a shorter code plus one index
+struct LzwDictionary
+{
+    std::array<uint16_t, MAX_LZW_CODES> prefix;
+    std::array<uint8_t, MAX_LZW_CODES> suffix;
+    std::array<uint8_t, MAX_LZW_CODES> first;
+    std::array<uint16_t, MAX_LZW_CODES> length;
+};
+
+} // namespace
+
+GifDecoder::Iterator::Iterator(GifDecoder& decoder)
+ : m_decoder(&decoder)
+{
+    ++*this;
+}
+
+GifDecoder::Iterator& GifDecoder::Iterator::operator++()
+{
+    m_frame = m_decoder->next();
+    if (!m_frame)
+    {
+        m_decoder = nullptr;
+    }
+    return *this;
+}
+
+GifDecoder::GifDecoder(const std::string& filePath, std::pmr::memory_resource* resource)
+ : m_file(filePath, std::ios::binary),
+   m_resource(resource),
+   m_canvas(0, 0, BLACK, resource)
+{
+    if (!m_file)
+    {
+        P_LOGF_ERROR("Cannot open {}\n", filePath);
+        return;
+    }
+    char signature[6];
+    m_file.read(signature, sizeof(signature));
+    if (!m_file || (std::memcmp(signature, "GIF87a", 6) != 0 && std::memcmp(signature, "GIF89a", 6) != 0))
+    {
+        P_LOGF_ERROR("{} is not a gif\n", filePath);
+        return;
+    }
+    uint16_t width = 0;
+    uint16_t height = 0;
+    uint8_t packed = 0;
+    uint8_t background = 0;
+    uint8_t aspect = 0;
+    if (!readShort(width) || !readShort(height) || !readByte(packed) || !readByte(background) || !readByte(aspect) ||
+        !readColorTable(packed, m_globalTable, m_globalTableSize))
+    {
+        P_LOGF_ERROR("{} has a truncated header\n", filePath);
+        return;
+    }
+    // the canvas starts with the background color of the global table, or
+    // transparent without one
+    const Color backgroundColor = background < m_globalTableSize ? m_globalTable[background] : Color(0, 0, 0, 0);
+    m_canvas = Image(width, height, backgroundColor, m_resource);
+    m_backgroundIndex = m_canvas.resolveColor(backgroundColor);
+    m_open = true;
+}
+
+bool GifDecoder::isOpen() const
+{
+    return m_open;
+}
+
+bool GifDecoder::failed() const
+{
+    return m_failed;
+}
+
+int GifDecoder::getWidth() const
+{
+    return m_canvas.getWidth();
+}
+
+int GifDecoder::getHeight() const
+{
+    return m_canvas.getHeight();
+}
+
+GifDecoder::Iterator GifDecoder::begin()
+{
+    return Iterator(*this);
+}
+
+GifDecoder::Iterator GifDecoder::end()
+{
+    return Iterator();
+}
+
+bool GifDecoder::readBytes(uint8_t* data, std::size_t size)
+{
+    m_file.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(size));
+    return static_cast<bool>(m_file);
+}
+
+bool GifDecoder::readByte(uint8_t& value)
+{
+    return readBytes(&value, 1);
+}
+
+bool GifDecoder::readShort(uint16_t& value)
+{
+    uint8_t bytes[2];
+    if (!readBytes(bytes, 2))
+    {
+        return false;
+    }
+    value = static_cast<uint16_t>(bytes[0] | bytes[1] << 8);
+    return true;
+}
+
+bool GifDecoder::readColorTable(uint8_t packed, ColorTable& table, std::size_t& tableSize)
+{
+    tableSize = 0;
+    if ((packed & COLOR_TABLE_FLAG) == 0)
+    {
+        return true;
+    }
+    const std::size_t size = std::size_t{2} << (packed & 0x07);
+    uint8_t rgb[256 * 3];
+    if (!readBytes(rgb, size * 3))
+    {
+        return false;
+    }
+    for (std::size_t i = 0; i < size; i++)
+    {
+        table[i] = Color(rgb[i * 3], rgb[i * 3 + 1], rgb[i * 3 + 2]);
+    }
+    tableSize = size;
+    return true;
+}
+
+bool GifDecoder::skipSubBlocks()
+{
+    uint8_t size = 0;
+    while (readByte(size) && size != 0)
+    {
+        m_file.ignore(size);
+    }
+    return static_cast<bool>(m_file);
+}
+
+bool GifDecoder::readControl()
+{
+    uint8_t size = 0;
+    uint8_t packed = 0;
+    uint16_t delay = 0;
+    uint8_t transparent = 0;
+    if (!readByte(size) || size != 4 || !readByte(packed) || !readShort(delay) || !readByte(transparent))
+    {
+        return false;
+    }
+    m_control.delay = delay;
+    const int disposal = packed >> 2 & 0x07;
+    m_control.disposal = disposal == 2 ? Disposal::Background : disposal == 3 ? Disposal::Previous : Disposal::Keep;
+    m_control.transparentIndex = (packed & 0x01) != 0 ? std::optional<uint8_t>(transparent) : std::nullopt;
+    return skipSubBlocks();
+}
+
+std::optional<Frame> GifDecoder::next()
+{
+    if (!m_open || m_failed || m_finished)
+    {
+        return std::nullopt;
+    }
+    P_PROFILE_SCOPE("GifDecoder::next");
+    uint8_t introducer = 0;
+    while (readByte(introducer))
+    {
+        if (introducer == TRAILER)
+        {
+            m_finished = true;
+            return std::nullopt;
+        }
+        if (introducer == EXTENSION_INTRODUCER)
+        {
+            uint8_t label = 0;
+            if (!readByte(label) || !(label == GRAPHIC_CONTROL_LABEL ? readControl() : skipSubBlocks()))
+            {
+                break;
+            }
+            continue;
+        }
+        if (introducer != IMAGE_SEPARATOR)
+        {
+            P_LOGF_ERROR("Unknown gif block {:#x}\n", introducer);
+            break;
+        }
+        graphics::Rect changed;
+        uint16_t delay = 0;
+        if (!decodeImage(changed, delay))
+        {
+            break;
+        }
+        P_PROFILE_COUNTER("gif.framesDecoded", 1);
+        return Frame(delay, Image(m_canvas, m_resource), changed);
+    }
+    // a gif without a trailer ends after its last frame
+    m_failed = !m_file.eof();
+    m_finished = true;
+    return std::nullopt;
+}
+
+// Read one image, restore what the previous frame asked for and draw the
+// image on the canvas
+bool GifDecoder::decodeImage(graphics::Rect& changed, uint16_t& delay)
+{
+    uint16_t left = 0;
+    uint16_t top = 0;
+    uint16_t width = 0;
+    uint16_t height = 0;
+    uint8_t packed = 0;
+    ColorTable localTable;
+    std::size_t localTableSize = 0;
+    if (!readShort(left) || !readShort(top) || !readShort(width) || !readShort(height) || !readByte(packed) ||
+        !readColorTable(packed, localTable, localTableSize))
+    {
+        P_LOG_ERROR() << "Truncated gif image descriptor\n";
+        m_failed = true;
+        return false;
+    }
+    // an image past the screen is decoded whole and clipped when it is drawn
+    if (!decompress(static_cast<std::size_t>(width) * height))
+    {
+        m_failed = true;
+        return false;
+    }
+
+    const graphics::Rect area(top, left, top + height, left + width);
+    changed = m_previousDisposal == Disposal::Keep ? graphics::Rect() : m_previousArea;
+    disposePrevious();
+    const graphics::Rect visible = area.intersected(m_canvas.bounds());
+    if (m_control.disposal == Disposal::Previous && !visible.isEmpty())
+    {
+        m_restore.clear();
+        for (int row = visible.minX; row < visible.maxX; row++)
+        {
+            const uint16_t* indices = m_canvas.rowIndices(row);
+            m_restore.insert(m_restore.end(), indices + visible.minY, indices + visible.maxY);
+        }
+    }
+    if (localTableSize > 0)
+    {
+        draw(area, (packed & INTERLACE_FLAG) != 0, localTable, localTableSize);
+    }
+    else
+    {
+        draw(area, (packed & INTERLACE_FLAG) != 0, m_globalTable, m_globalTableSize);
+    }
+    changed = changed.united(visible);
+    delay = m_control.delay;
+    m_previousDisposal = m_control.disposal;
+    m_previousArea = visible;
+    // a control block only applies to the image after it
+    m_control = {};
+    return true;
+}
+
+// LZW codes of the image, read sub-block by sub-block into m_pixels
+bool GifDecoder::decompress(std::size_t pixelCount)
+{
+    P_PROFILE_SCOPE("GifDecoder::decompress");
+    uint8_t minimumBits = 0;
+    if (!readByte(minimumBits) || minimumBits < 2 || minimumBits > 8)
+    {
+        P_LOG_ERROR() << "Invalid gif LZW code size\n";
+        return false;
+    }
+    m_pixels.assign(pixelCount, 0);
+    LzwDictionary dictionary;
+    const uint16_t clearCode = static_cast<uint16_t>(1u << minimumBits);
+    const uint16_t endCode = clearCode + 1;
+    for (uint16_t code = 0; code < clearCode; code++)
+    {
+        dictionary.prefix[code] = NO_CODE;
+        dictionary.suffix[code] = static_cast<uint8_t>(code);
+        dictionary.first[code] = static_cast<uint8_t>(code);
+        dictionary.length[code] = 1;
+    }
+    uint16_t nextCode = clearCode + 2;
+    int codeBits = minimumBits + 1;
+    uint16_t previous = NO_CODE;
+    std::size_t written = 0;
+    uint32_t bitBuffer = 0;
+    int bufferedBits = 0;
+    bool ended = false;
+
+    // write the string of a code, strings past the end of the image are cut
+    auto output = [&dictionary, &written, pixelCount, this](uint16_t code) {
+        const std::size_t length = dictionary.length[code];
+        std::size_t position = written + length;
+        for (uint16_t c = code; c != NO_CODE; c = dictionary.prefix[c])
+        {
+            position--;
+            if (position < pixelCount)
+            {
+                m_pixels[position] = dictionary.suffix[c];
+            }
+        }
+        written += length;
+    };
+
+    uint8_t block[255];
+    uint8_t blockSize = 0;
+    while (readByte(blockSize) && blockSize != 0)
+    {
+        if (!readBytes(block, blockSize))
+        {
+            break;
+        }
+        for (uint8_t i = 0; i < blockSize && !ended; i++)
+        {
+            bitBuffer |= static_cast<uint32_t>(block[i]) << bufferedBits;
+            bufferedBits += 8;
+            while (bufferedBits >= codeBits && !ended)
+            {
+                const auto code = static_cast<uint16_t>(bitBuffer & ((1u << codeBits) - 1));
+                bitBuffer >>= codeBits;
+                bufferedBits -= codeBits;
+                if (code == clearCode)
+                {
+                    nextCode = clearCode + 2;
+                    codeBits = minimumBits + 1;
+                    previous = NO_CODE;
+                    continue;
+                }
+                if (code == endCode)
+                {
+                    ended = true;
+                    break;
+                }
+                if (previous == NO_CODE)
+                {
+                    if (code >= clearCode)
+                    {
+                        P_LOG_ERROR() << "Invalid first gif LZW code\n";
+                        return false;
+                    }
+                    output(code);
+                    previous = code;
+                    continue;
+                }
+                if (code > nextCode || (code == nextCode && nextCode >= MAX_LZW_CODES))
+                {
+                    P_LOG_ERROR() << "Invalid gif LZW code\n";
+                    return false;
+                }
+                // a code not in the dictionary yet is the previous string
+                // plus its own first index
+                const uint8_t first = code < nextCode ? dictionary.first[code] : dictionary.first[previous];
+                if (nextCode < MAX_LZW_CODES)
+                {
+                    dictionary.prefix[nextCode] = previous;
+                    dictionary.suffix[nextCode] = first;
+                    dictionary.first[nextCode] = dictionary.first[previous];
+                    dictionary.length[nextCode] = static_cast<uint16_t>(dictionary.length[previous] + 1);
+                    nextCode++;
+                    if (nextCode == (1u << codeBits) && codeBits < MAX_LZW_BITS)
+                    {
+                        codeBits++;
+                    }
+                }
+                output(code);
+                previous = code;
+            }
+        }
+    }
+    if (!m_file)
+    {
+        P_LOG_ERROR() << "Truncated gif image data\n";
+        return false;
+    }
+    // missing pixels keep index 0, like most decoders do
+    P_PROFILE_COUNTER("gif.pixelsDecoded", std::min(written, pixelCount));
+    return true;
+}
+
+void GifDecoder::disposePrevious()
+{
+    const graphics::Rect& area = m_previousArea;
+    if (m_previousDisposal == Disposal::Background)
+    {
+        for (int row = area.minX; row < area.maxX; row++)
+        {
+            m_canvas.fillRow(row, area.minY, area.maxY - 1, m_backgroundIndex);
+        }
+    }
+    else if (m_previousDisposal == Disposal::Previous && !m_restore.empty())
+    {
+        const auto width = static_cast<std::size_t>(area.maxY - area.minY);
+        for (int row = area.minX; row < area.maxX; row++)
+        {
+            const uint16_t* saved = m_restore.data() + static_cast<std::size_t>(row - area.minX) * width;
+            for (int column = area.minY; column < area.maxY; column++)
+            {
+                m_canvas.setPixel(row, column, saved[column - area.minY]);
+            }
+        }
+    }
+    m_previousDisposal = Disposal::Keep;
+}
+
+// Translate the table once to canvas indices and copy the opaque pixels
+void GifDecoder::draw(const graphics::Rect& area, bool interlaced, const ColorTable& table, std::size_t tableSize)
+{
+    std::array<uint16_t, 256> canvasIndex{};
+    std::array<bool, 256> drawn{};
+    for (std::size_t i = 0; i < tableSize; i++)
+    {
+        canvasIndex[i] = m_canvas.resolveColor(table[i]);
+        drawn[i] = true;
+    }
+    // indices outside the table and the transparent index leave the canvas
+    if (m_control.transparentIndex)
+    {
+        drawn[*m_control.transparentIndex] = false;
+    }
+
+    const int width = area.maxY - area.minY;
+    const int height = area.maxX - area.minX;
+    int stored = 0;
+    auto drawRow = [&](int row) {
+        const uint8_t* indices = m_pixels.data() + static_cast<std::size_t>(stored) * static_cast<std::size_t>(width);
+        stored++;
+        const int canvasRow = area.minX + row;
+        if (canvasRow >= m_canvas.getHeight())
+        {
+            return;
+        }
+        const int columns = std::min(width, m_canvas.getWidth() - area.minY);
+        for (int column = 0; column < columns; column++)
+        {
+            if (drawn[indices[column]])
+            {
+                m_canvas.setPixel(canvasRow, area.minY + column, canvasIndex[indices[column]]);
+            }
+        }
+    };
+    if (!interlaced)
+    {
+        for (int row = 0; row < height; row++)
+        {
+            drawRow(row);
+        }
+        return;
+    }
+    for (const InterlacePass& pass : INTERLACE_PASSES)
+    {
+        for (int row = pass.first; row < height; row += pass.step)
+        {
+            drawRow(row);
+        }
+    }
+}
+
+} // namespace pixelmancy
@@ -0,0 +1,154 @@
+#pragma once
+
+#include "Common.hpp"
+#include "Image.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace pixelmancy {
+
+/**
+ * Streaming GIF reader. Frames are decoded one at a time when they are
+ * asked for, drawn on a canvas with their offset, transparency and the
+ * disposal of the previous frame, and returned as a copy of the canvas. The
+ * pixels are GIF color table indices translated to the canvas palette, no
+ * frame is expanded to RGBA. Memory stays at the canvas, one frame of LZW
+ * output and the area a frame asks to restore.
+ */
+class GifDecoder
+{
+public:
+    /**
+     * Input iterator over the remaining frames
+     */
+    class Iterator
+    {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Frame;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Frame*;
+        using reference = const Frame&;
+
+        Iterator() = default;
+        explicit Iterator(GifDecoder& decoder);
+
+        reference operator*() const
+        {
+            return *m_frame;
+        }
+
+        pointer operator->() const
+        {
+            return &*m_frame;
+        }
+
+        Iterator& operator++();
+
+        bool operator==(const Iterator& other) const
+        {
+            return m_decoder == other.m_decoder;
+        }
+
+        bool operator!=(const Iterator& other) const
+        {
+            return !(*this == other);
+        }
+
+    private:
+        GifDecoder* m_decoder = nullptr;
+        std::optional<Frame> m_frame;
+    };
+
+    /**
+     * Open a gif and read its header and global color table
+     * @param filePath path of the gif
+     * @param resource resource for the canvas and the decoded frames, it must outlive them
+     */
+    explicit GifDecoder(const std::string& filePath, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    GifDecoder(const GifDecoder&) = delete;
+    GifDecoder& operator=(const GifDecoder&) = delete;
+
+    /**
+     * @return false if the file could not be read or is not a gif
+     */
+    bool isOpen() const;
+
+    /**
+     * @return true if a frame could not be decoded, the frames before it are valid
+     */
+    bool failed() const;
+
+    int getWidth() const;
+    int getHeight() const;
+
+    /**
+     * Decode the next frame. Its changed region covers the frame and the
+     * area the disposal of the previous frame restored.
+     * @return the canvas after the frame, std::nullopt at the end of the gif or on an error
+     */
+    std::optional<Frame> next();
+
+    /**
+     * Iterate over the frames that have not been decoded yet
+     */
+    Iterator begin();
+    Iterator end();
+
+private:
+    // how the area of a frame is left for the next one
+    enum class Disposal
+    {
+        Keep,
+        Background,
+        Previous,
+    };
+
+    struct FrameControl
+    {
+        uint16_t delay = 0;
+        Disposal disposal = Disposal::Keep;
+        std::optional<uint8_t> transparentIndex;
+    };
+
+    using ColorTable = std::array<Color, 256>;
+
+    bool readBytes(uint8_t* data, std::size_t size);
+    bool readByte(uint8_t& value);
+    bool readShort(uint16_t& value);
+    bool readColorTable(uint8_t packed, ColorTable& table, std::size_t& tableSize);
+    bool skipSubBlocks();
+    bool readControl();
+    bool decodeImage(graphics::Rect& frameArea, uint16_t& delay);
+    bool decompress(std::size_t pixelCount);
+    void disposePrevious();
+    void draw(const graphics::Rect& frameArea, bool interlaced, const ColorTable& table, std::size_t tableSize);
+
+    std::ifstream m_file;
+    std::pmr::memory_resource* m_resource;
+    bool m_open = false;
+    bool m_failed = false;
+    bool m_finished = false;
+    Image m_canvas;
+    uint16_t m_backgroundIndex = 0;
+    ColorTable m_globalTable{};
+    std::size_t m_globalTableSize = 0;
+    FrameControl m_control;
+    // what the previous frame asked to restore before the next one
+    Disposal m_previousDisposal = Disposal::Keep;
+    graphics::Rect m_previousArea;
+    std::vector<uint16_t> m_restore;
+    // LZW output of the frame being decoded
+    std::vector<uint8_t> m_pixels;
+};
+
+} // namespace pixelmancy
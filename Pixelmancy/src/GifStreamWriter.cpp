@@ -0,0 +1,314 @@
+#include "GifStreamWriter.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include "Log.hpp"
+#include "ThreadPool.hpp"
+#include "profiler/Profiler.hpp"
+
+namespace pixelmancy {
+
+namespace {
+
+constexpr uint32_t MAX_DELAY = 0xFFFF;
+// above every RGB color, and different for the two frames compared
+constexpr uint32_t OUTSIDE_CURRENT = 0x1000000;
+constexpr uint32_t OUTSIDE_PREVIOUS = 0x2000000;
+
+// bytes one frame stream writes after its header
+struct FrameBytes
+{
+    bool recording = false;
+    std::vector<uint8_t> bytes;
+};
+
+int recordFrameBytes(void* context, const uint8_t* data, std::size_t size)
+{
+    auto* frame = static_cast<FrameBytes*>(context);
+    if (frame->recording)
+    {
+        frame->bytes.insert(frame->bytes.end(), data, data + size);
+    }
+    return 0;
+}
+
+// The frame is encoded by a stream of its own, so frames can be compressed
+// at the same time. Its header and trailer are dropped, the frame bytes are
+// what cgif_raw_addframe() writes for the frame in the real stream.
+cgif_result encodeFrame(CGIFRaw_Config config, const CGIFRaw_FrameConfig& frameConfig, std::vector<uint8_t>& bytes)
+{
+    FrameBytes frame;
+    config.pWriteFn = recordFrameBytes;
+    config.pContext = &frame;
+    CGIFRaw* stream = cgif_raw_newgif(&config);
+    if (stream == nullptr)
+    {
+        return CGIF_ERROR;
+    }
+    frame.recording = true;
+    const cgif_result result = cgif_raw_addframe(stream, &frameConfig);
+    frame.recording = false;
+    cgif_raw_close(stream);
+    bytes = std::move(frame.bytes);
+    return result;
+}
+
+} // namespace
+
+GifStreamWriter::GifStreamWriter(ThreadPool& pool)
+ : m_pool(pool)
+{
+}
+
+GifStreamWriter::~GifStreamWriter()
+{
+    if (m_stream != nullptr)
+    {
+        close();
+    }
+}
+
+bool GifStreamWriter::open(ByteSink& sink, uint16_t width, uint16_t height, const uint8_t* palette,
+                           uint16_t paletteSize, int quality)
+{
+    if (width == 0 || height == 0)
+    {
+        return false;
+    }
+    m_sink = &sink;
+    m_palette.assign(palette, palette + paletteSize * 3);
+    tableColors(m_palette.data(), paletteSize, OUTSIDE_CURRENT, m_globalColors);
+
+    // the same configuration cgif_newgif() gives an animated gif
+    m_config = {};
+    m_config.pGCT = m_palette.data();
+    m_config.sizeGCT = paletteSize;
+    m_config.attrFlags = CGIF_RAW_ATTR_IS_ANIMATED;
+    m_config.width = width;
+    m_config.height = height;
+    m_config.pWriteFn = ByteSink::writeCallback;
+    m_config.pContext = m_sink;
+    m_stream = cgif_raw_newgif(&m_config);
+    m_failed = m_stream == nullptr;
+    m_quality = quality;
+    m_lossy = std::make_unique<const LossyLzw>(m_palette.data(), paletteSize, quality);
+    m_stats = {};
+    m_previous.clear();
+    m_pending.reset();
+    return !m_failed;
+}
+
+void GifStreamWriter::tableColors(const uint8_t* palette, uint16_t paletteSize, uint32_t outside, TableColors& colors)
+{
+    colors.fill(outside);
+    for (uint16_t index = 0; index < paletteSize && index < colors.size(); index++)
+    {
+        colors[index] = static_cast<uint32_t>(palette[index * 3u]) << 16 | static_cast<uint32_t>(palette[index * 3u + 1]) << 8 |
+                        palette[index * 3u + 2];
+    }
+}
+
+// like cmpPixel() of cgif, the two frames may use different color tables
+bool GifStreamWriter::samePixel(uint8_t current, uint8_t previous) const
+{
+    return m_currentColors[current] == m_previousColors[previous];
+}
+
+bool GifStreamWriter::sameAsPrevious(const uint8_t* imageData) const
+{
+    for (std::size_t i = 0; i < m_previous.size(); i++)
+    {
+        if (!samePixel(imageData[i], m_previous[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// the bounding box of the pixels that differ from the previous frame, what
+// doWidthHeightOptim() of cgif finds with its four scans
+GifStreamWriter::PendingFrame GifStreamWriter::diffWindow(const uint8_t* imageData) const
+{
+    const int width = m_config.width;
+    const int height = m_config.height;
+    int top = height;
+    int bottom = -1;
+    int left = width;
+    int right = -1;
+    for (int row = 0; row < height; row++)
+    {
+        const std::size_t offset = static_cast<std::size_t>(row) * static_cast<std::size_t>(width);
+        for (int column = 0; column < width; column++)
+        {
+            if (!samePixel(imageData[offset + static_cast<std::size_t>(column)], m_previous[offset + static_cast<std::size_t>(column)]))
+            {
+                top = std::min(top, row);
+                bottom = row;
+                left = std::min(left, column);
+                right = std::max(right, column);
+            }
+        }
+    }
+    if (bottom < 0)
+    {
+        // cgif keeps one pixel of a frame that equals the previous one
+        top = 0;
+        bottom = 0;
+        left = 0;
+        right = 0;
+    }
+
+    PendingFrame frame;
+    frame.config = {};
+    frame.config.width = static_cast<uint16_t>(right - left + 1);
+    frame.config.height = static_cast<uint16_t>(bottom - top + 1);
+    frame.config.top = static_cast<uint16_t>(top);
+    frame.config.left = static_cast<uint16_t>(left);
+    frame.data.resize(static_cast<std::size_t>(frame.config.width) * frame.config.height);
+    for (int row = 0; row < frame.config.height; row++)
+    {
+        std::memcpy(frame.data.data() + static_cast<std::size_t>(row) * frame.config.width,
+                    imageData + static_cast<std::size_t>(top + row) * static_cast<std::size_t>(width) + static_cast<std::size_t>(left),
+                    frame.config.width);
+    }
+    return frame;
+}
+
+bool GifStreamWriter::addFrame(const uint8_t* imageData, uint16_t delay, bool useDiffWindow, const uint8_t* localPalette,
+                               uint16_t localPaletteSize)
+{
+    if (m_failed || m_stream == nullptr)
+    {
+        return false;
+    }
+    const std::size_t frameSize = static_cast<std::size_t>(m_config.width) * m_config.height;
+    if (localPalette != nullptr)
+    {
+        tableColors(localPalette, localPaletteSize, OUTSIDE_CURRENT, m_currentColors);
+    }
+    else
+    {
+        m_currentColors = m_globalColors;
+    }
+
+    // a frame equal to the previous one only extends its delay
+    if (m_pending && m_pending->config.delay + static_cast<uint32_t>(delay) <= MAX_DELAY && sameAsPrevious(imageData))
+    {
+        m_pending->config.delay = static_cast<uint16_t>(m_pending->config.delay + delay);
+        return true;
+    }
+
+    // the delay of the previous frame is final now
+    submitPending();
+
+    PendingFrame frame;
+    if (useDiffWindow && !m_previous.empty())
+    {
+        frame = diffWindow(imageData);
+    }
+    else
+    {
+        frame.config = {};
+        frame.config.width = m_config.width;
+        frame.config.height = m_config.height;
+        frame.data.assign(imageData, imageData + frameSize);
+    }
+    frame.config.delay = delay;
+    frame.config.disposalMethod = DISPOSAL_METHOD_LEAVE;
+    if (localPalette != nullptr)
+    {
+        frame.palette.assign(localPalette, localPalette + localPaletteSize * 3u);
+        frame.config.sizeLCT = localPaletteSize;
+    }
+    m_pending = std::move(frame);
+    m_previous.assign(imageData, imageData + frameSize);
+    // the colors of the next frame are compared with these
+    for (std::size_t index = 0; index < m_previousColors.size(); index++)
+    {
+        m_previousColors[index] = m_currentColors[index] == OUTSIDE_CURRENT ? OUTSIDE_PREVIOUS : m_currentColors[index];
+    }
+
+    writeEncoded(2 * m_pool.size());
+    return !m_failed;
+}
+
+void GifStreamWriter::submitPending()
+{
+    if (!m_pending)
+    {
+        return;
+    }
+    auto frame = std::make_shared<PendingFrame>(std::move(*m_pending));
+    m_pending.reset();
+    m_encoded.push_back(m_pool.submit([config = m_config, frame, lossy = m_lossy.get(), quality = m_quality]() {
+        P_PROFILE_SCOPE("GifStreamWriter::encodeFrame");
+        EncodedFrame encoded;
+        // only the pixels inside the difference window are encoded, so only
+        // they take part in the lossy matching
+        if (frame->palette.empty())
+        {
+            lossy->apply(frame->data.data(), frame->data.size(), encoded.stats);
+        }
+        else
+        {
+            frame->config.pLCT = frame->palette.data();
+            LossyLzw(frame->palette.data(), frame->config.sizeLCT, quality).apply(frame->data.data(), frame->data.size(), encoded.stats);
+        }
+        frame->config.pImageData = frame->data.data();
+        encoded.result = encodeFrame(config, frame->config, encoded.bytes);
+        return encoded;
+    }));
+}
+
+// write the oldest frames in order until at most maxQueued are left
+void GifStreamWriter::writeEncoded(std::size_t maxQueued)
+{
+    while (m_encoded.size() > maxQueued)
+    {
+        std::future<EncodedFrame> oldest = std::move(m_encoded.front());
+        m_encoded.pop_front();
+        // the waiting thread compresses queued frames instead of idling
+        while (oldest.wait_for(std::chrono::seconds(0)) != std::future_status::ready && m_pool.runPendingTask())
+        {
+        }
+        const EncodedFrame frame = oldest.get();
+        if (frame.result != CGIF_OK)
+        {
+            P_LOGF_ERROR("Encoding a gif frame failed with {}\n", static_cast<int>(frame.result));
+            m_failed = true;
+            continue;
+        }
+        if (!m_failed && !m_sink->write(frame.bytes.data(), frame.bytes.size()))
+        {
+            m_failed = true;
+        }
+        m_stats.add(frame.stats);
+        P_PROFILE_COUNTER("gif.framesEncoded", 1);
+    }
+}
+
+bool GifStreamWriter::close()
+{
+    if (m_stream == nullptr)
+    {
+        return false;
+    }
+    submitPending();
+    writeEncoded(0);
+    // the trailer, the result of the header-only stream is still pending
+    cgif_raw_close(m_stream);
+    m_stream = nullptr;
+    const bool written = !m_failed && !m_sink->failed();
+    m_previous.clear();
+    return written;
+}
+
+const LossyStats& GifStreamWriter::stats() const
+{
+    return m_stats;
+}
+
+} // namespace pixelmancy
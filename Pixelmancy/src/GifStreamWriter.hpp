@@ -0,0 +1,123 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <optional>
+#include <vector>
+
+extern "C"
+{
+#include <cgif_raw.h>
+}
+
+#include "ByteSink.hpp"
+#include "LossyLzw.hpp"
+
+namespace pixelmancy {
+class ThreadPool;
+
+/**
+ * GIF writer that compresses frames on a thread pool and writes them in
+ * order. Frames go through the same identical frame merging and difference
+ * window as cgif_addframe(), so the file is byte-identical to the one cgif
+ * writes for the same frames. With a quality below LOSSLESS_QUALITY the
+ * frames are passed through LossyLzw before they are compressed.
+ */
+class GifStreamWriter
+{
+public:
+    /**
+     * @param pool pool to compress the frames on, it must outlive the writer
+     */
+    explicit GifStreamWriter(ThreadPool& pool);
+    ~GifStreamWriter();
+
+    GifStreamWriter(const GifStreamWriter&) = delete;
+    GifStreamWriter& operator=(const GifStreamWriter&) = delete;
+
+    /**
+     * Write the header and the global palette
+     * @param sink destination of the gif, it must outlive the writer
+     * @param width width of the frames
+     * @param height height of the frames
+     * @param palette global palette, RGBRGB...
+     * @param paletteSize number of colors in the palette, at most 256
+     * @param quality 0 to 100, LOSSLESS_QUALITY keeps the pixels as they are
+     * @return false if the header cannot be written
+     */
+    bool open(ByteSink& sink, uint16_t width, uint16_t height, const uint8_t* palette, uint16_t paletteSize,
+              int quality = LOSSLESS_QUALITY);
+
+    /**
+     * Queue a frame for compression, the data is copied
+     * @param imageData width * height palette indices
+     * @param delay delay of the frame in hundredths of a second
+     * @param useDiffWindow encode only the area that differs from the previous frame
+     * @param localPalette local color table of the frame, RGBRGB..., nullptr uses the global palette
+     * @param localPaletteSize number of colors in the local color table, at most 256
+     * @return false if an earlier frame failed
+     */
+    bool addFrame(const uint8_t* imageData, uint16_t delay, bool useDiffWindow, const uint8_t* localPalette = nullptr,
+                  uint16_t localPaletteSize = 0);
+
+    /**
+     * Write the remaining frames and the trailer
+     * @return false if a frame failed or the sink could not be written
+     */
+    bool close();
+
+    /**
+     * Color error of the frames written so far
+     */
+    const LossyStats& stats() const;
+
+private:
+    struct PendingFrame
+    {
+        std::vector<uint8_t> data;
+        // local color table, empty for the global palette
+        std::vector<uint8_t> palette;
+        CGIFRaw_FrameConfig config;
+    };
+
+    // RGB of every index of a color table, indices outside the table never
+    // equal any color
+    using TableColors = std::array<uint32_t, 256>;
+
+    struct EncodedFrame
+    {
+        cgif_result result = CGIF_OK;
+        std::vector<uint8_t> bytes;
+        LossyStats stats;
+    };
+
+    static void tableColors(const uint8_t* palette, uint16_t paletteSize, uint32_t outside, TableColors& colors);
+    bool samePixel(uint8_t current, uint8_t previous) const;
+    bool sameAsPrevious(const uint8_t* imageData) const;
+    PendingFrame diffWindow(const uint8_t* imageData) const;
+    void submitPending();
+    void writeEncoded(std::size_t maxQueued);
+
+    ThreadPool& m_pool;
+    ByteSink* m_sink = nullptr;
+    CGIFRaw* m_stream = nullptr;
+    CGIFRaw_Config m_config{};
+    std::vector<uint8_t> m_palette;
+    int m_quality = LOSSLESS_QUALITY;
+    std::unique_ptr<const LossyLzw> m_lossy;
+    LossyStats m_stats;
+    // colors of the frame being added and of the previous frame, compared
+    // by RGB like cmpPixel() of cgif
+    TableColors m_globalColors{};
+    TableColors m_currentColors{};
+    TableColors m_previousColors{};
+    std::vector<uint8_t> m_previous;
+    std::optional<PendingFrame> m_pending;
+    std::deque<std::future<EncodedFrame>> m_encoded;
+    bool m_failed = false;
+};
+
+} // namespace pixelmancy
@@ -1,10 +1,16 @@
 #include "Image.hpp"
+#include "ImageHandle.hpp"
 
 #include "Log.hpp"
 #include "PNG.hpp"
+#include "kernels/Kernels.hpp"
+#include "profiler/Profiler.hpp"
 #include <lodepng.h>
 
+#include <algorithm>
+#include <cstring>
 #include <memory>
+#include <vector>
 
 namespace pixelmancy {
 
@@ -40,8 +46,10 @@ Image Image::mergeImages(const Image &firstImage, const Image &secondImage) {
   return img;
 }
 
-Image::Image(int width, int height, const Color &background)
-    : m_imageDimensions({width, height}) {
+Image::Image(int width, int height, const Color &background,
+             std::pmr::memory_resource *resource)
+    : m_imageDimensions({width, height}), m_pixels(resource),
+      m_colorPalette(resource) {
   if (m_imageDimensions.isEmpty()) {
     return;
   }
@@ -55,6 +63,11 @@ Image::Image(const Image &other)
     : m_imageDimensions(other.m_imageDimensions), m_pixels(other.m_pixels),
       m_colorPalette(other.m_colorPalette) {}
 
+Image::Image(const Image &other, std::pmr::memory_resource *resource)
+    : m_imageDimensions(other.m_imageDimensions),
+      m_pixels(other.m_pixels, resource),
+      m_colorPalette(other.m_colorPalette, resource) {}
+
 Image::Image(Image &&other) noexcept
     : m_imageDimensions(other.m_imageDimensions),
       m_pixels(std::move(other.m_pixels)),
@@ -65,6 +78,19 @@ Image::Image(Image &&other) noexcept
   other.m_colorPalette.reset();
 }
 
+void Image::reset(int width, int height, const Color &background) {
+  m_imageDimensions = {width, height};
+  m_colorPalette.reset();
+  if (m_imageDimensions.isEmpty()) {
+    m_pixels.clear();
+    return;
+  }
+  auto index = m_colorPalette.addColor(background);
+  auto size = static_cast<std::size_t>(m_imageDimensions.width *
+                                       m_imageDimensions.height);
+  m_pixels.assign(size, index);
+}
+
 bool Image::operator==(const Image &other) const {
   if (m_imageDimensions != other.m_imageDimensions) {
     return false;
@@ -95,6 +121,25 @@ void Image::removeAlphaChannel() { m_colorPalette.convertToRGBfromRGBA(); }
 
 void Image::blueShift() { m_colorPalette.blueShift(); }
 
+void Image::replaceColors(std::pmr::vector<Color> &&colors) {
+  P_PROFILE_SCOPE("Image::replaceColors");
+  if (colors.size() != m_colorPalette.size()) {
+    P_LOGF_ERROR("Expected {} colors, got {}\n", m_colorPalette.size(),
+                 colors.size());
+    return;
+  }
+  const std::vector<uint16_t> oldToNewIndex =
+      m_colorPalette.replaceColors(std::move(colors));
+  if (oldToNewIndex.empty() || m_pixels.empty()) {
+    return;
+  }
+  const std::vector<uint32_t> table(oldToNewIndex.begin(),
+                                    oldToNewIndex.end());
+  kernels::active().translateIndices(m_pixels.data(), m_pixels.size(),
+                                     table.data(), m_pixels.data());
+  P_PROFILE_COUNTER("image.pixelsWritten", m_pixels.size());
+}
+
 Image Image::resize(double percentage) const {
   const int width =
       static_cast<int>(std::ceil(m_imageDimensions.width * percentage));
@@ -109,21 +154,37 @@ Image Image::resize(double percentage) const {
   }
   double scaleX = static_cast<double>(m_imageDimensions.width) / width;
   double scaleY = static_cast<double>(m_imageDimensions.height) / height;
-  Image newImage(width, height, WHITE);
+  Image newImage(width, height, WHITE, resource());
+
+  // nearest neighbour: every target column reads the same source column in
+  // each row, so rows are gathered and then mapped to the new palette
+  std::vector<int32_t> sourceColumns(static_cast<std::size_t>(width));
+  for (int x = 0; x < width; x++) {
+    const int originalX = static_cast<int>(std::floor(x * scaleX));
+    sourceColumns[static_cast<std::size_t>(x)] =
+        std::clamp(originalX, 0, m_imageDimensions.width - 1);
+  }
+  constexpr int UNRESOLVED = -1;
+  std::vector<int> sourceToLocalIndex(m_colorPalette.size(), UNRESOLVED);
+  std::vector<uint16_t> gathered(static_cast<std::size_t>(width));
+  const kernels::KernelTable &kernel = kernels::active();
   for (int y = 0; y < height; y++) {
+    const int originalY =
+        std::clamp(static_cast<int>(std::floor(y * scaleY)), 0,
+                   m_imageDimensions.height - 1);
+    kernel.gatherIndices(rowIndices(originalY),
+                         static_cast<std::size_t>(m_imageDimensions.width),
+                         sourceColumns.data(), gathered.size(),
+                         gathered.data());
+    // colors are added in the order they are met, like pixel by pixel copies
     for (int x = 0; x < width; x++) {
-      int originalX = static_cast<int>(std::floor(x * scaleX));
-      int originalY = static_cast<int>(std::floor(y * scaleY));
-      if (originalY < 0)
-        originalY = 0;
-      if (originalX < 0)
-        originalX = 0;
-      if (originalY >= m_imageDimensions.height)
-        originalY = m_imageDimensions.height - 1;
-      if (originalX >= m_imageDimensions.width)
-        originalX = m_imageDimensions.width - 1;
-      const Color &clr = (*this)(originalY, originalX);
-      newImage(y, x) = clr;
+      int &localIndex =
+          sourceToLocalIndex[gathered[static_cast<std::size_t>(x)]];
+      if (localIndex == UNRESOLVED) {
+        localIndex = newImage.resolveColor(
+            m_colorPalette.getColor(gathered[static_cast<std::size_t>(x)]));
+      }
+      newImage.setPixel(y, x, static_cast<uint16_t>(localIndex));
     }
   }
   return newImage;
@@ -147,7 +208,8 @@ bool Image::replaceColorPalette(ColorPallette &&colorPalette) {
   return true;
 }
 
-bool Image::reduceColorPalette(std::size_t expectedPaletteSize) {
+bool Image::reduceColorPalette(std::size_t expectedPaletteSize,
+                                Dither dither) {
   ColorPallette colorPalette = m_colorPalette;
   const std::vector<int> &oldToNewIndexMap =
       m_colorPalette.reduceColors(expectedPaletteSize);
@@ -157,6 +219,18 @@ bool Image::reduceColorPalette(std::size_t expectedPaletteSize) {
     return false;
   }
 
+  if (dither != Dither::None) {
+    // the pixels still index the original colors, they are diffused over
+    // the reduced ones
+    std::swap(m_colorPalette, colorPalette);
+    const std::vector<uint16_t> indices =
+        dither::remap(*this, colorPalette.getColors().data(),
+                      colorPalette.size(), dither);
+    std::swap(m_colorPalette, colorPalette);
+    std::copy(indices.begin(), indices.end(), m_pixels.begin());
+    return true;
+  }
+
   for (size_t i = 0; i < m_pixels.size(); i++) {
     m_pixels[i] = static_cast<uint16_t>(oldToNewIndexMap[m_pixels[i]]);
   }
@@ -167,7 +241,7 @@ bool Image::reduceColorPalette(std::size_t expectedPaletteSize) {
 // Removed rvalue reference return for member variable
 ColorPallette &&Image::colorPalette() { return std::move(m_colorPalette); }
 
-const ColorPallette &Image::getColorPalette() { return m_colorPalette; }
+const ColorPallette &Image::getColorPalette() const { return m_colorPalette; }
 
 int Image::getWidth() const { return m_imageDimensions.width; }
 
@@ -186,14 +260,96 @@ std::vector<uint8_t> Image::getImageData() const {
   return data;
 }
 
+uint16_t Image::resolveColor(const Color &color) {
+  return m_colorPalette.addColor(color);
+}
+
+void Image::fillRow(int row, int beginColumn, int endColumn,
+                    uint16_t colorIndex) {
+  if (row < 0 || row >= m_imageDimensions.height) {
+    return;
+  }
+  beginColumn = std::max(beginColumn, 0);
+  endColumn = std::min(endColumn, m_imageDimensions.width - 1);
+  if (beginColumn > endColumn) {
+    return;
+  }
+  kernels::active().fillIndices(
+      m_pixels.data() + row * m_imageDimensions.width + beginColumn,
+      static_cast<std::size_t>(endColumn - beginColumn + 1), colorIndex);
+  P_PROFILE_COUNTER("image.pixelsWritten", endColumn - beginColumn + 1);
+}
+
+void Image::copyRegion(const Image &source, const graphics::Rect &region) {
+  const graphics::Rect clipped =
+      region.intersected(bounds()).intersected(source.bounds());
+  if (clipped.isEmpty()) {
+    return;
+  }
+  constexpr int UNRESOLVED = -1;
+  std::vector<int> sourceToLocalIndex(source.m_colorPalette.size(),
+                                      UNRESOLVED);
+  for (int row = clipped.minX; row < clipped.maxX; row++) {
+    const auto sourceRow = static_cast<std::size_t>(
+        row * source.m_imageDimensions.width + clipped.minY);
+    const auto localRow =
+        static_cast<std::size_t>(row * m_imageDimensions.width + clipped.minY);
+    for (int column = 0; column < clipped.maxY - clipped.minY; column++) {
+      const uint16_t sourceIndex = source.m_pixels[sourceRow + column];
+      int &localIndex = sourceToLocalIndex[sourceIndex];
+      if (localIndex == UNRESOLVED) {
+        localIndex = m_colorPalette.addColor(
+            source.m_colorPalette.getColor(sourceIndex));
+      }
+      m_pixels[localRow + column] = static_cast<uint16_t>(localIndex);
+    }
+  }
+  P_PROFILE_COUNTER("image.pixelsWritten", clipped.area());
+}
+
+void Image::importRgba(const uint8_t *rgba) {
+  P_PROFILE_SCOPE("Image::importRgba");
+  // recently resolved colors, a hit skips both palette hash probes
+  constexpr std::size_t CACHE_SIZE = 4096;
+  struct CacheEntry {
+    uint32_t color = 0;
+    uint16_t index = 0;
+    bool used = false;
+  };
+  std::vector<CacheEntry> cache(CACHE_SIZE);
+  const std::size_t count = m_pixels.size();
+  for (std::size_t i = 0; i < count; i++) {
+    const uint8_t *bytes = rgba + i * 4;
+    uint32_t word = 0;
+    std::memcpy(&word, bytes, sizeof(word));
+    CacheEntry &entry = cache[(word * 2654435761u) >> 20];
+    if (!entry.used || entry.color != word) {
+      entry.color = word;
+      entry.index = m_colorPalette.addColor(
+          Color(bytes[0], bytes[1], bytes[2], bytes[3]));
+      entry.used = true;
+    }
+    m_pixels[i] = entry.index;
+  }
+  if (m_colorPalette.size() > 0x10000) {
+    P_LOGF_WARN("Image has {} colors, more than the 16 bit indices hold\n",
+                m_colorPalette.size());
+  }
+  P_PROFILE_COUNTER("image.pixelsWritten", count);
+}
+
 bool Image::isEmpty() const { return m_imageDimensions.isEmpty(); }
 
 Image Image::loadFromFile(const std::string &filePath) {
+  P_PROFILE_SCOPE("Image::loadFromFile");
   std::vector<unsigned char> buffer;
   std::vector<unsigned char> image;
   unsigned w, h;
 
-  lodepng::load_file(buffer, filePath);
+  {
+    P_PROFILE_SCOPE("lodepng::load_file");
+    lodepng::load_file(buffer, filePath);
+  }
   lodepng::State state;
 
   state.decoder.color_convert = 1;
@@ -202,43 +358,43 @@ Image Image::loadFromFile(const std::string &filePath) {
 
   P_LOG_INFO() << "Loading image from file: " << filePath << "\n";
   P_LOG_TRACE() << "buffer.size() " << buffer.size() << "\n";
-  unsigned error = lodepng::decode(image, w, h, state, buffer);
+  unsigned error = 0;
+  {
+    P_PROFILE_SCOPE("lodepng::decode");
+    error = lodepng::decode(image, w, h, state, buffer);
+  }
 
   if (error) {
     P_LOG_ERROR() << "decoder error " << error << " : "
                   << lodepng_error_text(error) << "\n";
     throw std::runtime_error(lodepng_error_text(error));
   }
-  P_LOG_TRACE() << fmt::format("Image size - width: {} height: {}\n", w, h);
-  P_LOG_TRACE() << fmt::format(
-      "Color type : {}\n", static_cast<int>(state.info_png.color.colortype));
-  P_LOG_TRACE() << fmt::format("Bit depth : {}\n",
-                               static_cast<int>(state.info_png.color.bitdepth));
-  P_LOG_TRACE() << fmt::format(
-      "Palette size : {}\n",
-      static_cast<int>(state.info_png.color.palettesize));
-
+  P_LOGF_TRACE("Image size - width: {} height: {}\n", w, h);
+  P_LOGF_TRACE("Color type : {}\n",
+               static_cast<int>(state.info_png.color.colortype));
+  P_LOGF_TRACE("Bit depth : {}\n",
+               static_cast<int>(state.info_png.color.bitdepth));
+  P_LOGF_TRACE("Palette size : {}\n",
+               static_cast<int>(state.info_png.color.palettesize));
+
+  P_PROFILE_SCOPE("Image::palettize");
   pixelmancy::Image img(static_cast<int>(w), static_cast<int>(h));
-
-  for (int j = 0; j < img.getHeight(); j++) {
-    for (int i = 0; i < img.getWidth(); i++) {
-      const auto imageIndex =
-          static_cast<std::size_t>((j * img.getWidth() + i) * 4);
-      const unsigned char red = image[imageIndex];
-      const unsigned char green = image[imageIndex + 1];
-      const unsigned char blue = image[imageIndex + 2];
-      const unsigned char alpha = image[imageIndex + 3];
-      const Color clr_(red, green, blue, alpha);
-      img(j, i) = clr_;
-    }
-  }
+  img.importRgba(image.data());
 
   return img;
 }
 
+ImageHandle Image::open(const std::string &filePath) {
+  return ImageHandle(filePath);
+}
+
 bool Image::save(const std::string &filePath) const {
   PNG png(*this);
   return png.save(filePath);
 }
 
+std::vector<unsigned char> Image::encodePng(PaletteOrder order) const {
+  return PNG(*this).encode(order);
+}
+
 } // namespace pixelmancy
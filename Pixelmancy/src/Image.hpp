@@ -1,34 +1,96 @@
 #pragma once
 
 #include "ColorPalette.hpp"
+#include "Dither.hpp"
+#include "PaletteUsage.hpp"
+#include "Rect.hpp"
 #include "colors/Color.hpp"
 #include "sizei2d.hpp"
 #include <logger/Log.hpp>
 
+#include <memory_resource>
+
 namespace pixelmancy {
+class ImageHandle;
+
 class Image {
 public:
   static Image loadFromFile(const std::string &filePath);
 
+  /**
+   * Open a PNG without decoding it, see ImageHandle
+   * @param filePath path of the png
+   * @return handle that reads the header now and the pixels when needed
+   */
+  static ImageHandle open(const std::string &filePath);
+
   static Image mergeImages(const Image &firstImage, const Image &secondImage);
 
-  Image(int width, int height, const Color &background = BLACK);
+  /**
+   * @param resource resource for the pixels and the palette, it must outlive
+   * the image
+   */
+  Image(int width, int height, const Color &background = BLACK,
+        std::pmr::memory_resource *resource = std::pmr::get_default_resource());
   Image(const Image &other);
+
+  /**
+   * Copy an image into another memory resource
+   */
+  Image(const Image &other, std::pmr::memory_resource *resource);
   Image(Image &&other) noexcept;
   Image &operator=(const Image &other) = default;
   Image &operator=(Image &&other) noexcept = default;
 
   ~Image() = default;
 
+  /**
+   * Turn the image into a blank image of the given size. The pixel buffer and
+   * the palette tables keep their capacity, so reusing an image for frames of
+   * the same size does not allocate.
+   * @param width new width
+   * @param height new height
+   * @param background color of every pixel
+   */
+  void reset(int width, int height, const Color &background = BLACK);
+
   bool isEmpty() const;
+
+  /**
+   * Get the memory resource the image allocates from
+   */
+  std::pmr::memory_resource *resource() const {
+    return m_pixels.get_allocator().resource();
+  }
   void removeAlphaChannel();
   void blueShift();
+
+  /**
+   * Apply a color function to every color of the image. Only the palette is
+   * transformed, the pixels are rewritten only when colors merge, so the cost
+   * follows the palette size instead of the pixel count.
+   * @param function callable taking a const Color& and returning a Color
+   */
+  template <typename F> void mapColors(F &&function) {
+    std::pmr::vector<Color> colors(m_colorPalette.resource());
+    colors.reserve(m_colorPalette.size());
+    for (const Color &color : m_colorPalette.getColors()) {
+      colors.push_back(function(color));
+    }
+    replaceColors(std::move(colors));
+  }
+
+  /**
+   * Give every palette index a new color, merging equal colors
+   * @param colors new color of every index, as many as the palette has
+   */
+  void replaceColors(std::pmr::vector<Color> &&colors);
   Image resize(double percentage) const;
   bool replaceColorPalette(const ColorPallette &colorPalette);
   bool replaceColorPalette(ColorPallette &&colorPalette);
 
   ColorPallette &&colorPalette();
-  const ColorPallette &getColorPalette();
+  const ColorPallette &getColorPalette() const;
 
   bool operator==(const Image &other) const;
 
@@ -44,12 +106,112 @@ public:
   std::size_t size() const;
 
   std::vector<uint8_t> getImageData() const;
-  bool reduceColorPalette(std::size_t expectedPaletteSize);
+
+  /**
+   * Get the palette index of a pixel without bounds checking
+   * @param row row of the pixel
+   * @param column column of the pixel
+   */
+  uint16_t colorIndex(int row, int column) const {
+    return m_pixels[static_cast<std::size_t>(row * m_imageDimensions.width +
+                                             column)];
+  }
+
+  /**
+   * Get the palette indices of a row, getWidth() entries
+   * @param row row of the image
+   */
+  const uint16_t *rowIndices(int row) const {
+    return m_pixels.data() +
+           static_cast<std::size_t>(row * m_imageDimensions.width);
+  }
+
+  /**
+   * Get the palette index of a color, adding the color to the palette when it
+   * is not there yet. Resolve once and write indices in tight drawing loops.
+   * @param color color to resolve
+   * @return palette index of the color
+   */
+  uint16_t resolveColor(const Color &color);
+
+  /**
+   * Check whether a pixel lies inside the image
+   * @param row row of the pixel
+   * @param column column of the pixel
+   */
+  bool contains(int row, int column) const {
+    return row >= 0 && row < m_imageDimensions.height && column >= 0 &&
+           column < m_imageDimensions.width;
+  }
+
+  /**
+   * Write a palette index without bounds checking, the caller must make sure
+   * that the pixel is inside the image (see contains())
+   * @param row row of the pixel
+   * @param column column of the pixel
+   * @param colorIndex index returned by resolveColor()
+   */
+  void setPixel(int row, int column, uint16_t colorIndex) {
+    m_pixels[static_cast<std::size_t>(row * m_imageDimensions.width +
+                                      column)] = colorIndex;
+  }
+
+  /**
+   * Fill the columns [beginColumn, endColumn] of a row with a palette index.
+   * The span is clipped to the image, rows outside the image are ignored.
+   * @param row row to fill
+   * @param beginColumn first column of the span
+   * @param endColumn last column of the span (inclusive)
+   * @param colorIndex index returned by resolveColor()
+   */
+  void fillRow(int row, int beginColumn, int endColumn, uint16_t colorIndex);
+
+  /**
+   * Copy the pixels of a region from another image into the same place in
+   * this image. Source palette indices are translated into this palette once
+   * per color, so the images do not need to share a palette.
+   * @param source image to copy from
+   * @param region region in drawing coordinates (x is the row), clipped to
+   * both images
+   */
+  void copyRegion(const Image &source, const graphics::Rect &region);
+
+  /**
+   * Overwrite every pixel from RGBA bytes. Recently seen colors are looked
+   * up in a small cache before the palette.
+   * @param rgba getWidth() * getHeight() colors of four bytes, row by row
+   */
+  void importRgba(const uint8_t *rgba);
+
+  /**
+   * Get the area of the image as a rectangle in drawing coordinates
+   */
+  graphics::Rect bounds() const {
+    return {0, 0, m_imageDimensions.height, m_imageDimensions.width};
+  }
+  /**
+   * Reduce the palette by dropping the low bits of the channels
+   * @param expectedPaletteSize colors to keep, rounded up to a power of two
+   * @param dither Dither::None maps every color to its reduced color, the
+   * others map the pixels with dither::remap() to hide the banding
+   * @return false if the palette is small enough already
+   */
+  bool reduceColorPalette(std::size_t expectedPaletteSize,
+                          Dither dither = Dither::None);
   bool save(const std::string &filePath) const;
 
+  /**
+   * Encode the image as a PNG in memory, without a file
+   * @param order see PNG::save()
+   * @return bytes of the PNG, empty if it could not be encoded
+   */
+  std::vector<unsigned char>
+  encodePng(PaletteOrder order = PaletteOrder::Unchanged) const;
+
   class Proxy {
   public:
-    Proxy(std::vector<uint16_t> &pixels, int index, ColorPallette &colorPalette)
+    Proxy(std::pmr::vector<uint16_t> &pixels, int index,
+          ColorPallette &colorPalette)
         : m_pixels(pixels), m_index(static_cast<unsigned int>(index)),
           m_colorPalette(colorPalette) {}
 
@@ -79,7 +241,7 @@ public:
     }
 
   private:
-    std::vector<uint16_t> &m_pixels;
+    std::pmr::vector<uint16_t> &m_pixels;
     unsigned int m_index;
     ColorPallette &m_colorPalette;
   };
@@ -91,7 +253,7 @@ public:
 
 private:
   sizei2d m_imageDimensions;
-  std::vector<uint16_t> m_pixels;
+  std::pmr::vector<uint16_t> m_pixels;
   ColorPallette m_colorPalette;
 };
 } // namespace pixelmancy
@@ -0,0 +1,101 @@
+#include "ImageCompare.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "Image.hpp"
+#include "kernels/Kernels.hpp"
+
+namespace pixelmancy {
+
+namespace {
+
+constexpr int CHANNELS = 4;
+
+// packed RGBA of every palette entry, so rows expand with one lookup per pixel
+std::vector<uint32_t> expandPalette(const ColorPallette& palette)
+{
+    std::vector<uint32_t> table;
+    table.reserve(palette.size());
+    for (const Color& color : palette.getColors())
+    {
+        table.push_back(kernels::packRgba(color.red, color.green, color.blue, color.alpha));
+    }
+    return table;
+}
+
+} // namespace
+
+CompareResult compare(const Image& expected, const Image& actual, const Tolerance& tolerance)
+{
+    CompareResult result;
+    if (expected.getWidth() != actual.getWidth() || expected.getHeight() != actual.getHeight())
+    {
+        result.sizeMismatch = true;
+        result.matches = false;
+        result.mismatchCount = std::max(expected.size(), actual.size());
+        result.maxChannelError = COLOR_CLAMP_VALUE;
+        result.psnr = 0.0;
+        result.diffBounds = expected.bounds().united(actual.bounds());
+        return result;
+    }
+
+    const int width = expected.getWidth();
+    // colors compare only RGB, so the palettes are compared as packed RGBA
+    const std::vector<uint32_t> expectedTable = expandPalette(expected.getColorPalette());
+    const std::vector<uint32_t> actualTable = expandPalette(actual.getColorPalette());
+    const bool samePalette = expectedTable == actualTable;
+    // the rows are contiguous, so equal images are found with one pass
+    if (samePalette &&
+        (expected.isEmpty() || std::equal(expected.rowIndices(0), expected.rowIndices(0) + expected.size(), actual.rowIndices(0))))
+    {
+        return result;
+    }
+    std::vector<uint32_t> expectedRow(static_cast<std::size_t>(width));
+    std::vector<uint32_t> actualRow(expectedRow.size());
+    std::vector<uint8_t> pixelError(static_cast<std::size_t>(width));
+    uint64_t squaredError = 0;
+    const kernels::KernelTable& kernel = kernels::active();
+
+    for (int row = 0; row < expected.getHeight(); row++)
+    {
+        const uint16_t* expectedIndices = expected.rowIndices(row);
+        const uint16_t* actualIndices = actual.rowIndices(row);
+        if (samePalette && std::equal(expectedIndices, expectedIndices + width, actualIndices))
+        {
+            continue;
+        }
+        kernel.expandIndices(expectedIndices, expectedRow.size(), expectedTable.data(), expectedRow.data());
+        kernel.expandIndices(actualIndices, actualRow.size(), actualTable.data(), actualRow.data());
+        squaredError += kernel.colorDistance(expectedRow.data(), actualRow.data(), expectedRow.size(), pixelError.data());
+
+        int firstColumn = -1;
+        int lastColumn = -1;
+        for (int column = 0; column < width; column++)
+        {
+            const int error = pixelError[static_cast<std::size_t>(column)];
+            result.maxChannelError = std::max(result.maxChannelError, error);
+            if (error > tolerance.channel)
+            {
+                result.mismatchCount++;
+                firstColumn = firstColumn < 0 ? column : firstColumn;
+                lastColumn = column;
+            }
+        }
+        if (firstColumn >= 0)
+        {
+            result.diffBounds = result.diffBounds.united({row, firstColumn, row + 1, lastColumn + 1});
+        }
+    }
+
+    if (squaredError > 0)
+    {
+        const double meanSquaredError = static_cast<double>(squaredError) / (static_cast<double>(expected.size()) * CHANNELS);
+        result.psnr = 10.0 * std::log10(static_cast<double>(COLOR_CLAMP_VALUE * COLOR_CLAMP_VALUE) / meanSquaredError);
+    }
+    result.matches = result.mismatchCount <= tolerance.mismatches;
+    return result;
+}
+
+} // namespace pixelmancy
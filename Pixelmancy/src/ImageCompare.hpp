@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "Rect.hpp"
+
+namespace pixelmancy {
+
+class Image;
+
+/**
+ * Differences that compare() accepts
+ */
+struct Tolerance
+{
+    // largest difference of a color channel that still counts as equal
+    int channel = 0;
+    // number of differing pixels that still counts as a match
+    std::size_t mismatches = 0;
+};
+
+/**
+ * Result of comparing two images pixel by pixel
+ */
+struct CompareResult
+{
+    // pixels with a channel difference larger than Tolerance::channel
+    std::size_t mismatchCount = 0;
+    // largest difference of any channel, tolerated or not
+    int maxChannelError = 0;
+    // peak signal to noise ratio over the RGBA channels, infinite for equal images
+    double psnr = std::numeric_limits<double>::infinity();
+    // area of the mismatching pixels in drawing coordinates (x is the row)
+    graphics::Rect diffBounds;
+    bool sizeMismatch = false;
+    // no size mismatch and at most Tolerance::mismatches differing pixels
+    bool matches = true;
+};
+
+/**
+ * Compare the colors of two images. Images with the same palette and pixel
+ * indices return without looking at the colors, rows with equal indices are
+ * skipped when the palettes are equal.
+ * @param expected reference image
+ * @param actual image to check
+ * @param tolerance accepted differences
+ */
+CompareResult compare(const Image& expected, const Image& actual, const Tolerance& tolerance = {});
+
+} // namespace pixelmancy
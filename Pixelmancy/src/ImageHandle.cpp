@@ -0,0 +1,227 @@
+#include "ImageHandle.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "Log.hpp"
+#include "Parallel.hpp"
+#include "lodepng.h"
+#include "profiler/Profiler.hpp"
+
+namespace pixelmancy {
+
+namespace {
+
+// signature and IHDR chunk, all lodepng_inspect() needs
+constexpr std::size_t PNG_HEADER_SIZE = 33;
+// length and type in front of the data of a chunk, CRC after it
+constexpr std::size_t CHUNK_HEADER_SIZE = 8;
+constexpr std::size_t CHUNK_CRC_SIZE = 4;
+// rows of the thumbnail averaged by one task
+constexpr int THUMBNAIL_GRAIN_ROWS = 8;
+
+uint32_t readUint32(const unsigned char* data)
+{
+    return static_cast<uint32_t>(data[0]) << 24 | static_cast<uint32_t>(data[1]) << 16 | static_cast<uint32_t>(data[2]) << 8 | data[3];
+}
+
+std::vector<unsigned char> decodeRgba(const std::string& filePath, unsigned& width, unsigned& height)
+{
+    std::vector<unsigned char> buffer;
+    std::vector<unsigned char> rgba;
+    {
+        P_PROFILE_SCOPE("lodepng::load_file");
+        lodepng::load_file(buffer, filePath);
+    }
+    P_PROFILE_SCOPE("lodepng::decode");
+    const unsigned error = lodepng::decode(rgba, width, height, buffer, LCT_RGBA, 8);
+    if (error)
+    {
+        P_LOGF_ERROR("decoder error {} : {}\n", error, lodepng_error_text(error));
+        throw std::runtime_error(lodepng_error_text(error));
+    }
+    return rgba;
+}
+
+// First source row or column of every target row or column, and the end of
+// the last one
+std::vector<int> boxEdges(int sourceSize, int targetSize)
+{
+    std::vector<int> edges(static_cast<std::size_t>(targetSize) + 1);
+    for (int i = 0; i <= targetSize; i++)
+    {
+        edges[static_cast<std::size_t>(i)] = static_cast<int>(static_cast<int64_t>(i) * sourceSize / targetSize);
+    }
+    return edges;
+}
+
+} // namespace
+
+ImageHandle::ImageHandle(std::string filePath, std::pmr::memory_resource* resource)
+ : m_filePath(std::move(filePath)),
+   m_resource(resource)
+{
+    P_PROFILE_SCOPE("ImageHandle::open");
+    std::ifstream file(m_filePath, std::ios::binary);
+    std::array<unsigned char, PNG_HEADER_SIZE> header{};
+    if (!file.read(reinterpret_cast<char*>(header.data()), header.size()))
+    {
+        P_LOGF_ERROR("Cannot read the header of {}\n", m_filePath);
+        return;
+    }
+    unsigned width = 0;
+    unsigned height = 0;
+    lodepng::State state;
+    const unsigned error = lodepng_inspect(&width, &height, &state, header.data(), header.size());
+    if (error)
+    {
+        P_LOGF_ERROR("{} is not a png: {}\n", m_filePath, lodepng_error_text(error));
+        return;
+    }
+    m_info.width = static_cast<int>(width);
+    m_info.height = static_cast<int>(height);
+    m_info.colorType = state.info_png.color.colortype;
+    m_info.bitDepth = state.info_png.color.bitdepth;
+
+    // the palette comes before the image data, the chunks in between are skipped
+    std::array<unsigned char, CHUNK_HEADER_SIZE> chunk{};
+    while (file.read(reinterpret_cast<char*>(chunk.data()), chunk.size()))
+    {
+        const uint32_t length = readUint32(chunk.data());
+        if (lodepng_chunk_type_equals(chunk.data(), "PLTE"))
+        {
+            m_info.paletteSize = length / 3;
+            break;
+        }
+        if (lodepng_chunk_type_equals(chunk.data(), "IDAT") || lodepng_chunk_type_equals(chunk.data(), "IEND"))
+        {
+            break;
+        }
+        file.seekg(static_cast<std::streamoff>(length + CHUNK_CRC_SIZE), std::ios::cur);
+    }
+    m_valid = true;
+}
+
+bool ImageHandle::isValid() const
+{
+    return m_valid;
+}
+
+const std::string& ImageHandle::getFilePath() const
+{
+    return m_filePath;
+}
+
+const ImageInfo& ImageHandle::info() const
+{
+    return m_info;
+}
+
+int ImageHandle::getWidth() const
+{
+    return m_info.width;
+}
+
+int ImageHandle::getHeight() const
+{
+    return m_info.height;
+}
+
+bool ImageHandle::isDecoded() const
+{
+    return m_image.has_value();
+}
+
+const Image& ImageHandle::image()
+{
+    if (!m_image)
+    {
+        P_PROFILE_SCOPE("ImageHandle::decode");
+        unsigned width = 0;
+        unsigned height = 0;
+        const std::vector<unsigned char> rgba = decodeRgba(m_filePath, width, height);
+        P_PROFILE_SCOPE("Image::palettize");
+        m_image.emplace(static_cast<int>(width), static_cast<int>(height), BLACK, m_resource);
+        m_image->importRgba(rgba.data());
+    }
+    return *m_image;
+}
+
+Image ImageHandle::decodeToSize(int maxWidth, int maxHeight) const
+{
+    P_PROFILE_SCOPE("ImageHandle::decodeToSize");
+    if (maxWidth <= 0 || maxHeight <= 0)
+    {
+        P_LOG_ERROR() << "Invalid thumbnail size\n";
+        return Image(0, 0, BLACK, m_resource);
+    }
+    unsigned width = 0;
+    unsigned height = 0;
+    const std::vector<unsigned char> rgba = decodeRgba(m_filePath, width, height);
+    const double scale = std::min({static_cast<double>(maxWidth) / width, static_cast<double>(maxHeight) / height, 1.0});
+    const int targetWidth = std::max(1, static_cast<int>(std::lround(width * scale)));
+    const int targetHeight = std::max(1, static_cast<int>(std::lround(height * scale)));
+    Image thumbnail(targetWidth, targetHeight, BLACK, m_resource);
+    if (targetWidth == static_cast<int>(width) && targetHeight == static_cast<int>(height))
+    {
+        thumbnail.importRgba(rgba.data());
+        return thumbnail;
+    }
+
+    // every target pixel is the average of the box of source pixels it covers
+    const std::vector<int> rows = boxEdges(static_cast<int>(height), targetHeight);
+    const std::vector<int> columns = boxEdges(static_cast<int>(width), targetWidth);
+    std::vector<unsigned char> averaged(static_cast<std::size_t>(targetWidth) * static_cast<std::size_t>(targetHeight) * 4);
+    parallelFor(thumbnail.bounds(), Grain{THUMBNAIL_GRAIN_ROWS, 0}, [&](const graphics::Rect& tile) {
+        std::vector<uint64_t> sums(static_cast<std::size_t>(targetWidth) * 4);
+        for (int row = tile.minX; row < tile.maxX; row++)
+        {
+            std::fill(sums.begin(), sums.end(), 0);
+            const int firstRow = rows[static_cast<std::size_t>(row)];
+            const int endRow = rows[static_cast<std::size_t>(row) + 1];
+            for (int sourceRow = firstRow; sourceRow < endRow; sourceRow++)
+            {
+                const unsigned char* source = rgba.data() + static_cast<std::size_t>(sourceRow) * width * 4;
+                for (int column = 0; column < targetWidth; column++)
+                {
+                    uint64_t* sum = sums.data() + static_cast<std::size_t>(column) * 4;
+                    for (int sourceColumn = columns[static_cast<std::size_t>(column)];
+                         sourceColumn < columns[static_cast<std::size_t>(column) + 1]; sourceColumn++)
+                    {
+                        const unsigned char* pixel = source + static_cast<std::size_t>(sourceColumn) * 4;
+                        sum[0] += pixel[0];
+                        sum[1] += pixel[1];
+                        sum[2] += pixel[2];
+                        sum[3] += pixel[3];
+                    }
+                }
+            }
+            unsigned char* target = averaged.data() + static_cast<std::size_t>(row) * static_cast<std::size_t>(targetWidth) * 4;
+            for (int column = 0; column < targetWidth; column++)
+            {
+                const auto area = static_cast<uint64_t>(endRow - firstRow) *
+                                  static_cast<uint64_t>(columns[static_cast<std::size_t>(column) + 1] - columns[static_cast<std::size_t>(column)]);
+                for (std::size_t channel = 0; channel < 4; channel++)
+                {
+                    const std::size_t i = static_cast<std::size_t>(column) * 4 + channel;
+                    target[i] = static_cast<unsigned char>((sums[i] + area / 2) / area);
+                }
+            }
+        }
+    });
+    P_PROFILE_SCOPE("Image::palettize");
+    thumbnail.importRgba(averaged.data());
+    return thumbnail;
+}
+
+void ImageHandle::release()
+{
+    m_image.reset();
+}
+
+} // namespace pixelmancy
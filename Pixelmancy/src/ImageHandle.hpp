@@ -0,0 +1,87 @@
+#pragma once
+
+#include "Image.hpp"
+
+#include <cstddef>
+#include <memory_resource>
+#include <optional>
+#include <string>
+
+namespace pixelmancy {
+
+/**
+ * What the header of a PNG tells without decoding it
+ */
+struct ImageInfo
+{
+    int width = 0;
+    int height = 0;
+    // PNG color type, see LodePNGColorType
+    unsigned colorType = 0;
+    unsigned bitDepth = 0;
+    // entries of the PLTE chunk, 0 for images without one
+    std::size_t paletteSize = 0;
+};
+
+/**
+ * PNG file that is decoded only when its pixels are needed. Opening it reads
+ * the IHDR chunk and the chunk headers up to the palette or the image data,
+ * so sizes of many files can be looked at without decoding any of them.
+ */
+class ImageHandle
+{
+public:
+    /**
+     * Read the header of a PNG
+     * @param filePath path of the png
+     * @param resource resource for the decoded image, it must outlive the handle
+     */
+    explicit ImageHandle(std::string filePath, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    /**
+     * @return false if the file could not be read or is not a PNG
+     */
+    bool isValid() const;
+
+    const std::string& getFilePath() const;
+    const ImageInfo& info() const;
+    int getWidth() const;
+    int getHeight() const;
+
+    /**
+     * @return true once image() has decoded the pixels
+     */
+    bool isDecoded() const;
+
+    /**
+     * Decode the image on the first call, later calls return the same image
+     * @throws std::runtime_error if the PNG cannot be decoded, like Image::loadFromFile()
+     */
+    const Image& image();
+
+    /**
+     * Decode the image scaled down to fit a box, for thumbnails. Pixels are
+     * averaged in RGBA before they are turned into palette indices, so only
+     * the small image is palettized. The decoded image of image() is not
+     * kept or used.
+     * @param maxWidth largest width of the result
+     * @param maxHeight largest height of the result
+     * @return image of the aspect ratio of the file, never larger than the file
+     * @throws std::runtime_error if the PNG cannot be decoded
+     */
+    Image decodeToSize(int maxWidth, int maxHeight) const;
+
+    /**
+     * Drop the decoded image, the next image() decodes again
+     */
+    void release();
+
+private:
+    std::string m_filePath;
+    std::pmr::memory_resource* m_resource;
+    ImageInfo m_info;
+    bool m_valid = false;
+    std::optional<Image> m_image;
+};
+
+} // namespace pixelmancy
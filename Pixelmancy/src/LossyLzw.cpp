@@ -0,0 +1,273 @@
+#include "LossyLzw.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+namespace pixelmancy {
+
+namespace {
+
+// codes of the LZW dictionary, as in cgif
+constexpr std::size_t MAX_DICT_LEN = 4096;
+constexpr std::uint16_t NO_CODE = 0;
+constexpr std::uint32_t NEVER = std::numeric_limits<std::uint32_t>::max();
+// inexact children tried when looking for the longest match of one code
+constexpr int SEARCH_BUDGET = 16;
+
+// the initial dictionary length cgif_raw uses for a palette
+std::uint16_t rootCount(std::uint16_t paletteSize)
+{
+    int power = 0;
+    while (paletteSize > (1u << power))
+    {
+        power++;
+    }
+    return static_cast<std::uint16_t>(power < 3 ? 4 : 1u << power);
+}
+
+} // namespace
+
+void LossyStats::add(const LossyStats& other)
+{
+    pixels += other.pixels;
+    changedPixels += other.changedPixels;
+    squaredError += other.squaredError;
+    maxSquaredError = std::max(maxSquaredError, other.maxSquaredError);
+}
+
+double LossyStats::rmsError() const
+{
+    return pixels == 0 ? 0.0 : std::sqrt(static_cast<double>(squaredError) / static_cast<double>(pixels));
+}
+
+double LossyStats::maxError() const
+{
+    return std::sqrt(static_cast<double>(maxSquaredError));
+}
+
+LossyLzw::LossyLzw(const std::uint8_t* palette, std::uint16_t paletteSize, int quality)
+ : m_rootCount(rootCount(paletteSize))
+{
+    const int maxDistance = (LOSSLESS_QUALITY - std::clamp(quality, 0, LOSSLESS_QUALITY)) * MAX_LOSSY_DISTANCE / LOSSLESS_QUALITY;
+    m_maxSquaredDistance = static_cast<std::uint32_t>(maxDistance * maxDistance);
+    if (lossless())
+    {
+        return;
+    }
+    m_distances.assign(static_cast<std::size_t>(m_rootCount) * m_rootCount, NEVER);
+    for (std::uint16_t first = 0; first < paletteSize; first++)
+    {
+        for (std::uint16_t second = 0; second < paletteSize; second++)
+        {
+            std::uint32_t squared = 0;
+            for (int channel = 0; channel < 3; channel++)
+            {
+                const int difference = palette[first * 3 + channel] - palette[second * 3 + channel];
+                squared += static_cast<std::uint32_t>(difference * difference);
+            }
+            m_distances[static_cast<std::size_t>(first) * m_rootCount + second] = squared;
+        }
+    }
+    // the colors each color may be replaced with, closest first
+    m_neighbours.resize(m_rootCount);
+    for (std::uint16_t color = 0; color < paletteSize; color++)
+    {
+        const std::uint32_t* distances = m_distances.data() + static_cast<std::size_t>(color) * m_rootCount;
+        for (std::uint16_t other = 0; other < paletteSize; other++)
+        {
+            if (other != color && distances[other] <= m_maxSquaredDistance)
+            {
+                m_neighbours[color].push_back(static_cast<std::uint8_t>(other));
+            }
+        }
+        std::stable_sort(m_neighbours[color].begin(), m_neighbours[color].end(),
+                         [distances](std::uint8_t first, std::uint8_t second) { return distances[first] < distances[second]; });
+    }
+}
+
+bool LossyLzw::lossless() const
+{
+    return m_maxSquaredDistance == 0;
+}
+
+// The LZW dictionary of the encoder and the state of the search for the
+// longest match
+struct LossyLzw::Search
+{
+    // code of every string extended by one color, rootCount colors per code.
+    // Only the slots in written are set, the rest are NO_CODE
+    std::vector<std::uint16_t> children;
+    std::vector<std::size_t> written;
+    const std::uint8_t* original = nullptr;
+    std::size_t count = 0;
+    std::size_t start = 0;
+    // colors of the path being searched and of the longest path found,
+    // the first syncedLength colors of both are the same
+    std::vector<std::uint8_t> path;
+    std::vector<std::uint8_t> best;
+    std::size_t syncedLength = 0;
+    std::size_t bestEnd = 0;
+    std::uint16_t bestCode = NO_CODE;
+    int budget = 0;
+    // a code being extended, and how far it is: 0 before its exact child,
+    // then 1 + the number of neighbours looked at
+    struct Step
+    {
+        std::uint16_t code;
+        std::size_t position;
+        std::size_t tried;
+    };
+    std::vector<Step> stack;
+};
+
+// Follow every child close enough to the pixel at position and keep the
+// path that reaches furthest. The exact child is tried first, so a search
+// cut short by the budget still finds what the lossless encoder would. Paths
+// are as long as the dictionary strings, so they are followed with a stack of
+// their own instead of recursion on the small stacks of the pool threads.
+void LossyLzw::extend(Search& search, std::uint16_t code, std::size_t position) const
+{
+    // keep the path if it is the longest yet, and go on from it unless the
+    // pixels or the colors of the roots end there
+    auto reach = [this, &search](std::uint16_t reached, std::size_t end) {
+        if (end > search.bestEnd)
+        {
+            const std::size_t length = end - search.start;
+            std::copy(search.path.begin() + static_cast<std::ptrdiff_t>(search.syncedLength),
+                      search.path.begin() + static_cast<std::ptrdiff_t>(length),
+                      search.best.begin() + static_cast<std::ptrdiff_t>(search.syncedLength));
+            search.syncedLength = length;
+            search.bestEnd = end;
+            search.bestCode = reached;
+        }
+        if (end < search.count && search.original[end] < m_rootCount)
+        {
+            search.stack.push_back({reached, end, 0});
+        }
+    };
+
+    search.stack.clear();
+    reach(code, position);
+    while (!search.stack.empty())
+    {
+        Search::Step& step = search.stack.back();
+        const std::uint8_t pixel = search.original[step.position];
+        const std::size_t depth = step.position - search.start;
+        const std::uint16_t* children = search.children.data() + static_cast<std::size_t>(step.code) * m_rootCount;
+        const std::size_t next = step.position + 1;
+        if (step.tried == 0)
+        {
+            step.tried = 1;
+            if (children[pixel] != NO_CODE)
+            {
+                search.syncedLength = std::min(search.syncedLength, depth);
+                search.path[depth] = pixel;
+                reach(children[pixel], next);
+                continue;
+            }
+        }
+        const std::vector<std::uint8_t>& neighbours = m_neighbours[pixel];
+        std::size_t neighbour = step.tried - 1;
+        while (neighbour < neighbours.size() && search.budget != 0 && children[neighbours[neighbour]] == NO_CODE)
+        {
+            neighbour++;
+        }
+        if (neighbour == neighbours.size() || search.budget == 0)
+        {
+            search.stack.pop_back();
+            continue;
+        }
+        step.tried = neighbour + 2;
+        search.budget--;
+        search.syncedLength = std::min(search.syncedLength, depth);
+        search.path[depth] = neighbours[neighbour];
+        reach(children[neighbours[neighbour]], next);
+    }
+}
+
+void LossyLzw::apply(std::uint8_t* indices, std::size_t count, LossyStats& stats) const
+{
+    stats.pixels += count;
+    if (lossless() || count == 0)
+    {
+        return;
+    }
+    // the dictionary of the thread is kept between frames and only the codes
+    // set are cleared, instead of allocating and filling the whole table
+    thread_local Search search;
+    if (search.children.size() < MAX_DICT_LEN * m_rootCount)
+    {
+        search.children.resize(MAX_DICT_LEN * m_rootCount, NO_CODE);
+    }
+    auto clearDictionary = []() {
+        for (const std::size_t slot : search.written)
+        {
+            search.children[slot] = NO_CODE;
+        }
+        search.written.clear();
+    };
+    search.original = indices;
+    search.count = count;
+    const std::size_t firstFreeCode = m_rootCount + 2u;
+    std::size_t nextCode = firstFreeCode;
+
+    std::size_t position = 0;
+    while (position < count)
+    {
+        const std::uint16_t root = indices[position];
+        if (root >= m_rootCount)
+        {
+            // the encoder rejects the frame, leave it as it is
+            clearDictionary();
+            return;
+        }
+        // no code is longer than the dictionary
+        const std::size_t longest = std::min(count - position, MAX_DICT_LEN);
+        search.path.resize(longest);
+        search.best.resize(longest);
+        search.start = position + 1;
+        search.syncedLength = 0;
+        search.bestEnd = 0;
+        search.budget = SEARCH_BUDGET;
+        extend(search, root, position + 1);
+
+        // the encoder finds the same code in the replaced pixels
+        for (std::size_t i = 0; i < search.bestEnd - search.start; i++)
+        {
+            const std::uint8_t pixel = indices[search.start + i];
+            const std::uint8_t replacement = search.best[i];
+            if (replacement != pixel)
+            {
+                const std::uint32_t error = m_distances[static_cast<std::size_t>(pixel) * m_rootCount + replacement];
+                indices[search.start + i] = replacement;
+                stats.changedPixels++;
+                stats.squaredError += error;
+                stats.maxSquaredError = std::max(stats.maxSquaredError, error);
+            }
+        }
+        position = search.bestEnd;
+        if (position == count)
+        {
+            break;
+        }
+        // the encoder writes the code and adds the next one, or starts over
+        // with a full dictionary
+        const std::size_t child = static_cast<std::size_t>(search.bestCode) * m_rootCount + indices[position];
+        if (nextCode < MAX_DICT_LEN)
+        {
+            search.children[child] = static_cast<std::uint16_t>(nextCode);
+            search.written.push_back(child);
+            nextCode++;
+        }
+        else
+        {
+            clearDictionary();
+            nextCode = firstFreeCode;
+        }
+    }
+    clearDictionary();
+}
+
+} // namespace pixelmancy
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace pixelmancy {
+
+/**
+ * Quality that keeps every pixel, lower qualities allow larger color errors
+ */
+constexpr int LOSSLESS_QUALITY = 100;
+
+/**
+ * Largest RGB distance a pixel may move at quality 0
+ */
+constexpr int MAX_LOSSY_DISTANCE = 64;
+
+/**
+ * Color error caused by lossy LZW
+ */
+struct LossyStats
+{
+    // pixels passed to the encoder
+    std::uint64_t pixels = 0;
+    // pixels encoded with another color
+    std::uint64_t changedPixels = 0;
+    // sum of the squared RGB distances of the changed pixels
+    std::uint64_t squaredError = 0;
+    // largest squared RGB distance of a changed pixel
+    std::uint32_t maxSquaredError = 0;
+
+    void add(const LossyStats& other);
+
+    /**
+     * Root mean square RGB distance over all pixels
+     */
+    double rmsError() const;
+
+    /**
+     * Largest RGB distance of a pixel
+     */
+    double maxError() const;
+};
+
+/**
+ * Lossy LZW like gifsicle --lossy. The frame is walked through the same LZW
+ * dictionary the encoder builds, and a pixel that does not extend the
+ * current code is replaced with a color that does, if that color is close
+ * enough. The lossless encoder then finds the longer codes in the changed
+ * pixels.
+ */
+class LossyLzw
+{
+public:
+    /**
+     * @param palette palette of the frames, RGBRGB...
+     * @param paletteSize number of colors in the palette, at most 256
+     * @param quality 0 to 100, LOSSLESS_QUALITY keeps the pixels
+     */
+    LossyLzw(const std::uint8_t* palette, std::uint16_t paletteSize, int quality);
+
+    /**
+     * @return true if apply() leaves the pixels as they are
+     */
+    bool lossless() const;
+
+    /**
+     * Replace pixels that lengthen the LZW codes of the frame
+     * @param indices palette indices of the frame, changed in place
+     * @param count number of pixels
+     * @param stats error of the replaced pixels is added here
+     */
+    void apply(std::uint8_t* indices, std::size_t count, LossyStats& stats) const;
+
+private:
+    struct Search;
+
+    void extend(Search& search, std::uint16_t code, std::size_t position) const;
+
+    // colors of the LZW roots, a power of two like in the encoder
+    std::uint16_t m_rootCount = 0;
+    std::uint32_t m_maxSquaredDistance = 0;
+    // squared RGB distance of every pair of roots, indices outside the
+    // palette are never replaced
+    std::vector<std::uint32_t> m_distances;
+    // colors close enough to replace each color, closest first
+    std::vector<std::vector<std::uint8_t>> m_neighbours;
+};
+
+} // namespace pixelmancy
@@ -1,8 +1,14 @@
 #include "PNG.hpp"
 
+#include <algorithm>
+#include <fstream>
+
+#include "ByteSink.hpp"
 #include "Image.hpp"
 #include "Log.hpp"
+#include "kernels/Kernels.hpp"
 #include "lodepng.h"
+#include "profiler/Profiler.hpp"
 
 namespace pixelmancy {
 
@@ -12,35 +18,157 @@ PNG::PNG(const Image& image) : _image(image)
 
 PNG::~PNG() = default;
 
-bool PNG::save(const std::string& filePath)
+namespace {
+
+// colors of a PNG palette
+constexpr std::size_t MAX_PNG_PALETTE = 256;
+
+// the smallest bit depth that holds the palette indices
+unsigned paletteBitDepth(std::size_t colors)
+{
+    unsigned bits = 1;
+    while ((std::size_t{1} << bits) < colors)
+    {
+        bits *= 2;
+    }
+    return bits;
+}
+
+} // namespace
+
+bool PNG::save(const std::string& filePath, PaletteOrder order)
+{
+    std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        P_LOGF_ERROR("Cannot open {} for writing\n", filePath);
+        return false;
+    }
+    ByteSink sink(file);
+    const bool saved = save(sink, order);
+    file.close();
+    return saved && !file.fail();
+}
+
+bool PNG::save(ByteSink& sink, PaletteOrder order)
+{
+    P_PROFILE_SCOPE("PNG::save");
+    const std::vector<unsigned char> png = encode(order);
+    if (png.empty())
+    {
+        return false;
+    }
+    P_PROFILE_SCOPE("PNG::write");
+    return sink.write(png.data(), png.size());
+}
+
+std::vector<unsigned char> PNG::encode(PaletteOrder order) const
+{
+    P_PROFILE_SCOPE("PNG::encode");
+    std::vector<uint16_t> entries;
+    if (order == PaletteOrder::ByUsage)
+    {
+        P_PROFILE_SCOPE("PNG::paletteUsage");
+        PaletteUsage usage(_image.getColorPalette().size());
+        usage.addImage(_image);
+        entries = usage.order();
+    }
+
+    std::vector<unsigned char> png;
+    // images of more colors than a PNG palette holds stay RGBA
+    const unsigned error = !entries.empty() && entries.size() <= MAX_PNG_PALETTE ? encodeIndexed(entries, png) : encodeRgba(png);
+    if (error)
+    {
+        P_LOGF_ERROR("encoder error {}: {}\n", error, lodepng_error_text(error));
+        return {};
+    }
+    P_PROFILE_COUNTER("png.bytesEncoded", png.size());
+    return png;
+}
+
+unsigned PNG::encodeRgba(std::vector<unsigned char>& png) const
 {
-    std::vector<unsigned char> image;
     const auto width = static_cast<uint16_t>(_image.getWidth());
     const auto height = static_cast<uint16_t>(_image.getHeight());
-    image.reserve(static_cast<std::size_t>(width * height * 4));
+    // RGBA bytes of every pixel, packed as by kernels::packRgba
+    std::vector<uint32_t> image(static_cast<std::size_t>(width * height));
 
-    for (uint16_t x = 0; x < _image.getHeight(); x++)
     {
-        for (uint16_t y = 0; y < _image.getWidth(); y++)
+        P_PROFILE_SCOPE("PNG::convert");
+        std::vector<uint32_t> palette;
+        palette.reserve(_image.getColorPalette().size());
+        for (const Color& color : _image.getColorPalette().getColors())
         {
-            const Color& clr_ = _image(x, y);
-            image.push_back(clr_.red);
-            image.push_back(clr_.green);
-            image.push_back(clr_.blue);
-            image.push_back(clr_.alpha);
+            palette.push_back(kernels::packRgba(color.red, color.green, color.blue, color.alpha));
+        }
+        // the rows are contiguous, so the whole image expands in one call
+        if (!image.empty())
+        {
+            kernels::active().expandIndices(_image.rowIndices(0), _image.size(), palette.data(), image.data());
         }
     }
 
     lodepng::State state;
     state.encoder.auto_convert = 1;
-    std::vector<unsigned char> png;
-    unsigned error = lodepng::encode(png, image, width, height, state);
+    P_PROFILE_SCOPE("lodepng::encode");
+    return lodepng::encode(png, reinterpret_cast<const unsigned char*>(image.data()), width, height, state);
+}
+
+// Palette PNG with the entries in the given order. Translucent entries go
+// first, so the tRNS chunk stays short.
+unsigned PNG::encodeIndexed(const std::vector<uint16_t>& entries, std::vector<unsigned char>& png) const
+{
+    const auto width = static_cast<unsigned>(_image.getWidth());
+    const auto height = static_cast<unsigned>(_image.getHeight());
+    const std::pmr::vector<Color>& colors = _image.getColorPalette().getColors();
+    std::vector<uint16_t> ordered(entries);
+    std::stable_partition(ordered.begin(), ordered.end(), [&colors](uint16_t entry) { return colors[entry].alpha != 255; });
+
+    lodepng::State state;
+    state.encoder.auto_convert = 0;
+    for (LodePNGColorMode* mode : {&state.info_raw, &state.info_png.color})
+    {
+        mode->colortype = LCT_PALETTE;
+        mode->bitdepth = 8;
+        for (const uint16_t entry : ordered)
+        {
+            lodepng_palette_add(mode, colors[entry].red, colors[entry].green, colors[entry].blue, colors[entry].alpha);
+        }
+    }
+    state.info_png.color.bitdepth = paletteBitDepth(ordered.size());
+
+    std::vector<uint8_t> indices(_image.size());
+    {
+        P_PROFILE_SCOPE("PNG::remap");
+        // new index of every palette index, one table pass over the pixels
+        std::vector<uint32_t> lookup(colors.size(), 0);
+        for (std::size_t i = 0; i < ordered.size(); i++)
+        {
+            lookup[ordered[i]] = static_cast<uint32_t>(i);
+        }
+        if (!indices.empty())
+        {
+            kernels::active().remapIndices(_image.rowIndices(0), _image.size(), lookup.data(), lookup.size(), indices.data());
+        }
+    }
+
+    P_PROFILE_SCOPE("lodepng::encode");
+    const unsigned error = lodepng::encode(png, indices.data(), width, height, state);
     if (error)
     {
-        P_LOG_ERROR() << fmt::format("encoder error {}: {}\n", error, lodepng_error_text(error));
-        return false;
+        return error;
+    }
+    // neighbouring colors have close indices, so filtered rows often
+    // compress better than the unfiltered rows lodepng uses for palettes
+    std::vector<unsigned char> filtered;
+    state.encoder.filter_palette_zero = 0;
+    state.encoder.filter_strategy = LFS_ENTROPY;
+    // only a smaller file, the unfiltered one is kept if this fails
+    if (lodepng::encode(filtered, indices.data(), width, height, state) == 0 && filtered.size() < png.size())
+    {
+        png.swap(filtered);
     }
-    return lodepng::save_file(png, filePath) == 0;
+    return 0;
 }
 
 } // namespace pixelmancy
@@ -1,18 +1,46 @@
 #pragma once
 
 #include "Image.hpp"
+#include "PaletteUsage.hpp"
 
 namespace pixelmancy {
+class ByteSink;
+
 class PNG
 {
 public:
     explicit PNG(const Image& image);
     ~PNG();
 
-    bool save(const std::string& filePath);
+    /**
+     * Save the image as a PNG
+     * @param filePath path to save the png
+     * @param order PaletteOrder::ByUsage writes an image of at most 256
+     * colors with a palette sorted by PaletteUsage, and keeps the smaller of
+     * unfiltered and filtered rows. The neighbour ordering makes the filters
+     * worth trying, it takes about twice as long.
+     */
+    bool save(const std::string& filePath, PaletteOrder order = PaletteOrder::Unchanged);
+
+    /**
+     * Save the image as a PNG to a sink instead of a file
+     * @param sink destination of the bytes
+     * @param order see save(const std::string&, PaletteOrder)
+     */
+    bool save(ByteSink& sink, PaletteOrder order = PaletteOrder::Unchanged);
+
+    /**
+     * Encode the image as a PNG in memory
+     * @param order see save(const std::string&, PaletteOrder)
+     * @return bytes of the PNG, empty if it could not be encoded
+     */
+    std::vector<unsigned char> encode(PaletteOrder order = PaletteOrder::Unchanged) const;
     // Image load(const std::string& filePath);
 
 private:
+    unsigned encodeRgba(std::vector<unsigned char>& png) const;
+    unsigned encodeIndexed(const std::vector<uint16_t>& entries, std::vector<unsigned char>& png) const;
+
     const Image& _image;
 };
 
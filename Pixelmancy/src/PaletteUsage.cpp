@@ -0,0 +1,128 @@
+#include "PaletteUsage.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+#include "Image.hpp"
+
+namespace pixelmancy {
+
+PaletteUsage::PaletteUsage(std::size_t paletteSize)
+ : m_counts(paletteSize, 0)
+{
+    if (paletteSize <= MAX_NEIGHBOUR_COLORS)
+    {
+        m_neighbours.assign(paletteSize * paletteSize, 0);
+    }
+}
+
+void PaletteUsage::addImage(const Image& image, const uint32_t* lookup)
+{
+    const std::size_t size = m_counts.size();
+    const bool neighbours = !m_neighbours.empty();
+    const int width = image.getWidth();
+    const uint16_t* previousRow = nullptr;
+    for (int row = 0; row < image.getHeight(); row++)
+    {
+        const uint16_t* indices = image.rowIndices(row);
+        uint32_t left = 0;
+        for (int column = 0; column < width; column++)
+        {
+            const uint32_t entry = lookup != nullptr ? lookup[indices[column]] : indices[column];
+            if (entry >= size)
+            {
+                // the next pixel is not a neighbour of the one before this
+                left = entry;
+                continue;
+            }
+            m_counts[entry]++;
+            if (!neighbours)
+            {
+                continue;
+            }
+            if (column > 0 && left != entry && left < size)
+            {
+                m_neighbours[left * size + entry]++;
+                m_neighbours[entry * size + left]++;
+            }
+            if (previousRow != nullptr)
+            {
+                const uint32_t above = lookup != nullptr ? lookup[previousRow[column]] : previousRow[column];
+                if (above != entry && above < size)
+                {
+                    m_neighbours[above * size + entry]++;
+                    m_neighbours[entry * size + above]++;
+                }
+            }
+            left = entry;
+        }
+        previousRow = indices;
+    }
+}
+
+void PaletteUsage::addPixels(uint32_t entry, std::uint64_t pixels)
+{
+    if (entry < m_counts.size())
+    {
+        m_counts[entry] += pixels;
+    }
+}
+
+void PaletteUsage::add(const PaletteUsage& other)
+{
+    if (other.m_counts.size() != m_counts.size())
+    {
+        return;
+    }
+    std::transform(m_counts.begin(), m_counts.end(), other.m_counts.begin(), m_counts.begin(), std::plus<>());
+    std::transform(m_neighbours.begin(), m_neighbours.end(), other.m_neighbours.begin(), m_neighbours.begin(), std::plus<>());
+}
+
+std::uint64_t PaletteUsage::count(uint32_t entry) const
+{
+    return entry < m_counts.size() ? m_counts[entry] : 0;
+}
+
+std::vector<uint16_t> PaletteUsage::order() const
+{
+    std::vector<uint16_t> byCount;
+    for (std::size_t entry = 0; entry < m_counts.size(); entry++)
+    {
+        if (m_counts[entry] > 0)
+        {
+            byCount.push_back(static_cast<uint16_t>(entry));
+        }
+    }
+    std::stable_sort(byCount.begin(), byCount.end(), [this](uint16_t first, uint16_t second) { return m_counts[first] > m_counts[second]; });
+    if (m_neighbours.empty() || byCount.empty())
+    {
+        return byCount;
+    }
+
+    // a greedy path through the neighbour counts, ties go to the more used entry
+    const std::size_t size = m_counts.size();
+    std::vector<uint16_t> order;
+    order.reserve(byCount.size());
+    std::vector<bool> placed(size, false);
+    order.push_back(byCount.front());
+    placed[byCount.front()] = true;
+    while (order.size() < byCount.size())
+    {
+        const uint32_t* neighbours = m_neighbours.data() + static_cast<std::size_t>(order.back()) * size;
+        uint16_t next = 0;
+        bool found = false;
+        for (const uint16_t entry : byCount)
+        {
+            if (!placed[entry] && (!found || neighbours[entry] > neighbours[next]))
+            {
+                next = entry;
+                found = true;
+            }
+        }
+        order.push_back(next);
+        placed[next] = true;
+    }
+    return order;
+}
+
+} // namespace pixelmancy
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace pixelmancy {
+class Image;
+
+/**
+ * Order of the palette entries in a saved file
+ */
+enum class PaletteOrder
+{
+    // entries in the order the colors were added
+    Unchanged,
+    // unused entries dropped, the rest ordered by PaletteUsage::order()
+    ByUsage,
+};
+
+/**
+ * How often the pixels use each palette entry and how often two entries are
+ * next to each other
+ */
+class PaletteUsage
+{
+public:
+    /**
+     * Neighbours are only counted for palettes up to this size
+     */
+    static constexpr std::size_t MAX_NEIGHBOUR_COLORS = 256;
+
+    /**
+     * @param paletteSize number of entries in the palette
+     */
+    explicit PaletteUsage(std::size_t paletteSize);
+
+    /**
+     * Count the pixels of an image and their right and lower neighbours
+     * @param image image to count
+     * @param lookup palette entry of every palette index of the image, nullptr if they are the same
+     */
+    void addImage(const Image& image, const uint32_t* lookup = nullptr);
+
+    /**
+     * Count pixels that have no neighbours in the images, like the canvas outside a frame
+     */
+    void addPixels(uint32_t entry, std::uint64_t pixels);
+
+    void add(const PaletteUsage& other);
+
+    std::uint64_t count(uint32_t entry) const;
+
+    /**
+     * The used entries, most used first, each following entry the one that
+     * is next to the previous entry most often. Neighbouring colors get
+     * close indices, which keeps PNG filter differences small.
+     * @return palette entry of every new index
+     */
+    std::vector<uint16_t> order() const;
+
+private:
+    std::vector<std::uint64_t> m_counts;
+    // pixels of the first entry next to the second, both ways
+    std::vector<uint32_t> m_neighbours;
+};
+
+} // namespace pixelmancy
@@ -0,0 +1,103 @@
+#include "Parallel.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+namespace pixelmancy {
+
+TaskGroup::TaskGroup(ThreadPool& pool) : m_pool(pool)
+{
+}
+
+TaskGroup::~TaskGroup()
+{
+    waitForTasks();
+}
+
+void TaskGroup::wait()
+{
+    waitForTasks();
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::swap(error, m_error);
+    }
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
+
+void TaskGroup::waitForTasks()
+{
+    while (m_pending.load() > 0)
+    {
+        if (m_pool.runPendingTask())
+        {
+            continue;
+        }
+        // the remaining tasks run on other threads, but they may still queue
+        // work of their own, so look for tasks again after a while
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait_for(lock, std::chrono::milliseconds(1), [this]() { return m_pending.load() == 0; });
+    }
+    // the last finishTask() may still hold the lock, it is done with the group
+    // once the lock is free
+    std::lock_guard<std::mutex> lock(m_mutex);
+}
+
+void TaskGroup::recordError(std::exception_ptr error)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_error)
+    {
+        m_error = std::move(error);
+    }
+}
+
+void TaskGroup::finishTask()
+{
+    // notify while locked so the group cannot be destroyed in between
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (--m_pending == 0)
+    {
+        m_done.notify_all();
+    }
+}
+
+void parallelFor(const graphics::Rect& range, Grain grain, const std::function<void(const graphics::Rect&)>& body,
+                 ThreadPool& pool)
+{
+    if (range.isEmpty())
+    {
+        return;
+    }
+    const int tileRows = std::max(1, grain.rows);
+    const int tileColumns = grain.columns > 0 ? grain.columns : range.maxY - range.minY;
+    std::vector<graphics::Rect> tiles;
+    for (int row = range.minX; row < range.maxX; row += tileRows)
+    {
+        for (int column = range.minY; column < range.maxY; column += tileColumns)
+        {
+            tiles.emplace_back(row, column, std::min(row + tileRows, range.maxX), std::min(column + tileColumns, range.maxY));
+        }
+    }
+
+    if (pool.size() == 1 || tiles.size() == 1)
+    {
+        for (const auto& tile : tiles)
+        {
+            body(tile);
+        }
+        return;
+    }
+    TaskGroup group(pool);
+    for (const auto& tile : tiles)
+    {
+        group.run([&body, tile]() { body(tile); });
+    }
+    group.wait();
+}
+
+} // namespace pixelmancy
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "Rect.hpp"
+#include "ThreadPool.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+
+namespace pixelmancy {
+
+/**
+ * Set of tasks that are waited for together. The thread calling wait() runs
+ * queued tasks of the pool until the tasks of the group are done.
+ */
+class TaskGroup
+{
+public:
+    /**
+     * @param pool pool to run the tasks on, it must outlive the group
+     */
+    explicit TaskGroup(ThreadPool& pool = ThreadPool::global());
+
+    /**
+     * Waits for the tasks, their exceptions stay in their futures
+     */
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    /**
+     * Queue a task of the group
+     * @param task callable without arguments
+     * @return future holding the result or the exception of the task
+     * @throws what queueing the task throws, the task is then not in the group
+     */
+    template <typename F>
+    auto run(F&& task) -> std::future<std::invoke_result_t<std::decay_t<F>>>
+    {
+        using Result = std::invoke_result_t<std::decay_t<F>>;
+        auto promise = std::make_shared<std::promise<Result>>();
+        std::future<Result> result = promise->get_future();
+        // counted before it is queued, it may finish before execute() returns
+        m_pending++;
+        try
+        {
+            m_pool.execute([this, promise, task = std::forward<F>(task)]() mutable {
+                try
+                {
+                    if constexpr (std::is_void_v<Result>)
+                    {
+                        task();
+                        promise->set_value();
+                    }
+                    else
+                    {
+                        promise->set_value(task());
+                    }
+                }
+                catch (...)
+                {
+                    recordError(std::current_exception());
+                    promise->set_exception(std::current_exception());
+                }
+                finishTask();
+            });
+        }
+        catch (...)
+        {
+            // a task that was never queued is not waited for
+            finishTask();
+            throw;
+        }
+        return result;
+    }
+
+    /**
+     * Wait until every task of the group is done
+     * @throws the first exception thrown by a task of the group
+     */
+    void wait();
+
+private:
+    void recordError(std::exception_ptr error);
+    void finishTask();
+    void waitForTasks();
+
+    ThreadPool& m_pool;
+    std::atomic<std::size_t> m_pending{0};
+    std::mutex m_mutex;
+    std::condition_variable m_done;
+    std::exception_ptr m_error;
+};
+
+/**
+ * Size of the tiles a range is split into
+ */
+struct Grain
+{
+    int rows = 1;
+    // 0 keeps whole rows in a tile
+    int columns = 0;
+};
+
+/**
+ * Call a function for every tile of a range, in parallel. Tiles do not
+ * overlap, so functions writing only inside their tile need no locking. On a
+ * pool of one thread the tiles run in row major order on the calling thread.
+ * @param range rows and columns to cover, like Rect x is the row
+ * @param grain size of the tiles
+ * @param body function called with each tile
+ * @param pool pool to run the tiles on
+ * @throws the first exception thrown by body
+ */
+void parallelFor(const graphics::Rect& range, Grain grain, const std::function<void(const graphics::Rect&)>& body,
+                 ThreadPool& pool = ThreadPool::global());
+
+} // namespace pixelmancy
@@ -0,0 +1,76 @@
+#ifndef PIXELMANCY_RECT_H
+#define PIXELMANCY_RECT_H
+
+#include <algorithm>
+
+namespace pixelmancy::graphics {
+
+/**
+ * Axis aligned rectangle in drawing coordinates. Like Point, x is the first
+ * image coordinate (row) and y the second one (column). The max corner is
+ * exclusive, so a rectangle with minX == maxX is empty.
+ */
+struct Rect
+{
+    constexpr Rect() = default;
+
+    constexpr Rect(int a_minX, int a_minY, int a_maxX, int a_maxY) noexcept
+     : minX(a_minX), minY(a_minY), maxX(a_maxX), maxY(a_maxY)
+    {
+    }
+
+    constexpr bool operator==(const Rect& other) const noexcept
+    {
+        return minX == other.minX && minY == other.minY && maxX == other.maxX && maxY == other.maxY;
+    }
+
+    constexpr bool operator!=(const Rect& other) const noexcept
+    {
+        return !(*this == other);
+    }
+
+    constexpr bool isEmpty() const noexcept
+    {
+        return maxX <= minX || maxY <= minY;
+    }
+
+    constexpr int area() const noexcept
+    {
+        return isEmpty() ? 0 : (maxX - minX) * (maxY - minY);
+    }
+
+    constexpr bool intersects(const Rect& other) const noexcept
+    {
+        return !intersected(other).isEmpty();
+    }
+
+    constexpr Rect intersected(const Rect& other) const noexcept
+    {
+        return {std::max(minX, other.minX), std::max(minY, other.minY), std::min(maxX, other.maxX), std::min(maxY, other.maxY)};
+    }
+
+    /**
+     * Smallest rectangle that contains both rectangles, empty rectangles are ignored
+     */
+    constexpr Rect united(const Rect& other) const noexcept
+    {
+        if (isEmpty())
+        {
+            return other;
+        }
+        if (other.isEmpty())
+        {
+            return *this;
+        }
+        return {std::min(minX, other.minX), std::min(minY, other.minY), std::max(maxX, other.maxX), std::max(maxY, other.maxY)};
+    }
+
+    int minX = 0;
+    int minY = 0;
+    int maxX = 0;
+    int maxY = 0;
+};
+
+} // namespace pixelmancy::graphics
+
+#endif // PIXELMANCY_RECT_H
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+
+namespace pixelmancy {
+
+/**
+ * ScopedArena class that serves allocations from a growing buffer and frees
+ * all of them at once when it goes out of scope. Deallocating single objects
+ * does nothing, so it suits short jobs that allocate a lot and free together.
+ * It is not thread safe, use one arena per thread.
+ */
+class ScopedArena
+{
+public:
+    /**
+     * @param initialSize size of the first buffer in bytes
+     * @param upstream resource the buffers are allocated from
+     */
+    explicit ScopedArena(std::size_t initialSize = DEFAULT_INITIAL_SIZE,
+                         std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+     : m_buffer(initialSize, upstream)
+    {
+    }
+
+    ScopedArena(const ScopedArena&) = delete;
+    ScopedArena& operator=(const ScopedArena&) = delete;
+
+    /**
+     * Get the resource to pass to containers and Pixelmancy objects, they must
+     * not outlive the arena
+     */
+    std::pmr::memory_resource* resource()
+    {
+        return &m_buffer;
+    }
+
+    /**
+     * Free everything allocated from the arena
+     */
+    void release()
+    {
+        m_buffer.release();
+    }
+
+    static constexpr std::size_t DEFAULT_INITIAL_SIZE = 64 * 1024;
+
+private:
+    std::pmr::monotonic_buffer_resource m_buffer;
+};
+
+} // namespace pixelmancy
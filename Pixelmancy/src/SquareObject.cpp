@@ -7,7 +7,7 @@ SquareObject::SquareObject(sizei2d size2d, int outlineWidth, const Color& fillCo
 {
 }
 
-void SquareObject::drawOn(Image& image) const
+std::array<Point, 4> SquareObject::getRotatedCorners() const
 {
     const Point pos = m_position;
     const float angle = m_angle;
@@ -18,17 +18,41 @@ void SquareObject::drawOn(Image& image) const
     const int xCorners[4] = {-m_size2d.width/2, m_size2d.width/2, m_size2d.width/2, -m_size2d.width/2};
     const int yCorners[4] = {-m_size2d.height/2, -m_size2d.height/2, m_size2d.height/2, m_size2d.height/2};
 
-    Point rotatedCorners[4];
+    std::array<Point, 4> rotatedCorners;
     for (int i = 0; i < 4; i++)
     {
         rotatedCorners[i].x = pos.x + xCorners[i] * std::cos(radAngle) - yCorners[i] * std::sin(radAngle);
         rotatedCorners[i].y = pos.y + xCorners[i] * std::sin(radAngle) + yCorners[i] * std::cos(radAngle);
     }
+    return rotatedCorners;
+}
+
+namespace {
 
+Rect cornerBounds(const std::array<Point, 4>& rotatedCorners)
+{
     int minX = std::min({rotatedCorners[0].x, rotatedCorners[1].x, rotatedCorners[2].x, rotatedCorners[3].x});
     int maxX = std::max({rotatedCorners[0].x, rotatedCorners[1].x, rotatedCorners[2].x, rotatedCorners[3].x});
     int minY = std::min({rotatedCorners[0].y, rotatedCorners[1].y, rotatedCorners[2].y, rotatedCorners[3].y});
     int maxY = std::max({rotatedCorners[0].y, rotatedCorners[1].y, rotatedCorners[2].y, rotatedCorners[3].y});
+    return {minX, minY, maxX + 1, maxY + 1};
+}
+
+} // namespace
+
+Rect SquareObject::getBoundingBox() const
+{
+    return cornerBounds(getRotatedCorners());
+}
+
+void SquareObject::drawOn(Image& image) const
+{
+    const std::array<Point, 4> rotatedCorners = getRotatedCorners();
+    const Rect bounds = cornerBounds(rotatedCorners);
+    const int minX = bounds.minX;
+    const int maxX = bounds.maxX - 1;
+    const int minY = bounds.minY;
+    const int maxY = bounds.maxY - 1;
 
     for (int x = minX; x <= maxX; x++)
     {
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include "Common.hpp"
 #include "FilledShape.hpp"
 #include "Image.hpp"
@@ -16,8 +17,11 @@ class SquareObject : public FilledShape
 public:
     SquareObject(sizei2d size2d, int outlineWidth, const Color& fillColor, const Color& outlineColor = BLACK);
     void drawOn(Image& image) const;
-    
+    Rect getBoundingBox() const override;
+
 private:
+    std::array<Point, 4> getRotatedCorners() const;
+
     sizei2d m_size2d = {0, 0};
 };
 
@@ -0,0 +1,172 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <limits>
+
+namespace pixelmancy {
+
+namespace {
+
+constexpr std::size_t NO_QUEUE = std::numeric_limits<std::size_t>::max();
+
+// the pool and queue of the worker running on this thread
+thread_local const ThreadPool* t_workerPool = nullptr;
+thread_local std::size_t t_workerQueue = NO_QUEUE;
+
+std::mutex g_globalMutex;
+std::unique_ptr<ThreadPool> g_globalPool;
+std::size_t g_globalThreadCount = 0;
+
+std::size_t resolveThreadCount(std::size_t threadCount)
+{
+    return threadCount == 0 ? std::max(1u, std::thread::hardware_concurrency()) : threadCount;
+}
+
+} // namespace
+
+ThreadPool::ThreadPool(std::size_t threadCount) : m_threadCount(resolveThreadCount(threadCount))
+{
+    // the thread that waits for the tasks helps run them, so it counts as one
+    const std::size_t workerCount = m_threadCount - 1;
+    m_queues.reserve(workerCount);
+    for (std::size_t i = 0; i < workerCount; i++)
+    {
+        m_queues.push_back(std::make_unique<WorkQueue>());
+    }
+    m_workers.reserve(workerCount);
+    for (std::size_t i = 0; i < workerCount; i++)
+    {
+        m_workers.emplace_back([this, i]() { workerLoop(i); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_taskAvailable.notify_all();
+    for (auto& worker : m_workers)
+    {
+        worker.join();
+    }
+}
+
+std::size_t ThreadPool::size() const
+{
+    return m_threadCount;
+}
+
+void ThreadPool::execute(std::function<void()> task)
+{
+    if (m_workers.empty())
+    {
+        task();
+        return;
+    }
+    // workers keep the tasks they spawn, other threads spread them round robin
+    const std::size_t queueIndex =
+        t_workerPool == this ? t_workerQueue : m_nextQueue.fetch_add(1, std::memory_order_relaxed) % m_queues.size();
+    {
+        // counted under the queue lock like the pops, so the count never drops below zero
+        std::lock_guard<std::mutex> lock(m_queues[queueIndex]->mutex);
+        m_queues[queueIndex]->tasks.push_back(std::move(task));
+        m_queuedTasks++;
+    }
+    {
+        // a worker that saw no tasks is waiting once the lock is free
+        std::lock_guard<std::mutex> lock(m_mutex);
+    }
+    m_taskAvailable.notify_one();
+}
+
+bool ThreadPool::runPendingTask()
+{
+    std::function<void()> task;
+    if (!popTask(t_workerPool == this ? t_workerQueue : NO_QUEUE, task))
+    {
+        return false;
+    }
+    task();
+    return true;
+}
+
+// the owner takes the oldest task of its own queue, thieves take the newest of the others
+bool ThreadPool::popTask(std::size_t queueIndex, std::function<void()>& task)
+{
+    if (m_queuedTasks.load() == 0)
+    {
+        return false;
+    }
+    if (queueIndex != NO_QUEUE)
+    {
+        WorkQueue& own = *m_queues[queueIndex];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty())
+        {
+            task = std::move(own.tasks.front());
+            own.tasks.pop_front();
+            m_queuedTasks--;
+            return true;
+        }
+    }
+    const std::size_t start = queueIndex == NO_QUEUE ? 0 : queueIndex + 1;
+    for (std::size_t i = 0; i < m_queues.size(); i++)
+    {
+        WorkQueue& victim = *m_queues[(start + i) % m_queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty())
+        {
+            task = std::move(victim.tasks.back());
+            victim.tasks.pop_back();
+            m_queuedTasks--;
+            return true;
+        }
+    }
+    return false;
+}
+
+// workers finish the queued tasks before they stop
+void ThreadPool::workerLoop(std::size_t queueIndex)
+{
+    t_workerPool = this;
+    t_workerQueue = queueIndex;
+    while (true)
+    {
+        std::function<void()> task;
+        if (popTask(queueIndex, task))
+        {
+            task();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_taskAvailable.wait(lock, [this]() { return m_stopping || m_queuedTasks.load() > 0; });
+        if (m_stopping && m_queuedTasks.load() == 0)
+        {
+            return;
+        }
+    }
+}
+
+ThreadPool& ThreadPool::global()
+{
+    std::lock_guard<std::mutex> lock(g_globalMutex);
+    if (!g_globalPool)
+    {
+        g_globalPool = std::make_unique<ThreadPool>(g_globalThreadCount);
+    }
+    return *g_globalPool;
+}
+
+void ThreadPool::setGlobalThreadCount(std::size_t threadCount)
+{
+    std::lock_guard<std::mutex> lock(g_globalMutex);
+    g_globalThreadCount = threadCount;
+    if (g_globalPool && g_globalPool->size() != resolveThreadCount(threadCount))
+    {
+        g_globalPool.reset();
+    }
+}
+
+} // namespace pixelmancy
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace pixelmancy {
+
+/**
+ * ThreadPool class that runs submitted tasks on a fixed set of worker threads.
+ * Every worker has its own deque, a worker that runs out of tasks steals from
+ * the others. A pool of one thread has no workers and runs every task on the
+ * thread that submits it, in submission order.
+ */
+class ThreadPool
+{
+public:
+    /**
+     * Start the worker threads
+     * @param threadCount threads that run tasks, the thread waiting for them
+     * included. 0 uses one thread per hardware thread
+     */
+    explicit ThreadPool(std::size_t threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * Queue a task to be run by one of the workers
+     * @param task callable without arguments
+     * @return future holding the result or the exception of the task
+     */
+    template <typename F>
+    auto submit(F&& task) -> std::future<std::invoke_result_t<std::decay_t<F>>>
+    {
+        using Result = std::invoke_result_t<std::decay_t<F>>;
+        auto packagedTask = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task));
+        std::future<Result> result = packagedTask->get_future();
+        execute([packagedTask]() { (*packagedTask)(); });
+        return result;
+    }
+
+    /**
+     * Queue a task without a future, the task must not throw
+     * @param task task to run
+     */
+    void execute(std::function<void()> task);
+
+    /**
+     * Run one queued task on the calling thread, used by threads that wait for
+     * other tasks so they help instead of blocking
+     * @return true if a task was run
+     */
+    bool runPendingTask();
+
+    /**
+     * Get the number of threads that run tasks
+     */
+    std::size_t size() const;
+
+    /**
+     * Get the pool shared by the library, it is created on first use
+     */
+    static ThreadPool& global();
+
+    /**
+     * Set the thread count of the global pool. The pool is recreated when the
+     * count changes, so call this before the pool is used, not while tasks run.
+     * @param threadCount threads of the pool, 0 uses one per hardware thread
+     */
+    static void setGlobalThreadCount(std::size_t threadCount);
+
+private:
+    struct WorkQueue
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    bool popTask(std::size_t queueIndex, std::function<void()>& task);
+    void workerLoop(std::size_t queueIndex);
+
+    std::size_t m_threadCount = 1;
+    std::vector<std::unique_ptr<WorkQueue>> m_queues;
+    std::vector<std::thread> m_workers;
+    std::atomic<std::size_t> m_queuedTasks{0};
+    std::atomic<std::size_t> m_nextQueue{0};
+    std::mutex m_mutex;
+    std::condition_variable m_taskAvailable;
+    bool m_stopping = false;
+};
+
+} // namespace pixelmancy
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Kernels.hpp"
+
+// Kernel tables of the translation units built for each instruction set. The
+// SIMD units must not instantiate inline functions or templates of shared
+// headers, the linker could keep their AVX2 copy for the scalar callers.
+namespace pixelmancy::kernels::detail {
+
+const KernelTable& scalarKernels();
+
+// nullptr when the unit was built without the instruction set
+const KernelTable* sse42Kernels();
+const KernelTable* avx2Kernels();
+
+// scalar kernels, the SIMD variants use them for the remaining elements and
+// where their instruction set has nothing to add
+void expandIndicesScalar(const uint16_t* indices, std::size_t count, const uint32_t* palette, uint32_t* rgba);
+void remapIndicesScalar(const uint16_t* indices, std::size_t count, const uint32_t* table, std::size_t tableSize, uint8_t* out);
+void translateIndicesScalar(const uint16_t* indices, std::size_t count, const uint32_t* table, uint16_t* out);
+void fillIndicesScalar(uint16_t* target, std::size_t count, uint16_t value);
+void gatherIndicesScalar(const uint16_t* source, std::size_t sourceCount, const int32_t* positions, std::size_t count,
+                         uint16_t* out);
+void premultiplyAlphaScalar(uint32_t* rgba, std::size_t count);
+uint64_t colorDistanceScalar(const uint32_t* expected, const uint32_t* actual, std::size_t count, uint8_t* maxChannelError);
+void rgbaToChannelsScalar(const uint32_t* rgba, std::size_t count, float* channels);
+void channelsToRgbaScalar(const float* channels, std::size_t count, float scale, uint32_t* rgba);
+void accumulateChannelsScalar(float* sum, const float* values, float weight, std::size_t count);
+void slideChannelsScalar(float* sum, const float* entering, const float* leaving, std::size_t count);
+void channelMagnitudeScalar(const float* x, const float* y, std::size_t count, float* out);
+// the thresholds start over at rgba[0]
+void ditherCellsScalar(const uint32_t* rgba, std::size_t count, const int32_t* thresholds, uint32_t* cells);
+
+} // namespace pixelmancy::kernels::detail
@@ -0,0 +1,188 @@
+#include "Kernels.hpp"
+
+#include <cstdlib>
+#include <string>
+
+#include "KernelVariants.hpp"
+#include "Log.hpp"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#    define PIXELMANCY_KERNELS_X86 1
+#    if defined(_MSC_VER)
+#        include <intrin.h>
+#    else
+#        include <cpuid.h>
+#    endif
+#endif
+
+namespace pixelmancy::kernels {
+
+namespace {
+
+struct CpuFeatures
+{
+    bool sse42 = false;
+    bool avx2 = false;
+};
+
+#if PIXELMANCY_KERNELS_X86
+
+void cpuid(unsigned leaf, unsigned subleaf, unsigned registers[4])
+{
+#    if defined(_MSC_VER)
+    int values[4];
+    __cpuidex(values, static_cast<int>(leaf), static_cast<int>(subleaf));
+    for (int i = 0; i < 4; i++)
+    {
+        registers[i] = static_cast<unsigned>(values[i]);
+    }
+#    else
+    __cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#    endif
+}
+
+// register state the operating system saves on context switches
+uint64_t enabledRegisterState()
+{
+#    if defined(_MSC_VER)
+    return _xgetbv(0);
+#    else
+    unsigned low = 0;
+    unsigned high = 0;
+    __asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+    return (static_cast<uint64_t>(high) << 32) | low;
+#    endif
+}
+
+CpuFeatures detectCpuFeatures()
+{
+    constexpr unsigned SSE42_BIT = 1u << 20;
+    constexpr unsigned OSXSAVE_BIT = 1u << 27;
+    constexpr unsigned AVX_BIT = 1u << 28;
+    constexpr unsigned AVX2_BIT = 1u << 5;
+    constexpr uint64_t XMM_YMM_STATE = 0x6;
+
+    CpuFeatures features;
+    unsigned registers[4] = {};
+    cpuid(0, 0, registers);
+    const unsigned maxLeaf = registers[0];
+    if (maxLeaf < 1)
+    {
+        return features;
+    }
+    cpuid(1, 0, registers);
+    const unsigned ecx = registers[2];
+    features.sse42 = (ecx & SSE42_BIT) != 0;
+    const bool avxUsable = (ecx & OSXSAVE_BIT) != 0 && (ecx & AVX_BIT) != 0 &&
+                           (enabledRegisterState() & XMM_YMM_STATE) == XMM_YMM_STATE;
+    if (avxUsable && maxLeaf >= 7)
+    {
+        cpuid(7, 0, registers);
+        features.avx2 = (registers[1] & AVX2_BIT) != 0;
+    }
+    return features;
+}
+
+#else
+
+CpuFeatures detectCpuFeatures()
+{
+    return {};
+}
+
+#endif
+
+const CpuFeatures& cpuFeatures()
+{
+    static const CpuFeatures features = detectCpuFeatures();
+    return features;
+}
+
+const KernelTable& selectKernels()
+{
+    const KernelTable* selected = &detail::scalarKernels();
+    for (Isa isa : {Isa::SSE42, Isa::AVX2})
+    {
+        if (const KernelTable* table = forIsa(isa))
+        {
+            selected = table;
+        }
+    }
+
+    const char* requested = std::getenv("PIXELMANCY_SIMD");
+    if (requested == nullptr || *requested == '\0')
+    {
+        return *selected;
+    }
+    for (Isa isa : {Isa::SCALAR, Isa::SSE42, Isa::AVX2})
+    {
+        if (std::string(requested) == isaName(isa))
+        {
+            if (const KernelTable* table = forIsa(isa))
+            {
+                return *table;
+            }
+        }
+    }
+    if (logger::Log::GetLogger())
+    {
+        P_LOGF_WARN("PIXELMANCY_SIMD={} is not available, using {}\n", requested, isaName(selected->isa));
+    }
+    return *selected;
+}
+
+} // namespace
+
+const KernelTable& active()
+{
+    static const KernelTable& table = selectKernels();
+    return table;
+}
+
+const KernelTable* forIsa(Isa isa)
+{
+    if (!isSupported(isa))
+    {
+        return nullptr;
+    }
+    switch (isa)
+    {
+    case Isa::SCALAR:
+        return &detail::scalarKernels();
+    case Isa::SSE42:
+        return detail::sse42Kernels();
+    case Isa::AVX2:
+        return detail::avx2Kernels();
+    }
+    return nullptr;
+}
+
+bool isSupported(Isa isa)
+{
+    switch (isa)
+    {
+    case Isa::SCALAR:
+        return true;
+    case Isa::SSE42:
+        return cpuFeatures().sse42;
+    case Isa::AVX2:
+        return cpuFeatures().avx2;
+    }
+    return false;
+}
+
+const char* isaName(Isa isa)
+{
+    switch (isa)
+    {
+    case Isa::SCALAR:
+        return "scalar";
+    case Isa::SSE42:
+        return "sse4.2";
+    case Isa::AVX2:
+        return "avx2";
+    }
+    return "unknown";
+}
+
+} // namespace pixelmancy::kernels
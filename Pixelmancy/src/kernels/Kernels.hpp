@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace pixelmancy::kernels {
+
+/**
+ * Instruction sets the kernels are compiled for
+ */
+enum class Isa
+{
+    SCALAR,
+    SSE42,
+    AVX2
+};
+
+/**
+ * Number of thresholds of ditherCells(), they repeat along a row
+ */
+constexpr std::size_t DITHER_THRESHOLDS = 8;
+
+/**
+ * Pixel kernels of one instruction set. Colors are packed as four bytes in
+ * red, green, blue, alpha order (see packRgba()).
+ */
+struct KernelTable
+{
+    Isa isa;
+
+    // rgba[i] = palette[indices[i]], every index must be inside the palette
+    void (*expandIndices)(const uint16_t* indices, std::size_t count, const uint32_t* palette, uint32_t* rgba);
+
+    // out[i] = table[indices[i]], 0 for indices outside the table. Table entries are below 256
+    void (*remapIndices)(const uint16_t* indices, std::size_t count, const uint32_t* table, std::size_t tableSize, uint8_t* out);
+
+    // out[i] = table[indices[i]], every index must be inside the table and
+    // entries are below 65536. out may be indices
+    void (*translateIndices)(const uint16_t* indices, std::size_t count, const uint32_t* table, uint16_t* out);
+
+    // target[i] = value
+    void (*fillIndices)(uint16_t* target, std::size_t count, uint16_t value);
+
+    // out[i] = source[positions[i]], every position must be below sourceCount
+    void (*gatherIndices)(const uint16_t* source, std::size_t sourceCount, const int32_t* positions, std::size_t count,
+                          uint16_t* out);
+
+    // Color::getColorPreMultipliedByAlpha on every color
+    void (*premultiplyAlpha)(uint32_t* rgba, std::size_t count);
+
+    // largest channel difference of every pair of colors, returns the sum of the squared channel differences
+    uint64_t (*colorDistance)(const uint32_t* expected, const uint32_t* actual, std::size_t count, uint8_t* maxChannelError);
+
+    // channels[4 * i + c] = byte c of rgba[i], four floats per color
+    void (*rgbaToChannels)(const uint32_t* rgba, std::size_t count, float* channels);
+
+    // rgba[i] = channels of color i times scale, clamped to 0-255 and rounded to nearest
+    void (*channelsToRgba)(const float* channels, std::size_t count, float scale, uint32_t* rgba);
+
+    // sum[i] += weight * values[i]
+    void (*accumulateChannels)(float* sum, const float* values, float weight, std::size_t count);
+
+    // sum[i] += entering[i] - leaving[i], a window sliding over rows or columns
+    void (*slideChannels)(float* sum, const float* entering, const float* leaving, std::size_t count);
+
+    // out[i] = sqrt(x[i] * x[i] + y[i] * y[i]), out may be x or y
+    void (*channelMagnitude)(const float* x, const float* y, std::size_t count, float* out);
+
+    // cells[i] = red << 12 | green << 6 | blue of the top 6 bits of the channels of rgba[i], after
+    // thresholds[i % DITHER_THRESHOLDS] is added to red, green and blue and they are clamped to 0-255
+    void (*ditherCells)(const uint32_t* rgba, std::size_t count, const int32_t* thresholds, uint32_t* cells);
+};
+
+/**
+ * Get the kernels selected for this CPU. The best supported instruction set
+ * is picked on first use, the PIXELMANCY_SIMD environment variable (scalar,
+ * sse4.2 or avx2) overrides it.
+ */
+const KernelTable& active();
+
+/**
+ * Get the kernels of an instruction set
+ * @param isa instruction set
+ * @return nullptr if the kernels were not compiled in or the CPU lacks the instruction set
+ */
+const KernelTable* forIsa(Isa isa);
+
+/**
+ * Check whether the kernels of an instruction set can run on this CPU
+ */
+bool isSupported(Isa isa);
+
+/**
+ * Get the name of an instruction set, as used by PIXELMANCY_SIMD
+ */
+const char* isaName(Isa isa);
+
+inline uint32_t packRgba(uint8_t red, uint8_t green, uint8_t blue, uint8_t alpha)
+{
+    const uint8_t bytes[4] = {red, green, blue, alpha};
+    uint32_t packed = 0;
+    std::memcpy(&packed, bytes, sizeof(packed));
+    return packed;
+}
+
+} // namespace pixelmancy::kernels
@@ -0,0 +1,282 @@
+#include "KernelVariants.hpp"
+
+#if defined(__AVX2__)
+#    include <immintrin.h>
+#    define PIXELMANCY_KERNELS_AVX2 1
+#endif
+
+namespace pixelmancy::kernels::detail {
+
+#if PIXELMANCY_KERNELS_AVX2
+
+namespace {
+
+// 8 indices widened to 32 bits
+__m256i loadIndices(const uint16_t* indices)
+{
+    return _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(indices)));
+}
+
+void expandIndicesAvx2(const uint16_t* indices, std::size_t count, const uint32_t* palette, uint32_t* rgba)
+{
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256i colors = _mm256_i32gather_epi32(reinterpret_cast<const int*>(palette), loadIndices(indices + i), 4);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(rgba + i), colors);
+    }
+    expandIndicesScalar(indices + i, count - i, palette, rgba + i);
+}
+
+void remapIndicesAvx2(const uint16_t* indices, std::size_t count, const uint32_t* table, std::size_t tableSize, uint8_t* out)
+{
+    // indices are below 65536, so larger tables need no bounds check
+    const __m256i limit = _mm256_set1_epi32(tableSize > 0x10000 ? 0x10000 : static_cast<int>(tableSize));
+    const __m256i firstBytes = _mm256_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 4, 8, 12, -1,
+                                                -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m256i lanes = _mm256_setr_epi32(0, 4, 1, 1, 1, 1, 1, 1);
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256i positions = loadIndices(indices + i);
+        const __m256i inside = _mm256_cmpgt_epi32(limit, positions);
+        const __m256i values = _mm256_mask_i32gather_epi32(_mm256_setzero_si256(), reinterpret_cast<const int*>(table),
+                                                           positions, inside, 4);
+        const __m256i packed = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(values, firstBytes), lanes);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm256_castsi256_si128(packed));
+    }
+    remapIndicesScalar(indices + i, count - i, table, tableSize, out + i);
+}
+
+void translateIndicesAvx2(const uint16_t* indices, std::size_t count, const uint32_t* table, uint16_t* out)
+{
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256i values = _mm256_i32gather_epi32(reinterpret_cast<const int*>(table), loadIndices(indices + i), 4);
+        const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(values, values), 0x08);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm256_castsi256_si128(packed));
+    }
+    translateIndicesScalar(indices + i, count - i, table, out + i);
+}
+
+void fillIndicesAvx2(uint16_t* target, std::size_t count, uint16_t value)
+{
+    const __m256i values = _mm256_set1_epi16(static_cast<short>(value));
+    std::size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(target + i), values);
+    }
+    fillIndicesScalar(target + i, count - i, value);
+}
+
+// the gather loads 32 bits per position, blocks that would read past the last
+// source element are copied one by one
+void gatherIndicesAvx2(const uint16_t* source, std::size_t sourceCount, const int32_t* positions, std::size_t count,
+                       uint16_t* out)
+{
+    const __m256i lastSafe = _mm256_set1_epi32(sourceCount >= 2 ? static_cast<int>(sourceCount - 2) : -1);
+    const __m256i lowHalf = _mm256_set1_epi32(0xFFFF);
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256i blockPositions = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(positions + i));
+        if (_mm256_movemask_epi8(_mm256_cmpgt_epi32(blockPositions, lastSafe)) != 0)
+        {
+            gatherIndicesScalar(source, sourceCount, positions + i, 8, out + i);
+            continue;
+        }
+        const __m256i values =
+            _mm256_and_si256(_mm256_i32gather_epi32(reinterpret_cast<const int*>(source), blockPositions, 2), lowHalf);
+        const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi32(values, values), 0x08);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm256_castsi256_si128(packed));
+    }
+    gatherIndicesScalar(source, sourceCount, positions + i, count - i, out + i);
+}
+
+// see premultiplyAlphaSse42, the lanes need no special cases
+void premultiplyAlphaAvx2(uint32_t* rgba, std::size_t count)
+{
+    const __m256i byteMask = _mm256_set1_epi32(0xFF);
+    const __m256i opaque = _mm256_set1_epi32(static_cast<int>(0xFF000000u));
+    const __m256 maxAlpha = _mm256_set1_ps(255.0f);
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256i colors = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rgba + i));
+        const __m256 alpha = _mm256_div_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(colors, 24)), maxAlpha);
+        const __m256i red = _mm256_cvttps_epi32(_mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(colors, byteMask)), alpha));
+        const __m256i green = _mm256_cvttps_epi32(
+            _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(colors, 8), byteMask)), alpha));
+        const __m256i blue = _mm256_cvttps_epi32(
+            _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(colors, 16), byteMask)), alpha));
+        const __m256i blended = _mm256_or_si256(_mm256_or_si256(red, _mm256_slli_epi32(green, 8)),
+                                                _mm256_or_si256(_mm256_slli_epi32(blue, 16), opaque));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(rgba + i), blended);
+    }
+    premultiplyAlphaScalar(rgba + i, count - i);
+}
+
+uint64_t colorDistanceAvx2(const uint32_t* expected, const uint32_t* actual, std::size_t count, uint8_t* maxChannelError)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i firstBytes = _mm256_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 4, 8, 12, -1,
+                                                -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m256i lanes = _mm256_setr_epi32(0, 4, 1, 1, 1, 1, 1, 1);
+    __m256i sums = _mm256_setzero_si256();
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256i left = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(expected + i));
+        const __m256i right = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(actual + i));
+        const __m256i difference = _mm256_or_si256(_mm256_subs_epu8(left, right), _mm256_subs_epu8(right, left));
+
+        const __m256i low = _mm256_unpacklo_epi8(difference, zero);
+        const __m256i high = _mm256_unpackhi_epi8(difference, zero);
+        const __m256i squares = _mm256_add_epi32(_mm256_madd_epi16(low, low), _mm256_madd_epi16(high, high));
+        sums = _mm256_add_epi64(sums, _mm256_unpacklo_epi32(squares, zero));
+        sums = _mm256_add_epi64(sums, _mm256_unpackhi_epi32(squares, zero));
+
+        __m256i largest = _mm256_max_epu8(difference, _mm256_srli_epi32(difference, 8));
+        largest = _mm256_max_epu8(largest, _mm256_srli_epi32(largest, 16));
+        const __m256i packed = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(largest, firstBytes), lanes);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(maxChannelError + i), _mm256_castsi256_si128(packed));
+    }
+    uint64_t partial[4];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(partial), sums);
+    return partial[0] + partial[1] + partial[2] + partial[3] +
+           colorDistanceScalar(expected + i, actual + i, count - i, maxChannelError + i);
+}
+
+void rgbaToChannelsAvx2(const uint32_t* rgba, std::size_t count, float* channels)
+{
+    std::size_t i = 0;
+    for (; i + 2 <= count; i += 2)
+    {
+        const __m128i colors = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(rgba + i));
+        _mm256_storeu_ps(channels + 4 * i, _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(colors)));
+    }
+    rgbaToChannelsScalar(rgba + i, count - i, channels + 4 * i);
+}
+
+// see channelsToRgbaSse42, the packs work per 128 bit lane so the colors are
+// put back in order with one permute
+void channelsToRgbaAvx2(const float* channels, std::size_t count, float scale, uint32_t* rgba)
+{
+    const __m256 factor = _mm256_set1_ps(scale);
+    const __m256 low = _mm256_setzero_ps();
+    const __m256 high = _mm256_set1_ps(255.0f);
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m256i words[4];
+        for (int pair = 0; pair < 4; pair++)
+        {
+            const __m256 values =
+                _mm256_mul_ps(_mm256_loadu_ps(channels + 4 * (i + 2 * static_cast<std::size_t>(pair))), factor);
+            words[pair] = _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(values, low), high));
+        }
+        const __m256i packed =
+            _mm256_packus_epi16(_mm256_packs_epi32(words[0], words[1]), _mm256_packs_epi32(words[2], words[3]));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(rgba + i), _mm256_permutevar8x32_epi32(packed, order));
+    }
+    channelsToRgbaScalar(channels + 4 * i, count - i, scale, rgba + i);
+}
+
+// multiply and add stay separate, a fused multiply-add would round
+// differently from the other variants
+void accumulateChannelsAvx2(float* sum, const float* values, float weight, std::size_t count)
+{
+    const __m256 factor = _mm256_set1_ps(weight);
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256 product = _mm256_mul_ps(factor, _mm256_loadu_ps(values + i));
+        _mm256_storeu_ps(sum + i, _mm256_add_ps(_mm256_loadu_ps(sum + i), product));
+    }
+    accumulateChannelsScalar(sum + i, values + i, weight, count - i);
+}
+
+void slideChannelsAvx2(float* sum, const float* entering, const float* leaving, std::size_t count)
+{
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256 change = _mm256_sub_ps(_mm256_loadu_ps(entering + i), _mm256_loadu_ps(leaving + i));
+        _mm256_storeu_ps(sum + i, _mm256_add_ps(_mm256_loadu_ps(sum + i), change));
+    }
+    slideChannelsScalar(sum + i, entering + i, leaving + i, count - i);
+}
+
+void channelMagnitudeAvx2(const float* x, const float* y, std::size_t count, float* out)
+{
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256 horizontal = _mm256_loadu_ps(x + i);
+        const __m256 vertical = _mm256_loadu_ps(y + i);
+        const __m256 squares = _mm256_add_ps(_mm256_mul_ps(horizontal, horizontal), _mm256_mul_ps(vertical, vertical));
+        _mm256_storeu_ps(out + i, _mm256_sqrt_ps(squares));
+    }
+    channelMagnitudeScalar(x + i, y + i, count - i, out + i);
+}
+
+// top 6 bits of one channel of eight colors after the thresholds are added
+__m256i channelCellsAvx2(__m256i colors, int shift, __m256i thresholds)
+{
+    const __m256i value = _mm256_and_si256(_mm256_srl_epi32(colors, _mm_cvtsi32_si128(shift)), _mm256_set1_epi32(0xFF));
+    const __m256i clamped =
+        _mm256_min_epi32(_mm256_max_epi32(_mm256_add_epi32(value, thresholds), _mm256_setzero_si256()), _mm256_set1_epi32(255));
+    return _mm256_srli_epi32(clamped, 2);
+}
+
+// one step covers the thresholds once
+void ditherCellsAvx2(const uint32_t* rgba, std::size_t count, const int32_t* thresholds, uint32_t* cells)
+{
+    const __m256i pattern = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(thresholds));
+    std::size_t i = 0;
+    for (; i + DITHER_THRESHOLDS <= count; i += DITHER_THRESHOLDS)
+    {
+        const __m256i colors = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rgba + i));
+        const __m256i red = channelCellsAvx2(colors, 0, pattern);
+        const __m256i green = channelCellsAvx2(colors, 8, pattern);
+        const __m256i blue = channelCellsAvx2(colors, 16, pattern);
+        const __m256i packed = _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi32(red, 12), _mm256_slli_epi32(green, 6)), blue);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(cells + i), packed);
+    }
+    ditherCellsScalar(rgba + i, count - i, thresholds, cells + i);
+}
+
+} // namespace
+
+const KernelTable* avx2Kernels()
+{
+    static const KernelTable table{Isa::AVX2,
+                                   expandIndicesAvx2,
+                                   remapIndicesAvx2,
+                                   translateIndicesAvx2,
+                                   fillIndicesAvx2,
+                                   gatherIndicesAvx2,
+                                   premultiplyAlphaAvx2,
+                                   colorDistanceAvx2,
+                                   rgbaToChannelsAvx2,
+                                   channelsToRgbaAvx2,
+                                   accumulateChannelsAvx2,
+                                   slideChannelsAvx2,
+                                   channelMagnitudeAvx2,
+                                   ditherCellsAvx2};
+    return &table;
+}
+
+#else
+
+const KernelTable* avx2Kernels()
+{
+    return nullptr;
+}
+
+#endif
+
+} // namespace pixelmancy::kernels::detail
@@ -0,0 +1,183 @@
+#include "KernelVariants.hpp"
+
+#include "CommonConfig.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace pixelmancy::kernels::detail {
+
+void expandIndicesScalar(const uint16_t* indices, std::size_t count, const uint32_t* palette, uint32_t* rgba)
+{
+    for (std::size_t i = 0; i < count; i++)
+    {
+        rgba[i] = palette[indices[i]];
+    }
+}
+
+void remapIndicesScalar(const uint16_t* indices, std::size_t count, const uint32_t* table, std::size_t tableSize, uint8_t* out)
+{
+    for (std::size_t i = 0; i < count; i++)
+    {
+        out[i] = indices[i] < tableSize ? static_cast<uint8_t>(table[indices[i]]) : 0;
+    }
+}
+
+void translateIndicesScalar(const uint16_t* indices, std::size_t count, const uint32_t* table, uint16_t* out)
+{
+    for (std::size_t i = 0; i < count; i++)
+    {
+        out[i] = static_cast<uint16_t>(table[indices[i]]);
+    }
+}
+
+void fillIndicesScalar(uint16_t* target, std::size_t count, uint16_t value)
+{
+    for (std::size_t i = 0; i < count; i++)
+    {
+        target[i] = value;
+    }
+}
+
+void gatherIndicesScalar(const uint16_t* source, std::size_t /*sourceCount*/, const int32_t* positions, std::size_t count,
+                         uint16_t* out)
+{
+    for (std::size_t i = 0; i < count; i++)
+    {
+        out[i] = source[positions[i]];
+    }
+}
+
+void premultiplyAlphaScalar(uint32_t* rgba, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; i++)
+    {
+        uint8_t bytes[4];
+        std::memcpy(bytes, &rgba[i], sizeof(bytes));
+        const uint8_t alpha = bytes[3];
+        if (alpha == MIN_ALPHA)
+        {
+            rgba[i] = packRgba(0, 0, 0, MAX_ALPHA);
+            continue;
+        }
+        if (alpha >= MAX_ALPHA)
+        {
+            continue;
+        }
+        const float alpha_ = static_cast<float>(alpha) / 255.0f;
+        rgba[i] = packRgba(static_cast<uint8_t>(static_cast<float>(bytes[0]) * alpha_),
+                           static_cast<uint8_t>(static_cast<float>(bytes[1]) * alpha_),
+                           static_cast<uint8_t>(static_cast<float>(bytes[2]) * alpha_), MAX_ALPHA);
+    }
+}
+
+uint64_t colorDistanceScalar(const uint32_t* expected, const uint32_t* actual, std::size_t count, uint8_t* maxChannelError)
+{
+    uint64_t squaredError = 0;
+    for (std::size_t i = 0; i < count; i++)
+    {
+        uint8_t expectedBytes[4];
+        uint8_t actualBytes[4];
+        std::memcpy(expectedBytes, &expected[i], sizeof(expectedBytes));
+        std::memcpy(actualBytes, &actual[i], sizeof(actualBytes));
+        int largest = 0;
+        for (int channel = 0; channel < 4; channel++)
+        {
+            const int difference = expectedBytes[channel] > actualBytes[channel] ? expectedBytes[channel] - actualBytes[channel]
+                                                                                 : actualBytes[channel] - expectedBytes[channel];
+            squaredError += static_cast<uint64_t>(difference * difference);
+            largest = difference > largest ? difference : largest;
+        }
+        maxChannelError[i] = static_cast<uint8_t>(largest);
+    }
+    return squaredError;
+}
+
+void rgbaToChannelsScalar(const uint32_t* rgba, std::size_t count, float* channels)
+{
+    for (std::size_t i = 0; i < count; i++)
+    {
+        uint8_t bytes[4];
+        std::memcpy(bytes, &rgba[i], sizeof(bytes));
+        for (std::size_t channel = 0; channel < 4; channel++)
+        {
+            channels[4 * i + channel] = static_cast<float>(bytes[channel]);
+        }
+    }
+}
+
+void channelsToRgbaScalar(const float* channels, std::size_t count, float scale, uint32_t* rgba)
+{
+    for (std::size_t i = 0; i < count; i++)
+    {
+        uint8_t bytes[4];
+        for (std::size_t channel = 0; channel < 4; channel++)
+        {
+            float value = channels[4 * i + channel] * scale;
+            value = value < 0.0f ? 0.0f : value > 255.0f ? 255.0f : value;
+            // rounds half to even, like the SIMD conversions
+            bytes[channel] = static_cast<uint8_t>(std::nearbyint(value));
+        }
+        std::memcpy(&rgba[i], bytes, sizeof(bytes));
+    }
+}
+
+void accumulateChannelsScalar(float* sum, const float* values, float weight, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; i++)
+    {
+        sum[i] += weight * values[i];
+    }
+}
+
+void slideChannelsScalar(float* sum, const float* entering, const float* leaving, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; i++)
+    {
+        sum[i] += entering[i] - leaving[i];
+    }
+}
+
+void channelMagnitudeScalar(const float* x, const float* y, std::size_t count, float* out)
+{
+    for (std::size_t i = 0; i < count; i++)
+    {
+        out[i] = std::sqrt(x[i] * x[i] + y[i] * y[i]);
+    }
+}
+
+void ditherCellsScalar(const uint32_t* rgba, std::size_t count, const int32_t* thresholds, uint32_t* cells)
+{
+    for (std::size_t i = 0; i < count; i++)
+    {
+        const int32_t threshold = thresholds[i % DITHER_THRESHOLDS];
+        uint32_t cell = 0;
+        for (int shift = 0; shift < 24; shift += 8)
+        {
+            const int32_t value = std::min(std::max(static_cast<int32_t>(rgba[i] >> shift & 0xFF) + threshold, 0), 255);
+            cell = cell << 6 | static_cast<uint32_t>(value) >> 2;
+        }
+        cells[i] = cell;
+    }
+}
+
+const KernelTable& scalarKernels()
+{
+    static const KernelTable table{Isa::SCALAR,
+                                   expandIndicesScalar,
+                                   remapIndicesScalar,
+                                   translateIndicesScalar,
+                                   fillIndicesScalar,
+                                   gatherIndicesScalar,
+                                   premultiplyAlphaScalar,
+                                   colorDistanceScalar,
+                                   rgbaToChannelsScalar,
+                                   channelsToRgbaScalar,
+                                   accumulateChannelsScalar,
+                                   slideChannelsScalar,
+                                   channelMagnitudeScalar,
+                                   ditherCellsScalar};
+    return table;
+}
+
+} // namespace pixelmancy::kernels::detail
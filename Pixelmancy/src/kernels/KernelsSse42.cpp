@@ -0,0 +1,216 @@
+#include "KernelVariants.hpp"
+
+#if defined(__SSE4_2__) || (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_AMD64)))
+#    include <nmmintrin.h>
+#    define PIXELMANCY_KERNELS_SSE42 1
+#endif
+
+namespace pixelmancy::kernels::detail {
+
+#if PIXELMANCY_KERNELS_SSE42
+
+namespace {
+
+void fillIndicesSse42(uint16_t* target, std::size_t count, uint16_t value)
+{
+    const __m128i values = _mm_set1_epi16(static_cast<short>(value));
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(target + i), values);
+    }
+    fillIndicesScalar(target + i, count - i, value);
+}
+
+// a / 255 * channel truncated, exactly like the scalar kernel. Fully
+// transparent colors give black and opaque ones keep their channels, so no
+// lane needs the special cases of the scalar kernel.
+void premultiplyAlphaSse42(uint32_t* rgba, std::size_t count)
+{
+    const __m128i byteMask = _mm_set1_epi32(0xFF);
+    const __m128i opaque = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+    const __m128 maxAlpha = _mm_set1_ps(255.0f);
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128i colors = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgba + i));
+        const __m128 alpha = _mm_div_ps(_mm_cvtepi32_ps(_mm_srli_epi32(colors, 24)), maxAlpha);
+        const __m128i red = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(colors, byteMask)), alpha));
+        const __m128i green =
+            _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(colors, 8), byteMask)), alpha));
+        const __m128i blue =
+            _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(colors, 16), byteMask)), alpha));
+        const __m128i blended =
+            _mm_or_si128(_mm_or_si128(red, _mm_slli_epi32(green, 8)), _mm_or_si128(_mm_slli_epi32(blue, 16), opaque));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(rgba + i), blended);
+    }
+    premultiplyAlphaScalar(rgba + i, count - i);
+}
+
+uint64_t colorDistanceSse42(const uint32_t* expected, const uint32_t* actual, std::size_t count, uint8_t* maxChannelError)
+{
+    const __m128i zero = _mm_setzero_si128();
+    // low byte of every color
+    const __m128i firstBytes = _mm_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    __m128i sums = _mm_setzero_si128();
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128i left = _mm_loadu_si128(reinterpret_cast<const __m128i*>(expected + i));
+        const __m128i right = _mm_loadu_si128(reinterpret_cast<const __m128i*>(actual + i));
+        const __m128i difference = _mm_or_si128(_mm_subs_epu8(left, right), _mm_subs_epu8(right, left));
+
+        const __m128i low = _mm_unpacklo_epi8(difference, zero);
+        const __m128i high = _mm_unpackhi_epi8(difference, zero);
+        const __m128i squares = _mm_add_epi32(_mm_madd_epi16(low, low), _mm_madd_epi16(high, high));
+        sums = _mm_add_epi64(sums, _mm_cvtepu32_epi64(squares));
+        sums = _mm_add_epi64(sums, _mm_cvtepu32_epi64(_mm_srli_si128(squares, 8)));
+
+        __m128i largest = _mm_max_epu8(difference, _mm_srli_epi32(difference, 8));
+        largest = _mm_max_epu8(largest, _mm_srli_epi32(largest, 16));
+        const int packed = _mm_cvtsi128_si32(_mm_shuffle_epi8(largest, firstBytes));
+        std::memcpy(maxChannelError + i, &packed, sizeof(packed));
+    }
+    uint64_t lanes[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), sums);
+    return lanes[0] + lanes[1] + colorDistanceScalar(expected + i, actual + i, count - i, maxChannelError + i);
+}
+
+void rgbaToChannelsSse42(const uint32_t* rgba, std::size_t count, float* channels)
+{
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128i colors = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgba + i));
+        float* out = channels + 4 * i;
+        _mm_storeu_ps(out, _mm_cvtepi32_ps(_mm_cvtepu8_epi32(colors)));
+        _mm_storeu_ps(out + 4, _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(colors, 4))));
+        _mm_storeu_ps(out + 8, _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(colors, 8))));
+        _mm_storeu_ps(out + 12, _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(colors, 12))));
+    }
+    rgbaToChannelsScalar(rgba + i, count - i, channels + 4 * i);
+}
+
+// the conversion rounds half to even in the default rounding mode, and the
+// packs saturate only values that were clamped already
+void channelsToRgbaSse42(const float* channels, std::size_t count, float scale, uint32_t* rgba)
+{
+    const __m128 factor = _mm_set1_ps(scale);
+    const __m128 low = _mm_setzero_ps();
+    const __m128 high = _mm_set1_ps(255.0f);
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i words[4];
+        for (int color = 0; color < 4; color++)
+        {
+            const __m128 values = _mm_mul_ps(_mm_loadu_ps(channels + 4 * (i + static_cast<std::size_t>(color))), factor);
+            words[color] = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(values, low), high));
+        }
+        const __m128i packed =
+            _mm_packus_epi16(_mm_packs_epi32(words[0], words[1]), _mm_packs_epi32(words[2], words[3]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(rgba + i), packed);
+    }
+    channelsToRgbaScalar(channels + 4 * i, count - i, scale, rgba + i);
+}
+
+void accumulateChannelsSse42(float* sum, const float* values, float weight, std::size_t count)
+{
+    const __m128 factor = _mm_set1_ps(weight);
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128 product = _mm_mul_ps(factor, _mm_loadu_ps(values + i));
+        _mm_storeu_ps(sum + i, _mm_add_ps(_mm_loadu_ps(sum + i), product));
+    }
+    accumulateChannelsScalar(sum + i, values + i, weight, count - i);
+}
+
+void slideChannelsSse42(float* sum, const float* entering, const float* leaving, std::size_t count)
+{
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128 change = _mm_sub_ps(_mm_loadu_ps(entering + i), _mm_loadu_ps(leaving + i));
+        _mm_storeu_ps(sum + i, _mm_add_ps(_mm_loadu_ps(sum + i), change));
+    }
+    slideChannelsScalar(sum + i, entering + i, leaving + i, count - i);
+}
+
+void channelMagnitudeSse42(const float* x, const float* y, std::size_t count, float* out)
+{
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128 horizontal = _mm_loadu_ps(x + i);
+        const __m128 vertical = _mm_loadu_ps(y + i);
+        const __m128 squares = _mm_add_ps(_mm_mul_ps(horizontal, horizontal), _mm_mul_ps(vertical, vertical));
+        _mm_storeu_ps(out + i, _mm_sqrt_ps(squares));
+    }
+    channelMagnitudeScalar(x + i, y + i, count - i, out + i);
+}
+
+// top 6 bits of one channel of four colors after the thresholds are added
+__m128i channelCellsSse42(__m128i colors, int shift, __m128i thresholds)
+{
+    const __m128i value = _mm_and_si128(_mm_srl_epi32(colors, _mm_cvtsi32_si128(shift)), _mm_set1_epi32(0xFF));
+    const __m128i clamped = _mm_min_epi32(_mm_max_epi32(_mm_add_epi32(value, thresholds), _mm_setzero_si128()), _mm_set1_epi32(255));
+    return _mm_srli_epi32(clamped, 2);
+}
+
+__m128i ditherCellsSse42(__m128i colors, __m128i thresholds)
+{
+    const __m128i red = channelCellsSse42(colors, 0, thresholds);
+    const __m128i green = channelCellsSse42(colors, 8, thresholds);
+    const __m128i blue = channelCellsSse42(colors, 16, thresholds);
+    return _mm_or_si128(_mm_or_si128(_mm_slli_epi32(red, 12), _mm_slli_epi32(green, 6)), blue);
+}
+
+// eight colors per step, so the scalar remainder starts the thresholds over
+void ditherCellsSse42(const uint32_t* rgba, std::size_t count, const int32_t* thresholds, uint32_t* cells)
+{
+    const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(thresholds));
+    const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(thresholds + 4));
+    std::size_t i = 0;
+    for (; i + DITHER_THRESHOLDS <= count; i += DITHER_THRESHOLDS)
+    {
+        const __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgba + i));
+        const __m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgba + i + 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(cells + i), ditherCellsSse42(first, low));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(cells + i + 4), ditherCellsSse42(second, high));
+    }
+    ditherCellsScalar(rgba + i, count - i, thresholds, cells + i);
+}
+
+} // namespace
+
+const KernelTable* sse42Kernels()
+{
+    // gathers need AVX2, without them the lookups stay scalar
+    static const KernelTable table{Isa::SSE42,
+                                   expandIndicesScalar,
+                                   remapIndicesScalar,
+                                   translateIndicesScalar,
+                                   fillIndicesSse42,
+                                   gatherIndicesScalar,
+                                   premultiplyAlphaSse42,
+                                   colorDistanceSse42,
+                                   rgbaToChannelsSse42,
+                                   channelsToRgbaSse42,
+                                   accumulateChannelsSse42,
+                                   slideChannelsSse42,
+                                   channelMagnitudeSse42,
+                                   ditherCellsSse42};
+    return &table;
+}
+
+#else
+
+const KernelTable* sse42Kernels()
+{
+    return nullptr;
+}
+
+#endif
+
+} // namespace pixelmancy::kernels::detail
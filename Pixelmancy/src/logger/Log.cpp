@@ -2,15 +2,19 @@
 
 #include <iostream>
 
+#include "async_logger.hpp"
+
 namespace pixelmancy {
 namespace logger {
-std::shared_ptr<ostream_logger> Log::s_logger;
+std::shared_ptr<iLogger> Log::s_logger;
+std::atomic<LogLevel> Log::s_filterLevel{LogLevel::OFF};
 
 void Log::Init()
 {
     s_logger = std::make_shared<ostream_logger>(std::cout);
     std::ios_base::sync_with_stdio(false);
     s_logger->setLogLevel(LogLevel::TRACE);
+    s_filterLevel = s_logger->filter();
 }
 
 void Log::Init(LogLevel level)
@@ -18,6 +22,23 @@ void Log::Init(LogLevel level)
     s_logger = std::make_shared<ostream_logger>(std::cout);
     std::ios_base::sync_with_stdio(false);
     s_logger->setLogLevel(level);
+    s_filterLevel = s_logger->filter();
+}
+
+void Log::InitAsync(LogLevel filterLevel, OverflowPolicy policy)
+{
+    std::ios_base::sync_with_stdio(false);
+    s_logger = std::make_shared<async_logger>(std::cout, filterLevel, policy);
+    s_filterLevel = s_logger->filter();
+}
+
+void Log::SetFilter(LogLevel level)
+{
+    if (s_logger)
+    {
+        s_logger->setFilter(level);
+        s_filterLevel = level;
+    }
 }
 } // namespace logger
 } // namespace pixelmancy
@@ -1,6 +1,13 @@
 #pragma once
 
+#include <atomic>
+#include <cstddef>
 #include <memory>
+#include <sstream>
+#include <type_traits>
+
+#include <fmt/format.h>
+
 #include "ostream_logger.hpp"
 
 namespace pixelmancy::logger {
@@ -10,59 +17,96 @@ public:
     static void Init();
     static void Init(LogLevel level);
 
-    static std::shared_ptr<ostream_logger>& GetLogger()
+    /**
+     * Log through an async_logger that writes to std::cout from a background thread
+     * @param filterLevel records below this level are discarded
+     * @param policy what to do when a thread logs faster than the records are written
+     */
+    static void InitAsync(LogLevel filterLevel = static_cast<LogLevel>(BUILD_LOG_LEVEL), OverflowPolicy policy = OverflowPolicy::DROP);
+
+    static std::shared_ptr<iLogger>& GetLogger()
     {
         return s_logger;
     }
 
+    /**
+     * Check whether messages of a level are written, the P_LOG macros call
+     * this before evaluating anything else
+     */
+    static bool IsEnabled(LogLevel level)
+    {
+        return level >= s_filterLevel.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Change the lowest level that is written
+     * @param level filter level of the logger
+     */
+    static void SetFilter(LogLevel level);
+
     ~Log() = default;
 
 private:
-    static std::shared_ptr<ostream_logger> s_logger;
+    static std::shared_ptr<iLogger> s_logger;
+    static std::atomic<LogLevel> s_filterLevel;
 };
 
 } // namespace pixelmancy::logger
 
+// location of the log statement, the directories of __FILE__ are stripped at compile time
+#define P_LOG_LOCATION()                                                                                                       \
+    ::pixelmancy::logger::file_t(__FILE__ + std::integral_constant<std::size_t, ::pixelmancy::logger::fileNameOffset(__FILE__)>::value, \
+                                 __LINE__)
+
+// the streamed arguments are evaluated only when the level passes the runtime filter
+#define P_LOG_ENABLED(level)                                                           \
+    !::pixelmancy::logger::Log::IsEnabled(level) ? static_cast<void>(0)                \
+                                                 : ::pixelmancy::logger::LogVoidify() & \
+                                                       (*::pixelmancy::logger::Log::GetLogger()) << level << P_LOG_LOCATION()
+
+// statements below BUILD_LOG_LEVEL are type checked but never evaluated
+#define P_LOG_DISABLED() true ? static_cast<void>(0) : ::pixelmancy::logger::null_logger() & ::pixelmancy::logger::null_logger()
+
 #if BUILD_LOG_LEVEL <= BUILD_LOG_LEVEL_TRACE
-#    define P_LOG_TRACE() \
-        (*::pixelmancy::logger::Log::GetLogger()) << ::pixelmancy::logger::LogLevel::TRACE << ::pixelmancy::logger::file_t(__FILE__, std::to_string(__LINE__))
+#    define P_LOG_TRACE() P_LOG_ENABLED(::pixelmancy::logger::LogLevel::TRACE)
 #else
-#    define P_LOG_TRACE() std::ostringstream()
+#    define P_LOG_TRACE() P_LOG_DISABLED()
 #endif
 
 #if BUILD_LOG_LEVEL <= BUILD_LOG_LEVEL_DEBUG
-#    define P_LOG_DEBUG() \
-        (*::pixelmancy::logger::Log::GetLogger()) << ::pixelmancy::logger::LogLevel::DEBUG << ::pixelmancy::logger::file_t(__FILE__, std::to_string(__LINE__))
+#    define P_LOG_DEBUG() P_LOG_ENABLED(::pixelmancy::logger::LogLevel::DEBUG)
 #else
-#    define P_LOG_DEBUG() std::ostringstream()
+#    define P_LOG_DEBUG() P_LOG_DISABLED()
 #endif
 
 #if BUILD_LOG_LEVEL <= BUILD_LOG_LEVEL_INFO
-#    define P_LOG_INFO() \
-        (*::pixelmancy::logger::Log::GetLogger()) << ::pixelmancy::logger::LogLevel::INFO << ::pixelmancy::logger::file_t(__FILE__, std::to_string(__LINE__))
+#    define P_LOG_INFO() P_LOG_ENABLED(::pixelmancy::logger::LogLevel::INFO)
 #else
-#    define P_LOG_INFO() std::ostringstream()
+#    define P_LOG_INFO() P_LOG_DISABLED()
 #endif
 
 #if BUILD_LOG_LEVEL <= BUILD_LOG_LEVEL_WARN
-#    define P_LOG_WARN() \
-        (*::pixelmancy::logger::Log::GetLogger()) << ::pixelmancy::logger::LogLevel::WARN << ::pixelmancy::logger::file_t(__FILE__, std::to_string(__LINE__))
+#    define P_LOG_WARN() P_LOG_ENABLED(::pixelmancy::logger::LogLevel::WARN)
 #else
-#    define P_LOG_WARN() std::ostringstream()
+#    define P_LOG_WARN() P_LOG_DISABLED()
 #endif
 
 #if BUILD_LOG_LEVEL <= BUILD_LOG_LEVEL_ERROR_LOG
-#    define P_LOG_ERROR()                                                                      \
-        (*::pixelmancy::logger::Log::GetLogger()) << ::pixelmancy::logger::LogLevel::ERROR_LOG \
-                                                  << ::pixelmancy::logger::file_t(__FILE__, std::to_string(__LINE__))
+#    define P_LOG_ERROR() P_LOG_ENABLED(::pixelmancy::logger::LogLevel::ERROR_LOG)
 #else
-#    define P_LOG_ERROR() std::ostringstream()
+#    define P_LOG_ERROR() P_LOG_DISABLED()
 #endif
 
 #if BUILD_LOG_LEVEL <= BUILD_LOG_LEVEL_CRITICAL
-#    define P_LOG_CRITICAL()                                                                  \
-        (*::pixelmancy::logger::Log::GetLogger()) << ::pixelmancy::logger::LogLevel::CRITICAL \
-                                                  << ::pixelmancy::logger::file_t(__FILE__, std::to_string(__LINE__))
+#    define P_LOG_CRITICAL() P_LOG_ENABLED(::pixelmancy::logger::LogLevel::CRITICAL)
 #else
-#    define P_LOG_CRITICAL() std::ostringstream()
+#    define P_LOG_CRITICAL() P_LOG_DISABLED()
 #endif
+
+// fmt variants, the message is formatted only when it is written
+#define P_LOGF_TRACE(...) P_LOG_TRACE() << ::fmt::format(__VA_ARGS__)
+#define P_LOGF_DEBUG(...) P_LOG_DEBUG() << ::fmt::format(__VA_ARGS__)
+#define P_LOGF_INFO(...) P_LOG_INFO() << ::fmt::format(__VA_ARGS__)
+#define P_LOGF_WARN(...) P_LOG_WARN() << ::fmt::format(__VA_ARGS__)
+#define P_LOGF_ERROR(...) P_LOG_ERROR() << ::fmt::format(__VA_ARGS__)
+#define P_LOGF_CRITICAL(...) P_LOG_CRITICAL() << ::fmt::format(__VA_ARGS__)
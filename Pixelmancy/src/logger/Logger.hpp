@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstddef>
+#include <string>
+
 #define BUILD_LOG_LEVEL_TRACE 0
 #define BUILD_LOG_LEVEL_DEBUG 1
 #define BUILD_LOG_LEVEL_INFO 2
@@ -41,9 +44,44 @@ enum class LogLevel
     INFO,
     WARN,
     ERROR_LOG,
-    CRITICAL
+    CRITICAL,
+    OFF // filter level that discards every message
+};
+
+/**
+ * What a logger does when it cannot queue a record
+ */
+enum class OverflowPolicy
+{
+    DROP, // discard the record and count it
+    BLOCK // wait until there is room
 };
 
+/**
+ * Get the colored tag that starts a message of the given level
+ */
+inline std::string levelTag(LogLevel level)
+{
+    switch (level)
+    {
+    case LogLevel::TRACE:
+        return std::string(TRACE_COLOR) + "[TRACE]" + RESET_COLOR;
+    case LogLevel::DEBUG:
+        return std::string(DEBUG_COLOR) + "[DEBUG]" + RESET_COLOR;
+    case LogLevel::INFO:
+        return std::string(INFO_COLOR) + "[INFO]" + RESET_COLOR;
+    case LogLevel::WARN:
+        return std::string(WARN_COLOR) + "[WARN]" + RESET_COLOR;
+    case LogLevel::ERROR_LOG:
+        return std::string(ERROR_COLOR) + "[ERROR]" + RESET_COLOR;
+    case LogLevel::CRITICAL:
+        return std::string(CRITICAL_COLOR) + "[CRITICAL]" + RESET_COLOR;
+    case LogLevel::OFF:
+        return {};
+    }
+    return {};
+}
+
 struct endl_t
 {
 };
@@ -52,16 +90,36 @@ struct flush_t
 {
 };
 
+/**
+ * Source location of a message. The file name is printed as it is, use
+ * fileNameOffset() to strip the directories of __FILE__ at compile time.
+ */
 struct file_t
 {
-    std::string fileName;
-    std::string lineNumber;
+    const char* fileName;
+    int lineNumber;
 
-    file_t(const std::string& file, const std::string& line) : fileName(file), lineNumber(line)
+    constexpr file_t(const char* file, int line) : fileName(file), lineNumber(line)
     {
     }
 };
 
+/**
+ * Get the position of the file name in a path
+ */
+constexpr std::size_t fileNameOffset(const char* path)
+{
+    std::size_t offset = 0;
+    for (std::size_t i = 0; path[i] != '\0'; i++)
+    {
+        if (path[i] == '/' || path[i] == '\\')
+        {
+            offset = i + 1;
+        }
+    }
+    return offset;
+}
+
 constexpr endl_t endl;
 constexpr flush_t flush;
 constexpr flush_t file;
@@ -72,6 +130,7 @@ public:
     virtual ~iLogger() = default;
 
     virtual LogLevel filter() const = 0;
+    virtual void setFilter(LogLevel level) = 0;
     virtual void setLogLevel(LogLevel level) = 0;
 
     virtual iLogger& operator<<(LogLevel level) = 0;
@@ -91,5 +150,31 @@ public:
     }
 };
 
+/**
+ * Turns a streamed log statement into void, so it fits in a conditional expression
+ */
+struct LogVoidify
+{
+    void operator&(iLogger&)
+    {
+    }
+};
+
+/**
+ * Sink for log statements removed at compile time, the arguments are not evaluated
+ */
+struct null_logger
+{
+    template <typename T>
+    null_logger& operator<<(const T&)
+    {
+        return *this;
+    }
+
+    void operator&(null_logger&)
+    {
+    }
+};
+
 } // namespace logger
 } // namespace pixelmancy
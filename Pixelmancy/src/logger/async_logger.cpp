@@ -0,0 +1,422 @@
+#include "async_logger.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+
+namespace pixelmancy {
+namespace logger {
+
+namespace {
+
+constexpr auto WRITER_IDLE_WAIT = std::chrono::milliseconds(5);
+
+std::atomic<std::uint64_t> s_nextLoggerId{1};
+
+std::size_t roundUpToPowerOfTwo(std::size_t value)
+{
+    std::size_t result = 1;
+    while (result < value)
+    {
+        result <<= 1;
+    }
+    return result;
+}
+
+template <typename T>
+std::string toString(T value)
+{
+    // same formatting as basic_ostream_logger
+    thread_local std::ostringstream stream;
+    stream.str(std::string());
+    stream << value;
+    return stream.str();
+}
+
+} // namespace
+
+struct async_logger::Record
+{
+    LogLevel level = LogLevel::INFO;
+    bool hasTag = false;
+    const char* fileName = nullptr;
+    int lineNumber = 0;
+    std::string payload;
+};
+
+/**
+ * Bounded single producer single consumer queue of records
+ */
+class async_logger::Ring
+{
+public:
+    explicit Ring(std::size_t capacity) : m_slots(capacity), m_mask(capacity - 1)
+    {
+    }
+
+    bool tryPush(Record& record)
+    {
+        const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) == m_slots.size())
+        {
+            return false;
+        }
+        m_slots[tail & m_mask] = std::move(record);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(Record& record)
+    {
+        const std::size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        record = std::move(m_slots[head & m_mask]);
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool isEmpty() const
+    {
+        return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+    }
+
+    void close()
+    {
+        m_closed.store(true, std::memory_order_release);
+    }
+
+    bool isClosed() const
+    {
+        return m_closed.load(std::memory_order_acquire);
+    }
+
+private:
+    std::vector<Record> m_slots;
+    const std::size_t m_mask;
+    alignas(64) std::atomic<std::size_t> m_head{0};
+    alignas(64) std::atomic<std::size_t> m_tail{0};
+    std::atomic<bool> m_closed{false};
+};
+
+/**
+ * Per thread state, the record that is being built and the ring it goes to
+ */
+struct async_logger::Producer
+{
+    ~Producer()
+    {
+        if (ring)
+        {
+            if (recording && enabled)
+            {
+                ring->tryPush(pending);
+            }
+            ring->close();
+        }
+    }
+
+    std::uint64_t loggerId = 0;
+    std::shared_ptr<Ring> ring;
+    Record pending;
+    LogLevel level = LogLevel::INFO;
+    bool recording = false;
+    bool enabled = false;
+};
+
+async_logger::async_logger(std::ostream& stream, LogLevel filterLevel, OverflowPolicy policy, std::size_t ringCapacity)
+ : m_stream(stream),
+   m_filterLogLevel(filterLevel),
+   m_policy(policy),
+   m_ringCapacity(roundUpToPowerOfTwo(std::max<std::size_t>(ringCapacity, 2))),
+   m_id(s_nextLoggerId++)
+{
+    m_writer = std::thread([this]() { writerLoop(); });
+}
+
+async_logger::~async_logger()
+{
+    Producer& state = producer();
+    commit(state);
+    {
+        std::lock_guard<std::mutex> lock(m_writerMutex);
+        m_stopping = true;
+    }
+    m_wakeWriter.notify_one();
+    m_writer.join();
+}
+
+LogLevel async_logger::filter() const
+{
+    return m_filterLogLevel.load(std::memory_order_relaxed);
+}
+
+void async_logger::setFilter(LogLevel level)
+{
+    m_filterLogLevel.store(level, std::memory_order_relaxed);
+    Producer& state = producer();
+    state.enabled = state.level >= level;
+}
+
+void async_logger::setLogLevel(LogLevel level)
+{
+    Producer& state = producer();
+    state.level = level;
+    state.enabled = level >= filter();
+}
+
+async_logger::Producer& async_logger::producer()
+{
+    thread_local Producer state;
+    if (state.loggerId != m_id)
+    {
+        if (state.ring)
+        {
+            state.ring->close();
+        }
+        state.loggerId = m_id;
+        state.ring = std::make_shared<Ring>(m_ringCapacity);
+        state.recording = false;
+        std::lock_guard<std::mutex> lock(m_ringsMutex);
+        m_rings.push_back(state.ring);
+    }
+    return state;
+}
+
+iLogger& async_logger::operator<<(LogLevel level)
+{
+    Producer& state = producer();
+    commit(state);
+    setLogLevel(level);
+    state.recording = true;
+    state.pending.level = level;
+    state.pending.hasTag = true;
+    return *this;
+}
+
+iLogger& async_logger::operator<<(std::string const& msg)
+{
+    append(msg);
+    // a newline finishes the record
+    if (!msg.empty() && msg.back() == '\n')
+    {
+        commit(producer());
+    }
+    return *this;
+}
+
+iLogger& async_logger::operator<<(endl_t)
+{
+    append("\n");
+    commit(producer());
+    return *this;
+}
+
+iLogger& async_logger::operator<<(flush_t)
+{
+    commit(producer());
+    flush();
+    return *this;
+}
+
+iLogger& async_logger::operator<<(file_t fileData)
+{
+    Producer& state = producer();
+    if (state.enabled)
+    {
+        state.pending.fileName = fileData.fileName;
+        state.pending.lineNumber = fileData.lineNumber;
+    }
+    return *this;
+}
+
+iLogger& async_logger::operator<<(int value)
+{
+    if (producer().enabled)
+    {
+        append(std::to_string(value));
+    }
+    return *this;
+}
+
+iLogger& async_logger::operator<<(float value)
+{
+    if (producer().enabled)
+    {
+        append(toString(value));
+    }
+    return *this;
+}
+
+iLogger& async_logger::operator<<(double value)
+{
+    if (producer().enabled)
+    {
+        append(toString(value));
+    }
+    return *this;
+}
+
+iLogger& async_logger::operator<<(unsigned value)
+{
+    if (producer().enabled)
+    {
+        append(std::to_string(static_cast<int>(value)));
+    }
+    return *this;
+}
+
+iLogger& async_logger::operator<<(std::size_t value)
+{
+    if (producer().enabled)
+    {
+        append(std::to_string(value));
+    }
+    return *this;
+}
+
+void async_logger::append(const std::string& text)
+{
+    Producer& state = producer();
+    if (!state.enabled)
+    {
+        return;
+    }
+    if (!state.recording)
+    {
+        // text after a finished record continues with the same level, without a tag
+        state.recording = true;
+        state.pending.level = state.level;
+        state.pending.hasTag = false;
+    }
+    state.pending.payload += text;
+}
+
+void async_logger::commit(Producer& state)
+{
+    if (!state.recording)
+    {
+        return;
+    }
+    state.recording = false;
+    if (state.enabled && !state.ring->tryPush(state.pending))
+    {
+        if (m_policy == OverflowPolicy::DROP)
+        {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        else
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_writerMutex);
+                m_blockedProducers++;
+            }
+            m_wakeWriter.notify_one();
+            while (!state.ring->tryPush(state.pending))
+            {
+                std::this_thread::yield();
+            }
+            std::lock_guard<std::mutex> lock(m_writerMutex);
+            m_blockedProducers--;
+        }
+    }
+    state.pending.fileName = nullptr;
+    state.pending.payload.clear();
+}
+
+void async_logger::flush()
+{
+    commit(producer());
+    std::unique_lock<std::mutex> lock(m_writerMutex);
+    const std::uint64_t request = ++m_flushRequests;
+    m_wakeWriter.notify_one();
+    m_drained.wait(lock, [&]() { return m_flushesDone >= request || m_stopping; });
+}
+
+std::uint64_t async_logger::droppedRecords() const
+{
+    return m_dropped.load(std::memory_order_relaxed);
+}
+
+void async_logger::writerLoop()
+{
+    std::string batch;
+    std::uint64_t reportedDrops = 0;
+    while (true)
+    {
+        std::uint64_t requests = 0;
+        bool stopping = false;
+        {
+            std::unique_lock<std::mutex> lock(m_writerMutex);
+            m_wakeWriter.wait_for(lock, WRITER_IDLE_WAIT, [this]() { return m_stopping || m_blockedProducers > 0 || m_flushRequests > m_flushesDone; });
+            requests = m_flushRequests;
+            stopping = m_stopping;
+        }
+
+        batch.clear();
+        drainRings(batch);
+        while (stopping && drainRings(batch))
+        {
+        }
+        const std::uint64_t drops = droppedRecords();
+        if (drops != reportedDrops)
+        {
+            batch += levelTag(LogLevel::WARN) + std::to_string(drops - reportedDrops) + " log records dropped\n";
+            reportedDrops = drops;
+        }
+        if (!batch.empty())
+        {
+            m_stream << batch << std::flush;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_writerMutex);
+            m_flushesDone = requests;
+        }
+        m_drained.notify_all();
+        if (stopping)
+        {
+            return;
+        }
+    }
+}
+
+// returns true when at least one record was written to the batch
+bool async_logger::drainRings(std::string& batch)
+{
+    std::vector<std::shared_ptr<Ring>> rings;
+    {
+        std::lock_guard<std::mutex> lock(m_ringsMutex);
+        // rings of finished threads are dropped once they are empty
+        m_rings.erase(std::remove_if(m_rings.begin(), m_rings.end(),
+                                     [](const std::shared_ptr<Ring>& ring) { return ring->isClosed() && ring->isEmpty(); }),
+                      m_rings.end());
+        rings = m_rings;
+    }
+
+    bool drained = false;
+    Record record;
+    for (auto& ring : rings)
+    {
+        while (ring->tryPop(record))
+        {
+            drained = true;
+            if (record.hasTag)
+            {
+                batch += levelTag(record.level);
+                if (record.fileName != nullptr)
+                {
+                    batch += std::string("[") + LINE_COLOR + record.fileName + RESET_COLOR + ":" + LINE_COLOR +
+                             std::to_string(record.lineNumber) + RESET_COLOR + "] - ";
+                }
+            }
+            batch += record.payload;
+        }
+    }
+    return drained;
+}
+
+} // namespace logger
+} // namespace pixelmancy
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Logger.hpp"
+
+namespace pixelmancy {
+namespace logger {
+
+/**
+ * @brief A logger that writes to an ostream from a background thread.
+ *
+ * Every thread that logs gets its own single producer single consumer ring of
+ * records, so producers never take a lock. A record is finished by a newline,
+ * logger::endl, logger::flush or the next log level. The writer thread
+ * formats the records and writes them in batches. Destroying the logger
+ * writes every record that is still queued.
+ */
+class async_logger : public iLogger
+{
+public:
+    /**
+     * @param stream stream to write to, it must outlive the logger
+     * @param filterLevel records below this level are discarded by the producer
+     * @param policy what to do when a ring is full
+     * @param ringCapacity number of records per thread, rounded up to a power of two
+     */
+    explicit async_logger(std::ostream& stream, LogLevel filterLevel = static_cast<LogLevel>(BUILD_LOG_LEVEL),
+                          OverflowPolicy policy = OverflowPolicy::DROP, std::size_t ringCapacity = DEFAULT_RING_CAPACITY);
+    ~async_logger() override;
+
+    async_logger(const async_logger&) = delete;
+    async_logger& operator=(const async_logger&) = delete;
+
+    LogLevel filter() const override;
+    void setFilter(LogLevel level) override;
+    void setLogLevel(LogLevel level) override;
+
+    iLogger& operator<<(LogLevel level) override;
+    iLogger& operator<<(std::string const& msg) override;
+    iLogger& operator<<(endl_t) override;
+    iLogger& operator<<(flush_t) override;
+    iLogger& operator<<(file_t fileData) override;
+    iLogger& operator<<(int value) override;
+    iLogger& operator<<(float value) override;
+    iLogger& operator<<(double value) override;
+    iLogger& operator<<(unsigned value) override;
+    iLogger& operator<<(std::size_t value) override;
+
+    /**
+     * Wait until every record finished before the call has been written
+     */
+    void flush();
+
+    /**
+     * Get the number of records dropped because a ring was full
+     */
+    std::uint64_t droppedRecords() const;
+
+    static constexpr std::size_t DEFAULT_RING_CAPACITY = 1024;
+
+private:
+    struct Record;
+    class Ring;
+    struct Producer;
+
+    Producer& producer();
+    void append(const std::string& text);
+    void commit(Producer& state);
+    void writerLoop();
+    bool drainRings(std::string& batch);
+
+    std::ostream& m_stream;
+    std::atomic<LogLevel> m_filterLogLevel;
+    const OverflowPolicy m_policy;
+    const std::size_t m_ringCapacity;
+    const std::uint64_t m_id;
+
+    std::vector<std::shared_ptr<Ring>> m_rings;
+    std::mutex m_ringsMutex;
+
+    std::mutex m_writerMutex;
+    std::condition_variable m_wakeWriter;
+    std::condition_variable m_drained;
+    std::uint64_t m_flushRequests = 0;
+    std::uint64_t m_flushesDone = 0;
+    // producers waiting for room in a full ring, the writer keeps draining while there are any
+    std::size_t m_blockedProducers = 0;
+    bool m_stopping = false;
+    std::atomic<std::uint64_t> m_dropped{0};
+    std::thread m_writer;
+};
+
+} // namespace logger
+} // namespace pixelmancy
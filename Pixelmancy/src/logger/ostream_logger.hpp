@@ -1,6 +1,5 @@
 #pragma once
 
-#include <filesystem>
 #include <ostream>
 #include <string>
 
@@ -26,6 +25,11 @@ public:
         return m_filterLogLevel;
     }
 
+    void setFilter(LogLevel level) override
+    {
+        m_filterLogLevel = level;
+    }
+
     void setLogLevel(LogLevel level) override
     {
         m_messageLogLevel = level;
@@ -36,32 +40,7 @@ public:
         setLogLevel(level);
         if (m_messageLogLevel >= m_filterLogLevel)
         {
-            switch (m_messageLogLevel)
-            {
-            case LogLevel::TRACE:
-                m_stream << TRACE_COLOR << "[TRACE]" << RESET_COLOR;
-                break;
-
-            case LogLevel::DEBUG:
-                m_stream << DEBUG_COLOR << "[DEBUG]" << RESET_COLOR;
-                break;
-
-            case LogLevel::INFO:
-                m_stream << INFO_COLOR << "[INFO]" << RESET_COLOR;
-                break;
-
-            case LogLevel::WARN:
-                m_stream << WARN_COLOR << "[WARN]" << RESET_COLOR;
-                break;
-
-            case LogLevel::ERROR_LOG:
-                m_stream << ERROR_COLOR << "[ERROR]" << RESET_COLOR;
-                break;
-
-            case LogLevel::CRITICAL:
-                m_stream << CRITICAL_COLOR << "[CRITICAL]" << RESET_COLOR;
-                break;
-            }
+            m_stream << levelTag(m_messageLogLevel);
         }
         return *this;
     }
@@ -88,8 +67,7 @@ public:
     {
         if (m_messageLogLevel >= m_filterLogLevel)
         {
-            std::filesystem::path filePath(fileData.fileName);
-            m_stream << "[" << LINE_COLOR << filePath.filename().string() << RESET_COLOR << ":" << LINE_COLOR << fileData.lineNumber << RESET_COLOR << "] - ";
+            m_stream << "[" << LINE_COLOR << fileData.fileName << RESET_COLOR << ":" << LINE_COLOR << fileData.lineNumber << RESET_COLOR << "] - ";
         }
         return *this;
     }
@@ -0,0 +1,50 @@
+#include "Json.hpp"
+
+#include <fmt/format.h>
+
+namespace pixelmancy::profiler {
+
+std::string escapeJson(std::string_view text)
+{
+    std::string escaped;
+    escaped.reserve(text.size());
+    for (const char c : text)
+    {
+        switch (c)
+        {
+        case '"':
+            escaped += "\\\"";
+            break;
+        case '\\':
+            escaped += "\\\\";
+            break;
+        case '\n':
+            escaped += "\\n";
+            break;
+        case '\r':
+            escaped += "\\r";
+            break;
+        case '\t':
+            escaped += "\\t";
+            break;
+        case '\b':
+            escaped += "\\b";
+            break;
+        case '\f':
+            escaped += "\\f";
+            break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20)
+            {
+                escaped += fmt::format("\\u{:04x}", static_cast<int>(c));
+            }
+            else
+            {
+                escaped += c;
+            }
+        }
+    }
+    return escaped;
+}
+
+} // namespace pixelmancy::profiler
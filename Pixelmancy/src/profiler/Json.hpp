@@ -0,0 +1,14 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace pixelmancy::profiler {
+
+/**
+ * Escape text for a JSON string, quotes and backslashes as well as the
+ * control characters, so names with line breaks still give valid JSON
+ */
+std::string escapeJson(std::string_view text);
+
+} // namespace pixelmancy::profiler
@@ -0,0 +1,293 @@
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+
+#include <fmt/format.h>
+
+#include "Json.hpp"
+#include "Log.hpp"
+
+namespace pixelmancy::profiler {
+
+namespace {
+
+struct Event
+{
+    const char* name;
+    std::int64_t startNs;
+    std::int64_t durationNs;
+    std::int64_t selfNs;
+    std::uint32_t depth;
+};
+
+// written by the owning thread, read by the thread that collects the results
+struct ThreadBuffer
+{
+    std::mutex mutex;
+    std::uint32_t threadId = 0;
+    std::vector<Event> events;
+};
+
+struct ThreadEvents
+{
+    std::uint32_t threadId;
+    std::vector<Event> events;
+};
+
+struct Registry
+{
+    std::mutex mutex;
+    // buffers stay registered after their thread exits, so no events are lost
+    std::vector<std::shared_ptr<ThreadBuffer>> threads;
+    std::vector<Counter*> counters;
+    std::atomic<std::int64_t> epochNs{0};
+};
+
+Registry& registry()
+{
+    static Registry instance;
+    return instance;
+}
+
+thread_local ScopedTimer* t_currentTimer = nullptr;
+
+std::int64_t nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+ThreadBuffer& localBuffer()
+{
+    thread_local std::shared_ptr<ThreadBuffer> buffer;
+    if (!buffer)
+    {
+        buffer = std::make_shared<ThreadBuffer>();
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        reg.threads.push_back(buffer);
+        buffer->threadId = static_cast<std::uint32_t>(reg.threads.size());
+    }
+    return *buffer;
+}
+
+std::vector<ThreadEvents> snapshot()
+{
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    std::vector<ThreadEvents> result;
+    result.reserve(reg.threads.size());
+    for (auto& thread : reg.threads)
+    {
+        std::lock_guard<std::mutex> threadLock(thread->mutex);
+        if (!thread->events.empty())
+        {
+            result.push_back({thread->threadId, thread->events});
+        }
+    }
+    return result;
+}
+
+double toMs(std::uint64_t ns)
+{
+    return static_cast<double>(ns) / 1e6;
+}
+
+double toUs(std::int64_t ns)
+{
+    return static_cast<double>(ns) / 1e3;
+}
+
+} // namespace
+
+std::atomic<bool> Profiler::s_enabled{false};
+
+void Profiler::Start()
+{
+    Reset();
+    registry().epochNs = nowNs();
+    s_enabled = true;
+}
+
+void Profiler::Stop()
+{
+    s_enabled = false;
+}
+
+void Profiler::Reset()
+{
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (auto& thread : reg.threads)
+    {
+        std::lock_guard<std::mutex> threadLock(thread->mutex);
+        thread->events.clear();
+    }
+    for (Counter* counter : reg.counters)
+    {
+        counter->reset();
+    }
+}
+
+std::vector<SummaryRow> Profiler::Summary()
+{
+    // the key is the path of scope names from the root, so ordering by key
+    // puts every scope right after its parent
+    constexpr char PATH_SEPARATOR = '\x01';
+    std::map<std::string, SummaryRow> rows;
+    for (auto& thread : snapshot())
+    {
+        std::vector<Event>& events = thread.events;
+        std::sort(events.begin(), events.end(), [](const Event& a, const Event& b) {
+            return a.startNs != b.startNs ? a.startNs < b.startNs : a.depth < b.depth;
+        });
+        std::vector<std::pair<std::uint32_t, std::string>> parents;
+        for (const Event& event : events)
+        {
+            while (!parents.empty() && parents.back().first >= event.depth)
+            {
+                parents.pop_back();
+            }
+            std::string path = parents.empty() ? event.name : parents.back().second + PATH_SEPARATOR + event.name;
+            SummaryRow& row = rows[path];
+            row.name = event.name;
+            row.depth = static_cast<std::uint32_t>(parents.size());
+            row.calls++;
+            row.totalNs += static_cast<std::uint64_t>(event.durationNs);
+            row.selfNs += static_cast<std::uint64_t>(event.selfNs);
+            row.maxNs = std::max(row.maxNs, static_cast<std::uint64_t>(event.durationNs));
+            parents.emplace_back(event.depth, std::move(path));
+        }
+    }
+
+    std::vector<SummaryRow> summary;
+    summary.reserve(rows.size());
+    for (auto& entry : rows)
+    {
+        summary.push_back(std::move(entry.second));
+    }
+    return summary;
+}
+
+std::map<std::string, std::int64_t> Profiler::CounterValues()
+{
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    std::map<std::string, std::int64_t> values;
+    for (const Counter* counter : reg.counters)
+    {
+        if (counter->value() != 0)
+        {
+            values[counter->name()] += counter->value();
+        }
+    }
+    return values;
+}
+
+void Profiler::WriteSummary(std::ostream& stream)
+{
+    stream << fmt::format("{:<48}{:>10}{:>14}{:>14}{:>14}\n", "Scope", "Calls", "Total ms", "Self ms", "Max ms");
+    for (const SummaryRow& row : Summary())
+    {
+        const std::string name = std::string(2 * row.depth, ' ') + row.name;
+        stream << fmt::format("{:<48}{:>10}{:>14.3f}{:>14.3f}{:>14.3f}\n", name, row.calls, toMs(row.totalNs), toMs(row.selfNs),
+                              toMs(row.maxNs));
+    }
+
+    const auto counters = CounterValues();
+    if (!counters.empty())
+    {
+        stream << fmt::format("\n{:<48}{:>24}\n", "Counter", "Value");
+        for (const auto& [name, value] : counters)
+        {
+            stream << fmt::format("{:<48}{:>24}\n", name, value);
+        }
+    }
+}
+
+void Profiler::WriteChromeTrace(std::ostream& stream)
+{
+    constexpr int PROCESS_ID = 1;
+    stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    const char* separator = "\n";
+    std::int64_t endNs = 0;
+    for (const auto& thread : snapshot())
+    {
+        stream << separator
+               << fmt::format(R"({{"name":"thread_name","ph":"M","pid":{},"tid":{},"args":{{"name":"thread {}"}}}})", PROCESS_ID,
+                              thread.threadId, thread.threadId);
+        separator = ",\n";
+        for (const Event& event : thread.events)
+        {
+            stream << separator
+                   << fmt::format(R"({{"name":"{}","cat":"pixelmancy","ph":"X","pid":{},"tid":{},"ts":{:.3f},"dur":{:.3f}}})",
+                                  escapeJson(event.name), PROCESS_ID, thread.threadId, toUs(event.startNs), toUs(event.durationNs));
+            endNs = std::max(endNs, event.startNs + event.durationNs);
+        }
+    }
+    // counters only have totals, they are shown as one sample at the end of the trace
+    for (const auto& [name, value] : CounterValues())
+    {
+        stream << separator
+               << fmt::format(R"({{"name":"{}","ph":"C","pid":{},"tid":0,"ts":{:.3f},"args":{{"value":{}}}}})", escapeJson(name),
+                              PROCESS_ID, toUs(endNs), value);
+        separator = ",\n";
+    }
+    stream << "\n]}\n";
+}
+
+bool Profiler::SaveChromeTrace(const std::string& filePath)
+{
+    std::ofstream file(filePath);
+    if (!file)
+    {
+        P_LOG_ERROR() << "Failed to open " << filePath << " for the profile\n";
+        return false;
+    }
+    WriteChromeTrace(file);
+    return file.good();
+}
+
+void ScopedTimer::begin(const char* name)
+{
+    m_name = name;
+    m_parent = t_currentTimer;
+    t_currentTimer = this;
+    m_startNs = nowNs();
+}
+
+void ScopedTimer::end()
+{
+    const std::int64_t durationNs = nowNs() - m_startNs;
+    t_currentTimer = m_parent;
+    std::uint32_t depth = 0;
+    for (const ScopedTimer* parent = m_parent; parent != nullptr; parent = parent->m_parent)
+    {
+        depth++;
+    }
+    if (m_parent != nullptr)
+    {
+        m_parent->m_childNs += durationNs;
+    }
+    if (!Profiler::IsEnabled())
+    {
+        return;
+    }
+
+    const std::int64_t startNs = std::max<std::int64_t>(m_startNs - registry().epochNs.load(), 0);
+    ThreadBuffer& buffer = localBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    buffer.events.push_back({m_name, startNs, durationNs, durationNs - m_childNs, depth});
+}
+
+Counter::Counter(const char* name) : m_name(name)
+{
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    reg.counters.push_back(this);
+}
+
+} // namespace pixelmancy::profiler
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// set to 0 by PIXELMANCY_ENABLE_PROFILING=OFF, the P_PROFILE macros then expand to nothing
+#ifndef PIXELMANCY_PROFILING
+#    define PIXELMANCY_PROFILING 1
+#endif
+
+namespace pixelmancy::profiler {
+
+constexpr bool PROFILING_COMPILED_IN = PIXELMANCY_PROFILING != 0;
+
+/**
+ * Aggregated timings of one scope, scopes with the same parents are merged
+ */
+struct SummaryRow
+{
+    std::string name;
+    std::uint32_t depth = 0;
+    std::uint64_t calls = 0;
+    std::uint64_t totalNs = 0;
+    std::uint64_t selfNs = 0;
+    std::uint64_t maxNs = 0;
+};
+
+/**
+ * Collects the scoped timers and counters of all threads between Start() and Stop()
+ */
+class Profiler
+{
+public:
+    /**
+     * Clear the recorded events and counters and start recording
+     */
+    static void Start();
+
+    /**
+     * Stop recording, the recorded events are kept until the next Start() or Reset()
+     */
+    static void Stop();
+
+    /**
+     * Clear the recorded events and counters
+     */
+    static void Reset();
+
+    static bool IsEnabled()
+    {
+        return s_enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Get the scope timings as a tree, children follow their parent
+     */
+    static std::vector<SummaryRow> Summary();
+
+    /**
+     * Get the totals of the counters by name
+     */
+    static std::map<std::string, std::int64_t> CounterValues();
+
+    /**
+     * Write the scope timings and the counters as a table
+     * @param stream stream to write to
+     */
+    static void WriteSummary(std::ostream& stream);
+
+    /**
+     * Write the recorded events in the Chrome trace event format, the file can
+     * be opened in chrome://tracing or https://ui.perfetto.dev
+     * @param stream stream to write to
+     */
+    static void WriteChromeTrace(std::ostream& stream);
+
+    /**
+     * Write the Chrome trace to a file
+     * @param filePath path of the file
+     * @return true if the file was written
+     */
+    static bool SaveChromeTrace(const std::string& filePath);
+
+private:
+    static std::atomic<bool> s_enabled;
+};
+
+/**
+ * Measures the time until the end of the scope. Timers nest per thread, the
+ * time of nested timers is subtracted from the self time of the parent.
+ */
+class ScopedTimer
+{
+public:
+    /**
+     * @param name name of the scope, it must outlive the profiler (use a string literal)
+     */
+    explicit ScopedTimer(const char* name)
+    {
+        if (Profiler::IsEnabled())
+        {
+            begin(name);
+        }
+    }
+
+    ~ScopedTimer()
+    {
+        if (m_name != nullptr)
+        {
+            end();
+        }
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    void begin(const char* name);
+    void end();
+
+    const char* m_name = nullptr;
+    ScopedTimer* m_parent = nullptr;
+    std::int64_t m_startNs = 0;
+    std::int64_t m_childNs = 0;
+};
+
+/**
+ * Running total that is shared by all threads. Counters with the same name
+ * are added together in the summary.
+ */
+class Counter
+{
+public:
+    /**
+     * @param name name of the counter, it must outlive the profiler (use a string literal)
+     */
+    explicit Counter(const char* name);
+
+    Counter(const Counter&) = delete;
+    Counter& operator=(const Counter&) = delete;
+
+    void add(std::int64_t value)
+    {
+        m_value.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    const char* name() const
+    {
+        return m_name;
+    }
+
+    std::int64_t value() const
+    {
+        return m_value.load(std::memory_order_relaxed);
+    }
+
+    void reset()
+    {
+        m_value.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    const char* m_name;
+    std::atomic<std::int64_t> m_value{0};
+};
+
+} // namespace pixelmancy::profiler
+
+#define P_PROFILE_CONCAT_IMPL(a, b) a##b
+#define P_PROFILE_CONCAT(a, b) P_PROFILE_CONCAT_IMPL(a, b)
+
+#if PIXELMANCY_PROFILING
+// time the rest of the enclosing scope
+#    define P_PROFILE_SCOPE(name) ::pixelmancy::profiler::ScopedTimer P_PROFILE_CONCAT(profileScope, __LINE__)(name)
+// the value is evaluated only while the profiler is recording
+#    define P_PROFILE_COUNTER(name, value)                                                  \
+        do                                                                                  \
+        {                                                                                   \
+            static ::pixelmancy::profiler::Counter profileCounter(name);                    \
+            if (::pixelmancy::profiler::Profiler::IsEnabled())                              \
+            {                                                                               \
+                profileCounter.add(static_cast<std::int64_t>(value));                       \
+            }                                                                               \
+        } while (false)
+#else
+#    define P_PROFILE_SCOPE(name) static_cast<void>(0)
+#    define P_PROFILE_COUNTER(name, value) static_cast<void>(sizeof(value))
+#endif
@@ -0,0 +1,197 @@
+#include "ScenarioBenchmark.hpp"
+
+#include <profiler/Json.hpp>
+#include <profiler/Profiler.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <windows.h>
+// windows.h must come first
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace scenario {
+
+namespace {
+
+using pixelmancy::profiler::escapeJson;
+
+std::uint64_t fileBytes(const std::vector<std::string> &files) {
+  std::uint64_t bytes = 0;
+  for (const auto &file : files) {
+    std::error_code error;
+    const auto size = std::filesystem::file_size(file, error);
+    if (!error) {
+      bytes += size;
+    }
+  }
+  return bytes;
+}
+
+} // namespace
+
+int Scale::canvasSize(int size) const {
+  return std::max(1, static_cast<int>(std::lround(size * canvas)));
+}
+
+int Scale::frameCount(int count) const {
+  return std::max(1, static_cast<int>(std::lround(count * frames)));
+}
+
+std::uint64_t peakRssBytes() {
+#ifdef _WIN32
+  PROCESS_MEMORY_COUNTERS counters;
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+    return counters.PeakWorkingSetSize;
+  }
+  return 0;
+#else
+  rusage usage{};
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return 0;
+  }
+#ifdef __APPLE__
+  return static_cast<std::uint64_t>(usage.ru_maxrss);
+#else
+  // kilobytes on Linux
+  return static_cast<std::uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+Report benchmark(const Scenario &scenario, const BenchmarkOptions &options) {
+  using Clock = std::chrono::steady_clock;
+  Report report;
+  report.name = scenario.name;
+  const std::uint64_t peakBefore = peakRssBytes();
+
+  for (int i = 0; i < options.warmup; i++) {
+    scenario.run(options.scale, options.outputFolder);
+  }
+
+  std::vector<double> wallMs;
+  Output output;
+  pixelmancy::profiler::Profiler::Start();
+  for (int i = 0; i < options.repeat; i++) {
+    const auto start = Clock::now();
+    output = scenario.run(options.scale, options.outputFolder);
+    wallMs.push_back(
+        std::chrono::duration<double, std::milli>(Clock::now() - start)
+            .count());
+    report.ok = report.ok && output.ok;
+  }
+  pixelmancy::profiler::Profiler::Stop();
+
+  if (wallMs.empty()) {
+    return report;
+  }
+  report.runs = static_cast<int>(wallMs.size());
+  double totalMs = 0.0;
+  for (double ms : wallMs) {
+    totalMs += ms;
+  }
+  report.meanMs = totalMs / report.runs;
+  std::sort(wallMs.begin(), wallMs.end());
+  const std::size_t middle = wallMs.size() / 2;
+  report.medianMs = wallMs.size() % 2 == 1
+                        ? wallMs[middle]
+                        : (wallMs[middle - 1] + wallMs[middle]) / 2.0;
+  report.minMs = wallMs.front();
+  report.maxMs = wallMs.back();
+  report.frames = output.frames;
+  if (report.medianMs > 0.0) {
+    report.framesPerSecond = output.frames * 1000.0 / report.medianMs;
+  }
+  report.outputBytes = fileBytes(output.files);
+  report.processPeakRssBytes = peakRssBytes();
+  report.peakRssGrowthBytes =
+      report.processPeakRssBytes > peakBefore
+          ? report.processPeakRssBytes - peakBefore
+          : 0;
+
+  for (const auto &row : pixelmancy::profiler::Profiler::Summary()) {
+    Stage stage;
+    stage.name = row.name;
+    stage.depth = row.depth;
+    stage.calls = static_cast<double>(row.calls) / report.runs;
+    stage.totalMs = static_cast<double>(row.totalNs) / 1e6 / report.runs;
+    stage.selfMs = static_cast<double>(row.selfNs) / 1e6 / report.runs;
+    report.stages.push_back(stage);
+  }
+  pixelmancy::profiler::Profiler::Reset();
+  return report;
+}
+
+void writeText(std::ostream &stream, const std::vector<Report> &reports) {
+  for (const auto &report : reports) {
+    stream << fmt::format("{} ({} runs{})\n", report.name, report.runs,
+                          report.ok ? "" : ", FAILED");
+    stream << fmt::format(
+        "  wall time  median {:.3f} ms  mean {:.3f} ms  min {:.3f} ms  max "
+        "{:.3f} ms\n",
+        report.medianMs, report.meanMs, report.minMs, report.maxMs);
+    stream << fmt::format("  frames     {}  ({:.2f} fps)\n", report.frames,
+                          report.framesPerSecond);
+    stream << fmt::format("  output     {} bytes\n", report.outputBytes);
+    stream << fmt::format(
+        "  peak RSS   {:.1f} MiB process  +{:.1f} MiB by this scenario\n",
+        static_cast<double>(report.processPeakRssBytes) / (1024.0 * 1024.0),
+        static_cast<double>(report.peakRssGrowthBytes) / (1024.0 * 1024.0));
+    if (!report.stages.empty()) {
+      stream << fmt::format("  {:<46}{:>10}{:>14}{:>14}\n", "Stage per run",
+                            "Calls", "Total ms", "Self ms");
+      for (const auto &stage : report.stages) {
+        stream << fmt::format(
+            "  {:<46}{:>10.1f}{:>14.3f}{:>14.3f}\n",
+            std::string(2 * stage.depth, ' ') + stage.name, stage.calls,
+            stage.totalMs, stage.selfMs);
+      }
+    }
+    stream << "\n";
+  }
+}
+
+void writeJson(std::ostream &stream, const std::vector<Report> &reports,
+               const BenchmarkOptions &options) {
+  stream << fmt::format("{{\n  \"repeat\": {}, \"warmup\": {}, "
+                        "\"canvas_scale\": {}, \"frame_scale\": {},\n"
+                        "  \"scenarios\": [",
+                        options.repeat, options.warmup, options.scale.canvas,
+                        options.scale.frames);
+  const char *separator = "\n";
+  for (const auto &report : reports) {
+    std::string stages;
+    for (const auto &stage : report.stages) {
+      stages += fmt::format(
+          "{}{{\"name\": \"{}\", \"depth\": {}, \"calls\": {:.1f}, "
+          "\"total_ms\": {:.3f}, \"self_ms\": {:.3f}}}",
+          stages.empty() ? "" : ", ", escapeJson(stage.name), stage.depth,
+          stage.calls, stage.totalMs, stage.selfMs);
+    }
+    stream << separator
+           << fmt::format(
+                  "    {{\"name\": \"{}\", \"ok\": {}, \"runs\": {}, "
+                  "\"median_ms\": {:.3f}, \"mean_ms\": {:.3f}, "
+                  "\"min_ms\": {:.3f}, \"max_ms\": {:.3f}, \"frames\": {}, "
+                  "\"fps\": {:.3f}, \"output_bytes\": {}, "
+                  "\"process_peak_rss_bytes\": {}, "
+                  "\"peak_rss_growth_bytes\": {}, \"stages\": [{}]}}",
+                  escapeJson(report.name), report.ok, report.runs,
+                  report.medianMs, report.meanMs, report.minMs, report.maxMs,
+                  report.frames, report.framesPerSecond, report.outputBytes,
+                  report.processPeakRssBytes, report.peakRssGrowthBytes,
+                  stages);
+    separator = ",\n";
+  }
+  stream << "\n  ]\n}\n";
+}
+
+} // namespace scenario
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace scenario {
+
+/**
+ * Factors applied to the frame counts and canvas sizes of a scenario, 1 runs
+ * the scenario as it is graded
+ */
+struct Scale {
+  double canvas = 1.0;
+  double frames = 1.0;
+
+  int canvasSize(int size) const;
+  int frameCount(int count) const;
+};
+
+/**
+ * Files written by one run of a scenario
+ */
+struct Output {
+  std::vector<std::string> files;
+  // frames or images produced, used for the frame rate
+  int frames = 0;
+  bool ok = true;
+};
+
+using Function =
+    std::function<Output(const Scale &scale, const std::string &outputFolder)>;
+
+struct Scenario {
+  std::string name;
+  Function run;
+};
+
+struct BenchmarkOptions {
+  int repeat = 5;
+  int warmup = 1;
+  Scale scale;
+  std::string outputFolder;
+};
+
+/**
+ * Mean time of a profiled stage in one run
+ */
+struct Stage {
+  std::string name;
+  std::uint32_t depth = 0;
+  double calls = 0.0;
+  double totalMs = 0.0;
+  double selfMs = 0.0;
+};
+
+struct Report {
+  std::string name;
+  int runs = 0;
+  double medianMs = 0.0;
+  double meanMs = 0.0;
+  double minMs = 0.0;
+  double maxMs = 0.0;
+  int frames = 0;
+  double framesPerSecond = 0.0;
+  std::uint64_t outputBytes = 0;
+  // peak of the whole process after the scenario ran, it includes the
+  // scenarios before this one
+  std::uint64_t processPeakRssBytes = 0;
+  // how much this scenario raised the peak of the process, 0 if it stayed
+  // below the peak of the scenarios before it
+  std::uint64_t peakRssGrowthBytes = 0;
+  bool ok = true;
+  std::vector<Stage> stages;
+};
+
+/**
+ * Run a scenario warmup times, then time it repeat times. The stages are
+ * collected with the profiler while the timed runs execute.
+ */
+Report benchmark(const Scenario &scenario, const BenchmarkOptions &options);
+
+void writeText(std::ostream &stream, const std::vector<Report> &reports);
+void writeJson(std::ostream &stream, const std::vector<Report> &reports,
+               const BenchmarkOptions &options);
+
+/**
+ * Get the largest resident set size of the process so far, 0 if unknown
+ */
+std::uint64_t peakRssBytes();
+
+} // namespace scenario
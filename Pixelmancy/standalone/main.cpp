@@ -1,19 +1,31 @@
+#include "ScenarioBenchmark.hpp"
 #include "config.hpp"
+#include <Animation.hpp>
+#include <AssetCache.hpp>
 #include <CircleObject.hpp>
 #include <Common.hpp>
+#include <FrameBuilder.hpp>
+#include <FramePool.hpp>
 #include <Gif.hpp>
 #include <Image.hpp>
+#include <ImageCompare.hpp>
 #include <Line.hpp>
 #include <Log.hpp>
 #include <SquareObject.hpp>
+#include <ThreadPool.hpp>
 #include <colors/Color.hpp>
 #include <colors/ColorMatcher.hpp>
 #include <cstddef>
 #include <cxxopts.hpp>
 #include <logger/ostream_logger.hpp>
+#include <profiler/Profiler.hpp>
 
 
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <iterator>
 #include <memory>
 #include <string>
 #include <unordered_set>
@@ -22,14 +34,6 @@
 #define M_PI 3.14159265358979323846
 #endif
 
-#ifdef _WIN32
-#include <cstdlib>
-#define WEXITSTATUS(x) x
-#define diff "fc "
-#else
-#define diff "diff "
-#endif
-
 const std::string OUTPUT_FOLDER_STR = std::string(OUTPUT_FOLDER);
 
 int virtualPoints = 0;
@@ -40,22 +44,44 @@ int totalPoints = 0;
 
 #define CHECK_RETURN return totalPoints == virtualPoints ? 0 : 1
 
-bool compareFiles(const std::string &file1, const std::string &file2) {
-#ifdef _WIN32
-  // Replace forward slashes with backslashes for Windows paths
-  std::string fixedFile1 = file1;
-  std::replace(fixedFile1.begin(), fixedFile1.end(), '/', '\\');
-
-  std::string fixedFile2 = file2;
-  std::replace(fixedFile2.begin(), fixedFile2.end(), '/', '\\');
-  std::string command =
-      fmt::format("{} \"{}\" \"{}\"", diff, fixedFile1, fixedFile2);
-#else
-  std::string command = fmt::format("{} \"{}\" \"{}\"", diff, file1, file2);
-#endif
+// PNG files are compared by their pixels, so different encodings of the same
+// image match. Other files are compared byte by byte.
+bool sameContent(const std::string &file1, const std::string &file2) {
+  if (std::filesystem::path(file1).extension() == ".png" &&
+      std::filesystem::path(file2).extension() == ".png") {
+    try {
+      const auto result =
+          pixelmancy::compare(pixelmancy::Image::loadFromFile(file2),
+                              pixelmancy::Image::loadFromFile(file1));
+      if (!result.matches && !result.sizeMismatch) {
+        P_LOGF_INFO("{} pixels differ in rows {}-{} columns {}-{}, max channel "
+                    "error {}, PSNR {:.2f} dB\n",
+                    result.mismatchCount, result.diffBounds.minX,
+                    result.diffBounds.maxX - 1, result.diffBounds.minY,
+                    result.diffBounds.maxY - 1, result.maxChannelError,
+                    result.psnr);
+      }
+      return result.matches;
+    } catch (const std::exception &e) {
+      P_LOG_ERROR() << "Failed to compare " << file1 << " and " << file2
+                    << " : " << e.what() << "\n";
+      return false;
+    }
+  }
+  std::ifstream stream1(file1, std::ios::binary);
+  std::ifstream stream2(file2, std::ios::binary);
+  if (!stream1 || !stream2) {
+    P_LOG_ERROR() << "Failed to open " << file1 << " or " << file2 << "\n";
+    return false;
+  }
+  return std::equal(std::istreambuf_iterator<char>(stream1),
+                    std::istreambuf_iterator<char>(),
+                    std::istreambuf_iterator<char>(stream2),
+                    std::istreambuf_iterator<char>());
+}
 
-  int result = WEXITSTATUS(system(command.c_str()));
-  if (result == 0) {
+bool compareFiles(const std::string &file1, const std::string &file2) {
+  if (sameContent(file1, file2)) {
     P_LOG_INFO() << "CORRECT : File : " << file1 << " and " << file2
                  << " are same\n";
     return true;
@@ -66,21 +92,7 @@ bool compareFiles(const std::string &file1, const std::string &file2) {
 }
 
 bool fakeCompareFiles(const std::string &file1, const std::string &file2) {
-#ifdef _WIN32
-  // Replace forward slashes with backslashes for Windows paths
-  std::string fixedFile1 = file1;
-  std::replace(fixedFile1.begin(), fixedFile1.end(), '/', '\\');
-
-  std::string fixedFile2 = file2;
-  std::replace(fixedFile2.begin(), fixedFile2.end(), '/', '\\');
-
-  std::string command = diff + fixedFile1 + " " + fixedFile2;
-#else
-  std::string command = diff + file1 + " " + file2;
-#endif
-
-  int result = WEXITSTATUS(system(command.c_str()));
-  if (result == 0) {
+  if (sameContent(file1, file2)) {
     P_LOG_ERROR() << "WRONG : File : " << file1 << " and " << file2
                   << " are same\n";
     return false;
@@ -91,39 +103,30 @@ bool fakeCompareFiles(const std::string &file1, const std::string &file2) {
   return true;
 }
 
-int imageResize() {
-  P_LOG_INFO() << "--- The color reduction problem START ---\n";
-
-  auto img =
-      pixelmancy::Image::loadFromFile(OUTPUT_FOLDER_STR + "/../tree.png");
+scenario::Output renderImageResize(const scenario::Scale &scale,
+                                   const std::string &outputFolder) {
+  // a copy of the shared tree, it is replaced by its resize
+  pixelmancy::Image img = *pixelmancy::AssetCache::global().load(TREE_IMAGE);
+  if (scale.canvas != 1.0) {
+    img = img.resize(scale.canvas);
+  }
   auto smallImage = img.resize(0.5);
   P_LOG_INFO() << "Original color count: " << img.getColorPalette().size()
                << "\n";
   P_LOG_INFO() << "Small image color count: "
                << smallImage.getColorPalette().size() << "\n";
 
-  smallImage.save(OUTPUT_FOLDER_STR + "/resized_image.png");
-  totalPoints += 1;
-  if (compareFiles(OUTPUT_FOLDER_STR + "/resized_image.png",
-                   OUTPUT_FOLDER_STR + "/../resized_image.png")) {
-    virtualPoints++;
-  }
+  scenario::Output output;
+  smallImage.save(outputFolder + "/resized_image.png");
+  output.files.push_back(outputFolder + "/resized_image.png");
 
   auto smallerImage = smallImage.resize(0.25);
-  smallerImage.save(OUTPUT_FOLDER_STR + "/resized_smaller_image.png");
-  totalPoints += 1;
-  if (compareFiles(OUTPUT_FOLDER_STR + "/resized_smaller_image.png",
-                   OUTPUT_FOLDER_STR + "/../resized_smaller_image.png")) {
-    virtualPoints++;
-  }
+  smallerImage.save(outputFolder + "/resized_smaller_image.png");
+  output.files.push_back(outputFolder + "/resized_smaller_image.png");
 
   auto largeImage = smallImage.resize(2);
-  largeImage.save(OUTPUT_FOLDER_STR + "/resized_large_image.png");
-  totalPoints += 1;
-  if (compareFiles(OUTPUT_FOLDER_STR + "/resized_large_image.png",
-                   OUTPUT_FOLDER_STR + "/../resized_large_image.png")) {
-    virtualPoints++;
-  }
+  largeImage.save(outputFolder + "/resized_large_image.png");
+  output.files.push_back(outputFolder + "/resized_large_image.png");
 
   smallImage.removeAlphaChannel();
   smallImage.blueShift();
@@ -133,13 +136,23 @@ int imageResize() {
                           pixelmancy::ROSY_BROWN);
   smallImage.replaceColorPalette(
       std::forward<decltype(colorPallette)>(colorPallette));
-  smallImage.save(OUTPUT_FOLDER_STR + "/tree_reduced_colors.png");
+  smallImage.save(outputFolder + "/tree_reduced_colors.png");
+  output.files.push_back(outputFolder + "/tree_reduced_colors.png");
+  output.frames = static_cast<int>(output.files.size());
+  return output;
+}
 
-  if (compareFiles(OUTPUT_FOLDER_STR + "/tree_reduced_colors.png",
-                   OUTPUT_FOLDER_STR + "/../tree_reduced_colors.png")) {
-    virtualPoints++;
+int imageResize() {
+  P_LOG_INFO() << "--- The color reduction problem START ---\n";
+
+  const scenario::Output output = renderImageResize({}, OUTPUT_FOLDER_STR);
+  for (const auto &file : output.files) {
+    totalPoints += 1;
+    const auto fileName = std::filesystem::path(file).filename().string();
+    if (compareFiles(file, OUTPUT_FOLDER_STR + "/../" + fileName)) {
+      virtualPoints++;
+    }
   }
-  totalPoints += 1;
   PRINT_POINTS;
 
   P_LOG_INFO() << "--- The color reduction problem END ---\n";
@@ -327,43 +340,58 @@ int threePNGBoxes() {
   CHECK_RETURN;
 }
 
+scenario::Output
+renderThreeBoxes(std::shared_ptr<pixelmancy::ColorMatcher> colorMatcher,
+                 const scenario::Scale &scale,
+                 const std::string &outputFolder) {
+  pixelmancy::Gif gif(colorMatcher);
+  std::vector<std::unique_ptr<pixelmancy::graphics::DrawableObject>> dObjs;
+  const int squareSize = scale.canvasSize(50);
+  dObjs.push_back(std::make_unique<pixelmancy::graphics::SquareObject>(
+      pixelmancy::sizei2d({squareSize, squareSize}), 0, pixelmancy::RED));
+  dObjs.push_back(std::make_unique<pixelmancy::graphics::CircleObject>(
+      scale.canvasSize(15), 2, pixelmancy::LIGHT_GOLDEN_ROD_YELLOW,
+      pixelmancy::DARK_GOLDEN_ROD));
+  std::array<pixelmancy::graphics::Point, 3> positions = {
+      pixelmancy::graphics::Point(0, 0),
+      pixelmancy::graphics::Point(scale.canvasSize(24), scale.canvasSize(26)),
+      pixelmancy::graphics::Point(scale.canvasSize(50), scale.canvasSize(50))};
+
+  const int frames = scale.frameCount(3);
+  for (int i = 0; i < frames; i++) {
+    int offset = 0;
+    pixelmancy::Image img(scale.canvasSize(100), scale.canvasSize(100),
+                          pixelmancy::WHITE);
+    for (auto &dObj : dObjs) {
+      auto pos = positions[static_cast<std::size_t>(i) % positions.size()];
+      // move circle to the middle of the square
+      if (dObj->getObjectType() == pixelmancy::graphics::ObjectType::CIRCLE) {
+        pos = pos + pixelmancy::graphics::Point(squareSize / 2, squareSize / 2);
+      }
+      dObj->setPosition(pos);
+      dObj->drawOn(img);
+      offset++;
+    }
+    gif.addFrame(img);
+  }
+  scenario::Output output;
+  output.ok = gif.save(outputFolder + "/three_boxes.gif");
+  gif.close();
+  output.files.push_back(outputFolder + "/three_boxes.gif");
+  output.frames = frames;
+  return output;
+}
+
 int threeBoxes(std::shared_ptr<pixelmancy::ColorMatcher> colorMatcher) {
   P_LOG_INFO() << "--- The boxes GIF problem START ---\n";
   totalPoints += 2;
-  {
-    pixelmancy::Gif gif(colorMatcher);
-    std::vector<std::unique_ptr<pixelmancy::graphics::DrawableObject>> dObjs;
-    dObjs.push_back(std::make_unique<pixelmancy::graphics::SquareObject>(
-        pixelmancy::sizei2d({50, 50}), 0, pixelmancy::RED));
-    dObjs.push_back(std::make_unique<pixelmancy::graphics::CircleObject>(
-        15, 2, pixelmancy::LIGHT_GOLDEN_ROD_YELLOW,
-        pixelmancy::DARK_GOLDEN_ROD));
-    std::array<pixelmancy::graphics::Point, 3> positions = {
-        pixelmancy::graphics::Point(0, 0), pixelmancy::graphics::Point(24, 26),
-        pixelmancy::graphics::Point(50, 50)};
-
-    for (std::size_t i = 0; i < 3; i++) {
-      int offset = 0;
-      pixelmancy::Image img(100, 100, pixelmancy::WHITE);
-      for (auto &dObj : dObjs) {
-        auto pos = positions[i];
-        // move circle to the middle of the square
-        if (dObj->getObjectType() == pixelmancy::graphics::ObjectType::CIRCLE) {
-          pos = pos + pixelmancy::graphics::Point(25, 25);
-        }
-        dObj->setPosition(pos);
-        dObj->drawOn(img);
-        offset++;
-      }
-      gif.addFrame(img);
-    }
-    if (gif.save(OUTPUT_FOLDER_STR + "/three_boxes.gif")) {
-      P_LOG_INFO() << "CORRECT: GIF saved successfully\n";
-      virtualPoints += 1;
-    } else {
-      P_LOG_ERROR() << "WRONG: GIF not saved\n";
-    }
-    gif.close();
+  const scenario::Output output =
+      renderThreeBoxes(colorMatcher, {}, OUTPUT_FOLDER_STR);
+  if (output.ok) {
+    P_LOG_INFO() << "CORRECT: GIF saved successfully\n";
+    virtualPoints += 1;
+  } else {
+    P_LOG_ERROR() << "WRONG: GIF not saved\n";
   }
 
   if (compareFiles(OUTPUT_FOLDER_STR + "/three_boxes.gif",
@@ -375,20 +403,22 @@ int threeBoxes(std::shared_ptr<pixelmancy::ColorMatcher> colorMatcher) {
   CHECK_RETURN;
 }
 
-int drawOnImage(std::shared_ptr<pixelmancy::ColorMatcher> colorMatcher) {
-  P_LOG_INFO() << "--- The draw on image problem START ---\n";
-
+scenario::Output
+renderDrawOnImage(std::shared_ptr<pixelmancy::ColorMatcher> colorMatcher,
+                  const scenario::Scale &scale,
+                  const std::string &outputFolder) {
+  // the default seed, so every run draws the same rain
+  std::srand(1);
   pixelmancy::Gif gif(colorMatcher);
-  pixelmancy::graphics::SquareObject rain({4, 4}, 0, pixelmancy::ROYAL_BLUE);
-  auto img = pixelmancy::Image::loadFromFile(TREE_IMAGE);
-  pixelmancy::Image smallImage = img.resize(0.5);
+  const auto tree = pixelmancy::AssetCache::global().load(TREE_IMAGE);
+  pixelmancy::Image smallImage = tree->resize(0.5 * scale.canvas);
   smallImage.blueShift();
   smallImage.removeAlphaChannel();
   smallImage.reduceColorPalette(64);
-  smallImage.save(OUTPUT_FOLDER_STR + "/small_tree.png");
+  smallImage.save(outputFolder + "/small_tree.png");
 
-  P_LOG_INFO() << fmt::format("smallImage size : {}x{} wxh\n",
-                              smallImage.getWidth(), smallImage.getHeight());
+  P_LOGF_INFO("smallImage size : {}x{} wxh\n", smallImage.getWidth(),
+              smallImage.getHeight());
 
   std::vector<pixelmancy::graphics::Point> positions(70);
   for (int j = 0; j < 70; j++) {
@@ -401,63 +431,66 @@ int drawOnImage(std::shared_ptr<pixelmancy::ColorMatcher> colorMatcher) {
     return (pos >= max) ? pos % max : pos;
   };
 
+  // only the areas the rain drops leave and enter are redrawn between frames
+  pixelmancy::FrameBuilder frameBuilder(smallImage);
+  std::vector<std::shared_ptr<pixelmancy::graphics::SquareObject>> rainDrops;
+  for (std::size_t j = 0; j < positions.size(); j++) {
+    rainDrops.push_back(std::make_shared<pixelmancy::graphics::SquareObject>(
+        pixelmancy::sizei2d{4, 4}, 0, pixelmancy::ROYAL_BLUE));
+    frameBuilder.addObject(rainDrops.back());
+  }
+
   auto colorPallette = smallImage.getColorPalette();
-  P_LOG_INFO() << fmt::format("Color pallette szie : {}\n",
-                              colorPallette.size());
+  P_LOGF_INFO("Color pallette szie : {}\n", colorPallette.size());
 
-  pixelmancy::Image imgCopy2(smallImage);
   const int frameDelay = 9;
-  for (int i = 0; i < 25; i++) {
-    pixelmancy::Image imgCopy(smallImage);
-    for (const auto &[x, y] : positions) {
-      int xPos = loopBack(x + i * 2, imgCopy.getWidth());
-      int yPos = loopBack(y + i, imgCopy.getHeight());
-      rain.setPosition({xPos, yPos});
-      rain.drawOn(imgCopy);
-    }
-    gif.addFrame(imgCopy, frameDelay);
-  }
-  colorPallette.swapColor(pixelmancy::Color(28, 176, 176),
-                          pixelmancy::DARK_GOLDEN_ROD);
-  for (int i = 25; i < 50; i++) {
-    pixelmancy::Image imgCopy(smallImage);
-    imgCopy.replaceColorPalette(colorPallette);
-    for (const auto &[x, y] : positions) {
-      int xPos = loopBack(x + i * 2, imgCopy.getWidth());
-      int yPos = loopBack(y + i, imgCopy.getHeight());
-      rain.setPosition({xPos, yPos});
-      rain.drawOn(imgCopy);
-    }
-    gif.addFrame(imgCopy, frameDelay);
-  }
-  colorPallette.swapColor(pixelmancy::Color(16, 72, 72), 
-                        pixelmancy::DARK_ORANGE);
-  for (int i = 50; i < 75; i++) {
-    pixelmancy::Image imgCopy(smallImage);
-    imgCopy.replaceColorPalette(colorPallette);
-    for (const auto &[x, y] : positions) {
-      int xPos = loopBack(x + i * 2, imgCopy.getWidth());
-      int yPos = loopBack(y + i, imgCopy.getHeight());
-      rain.setPosition({xPos, yPos});
-      rain.drawOn(imgCopy);
-    }
-    gif.addFrame(imgCopy, frameDelay);
-  }
-  colorPallette.swapColor(pixelmancy::Color(24, 112, 112), 
-                          pixelmancy::GOLDEN_ROD);
-  for (int i = 75; i < 100; i++) {
-    pixelmancy::Image imgCopy(smallImage);
-    imgCopy.replaceColorPalette(colorPallette);
-    for (const auto &[x, y] : positions) {
-      int xPos = loopBack(x + i * 2, imgCopy.getWidth());
-      int yPos = loopBack(y + i, imgCopy.getHeight());
-      rain.setPosition({xPos, yPos});
-      rain.drawOn(imgCopy);
+  auto addFrames = [&](int begin, int end) {
+    for (int i = begin; i < end; i++) {
+      for (std::size_t j = 0; j < positions.size(); j++) {
+        int xPos = loopBack(positions[j].x + i * 2, smallImage.getWidth());
+        int yPos = loopBack(positions[j].y + i, smallImage.getHeight());
+        rainDrops[j]->setPosition({xPos, yPos});
+      }
+      const pixelmancy::Image &frame = frameBuilder.render();
+      if (auto changedRegion = frameBuilder.changedRegion()) {
+        gif.addFrame(frame, frameDelay, *changedRegion);
+      } else {
+        gif.addFrame(frame, frameDelay);
+      }
     }
-    gif.addFrame(imgCopy, frameDelay);
-  }
-  gif.save(OUTPUT_FOLDER_STR + "/draw_on_tree.gif");
+  };
+  auto swapBackgroundColor = [&](const pixelmancy::Color &oldColor,
+                                 const pixelmancy::Color &newColor) {
+    colorPallette.swapColor(oldColor, newColor);
+    pixelmancy::Image background(smallImage);
+    background.replaceColorPalette(colorPallette);
+    frameBuilder.setBackground(background);
+  };
+
+  // the background color changes every quarter of the frames
+  const int frames = scale.frameCount(100);
+  addFrames(0, frames / 4);
+  swapBackgroundColor(pixelmancy::Color(28, 176, 176),
+                      pixelmancy::DARK_GOLDEN_ROD);
+  addFrames(frames / 4, frames / 2);
+  swapBackgroundColor(pixelmancy::Color(16, 72, 72), pixelmancy::DARK_ORANGE);
+  addFrames(frames / 2, frames * 3 / 4);
+  swapBackgroundColor(pixelmancy::Color(24, 112, 112),
+                      pixelmancy::GOLDEN_ROD);
+  addFrames(frames * 3 / 4, frames);
+  scenario::Output output;
+  output.ok = gif.save(outputFolder + "/draw_on_tree.gif");
   gif.close();
+  output.files = {outputFolder + "/small_tree.png",
+                  outputFolder + "/draw_on_tree.gif"};
+  output.frames = frames;
+  return output;
+}
+
+int drawOnImage(std::shared_ptr<pixelmancy::ColorMatcher> colorMatcher) {
+  P_LOG_INFO() << "--- The draw on image problem START ---\n";
+
+  renderDrawOnImage(colorMatcher, {}, OUTPUT_FOLDER_STR);
   if (fakeCompareFiles(OUTPUT_FOLDER_STR + "/draw_on_tree.gif",
                        OUTPUT_FOLDER_STR + "/../draw_on_tree.gif")) {
     virtualPoints += 1;
@@ -468,16 +501,22 @@ int drawOnImage(std::shared_ptr<pixelmancy::ColorMatcher> colorMatcher) {
   CHECK_RETURN;
 }
 
-int circleRotating(std::shared_ptr<pixelmancy::ColorMatcher> colorMatcher) {
-  P_LOG_INFO() << "--- The rotating circles problem START ---\n";
+scenario::Output
+renderCircleRotating(std::shared_ptr<pixelmancy::ColorMatcher> colorMatcher,
+                     const scenario::Scale &scale,
+                     const std::string &outputFolder) {
   pixelmancy::Gif gif(colorMatcher);
-  auto circle = pixelmancy::graphics::CircleObject(10, 2, pixelmancy::MAGENTA,
-                                                   pixelmancy::GREEN);
-  const int frames = 2;
-  for (int i = 0; i < frames; i++) {
-    pixelmancy::Image img(550, 550);
-    pixelmancy::sizei2d center = {275, 275};
-    int radius = 240;
+  const int frames = scale.frameCount(2);
+  const int canvas = scale.canvasSize(550);
+  auto framePool = std::make_shared<pixelmancy::FramePool>(canvas, canvas);
+  gif.setFramePool(framePool);
+  // every frame builds its own objects, frames are rendered in parallel
+  auto renderFrame = [scale](int i, pixelmancy::Image &img) {
+    auto circle = pixelmancy::graphics::CircleObject(
+        scale.canvasSize(10), 2, pixelmancy::MAGENTA, pixelmancy::GREEN);
+    pixelmancy::sizei2d center = {scale.canvasSize(275),
+                                  scale.canvasSize(275)};
+    int radius = scale.canvasSize(240);
     const double frameTheta = i * 5 * M_PI / 180;
     for (int j = 0; j < 360; j += 10) {
       double theta = frameTheta + j * M_PI / 180;
@@ -486,40 +525,55 @@ int circleRotating(std::shared_ptr<pixelmancy::ColorMatcher> colorMatcher) {
       circle.setPosition({x, y});
       circle.drawOn(img);
     }
-    gif.addFrame(img);
-  }
-  gif.save(OUTPUT_FOLDER_STR + "/circle_rotating.gif");
+  };
+  pixelmancy::Animation animation(frames, framePool, renderFrame);
+  animation.renderTo(gif);
+  scenario::Output output;
+  output.ok = gif.save(outputFolder + "/circle_rotating.gif");
   gif.close();
+  output.files.push_back(outputFolder + "/circle_rotating.gif");
+  output.frames = frames;
+  return output;
+}
+
+int circleRotating(std::shared_ptr<pixelmancy::ColorMatcher> colorMatcher) {
+  P_LOG_INFO() << "--- The rotating circles problem START ---\n";
+  renderCircleRotating(colorMatcher, {}, OUTPUT_FOLDER_STR);
   PRINT_POINTS;
   P_LOG_INFO() << "--- The rotating circles problem END ---\n";
   CHECK_RETURN;
 }
 
-int wheel(std::shared_ptr<pixelmancy::ColorMatcher> colorMatcher) {
-  P_LOG_INFO() << "--- The wheel problem START ---\n";
+scenario::Output renderWheel(std::shared_ptr<pixelmancy::ColorMatcher> colorMatcher,
+                             const scenario::Scale &scale,
+                             const std::string &outputFolder) {
   pixelmancy::Gif gif(colorMatcher);
-  auto circle = pixelmancy::graphics::CircleObject(10, 2, pixelmancy::MAGENTA,
-                                                   pixelmancy::GREEN);
-  auto circleType2 = pixelmancy::graphics::CircleObject(
-      6, 2, pixelmancy::YELLOW, pixelmancy::VIOLET);
-  auto circleMiddle = pixelmancy::graphics::CircleObject(
-      80, 2, pixelmancy::YELLOW_GREEN, pixelmancy::RED);
-  auto circleMiddle2 = pixelmancy::graphics::CircleObject(
-      63, 2, pixelmancy::BLANCHED_ALMOND, pixelmancy::RED);
-  auto circleMiddle3 = pixelmancy::graphics::CircleObject(
-      60, 2, pixelmancy::BLACK, pixelmancy::RED);
-  pixelmancy::graphics::SquareObject rain({10, 235}, 0, pixelmancy::WHITE);
-  const int frames = 2;
-  const pixelmancy::graphics::Point middlePos = {275, 275};
-  circleMiddle.setPosition(middlePos);
-  circleMiddle2.setPosition(middlePos);
-  circleMiddle3.setPosition(middlePos);
-  rain.setPosition({275, 275});
-
-  for (int i = 0; i < frames; i++) {
-    pixelmancy::Image img(550, 550);
-    pixelmancy::sizei2d center = {275, 275};
-    const int radius = 240;
+  const int frames = scale.frameCount(2);
+  const int canvas = scale.canvasSize(550);
+  auto framePool = std::make_shared<pixelmancy::FramePool>(canvas, canvas);
+  gif.setFramePool(framePool);
+  auto renderFrame = [scale](int i, pixelmancy::Image &img) {
+    auto circle = pixelmancy::graphics::CircleObject(
+        scale.canvasSize(10), 2, pixelmancy::MAGENTA, pixelmancy::GREEN);
+    auto circleType2 = pixelmancy::graphics::CircleObject(
+        scale.canvasSize(6), 2, pixelmancy::YELLOW, pixelmancy::VIOLET);
+    auto circleMiddle = pixelmancy::graphics::CircleObject(
+        scale.canvasSize(80), 2, pixelmancy::YELLOW_GREEN, pixelmancy::RED);
+    auto circleMiddle2 = pixelmancy::graphics::CircleObject(
+        scale.canvasSize(63), 2, pixelmancy::BLANCHED_ALMOND, pixelmancy::RED);
+    auto circleMiddle3 = pixelmancy::graphics::CircleObject(
+        scale.canvasSize(60), 2, pixelmancy::BLACK, pixelmancy::RED);
+    pixelmancy::graphics::SquareObject rain(
+        {scale.canvasSize(10), scale.canvasSize(235)}, 0, pixelmancy::WHITE);
+    const int middle = scale.canvasSize(275);
+    const pixelmancy::graphics::Point middlePos = {middle, middle};
+    circleMiddle.setPosition(middlePos);
+    circleMiddle2.setPosition(middlePos);
+    circleMiddle3.setPosition(middlePos);
+    rain.setPosition({middle, middle});
+
+    pixelmancy::sizei2d center = {middle, middle};
+    const int radius = scale.canvasSize(240);
     const double frameTheta = i * 5 * M_PI / 180;
     for (int j = 0; j < 360; j += 10) {
       double theta = frameTheta + j * M_PI / 180;
@@ -537,7 +591,7 @@ int wheel(std::shared_ptr<pixelmancy::ColorMatcher> colorMatcher) {
     circleMiddle.drawOn(img);
     circleMiddle2.drawOn(img);
     circleMiddle3.drawOn(img);
-    int radius2 = 70;
+    int radius2 = scale.canvasSize(70);
     for (int j = 0; j < 360; j += 10) {
       double theta = frameTheta + j * M_PI / 180;
       int x2 = static_cast<int>(center.width + radius2 * cos(theta));
@@ -545,37 +599,27 @@ int wheel(std::shared_ptr<pixelmancy::ColorMatcher> colorMatcher) {
       circleType2.setPosition({x2, y2});
       circleType2.drawOn(img);
     }
-    gif.addFrame(img);
-  }
-  gif.save(OUTPUT_FOLDER_STR + "/wheel.gif");
+  };
+  pixelmancy::Animation animation(frames, framePool, renderFrame);
+  animation.renderTo(gif);
+  scenario::Output output;
+  output.ok = gif.save(outputFolder + "/wheel.gif");
   gif.close();
+  output.files.push_back(outputFolder + "/wheel.gif");
+  output.frames = frames;
+  return output;
+}
+
+int wheel(std::shared_ptr<pixelmancy::ColorMatcher> colorMatcher) {
+  P_LOG_INFO() << "--- The wheel problem START ---\n";
+  renderWheel(colorMatcher, {}, OUTPUT_FOLDER_STR);
   PRINT_POINTS;
   P_LOG_INFO() << "--- The rotating circles problem END ---\n";
   CHECK_RETURN;
 }
 
-int main(int argc, char *argv[]) {
-  pixelmancy::logger::Log::Init(pixelmancy::logger::LogLevel::WARN);
-  std::shared_ptr<pixelmancy::ColorMatcher> colorMatcher =
-      std::make_shared<pixelmancy::ColorMatcher>();
-
-  cxxopts::Options options("Pixelmancy", "A simple GIF library");
-
-  options.add_options()("h,help", "Print help")("c,color", "Color problem")(
-      "d,distance", "Distance problem")("i,image", "Image problem")(
-      "p,three-png-boxes", "Three PNG boxes problem")("t,three-boxes",
-                                                      "Three boxes problem")(
-      "r,image-resize", "Image resize problem")("g,draw-on-image",
-                                                "Draw on image problem")(
-      "o,circle-rotating", "Circle rotating problem")("w,wheel",
-                                                      "Wheel problem");
-
-  auto result = options.parse(argc, argv);
-  if (result.count("help") == 1) {
-    std::cout << options.help() << std::endl;
-    exit(1);
-  }
-
+int runProblem(const cxxopts::ParseResult &result,
+               std::shared_ptr<pixelmancy::ColorMatcher> colorMatcher) {
   if (result["color"].as<bool>()) {
     return colorProblem();
   }
@@ -613,3 +657,148 @@ int main(int argc, char *argv[]) {
   }
   return 0;
 }
+
+int runBenchmark(const cxxopts::ParseResult &result,
+                 std::shared_ptr<pixelmancy::ColorMatcher> colorMatcher) {
+  const std::vector<scenario::Scenario> scenarios = {
+      {"image-resize", renderImageResize},
+      {"three-boxes",
+       [colorMatcher](const scenario::Scale &scale, const std::string &folder) {
+         return renderThreeBoxes(colorMatcher, scale, folder);
+       }},
+      {"draw-on-image",
+       [colorMatcher](const scenario::Scale &scale, const std::string &folder) {
+         return renderDrawOnImage(colorMatcher, scale, folder);
+       }},
+      {"circle-rotating",
+       [colorMatcher](const scenario::Scale &scale, const std::string &folder) {
+         return renderCircleRotating(colorMatcher, scale, folder);
+       }},
+      {"wheel",
+       [colorMatcher](const scenario::Scale &scale, const std::string &folder) {
+         return renderWheel(colorMatcher, scale, folder);
+       }}};
+
+  // writing the log would be timed too, and it would mix with the report
+  pixelmancy::logger::Log::SetFilter(pixelmancy::logger::LogLevel::ERROR_LOG);
+
+  scenario::BenchmarkOptions options;
+  options.repeat = result["repeat"].as<int>();
+  options.warmup = result["warmup"].as<int>();
+  options.scale.canvas = result["canvas-scale"].as<double>();
+  options.scale.frames = result["frame-scale"].as<double>();
+  options.outputFolder = result["bench-output"].as<std::string>();
+  if (options.repeat < 1 || options.warmup < 0 || options.scale.canvas <= 0 ||
+      options.scale.frames <= 0) {
+    P_LOG_ERROR() << "Repeat must be positive, warmup non-negative and the "
+                     "scales larger than 0\n";
+    return 1;
+  }
+  // the graded outputs in OUTPUT_FOLDER are left alone
+  std::error_code error;
+  std::filesystem::create_directories(options.outputFolder, error);
+  if (error) {
+    P_LOG_ERROR() << "Failed to create " << options.outputFolder << "\n";
+    return 1;
+  }
+
+  std::vector<std::string> selected =
+      result["scenarios"].as<std::vector<std::string>>();
+  std::vector<scenario::Report> reports;
+  for (const auto &name : selected) {
+    auto found = std::find_if(
+        scenarios.begin(), scenarios.end(),
+        [&name](const scenario::Scenario &s) { return s.name == name; });
+    if (found == scenarios.end()) {
+      P_LOG_ERROR() << "Unknown scenario " << name << "\n";
+      return 1;
+    }
+    reports.push_back(scenario::benchmark(*found, options));
+  }
+
+  if (result["format"].as<std::string>() == "json") {
+    scenario::writeJson(std::cout, reports, options);
+  } else {
+    scenario::writeText(std::cout, reports);
+  }
+  const bool ok = std::all_of(reports.begin(), reports.end(),
+                              [](const scenario::Report &r) { return r.ok; });
+  return ok ? 0 : 1;
+}
+
+int main(int argc, char *argv[]) {
+  pixelmancy::logger::Log::Init(pixelmancy::logger::LogLevel::WARN);
+  std::shared_ptr<pixelmancy::ColorMatcher> colorMatcher =
+      std::make_shared<pixelmancy::ColorMatcher>();
+
+  cxxopts::Options options("Pixelmancy", "A simple GIF library");
+
+  options.add_options()("h,help", "Print help")("c,color", "Color problem")(
+      "d,distance", "Distance problem")("i,image", "Image problem")(
+      "p,three-png-boxes", "Three PNG boxes problem")("t,three-boxes",
+                                                      "Three boxes problem")(
+      "r,image-resize", "Image resize problem")("g,draw-on-image",
+                                                "Draw on image problem")(
+      "o,circle-rotating", "Circle rotating problem")("w,wheel",
+                                                      "Wheel problem")(
+      "profile", "Print a timing summary and write a Chrome trace to a file",
+      cxxopts::value<std::string>())(
+      "threads", "Threads of the shared pool, 0 uses every hardware thread",
+      cxxopts::value<std::size_t>()->default_value("0"));
+  options.add_options("Benchmark")("b,benchmark",
+                                   "Time the scenarios instead of grading them")(
+      "scenarios", "Scenarios to time",
+      cxxopts::value<std::vector<std::string>>()->default_value(
+          "image-resize,three-boxes,draw-on-image,circle-rotating,wheel"))(
+      "repeat", "Timed runs of every scenario",
+      cxxopts::value<int>()->default_value("5"))(
+      "warmup", "Untimed runs before the timed ones",
+      cxxopts::value<int>()->default_value("1"))(
+      "canvas-scale", "Factor for the canvas sizes",
+      cxxopts::value<double>()->default_value("1"))(
+      "frame-scale", "Factor for the frame counts",
+      cxxopts::value<double>()->default_value("1"))(
+      "format", "Report format, text or json",
+      cxxopts::value<std::string>()->default_value("text"))(
+      "bench-output", "Folder for the files written while timing",
+      cxxopts::value<std::string>()->default_value(
+          (std::filesystem::temp_directory_path() / "pixelmancy_bench")
+              .string()));
+
+  auto result = options.parse(argc, argv);
+  if (result.count("help") == 1) {
+    std::cout << options.help() << std::endl;
+    exit(1);
+  }
+  pixelmancy::ThreadPool::setGlobalThreadCount(
+      result["threads"].as<std::size_t>());
+
+  const bool profile = result.count("profile") == 1;
+  if (result["benchmark"].as<bool>()) {
+    if (profile) {
+      P_LOG_ERROR() << "--profile cannot be combined with --benchmark, the "
+                       "benchmark reports the stages itself\n";
+      return 1;
+    }
+    return runBenchmark(result, colorMatcher);
+  }
+  if (profile) {
+    if (!pixelmancy::profiler::PROFILING_COMPILED_IN) {
+      P_LOG_WARN() << "Profiling is disabled in this build "
+                      "(PIXELMANCY_ENABLE_PROFILING=OFF)\n";
+    }
+    pixelmancy::profiler::Profiler::Start();
+  }
+
+  const int exitCode = runProblem(result, colorMatcher);
+
+  if (profile) {
+    pixelmancy::profiler::Profiler::Stop();
+    pixelmancy::profiler::Profiler::WriteSummary(std::cout);
+    const auto profilePath = result["profile"].as<std::string>();
+    if (!pixelmancy::profiler::Profiler::SaveChromeTrace(profilePath)) {
+      return 1;
+    }
+  }
+  return exitCode;
+}
@@ -0,0 +1,295 @@
+#include <Apng.hpp>
+#include <Image.hpp>
+#include <ThreadPool.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#include <lodepng.h>
+#include <string>
+#include <vector>
+
+#include "common.hpp"
+
+namespace {
+
+struct DecodedFrame
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t column = 0;
+    uint32_t row = 0;
+    uint16_t delay = 0;
+    // canvas after the frame, RGBA
+    std::vector<unsigned char> canvas;
+};
+
+struct DecodedApng
+{
+    uint32_t width = 0;
+    uint32_t height = 0;
+    unsigned char colorType = 0;
+    uint32_t frameCount = 0;
+    std::vector<DecodedFrame> frames;
+};
+
+uint32_t readUint32(const unsigned char* data)
+{
+    return static_cast<uint32_t>(data[0]) << 24 | static_cast<uint32_t>(data[1]) << 16 | static_cast<uint32_t>(data[2]) << 8 | data[3];
+}
+
+void appendUint32(std::vector<unsigned char>& data, uint32_t value)
+{
+    for (int shift = 24; shift >= 0; shift -= 8)
+    {
+        data.push_back(static_cast<unsigned char>(value >> shift));
+    }
+}
+
+void appendChunk(std::vector<unsigned char>& png, const char* type, const std::vector<unsigned char>& data)
+{
+    appendUint32(png, static_cast<uint32_t>(data.size()));
+    const std::size_t typeStart = png.size();
+    png.insert(png.end(), type, type + 4);
+    png.insert(png.end(), data.begin(), data.end());
+    appendUint32(png, lodepng_crc32(png.data() + typeStart, png.size() - typeStart));
+}
+
+// Decode the region of a frame as a PNG of its own, its fdAT chunks are IDAT
+// chunks with a sequence number
+std::vector<unsigned char> decodeRegion(const DecodedApng& apng, const DecodedFrame& frame, const std::vector<unsigned char>& data)
+{
+    std::vector<unsigned char> png = {137, 80, 78, 71, 13, 10, 26, 10};
+    std::vector<unsigned char> header;
+    appendUint32(header, frame.width);
+    appendUint32(header, frame.height);
+    header.insert(header.end(), {8, apng.colorType, 0, 0, 0});
+    appendChunk(png, "IHDR", header);
+    appendChunk(png, "IDAT", data);
+    appendChunk(png, "IEND", {});
+    std::vector<unsigned char> rgba;
+    unsigned width = 0;
+    unsigned height = 0;
+    REQUIRE(lodepng::decode(rgba, width, height, png) == 0);
+    REQUIRE(width == frame.width);
+    REQUIRE(height == frame.height);
+    return rgba;
+}
+
+// Play the animation, the frames replace their region of the canvas
+DecodedApng decodeApng(const std::string& filePath)
+{
+    std::ifstream file(filePath, std::ios::binary);
+    const std::vector<unsigned char> bytes{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    REQUIRE(bytes.size() > 8);
+    DecodedApng apng;
+    std::vector<unsigned char> canvas;
+    std::vector<unsigned char> data;
+    uint32_t sequence = 0;
+    auto finishFrame = [&]() {
+        if (apng.frames.empty() || data.empty())
+        {
+            return;
+        }
+        DecodedFrame& frame = apng.frames.back();
+        const std::vector<unsigned char> region = decodeRegion(apng, frame, data);
+        for (uint32_t row = 0; row < frame.height; row++)
+        {
+            std::copy_n(region.begin() + row * frame.width * 4, frame.width * 4,
+                        canvas.begin() + ((frame.row + row) * apng.width + frame.column) * 4);
+        }
+        frame.canvas = canvas;
+        data.clear();
+    };
+    for (std::size_t position = 8; position + 12 <= bytes.size();)
+    {
+        const uint32_t length = readUint32(bytes.data() + position);
+        const std::string type(bytes.begin() + static_cast<std::ptrdiff_t>(position + 4), bytes.begin() + static_cast<std::ptrdiff_t>(position + 8));
+        const unsigned char* chunk = bytes.data() + position + 8;
+        REQUIRE(readUint32(chunk + length) == lodepng_crc32(bytes.data() + position + 4, length + 4));
+        if (type == "IHDR")
+        {
+            apng.width = readUint32(chunk);
+            apng.height = readUint32(chunk + 4);
+            apng.colorType = chunk[9];
+            canvas.assign(apng.width * apng.height * 4, 0);
+        }
+        else if (type == "acTL")
+        {
+            apng.frameCount = readUint32(chunk);
+        }
+        else if (type == "fcTL")
+        {
+            finishFrame();
+            REQUIRE(readUint32(chunk) == sequence++);
+            DecodedFrame frame;
+            frame.width = readUint32(chunk + 4);
+            frame.height = readUint32(chunk + 8);
+            frame.column = readUint32(chunk + 12);
+            frame.row = readUint32(chunk + 16);
+            frame.delay = static_cast<uint16_t>(chunk[20] << 8 | chunk[21]);
+            REQUIRE((chunk[22] << 8 | chunk[23]) == 100);
+            REQUIRE(frame.column + frame.width <= apng.width);
+            REQUIRE(frame.row + frame.height <= apng.height);
+            apng.frames.push_back(frame);
+        }
+        else if (type == "IDAT")
+        {
+            data.insert(data.end(), chunk, chunk + length);
+        }
+        else if (type == "fdAT")
+        {
+            REQUIRE(readUint32(chunk) == sequence++);
+            data.insert(data.end(), chunk + 4, chunk + length);
+        }
+        position += 12 + length;
+    }
+    finishFrame();
+    return apng;
+}
+
+bool canvasMatches(const std::vector<unsigned char>& canvas, const pixelmancy::Image& image)
+{
+    for (int row = 0; row < image.getHeight(); row++)
+    {
+        for (int column = 0; column < image.getWidth(); column++)
+        {
+            const pixelmancy::Color color(image(row, column));
+            const unsigned char* pixel = canvas.data() + (static_cast<std::size_t>(row) * image.getWidth() + column) * 4;
+            if (pixel[0] != color.red || pixel[1] != color.green || pixel[2] != color.blue || pixel[3] != color.alpha)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// more colors than a GIF color table holds
+pixelmancy::Image fullColor(int width, int height)
+{
+    pixelmancy::Image image(width, height);
+    for (int row = 0; row < height; row++)
+    {
+        for (int column = 0; column < width; column++)
+        {
+            image(row, column) = pixelmancy::Color(column * 4, row * 6, (row * column) % 256, 255);
+        }
+    }
+    return image;
+}
+
+} // namespace
+
+TEST_CASE("[apng] Frames cropped to their changed regions", "[apng]")
+{
+    std::vector<pixelmancy::Image> expected;
+    expected.push_back(fullColor(60, 40));
+    expected.push_back(expected.back());
+    expected.back().fillRow(10, 5, 20, expected.back().resolveColor(pixelmancy::BLUE));
+    expected.back().fillRow(12, 8, 9, expected.back().resolveColor(pixelmancy::RED));
+    expected.push_back(expected.back());
+    expected.back().fillRow(30, 50, 59, expected.back().resolveColor(pixelmancy::WHITE));
+
+    auto saveWith = [&expected](pixelmancy::ThreadPool& pool, const std::string& filePath) {
+        pixelmancy::Apng apng;
+        apng.setThreadPool(pool);
+        apng.addFrame(expected[0], 5);
+        apng.addFrame(expected[1], 5);
+        // unchanged, only lengthens the frame before it
+        apng.addFrame(expected[1], 7);
+        apng.addFrame(expected[2], 5, pixelmancy::graphics::Rect(30, 50, 31, 60));
+        REQUIRE(apng.save(filePath));
+        return apng.savedBytes();
+    };
+
+    pixelmancy::ThreadPool single(1);
+    pixelmancy::ThreadPool several(4);
+    const std::uintmax_t bytes = saveWith(single, TEST_DATA_OUTPUT_IMAGE_FOLDER + "/apng_serial.png");
+    saveWith(several, TEST_DATA_OUTPUT_IMAGE_FOLDER + "/apng_parallel.png");
+
+    const DecodedApng apng = decodeApng(TEST_DATA_OUTPUT_IMAGE_FOLDER + "/apng_serial.png");
+    REQUIRE(apng.width == 60);
+    REQUIRE(apng.height == 40);
+    // no frame is translucent
+    REQUIRE(apng.colorType == LCT_RGB);
+    REQUIRE(apng.frameCount == 3);
+    REQUIRE(apng.frames.size() == 3);
+    REQUIRE(apng.frames[1].delay == 12);
+    REQUIRE(apng.frames[1].row == 10);
+    REQUIRE(apng.frames[1].column == 5);
+    REQUIRE(apng.frames[1].width == 16);
+    REQUIRE(apng.frames[1].height == 3);
+    REQUIRE(apng.frames[2].width == 10);
+    REQUIRE(apng.frames[2].height == 1);
+    for (std::size_t i = 0; i < expected.size(); i++)
+    {
+        REQUIRE(canvasMatches(apng.frames[i].canvas, expected[i]));
+    }
+
+    std::ifstream serial(TEST_DATA_OUTPUT_IMAGE_FOLDER + "/apng_serial.png", std::ios::binary);
+    std::ifstream parallel(TEST_DATA_OUTPUT_IMAGE_FOLDER + "/apng_parallel.png", std::ios::binary);
+    const std::vector<char> serialBytes{std::istreambuf_iterator<char>(serial), std::istreambuf_iterator<char>()};
+    REQUIRE(serialBytes.size() == bytes);
+    REQUIRE(serialBytes == std::vector<char>{std::istreambuf_iterator<char>(parallel), std::istreambuf_iterator<char>()});
+
+    pixelmancy::Apng inMemory;
+    inMemory.addFrame(expected[0], 5);
+    inMemory.addFrame(expected[1], 5);
+    inMemory.addFrame(expected[1], 7);
+    inMemory.addFrame(expected[2], 5, pixelmancy::graphics::Rect(30, 50, 31, 60));
+    const std::vector<uint8_t> buffer = inMemory.saveToBuffer();
+    REQUIRE(std::vector<char>(buffer.begin(), buffer.end()) == serialBytes);
+}
+
+TEST_CASE("[apng] Translucent and differently sized frames", "[apng]")
+{
+    pixelmancy::Image small(20, 10, pixelmancy::Color(10, 20, 30, 128));
+    pixelmancy::Image large = fullColor(30, 16);
+
+    pixelmancy::Apng apng;
+    apng.addFrame(small, 4);
+    apng.addFrame(large, 4);
+    REQUIRE(apng.save(TEST_DATA_OUTPUT_IMAGE_FOLDER + "/apng_sizes.png"));
+
+    const DecodedApng decoded = decodeApng(TEST_DATA_OUTPUT_IMAGE_FOLDER + "/apng_sizes.png");
+    REQUIRE(decoded.width == 30);
+    REQUIRE(decoded.height == 16);
+    REQUIRE(decoded.colorType == LCT_RGBA);
+    REQUIRE(decoded.frames.size() == 2);
+    // the canvas outside the first frame is transparent
+    pixelmancy::Image first(30, 16, pixelmancy::Color(0, 0, 0, 0));
+    first.copyRegion(small, small.bounds());
+    REQUIRE(canvasMatches(decoded.frames[0].canvas, first));
+    REQUIRE(canvasMatches(decoded.frames[1].canvas, large));
+
+    REQUIRE(!pixelmancy::Apng().save(TEST_DATA_OUTPUT_IMAGE_FOLDER + "/apng_empty.png"));
+}
+
+TEST_CASE("[apng] Frames that change only in alpha", "[apng]")
+{
+    // same indices and palettes that differ only in the alpha of one entry
+    pixelmancy::Image opaque(12, 8, pixelmancy::Color(200, 100, 50, 255));
+    pixelmancy::Image faded(opaque);
+    for (int row = 2; row < 4; row++)
+    {
+        opaque.fillRow(row, 4, 7, opaque.resolveColor(pixelmancy::Color(10, 20, 30, 255)));
+        faded.fillRow(row, 4, 7, faded.resolveColor(pixelmancy::Color(10, 20, 30, 0)));
+    }
+
+    pixelmancy::Apng apng;
+    apng.addFrame(opaque, 5);
+    apng.addFrame(faded, 5);
+    REQUIRE(apng.save(TEST_DATA_OUTPUT_IMAGE_FOLDER + "/apng_fade.png"));
+
+    const DecodedApng decoded = decodeApng(TEST_DATA_OUTPUT_IMAGE_FOLDER + "/apng_fade.png");
+    REQUIRE(decoded.colorType == LCT_RGBA);
+    // the fade is a frame of its own, not merged into the first one
+    REQUIRE(decoded.frameCount == 2);
+    REQUIRE(decoded.frames.size() == 2);
+    REQUIRE(decoded.frames[1].row == 2);
+    REQUIRE(decoded.frames[1].column == 4);
+    REQUIRE(decoded.frames[1].width == 4);
+    REQUIRE(decoded.frames[1].height == 2);
+    REQUIRE(canvasMatches(decoded.frames[1].canvas, faded));
+}
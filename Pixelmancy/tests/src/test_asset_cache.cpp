@@ -0,0 +1,97 @@
+#include <AssetCache.hpp>
+#include <ImageCompare.hpp>
+#include <Parallel.hpp>
+#include <ThreadPool.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "common.hpp"
+
+TEST_CASE("[assets] Loads of a file share one image", "[assets]")
+{
+    pixelmancy::AssetCache cache;
+    const std::string filePath = TEST_DATA_INPUT_IMAGE_FOLDER + "/tree.png";
+    const std::shared_ptr<const pixelmancy::Image> first = cache.load(filePath);
+    REQUIRE(pixelmancy::compare(pixelmancy::Image::loadFromFile(filePath), *first).matches);
+    // another spelling of the same path
+    REQUIRE(cache.load(TEST_DATA_INPUT_IMAGE_FOLDER + "/../tests/tree.png") == first);
+    REQUIRE(cache.size() == 1);
+    REQUIRE(cache.bytesUsed() >= first->size() * sizeof(uint16_t));
+    REQUIRE(cache.stats().hits == 1);
+    REQUIRE(cache.stats().misses == 1);
+
+    cache.clear();
+    REQUIRE(cache.size() == 0);
+    REQUIRE(cache.bytesUsed() == 0);
+    REQUIRE(cache.load(filePath) != first);
+}
+
+TEST_CASE("[assets] Least recently loaded images are evicted", "[assets]")
+{
+    pixelmancy::AssetCache cache;
+    const std::shared_ptr<const pixelmancy::Image> tree = cache.load(TEST_DATA_INPUT_IMAGE_FOLDER + "/tree.png");
+    const std::shared_ptr<const pixelmancy::Image> dog = cache.load(TEST_DATA_INPUT_IMAGE_FOLDER + "/dog.png");
+    const std::size_t bothBytes = cache.bytesUsed();
+    cache.load(TEST_DATA_INPUT_IMAGE_FOLDER + "/tree.png");
+
+    // the dog was loaded before the last tree load, it goes first
+    cache.setByteBudget(bothBytes - 1);
+    REQUIRE(cache.size() == 1);
+    REQUIRE(cache.stats().evictions == 1);
+    REQUIRE(cache.load(TEST_DATA_INPUT_IMAGE_FOLDER + "/tree.png") == tree);
+    // images in use outlive the cache entry
+    REQUIRE(dog->getWidth() == 768);
+    REQUIRE(cache.load(TEST_DATA_INPUT_IMAGE_FOLDER + "/dog.png") != dog);
+    REQUIRE(cache.size() == 1);
+    REQUIRE(cache.bytesUsed() <= cache.byteBudget());
+}
+
+TEST_CASE("[assets] Changed files are decoded again", "[assets]")
+{
+    pixelmancy::AssetCache cache;
+    const std::string filePath = TEST_DATA_OUTPUT_IMAGE_FOLDER + "/asset.png";
+    pixelmancy::Image(10, 10, pixelmancy::RED).save(filePath);
+    const std::shared_ptr<const pixelmancy::Image> red = cache.load(filePath);
+    pixelmancy::Image(12, 10, pixelmancy::BLUE).save(filePath);
+    const std::shared_ptr<const pixelmancy::Image> blue = cache.load(filePath);
+    REQUIRE(blue != red);
+    REQUIRE(blue->getWidth() == 12);
+    REQUIRE(cache.stats().reloads == 1);
+    REQUIRE(cache.size() == 1);
+}
+
+TEST_CASE("[assets] Concurrent loads decode once", "[assets]")
+{
+    pixelmancy::AssetCache cache;
+    pixelmancy::ThreadPool pool(4);
+    const std::string filePath = TEST_DATA_INPUT_IMAGE_FOLDER + "/naruto.png";
+    std::vector<std::future<std::shared_ptr<const pixelmancy::Image>>> loads;
+    {
+        pixelmancy::TaskGroup group(pool);
+        for (int i = 0; i < 8; i++)
+        {
+            loads.push_back(group.run([&cache, &filePath]() { return cache.load(filePath); }));
+        }
+        group.wait();
+    }
+    const std::shared_ptr<const pixelmancy::Image> image = loads.front().get();
+    for (std::size_t i = 1; i < loads.size(); i++)
+    {
+        REQUIRE(loads[i].get() == image);
+    }
+    REQUIRE(cache.stats().misses == 1);
+    REQUIRE(cache.stats().hits == 7);
+}
+
+TEST_CASE("[assets] Failed loads are not cached", "[assets]")
+{
+    pixelmancy::AssetCache cache;
+    REQUIRE_THROWS_AS(cache.load(TEST_DATA_INPUT_IMAGE_FOLDER + "/missing.png"), std::runtime_error);
+    REQUIRE(cache.size() == 0);
+    REQUIRE_THROWS_AS(cache.load(TEST_DATA_INPUT_IMAGE_FOLDER + "/missing.png"), std::runtime_error);
+    REQUIRE(cache.stats().misses == 2);
+}
@@ -0,0 +1,93 @@
+#include <Image.hpp>
+#include <ImageCompare.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+
+#include "common.hpp"
+
+TEST_CASE("[compare] Equal images match", "[compare]")
+{
+    pixelmancy::Image image(20, 10, pixelmancy::RED);
+    image(3, 4) = pixelmancy::BLUE;
+    const pixelmancy::Image copy(image);
+
+    const auto result = pixelmancy::compare(image, copy);
+    REQUIRE(result.matches);
+    REQUIRE(result.mismatchCount == 0);
+    REQUIRE(result.maxChannelError == 0);
+    REQUIRE(std::isinf(result.psnr));
+    REQUIRE(result.diffBounds.isEmpty());
+}
+
+TEST_CASE("[compare] Images with different palettes but the same colors match", "[compare]")
+{
+    pixelmancy::Image first(8, 8, pixelmancy::WHITE);
+    first(1, 1) = pixelmancy::GREEN;
+    // the colors are added in another order, so the indices differ
+    pixelmancy::Image second(8, 8, pixelmancy::GREEN);
+    for (int row = 0; row < 8; row++)
+    {
+        for (int column = 0; column < 8; column++)
+        {
+            if (row != 1 || column != 1)
+            {
+                second(row, column) = pixelmancy::WHITE;
+            }
+        }
+    }
+    REQUIRE_FALSE(first == second);
+
+    const auto result = pixelmancy::compare(first, second);
+    REQUIRE(result.matches);
+    REQUIRE(result.mismatchCount == 0);
+}
+
+TEST_CASE("[compare] Images that differ only in alpha do not match", "[compare]")
+{
+    // same indices and palettes that differ only in alpha
+    const pixelmancy::Image opaque(4, 4, pixelmancy::Color(10, 20, 30, 255));
+    const pixelmancy::Image faded(4, 4, pixelmancy::Color(10, 20, 30, 0));
+
+    const auto result = pixelmancy::compare(opaque, faded);
+    REQUIRE_FALSE(result.matches);
+    REQUIRE(result.mismatchCount == 16);
+    REQUIRE(result.maxChannelError == 255);
+    REQUIRE(result.diffBounds == pixelmancy::graphics::Rect(0, 0, 4, 4));
+}
+
+TEST_CASE("[compare] Differences are counted and bounded", "[compare]")
+{
+    const pixelmancy::Image expected(30, 20, pixelmancy::BLACK);
+    pixelmancy::Image actual(expected);
+    actual(2, 5) = pixelmancy::Color(10, 0, 0);
+    actual(7, 12) = pixelmancy::Color(0, 0, 200);
+
+    const auto exact = pixelmancy::compare(expected, actual);
+    REQUIRE_FALSE(exact.matches);
+    REQUIRE(exact.mismatchCount == 2);
+    REQUIRE(exact.maxChannelError == 200);
+    REQUIRE(exact.diffBounds == pixelmancy::graphics::Rect(2, 5, 8, 13));
+    const double meanSquaredError = (10.0 * 10.0 + 200.0 * 200.0) / (30.0 * 20.0 * 4.0);
+    REQUIRE(std::abs(exact.psnr - 10.0 * std::log10(255.0 * 255.0 / meanSquaredError)) < 1e-9);
+
+    // the small difference is tolerated per channel, the large one by count
+    const auto tolerated = pixelmancy::compare(expected, actual, {10, 1});
+    REQUIRE(tolerated.matches);
+    REQUIRE(tolerated.mismatchCount == 1);
+    REQUIRE(tolerated.diffBounds == pixelmancy::graphics::Rect(7, 12, 8, 13));
+}
+
+TEST_CASE("[compare] Images of different sizes do not match", "[compare]")
+{
+    const auto result = pixelmancy::compare(pixelmancy::Image(10, 10), pixelmancy::Image(10, 12));
+    REQUIRE(result.sizeMismatch);
+    REQUIRE_FALSE(result.matches);
+}
+
+TEST_CASE("[compare] Saved PNG loads back with the same pixels", "[compare]")
+{
+    auto image = pixelmancy::Image::loadFromFile(TEST_DATA_INPUT_IMAGE_FOLDER + "/tree.png");
+    REQUIRE(image.save(TEST_DATA_OUTPUT_IMAGE_FOLDER + "/tree_compare.png"));
+    const auto loaded = pixelmancy::Image::loadFromFile(TEST_DATA_OUTPUT_IMAGE_FOLDER + "/tree_compare.png");
+    REQUIRE(pixelmancy::compare(image, loaded).matches);
+}
@@ -0,0 +1,141 @@
+#include <Dither.hpp>
+#include <Image.hpp>
+#include <ThreadPool.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+
+const std::vector<pixelmancy::Color> BLACK_AND_WHITE = {pixelmancy::Color(0, 0, 0), pixelmancy::Color(255, 255, 255)};
+
+// gray from black on the left to white on the right
+pixelmancy::Image grayRamp(int width, int height)
+{
+    pixelmancy::Image image(width, height);
+    for (int row = 0; row < height; row++)
+    {
+        for (int column = 0; column < width; column++)
+        {
+            const int gray = column * 255 / (width - 1);
+            image(row, column) = pixelmancy::Color(gray, gray, gray);
+        }
+    }
+    return image;
+}
+
+// largest difference between the gray of the ramp and the average of the
+// black and white pixels in blocks of columns
+int worstBlockError(const std::vector<uint16_t>& indices, int width, int height, int blockWidth)
+{
+    int worst = 0;
+    for (int begin = 0; begin + blockWidth <= width; begin += blockWidth)
+    {
+        double sum = 0.0;
+        double expected = 0.0;
+        for (int row = 0; row < height; row++)
+        {
+            for (int column = begin; column < begin + blockWidth; column++)
+            {
+                sum += indices[static_cast<std::size_t>(row * width + column)] * 255.0;
+                expected += column * 255 / (width - 1);
+            }
+        }
+        const double pixels = static_cast<double>(blockWidth * height);
+        worst = std::max(worst, static_cast<int>(std::lround(std::abs(sum - expected) / pixels)));
+    }
+    return worst;
+}
+
+} // namespace
+
+TEST_CASE("[dither] Palette colors map to themselves", "[dither]")
+{
+    const std::vector<pixelmancy::Color> palette = {pixelmancy::Color(200, 10, 10), pixelmancy::Color(10, 200, 10),
+                                                    pixelmancy::Color(10, 10, 200), pixelmancy::Color(120, 120, 120)};
+    pixelmancy::Image image(37, 11);
+    for (int row = 0; row < 11; row++)
+    {
+        for (int column = 0; column < 37; column++)
+        {
+            image(row, column) = palette[static_cast<std::size_t>(row + column) % palette.size()];
+        }
+    }
+    for (pixelmancy::Dither method : {pixelmancy::Dither::None, pixelmancy::Dither::FloydSteinberg, pixelmancy::Dither::Atkinson})
+    {
+        const std::vector<uint16_t> indices = pixelmancy::dither::remap(image, palette.data(), palette.size(), method);
+        for (int row = 0; row < 11; row++)
+        {
+            for (int column = 0; column < 37; column++)
+            {
+                REQUIRE(palette[indices[static_cast<std::size_t>(row * 37 + column)]] == image(row, column));
+            }
+        }
+    }
+}
+
+TEST_CASE("[dither] Dithering keeps the average of a gradient", "[dither]")
+{
+    constexpr int WIDTH = 256;
+    constexpr int HEIGHT = 32;
+    const pixelmancy::Image ramp = grayRamp(WIDTH, HEIGHT);
+    auto blockError = [&ramp](pixelmancy::Dither method) {
+        const auto indices = pixelmancy::dither::remap(ramp, BLACK_AND_WHITE.data(), BLACK_AND_WHITE.size(), method);
+        return worstBlockError(indices, WIDTH, HEIGHT, 16);
+    };
+    // without dithering every block is black or white
+    REQUIRE(blockError(pixelmancy::Dither::None) > 100);
+    REQUIRE(blockError(pixelmancy::Dither::FloydSteinberg) <= 4);
+    REQUIRE(blockError(pixelmancy::Dither::Bayer) <= 12);
+    // Atkinson drops a quarter of the error, the ends of the ramp clip
+    REQUIRE(blockError(pixelmancy::Dither::Atkinson) <= 40);
+}
+
+TEST_CASE("[dither] Error diffusion gives the same pixels on any number of threads", "[dither]")
+{
+    std::mt19937 random(11);
+    std::uniform_int_distribution<int> channel(0, 255);
+    pixelmancy::Image image(301, 70);
+    for (int row = 0; row < 70; row++)
+    {
+        for (int column = 0; column < 301; column++)
+        {
+            image(row, column) = pixelmancy::Color(channel(random) & 0xF8, (row * 3) & 0xF8, (column * 2) & 0xF8);
+        }
+    }
+    std::vector<pixelmancy::Color> palette;
+    for (int i = 0; i < 27; i++)
+    {
+        palette.emplace_back(i % 3 * 127, i / 3 % 3 * 127, i / 9 * 127);
+    }
+    pixelmancy::ThreadPool single(1);
+    pixelmancy::ThreadPool several(4);
+    for (pixelmancy::Dither method :
+         {pixelmancy::Dither::FloydSteinberg, pixelmancy::Dither::Atkinson, pixelmancy::Dither::Bayer})
+    {
+        REQUIRE(pixelmancy::dither::remap(image, palette.data(), palette.size(), method, single) ==
+                pixelmancy::dither::remap(image, palette.data(), palette.size(), method, several));
+    }
+}
+
+TEST_CASE("[dither] Reduced palettes with dithering", "[dither]")
+{
+    pixelmancy::Image plain = grayRamp(200, 20);
+    pixelmancy::Image dithered = plain;
+    REQUIRE(plain.reduceColorPalette(8));
+    REQUIRE(dithered.reduceColorPalette(8, pixelmancy::Dither::FloydSteinberg));
+    REQUIRE(dithered.getColorPalette() == plain.getColorPalette());
+
+    // the dithered pixels mix neighbouring reduced colors in the same row
+    int plainChanges = 0;
+    int ditheredChanges = 0;
+    const uint16_t* plainRow = plain.rowIndices(10);
+    const uint16_t* ditheredRow = dithered.rowIndices(10);
+    for (int column = 1; column < 200; column++)
+    {
+        plainChanges += plainRow[column] != plainRow[column - 1] ? 1 : 0;
+        ditheredChanges += ditheredRow[column] != ditheredRow[column - 1] ? 1 : 0;
+    }
+    REQUIRE(ditheredChanges > plainChanges);
+}
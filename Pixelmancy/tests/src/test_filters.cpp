@@ -0,0 +1,215 @@
+#include <Filters.hpp>
+#include <Image.hpp>
+#include <ImageCompare.hpp>
+#include <ThreadPool.hpp>
+#include <algorithm>
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <random>
+
+namespace {
+
+// wider and taller than a tile, so tiles meet inside the image
+constexpr int WIDTH = 301;
+constexpr int HEIGHT = 70;
+
+pixelmancy::Image randomImage(unsigned seed)
+{
+    std::mt19937 random(seed);
+    std::uniform_int_distribution<int> channel(0, 255);
+    pixelmancy::Image image(WIDTH, HEIGHT);
+    for (int row = 0; row < HEIGHT; row++)
+    {
+        for (int column = 0; column < WIDTH; column++)
+        {
+            // few colors, so the palette stays small
+            const int value = channel(random) & 0xE0;
+            image(row, column) = pixelmancy::Color(value, 255 - value, (value * 3) % 256, channel(random) | 0x80);
+        }
+    }
+    return image;
+}
+
+pixelmancy::Color clampedPixel(const pixelmancy::Image& image, int row, int column)
+{
+    return image(std::clamp(row, 0, image.getHeight() - 1), std::clamp(column, 0, image.getWidth() - 1));
+}
+
+// average of the window, rounded like the filter
+pixelmancy::Image referenceBoxBlur(const pixelmancy::Image& image, int radius)
+{
+    const int size = 2 * radius + 1;
+    const float scale = 1.0f / static_cast<float>(size * size);
+    pixelmancy::Image result(image.getWidth(), image.getHeight());
+    for (int row = 0; row < image.getHeight(); row++)
+    {
+        for (int column = 0; column < image.getWidth(); column++)
+        {
+            int sums[4] = {};
+            for (int y = -radius; y <= radius; y++)
+            {
+                for (int x = -radius; x <= radius; x++)
+                {
+                    const pixelmancy::Color color = clampedPixel(image, row + y, column + x);
+                    sums[0] += color.red;
+                    sums[1] += color.green;
+                    sums[2] += color.blue;
+                    sums[3] += color.alpha;
+                }
+            }
+            auto average = [scale](int sum) { return static_cast<int>(std::nearbyint(static_cast<float>(sum) * scale)); };
+            result(row, column) = pixelmancy::Color(average(sums[0]), average(sums[1]), average(sums[2]), average(sums[3]));
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+TEST_CASE("[filters] Box blur averages the window around every pixel", "[filters]")
+{
+    const pixelmancy::Image original = randomImage(1);
+    for (int radius : {1, 4})
+    {
+        pixelmancy::Image image = original;
+        pixelmancy::filters::boxBlur(image, radius);
+        REQUIRE(pixelmancy::compare(referenceBoxBlur(original, radius), image).mismatchCount == 0);
+    }
+
+    pixelmancy::Image image = original;
+    pixelmancy::filters::boxBlur(image, 0);
+    REQUIRE(image == original);
+}
+
+TEST_CASE("[filters] Blurring a single color keeps it", "[filters]")
+{
+    const pixelmancy::Color color(40, 120, 200, 180);
+    pixelmancy::Image image(WIDTH, HEIGHT, color);
+    pixelmancy::filters::gaussianBlur(image, 2.5f);
+    pixelmancy::filters::boxBlur(image, 3);
+    REQUIRE(pixelmancy::compare(pixelmancy::Image(WIDTH, HEIGHT, color), image).mismatchCount == 0);
+}
+
+TEST_CASE("[filters] Gaussian blur is close to the exact convolution", "[filters]")
+{
+    const pixelmancy::Image original = randomImage(2);
+    const float sigma = 1.5f;
+    const int radius = static_cast<int>(std::ceil(3.0f * sigma));
+    std::vector<double> weights;
+    double total = 0.0;
+    for (int i = -radius; i <= radius; i++)
+    {
+        weights.push_back(std::exp(-(i * i) / (2.0 * sigma * sigma)));
+        total += weights.back();
+    }
+
+    pixelmancy::Image image = original;
+    pixelmancy::filters::gaussianBlur(image, sigma);
+    pixelmancy::Image expected(WIDTH, HEIGHT);
+    for (int row = 0; row < HEIGHT; row++)
+    {
+        for (int column = 0; column < WIDTH; column++)
+        {
+            double sums[4] = {};
+            for (int y = -radius; y <= radius; y++)
+            {
+                for (int x = -radius; x <= radius; x++)
+                {
+                    const double weight = weights[static_cast<std::size_t>(y + radius)] *
+                                          weights[static_cast<std::size_t>(x + radius)] / (total * total);
+                    const pixelmancy::Color color = clampedPixel(original, row + y, column + x);
+                    sums[0] += weight * color.red;
+                    sums[1] += weight * color.green;
+                    sums[2] += weight * color.blue;
+                    sums[3] += weight * color.alpha;
+                }
+            }
+            expected(row, column) = pixelmancy::Color(static_cast<int>(std::lround(sums[0])), static_cast<int>(std::lround(sums[1])),
+                                                      static_cast<int>(std::lround(sums[2])), static_cast<int>(std::lround(sums[3])));
+        }
+    }
+    pixelmancy::Tolerance tolerance;
+    tolerance.channel = 1;
+    REQUIRE(pixelmancy::compare(expected, image, tolerance).matches);
+}
+
+TEST_CASE("[filters] Filters give the same image on any number of threads", "[filters]")
+{
+    const pixelmancy::Image original = randomImage(3);
+    pixelmancy::ThreadPool single(1);
+    pixelmancy::ThreadPool several(4);
+    auto check = [&original, &single, &several](auto filter) {
+        pixelmancy::Image serial = original;
+        pixelmancy::Image parallel = original;
+        filter(serial, single);
+        filter(parallel, several);
+        REQUIRE(pixelmancy::compare(serial, parallel).mismatchCount == 0);
+    };
+    check([](pixelmancy::Image& image, pixelmancy::ThreadPool& pool) { pixelmancy::filters::gaussianBlur(image, 2.0f, pool); });
+    check([](pixelmancy::Image& image, pixelmancy::ThreadPool& pool) { pixelmancy::filters::boxBlur(image, 5, pool); });
+    check([](pixelmancy::Image& image, pixelmancy::ThreadPool& pool) { pixelmancy::filters::sharpen(image, 0.5f, pool); });
+    check([](pixelmancy::Image& image, pixelmancy::ThreadPool& pool) { pixelmancy::filters::sobel(image, pool); });
+}
+
+TEST_CASE("[filters] Convolution kernels", "[filters]")
+{
+    const pixelmancy::Image original = randomImage(4);
+
+    SECTION("Identity kernels keep the image")
+    {
+        pixelmancy::filters::Kernel identity{5, std::vector<float>(25, 0.0f)};
+        identity.weights[12] = 1.0f;
+        pixelmancy::Image image = original;
+        pixelmancy::filters::convolve(image, identity);
+        REQUIRE(pixelmancy::compare(original, image).mismatchCount == 0);
+
+        image = original;
+        pixelmancy::filters::sharpen(image, 0.0f);
+        REQUIRE(pixelmancy::compare(original, image).mismatchCount == 0);
+    }
+
+    SECTION("Invalid kernels are ignored")
+    {
+        pixelmancy::Image image = original;
+        pixelmancy::filters::convolve(image, pixelmancy::filters::Kernel{4, std::vector<float>(16, 1.0f)});
+        pixelmancy::filters::convolve(image, pixelmancy::filters::Kernel{3, std::vector<float>(4, 1.0f)});
+        REQUIRE(image == original);
+    }
+
+    SECTION("Shifting kernel moves the pixels and keeps alpha")
+    {
+        // takes the color of the right neighbour
+        pixelmancy::filters::Kernel shift{3, std::vector<float>(9, 0.0f)};
+        shift.weights[5] = 1.0f;
+        pixelmancy::Image image = original;
+        pixelmancy::filters::convolve(image, shift);
+        for (int row = 0; row < HEIGHT; row += 7)
+        {
+            for (int column = 0; column < WIDTH; column += 3)
+            {
+                const pixelmancy::Color source = clampedPixel(original, row, column + 1);
+                const pixelmancy::Color expected(source.red, source.green, source.blue, original(row, column).alpha);
+                REQUIRE(image(row, column) == expected);
+            }
+        }
+    }
+}
+
+TEST_CASE("[filters] Sobel finds edges", "[filters]")
+{
+    pixelmancy::Image image(40, 30, pixelmancy::Color(10, 10, 10, 200));
+    for (int row = 0; row < 30; row++)
+    {
+        image.fillRow(row, 20, 39, image.resolveColor(pixelmancy::Color(110, 10, 10, 200)));
+    }
+    pixelmancy::filters::sobel(image);
+    for (int row = 0; row < 30; row++)
+    {
+        for (int column = 0; column < 40; column++)
+        {
+            // 4 * 100 saturates the red channel next to the edge
+            const bool edge = column == 19 || column == 20;
+            REQUIRE(image(row, column) == pixelmancy::Color(edge ? 255 : 0, 0, 0, 200));
+        }
+    }
+}
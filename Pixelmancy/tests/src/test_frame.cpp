@@ -1,5 +1,8 @@
+#include <CircleObject.hpp>
 #include <Common.hpp>
+#include <FrameBuilder.hpp>
 #include <Image.hpp>
+#include <SquareObject.hpp>
 #include <catch2/catch_test_macros.hpp>
 #include "common.hpp"
 
@@ -25,3 +28,97 @@ TEST_CASE("Green Frame", "[frame]")
 
     REQUIRE(greenImage.save(TEST_DATA_OUTPUT_IMAGE_FOLDER + "/test_green_frame.png"));
 }
+
+namespace {
+
+bool sameColors(const pixelmancy::Image& first, const pixelmancy::Image& second)
+{
+    if (first.getWidth() != second.getWidth() || first.getHeight() != second.getHeight())
+    {
+        return false;
+    }
+    for (int row = 0; row < first.getHeight(); row++)
+    {
+        for (int column = 0; column < first.getWidth(); column++)
+        {
+            if (!(first(row, column) == second(row, column)))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+TEST_CASE("Copy a region between images", "[frame]")
+{
+    pixelmancy::Image source(40, 30, pixelmancy::GREEN);
+    pixelmancy::Image target(40, 30, pixelmancy::BLUE);
+
+    target.copyRegion(source, {10, 5, 20, 15});
+    REQUIRE(target(10, 5) == pixelmancy::GREEN);
+    REQUIRE(target(19, 14) == pixelmancy::GREEN);
+    REQUIRE(target(9, 5) == pixelmancy::BLUE);
+    REQUIRE(target(20, 14) == pixelmancy::BLUE);
+    REQUIRE(target(10, 15) == pixelmancy::BLUE);
+
+    // regions crossing the border are clipped
+    target.copyRegion(source, {-5, 35, 3, 50});
+    REQUIRE(target(0, 39) == pixelmancy::GREEN);
+    REQUIRE(target(3, 39) == pixelmancy::BLUE);
+}
+
+TEST_CASE("Frame builder matches a full redraw", "[frame]")
+{
+    pixelmancy::Image background(120, 90, pixelmancy::BLACK);
+    for (int row = 0; row < background.getHeight(); row++)
+    {
+        background.fillRow(row, 0, row, background.resolveColor(pixelmancy::Color(static_cast<uint8_t>(row * 2), 40, 80)));
+    }
+
+    auto circle = std::make_shared<pixelmancy::graphics::CircleObject>(12, 2, pixelmancy::MAGENTA, pixelmancy::GREEN);
+    auto square = std::make_shared<pixelmancy::graphics::SquareObject>(pixelmancy::sizei2d{16, 16}, 0, pixelmancy::ROYAL_BLUE);
+    auto still = std::make_shared<pixelmancy::graphics::SquareObject>(pixelmancy::sizei2d{10, 10}, 0, pixelmancy::GOLDEN_ROD);
+    still->setPosition({60, 60});
+
+    pixelmancy::FrameBuilder builder(background);
+    builder.addObject(circle);
+    builder.addObject(square);
+    builder.addObject(still);
+
+    builder.render();
+    REQUIRE_FALSE(builder.changedRegion().has_value());
+
+    for (int i = 0; i < 30; i++)
+    {
+        circle->setPosition({5 + i * 3, 10 + i * 2});
+        square->setPosition({80 - i * 2, 20 + i * 3});
+        square->setAngle(static_cast<float>(i * 10));
+
+        const pixelmancy::Image& frame = builder.render();
+
+        pixelmancy::Image expected(background);
+        circle->drawOn(expected);
+        square->drawOn(expected);
+        still->drawOn(expected);
+        REQUIRE(sameColors(frame, expected));
+        REQUIRE(builder.changedRegion().has_value());
+    }
+
+    SECTION("Nothing is redrawn when nothing moves")
+    {
+        builder.render();
+        REQUIRE(builder.dirtyRects().empty());
+        REQUIRE(builder.changedRegion()->isEmpty());
+    }
+
+    SECTION("A new background redraws the whole frame")
+    {
+        builder.setBackground(pixelmancy::Image(120, 90, pixelmancy::WHITE));
+        builder.render();
+        REQUIRE_FALSE(builder.changedRegion().has_value());
+        REQUIRE(builder.frame()(0, 0) == pixelmancy::WHITE);
+    }
+}
@@ -1,8 +1,23 @@
+#include <Animation.hpp>
+#include <ByteSink.hpp>
+#include <CircleObject.hpp>
 #include <Common.hpp>
+#include <FramePool.hpp>
 #include <Gif.hpp>
+#include <GifDecoder.hpp>
+#include <ImageCompare.hpp>
+#include <LossyLzw.hpp>
 #include <PNG.hpp>
+#include <ScopedArena.hpp>
+#include <ThreadPool.hpp>
 #include <catch2/catch_test_macros.hpp>
+#include <fstream>
+#include <functional>
+#include <iterator>
 #include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_set>
 
 #include <colors/ColorMatcher.hpp>
 #include "common.hpp"
@@ -92,3 +107,603 @@ TEST_CASE("[gif] GIF from images - 2", "[gif]")
     gifsaver.addFrame(naruto_f1);
     REQUIRE(gifsaver.save(TEST_DATA_OUTPUT_IMAGE_FOLDER + "/naruto.gif"));
 }
+
+namespace {
+
+std::vector<char> readFile(const std::string& filePath)
+{
+    std::ifstream file(filePath, std::ios::binary);
+    return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+}
+
+pixelmancy::Image renderMovingCircle(int frameIndex)
+{
+    pixelmancy::Image img(120, 120, pixelmancy::SALMON);
+    pixelmancy::graphics::CircleObject circle(10 + frameIndex % 5, 2, pixelmancy::FULL_PALLETTE[frameIndex % 10], BLACK);
+    circle.setPosition({20 + frameIndex * 4, 60});
+    circle.drawOn(img);
+    return img;
+}
+
+// Save the gif that addFrames builds on one thread and on four, the files
+// must be the same. Returns the stats of the save on one thread.
+pixelmancy::GifSaveStats saveOnThreads(const std::string& name, const std::function<void(pixelmancy::Gif&)>& addFrames,
+                                       int quality = pixelmancy::LOSSLESS_QUALITY,
+                                       pixelmancy::PaletteOrder order = pixelmancy::PaletteOrder::Unchanged)
+{
+    std::shared_ptr<pixelmancy::ColorMatcher> colorMatcher = std::make_shared<pixelmancy::ColorMatcher>();
+    pixelmancy::GifSaveStats stats;
+    std::vector<std::vector<char>> files;
+    for (const std::size_t threads : {1, 4})
+    {
+        pixelmancy::ThreadPool pool(threads);
+        pixelmancy::Gif gif(colorMatcher);
+        gif.setThreadPool(pool);
+        addFrames(gif);
+        const std::string filePath = TEST_DATA_OUTPUT_IMAGE_FOLDER + "/" + name + (threads == 1 ? "_serial.gif" : "_parallel.gif");
+        REQUIRE(gif.save(filePath, quality, order));
+        if (threads == 1)
+        {
+            stats = gif.saveStats();
+        }
+        files.push_back(readFile(filePath));
+    }
+    REQUIRE(!files[0].empty());
+    REQUIRE(files[0] == files[1]);
+    return stats;
+}
+
+struct ColorTables
+{
+    std::size_t global = 0;
+    // one entry per image, 0 for images that use the global table
+    std::vector<std::size_t> local;
+};
+
+// Walk the blocks of a gif file and read the sizes of its color tables
+ColorTables readColorTables(const std::vector<char>& file)
+{
+    const auto byte = [&file](std::size_t offset) { return static_cast<unsigned char>(file.at(offset)); };
+    const auto tableSize = [](unsigned char packed) -> std::size_t { return packed & 0x80 ? 2u << (packed & 0x07) : 0; };
+    const auto skipSubBlocks = [&byte](std::size_t offset) {
+        while (byte(offset) != 0)
+        {
+            offset += byte(offset) + 1;
+        }
+        return offset + 1;
+    };
+
+    ColorTables tables;
+    tables.global = tableSize(byte(10));
+    std::size_t offset = 13 + 3 * tables.global;
+    while (byte(offset) != 0x3B)
+    {
+        if (byte(offset) == 0x21)
+        {
+            offset = skipSubBlocks(offset + 2);
+            continue;
+        }
+        REQUIRE(byte(offset) == 0x2C);
+        const std::size_t local = tableSize(byte(offset + 9));
+        tables.local.push_back(local);
+        // the descriptor, the table and the lzw code size
+        offset = skipSubBlocks(offset + 10 + 3 * local + 1);
+    }
+    return tables;
+}
+
+} // namespace
+
+TEST_CASE("[gif] Animation rendered in parallel", "[gif]")
+{
+    std::shared_ptr<pixelmancy::ColorMatcher> colorMatcher = std::make_shared<pixelmancy::ColorMatcher>();
+    const int frames = 20;
+
+    pixelmancy::Gif serial(colorMatcher);
+    for (int i = 0; i < frames; i++)
+    {
+        serial.addFrame(renderMovingCircle(i), 5);
+    }
+    REQUIRE(serial.save(TEST_DATA_OUTPUT_IMAGE_FOLDER + "/animation_serial.gif"));
+
+    pixelmancy::ThreadPool pool(4);
+    pixelmancy::Animation animation(frames, renderMovingCircle, 5);
+    animation.setMaxFramesInFlight(3);
+    pixelmancy::Gif parallel(colorMatcher);
+    animation.renderTo(parallel, pool);
+    REQUIRE(parallel.save(TEST_DATA_OUTPUT_IMAGE_FOLDER + "/animation_parallel.gif"));
+
+    REQUIRE(readFile(TEST_DATA_OUTPUT_IMAGE_FOLDER + "/animation_serial.gif") ==
+            readFile(TEST_DATA_OUTPUT_IMAGE_FOLDER + "/animation_parallel.gif"));
+
+    SECTION("Frames and palettes allocated from an arena")
+    {
+        pixelmancy::ScopedArena arena;
+        pixelmancy::Gif gif(colorMatcher, arena.resource());
+        for (int i = 0; i < frames; i++)
+        {
+            gif.addFrame(renderMovingCircle(i), 5);
+        }
+        REQUIRE(gif.save(TEST_DATA_OUTPUT_IMAGE_FOLDER + "/animation_arena.gif"));
+        REQUIRE(readFile(TEST_DATA_OUTPUT_IMAGE_FOLDER + "/animation_serial.gif") ==
+                readFile(TEST_DATA_OUTPUT_IMAGE_FOLDER + "/animation_arena.gif"));
+    }
+
+    SECTION("Frames from a pool are recycled after saving")
+    {
+        auto framePool = std::make_shared<pixelmancy::FramePool>(120, 120, pixelmancy::SALMON, 2 * frames);
+        pixelmancy::Animation pooled(
+            frames, framePool, [](int frameIndex, pixelmancy::Image& frame) { frame = renderMovingCircle(frameIndex); }, 5);
+        pixelmancy::Gif gif(colorMatcher);
+        gif.setFramePool(framePool);
+        pooled.renderTo(gif, pool);
+        REQUIRE(gif.save(TEST_DATA_OUTPUT_IMAGE_FOLDER + "/animation_pooled.gif"));
+        REQUIRE(framePool->available() == static_cast<std::size_t>(2 * frames));
+        REQUIRE(readFile(TEST_DATA_OUTPUT_IMAGE_FOLDER + "/animation_serial.gif") ==
+                readFile(TEST_DATA_OUTPUT_IMAGE_FOLDER + "/animation_pooled.gif"));
+    }
+
+    SECTION("One thread renders and remaps the same gif")
+    {
+        pixelmancy::ThreadPool single(1);
+        pixelmancy::Gif gif(colorMatcher);
+        gif.setThreadPool(single);
+        animation.renderTo(gif, single);
+        REQUIRE(gif.save(TEST_DATA_OUTPUT_IMAGE_FOLDER + "/animation_single.gif"));
+        REQUIRE(readFile(TEST_DATA_OUTPUT_IMAGE_FOLDER + "/animation_serial.gif") ==
+                readFile(TEST_DATA_OUTPUT_IMAGE_FOLDER + "/animation_single.gif"));
+    }
+
+    SECTION("Errors from the generator are passed on")
+    {
+        pixelmancy::Animation failing(frames, [](int frameIndex) {
+            if (frameIndex == 7)
+            {
+                throw std::runtime_error("frame failed");
+            }
+            return renderMovingCircle(frameIndex);
+        });
+        pixelmancy::Gif gif(colorMatcher);
+        REQUIRE_THROWS_AS(failing.renderTo(gif, pool), std::runtime_error);
+    }
+}
+
+TEST_CASE("[gif] Frames compressed in parallel", "[gif]")
+{
+    saveOnThreads("compressed", [](pixelmancy::Gif& gif) {
+        for (int i = 0; i < 12; i++)
+        {
+            gif.addFrame(renderMovingCircle(i), 5);
+        }
+        // repeated frames are merged into one with a longer delay
+        gif.addFrame(renderMovingCircle(11), 40000);
+        gif.addFrame(renderMovingCircle(11), 40000);
+        // only the changed region is encoded
+        pixelmancy::Image next = renderMovingCircle(11);
+        next.fillRow(30, 40, 60, next.resolveColor(pixelmancy::BLUE));
+        gif.addFrame(next, 5, pixelmancy::graphics::Rect(30, 40, 31, 61));
+        gif.addFrame(next, 5, pixelmancy::graphics::Rect(30, 40, 31, 61));
+    });
+}
+
+namespace {
+
+// a gradient with noise, where lossless LZW finds only short codes
+pixelmancy::Image noisyGradient(int frameIndex)
+{
+    pixelmancy::Image img(96, 96);
+    unsigned state = 12345u + static_cast<unsigned>(frameIndex);
+    for (int row = 0; row < img.getHeight(); row++)
+    {
+        for (int column = 0; column < img.getWidth(); column++)
+        {
+            state = state * 1103515245u + 12345u;
+            const int noise = static_cast<int>((state >> 16) % 3) * 8;
+            img(row, column) = pixelmancy::Color(column * 10 / 96 * 20 + noise, row * 8 / 96 * 20, 96, 255);
+        }
+    }
+    return img;
+}
+
+} // namespace
+
+TEST_CASE("[gif] Lossy LZW", "[gif]")
+{
+    SECTION("Replaced pixels stay within the error of the quality")
+    {
+        std::vector<uint8_t> palette;
+        for (int i = 0; i < 64; i++)
+        {
+            palette.insert(palette.end(), {static_cast<uint8_t>(i * 4), static_cast<uint8_t>(i * 2), 40});
+        }
+        std::vector<uint8_t> original(5000);
+        unsigned state = 7u;
+        for (std::size_t i = 0; i < original.size(); i++)
+        {
+            state = state * 1103515245u + 12345u;
+            original[i] = static_cast<uint8_t>((i / 40 + (state >> 16) % 3) % 64);
+        }
+
+        pixelmancy::LossyStats lossless;
+        std::vector<uint8_t> indices = original;
+        pixelmancy::LossyLzw(palette.data(), 64, pixelmancy::LOSSLESS_QUALITY).apply(indices.data(), indices.size(), lossless);
+        REQUIRE(indices == original);
+        REQUIRE(lossless.pixels == original.size());
+        REQUIRE(lossless.changedPixels == 0);
+
+        pixelmancy::LossyStats lossy;
+        pixelmancy::LossyLzw(palette.data(), 64, 50).apply(indices.data(), indices.size(), lossy);
+        REQUIRE(lossy.changedPixels > 0);
+        REQUIRE(lossy.maxError() <= pixelmancy::MAX_LOSSY_DISTANCE / 2);
+        std::uint64_t changed = 0;
+        for (std::size_t i = 0; i < original.size(); i++)
+        {
+            if (indices[i] != original[i])
+            {
+                changed++;
+                const int red = palette[indices[i] * 3u] - palette[original[i] * 3u];
+                const int green = palette[indices[i] * 3u + 1] - palette[original[i] * 3u + 1];
+                REQUIRE(red * red + green * green <= pixelmancy::MAX_LOSSY_DISTANCE * pixelmancy::MAX_LOSSY_DISTANCE / 4);
+            }
+        }
+        REQUIRE(changed == lossy.changedPixels);
+    }
+
+    SECTION("Lower quality gives smaller files with a bounded error")
+    {
+        auto addFrames = [](pixelmancy::Gif& gif) {
+            for (int i = 0; i < 3; i++)
+            {
+                gif.addFrame(noisyGradient(i), 5);
+            }
+        };
+        const pixelmancy::GifSaveStats lossless = saveOnThreads("lossless", addFrames);
+        const pixelmancy::GifSaveStats lossy = saveOnThreads("lossy", addFrames, 60);
+
+        REQUIRE(lossless.error.changedPixels == 0);
+        REQUIRE(lossy.compressedBytes < lossless.compressedBytes);
+        REQUIRE(lossy.error.changedPixels > 0);
+        REQUIRE(lossy.error.maxError() <= 0.4 * pixelmancy::MAX_LOSSY_DISTANCE);
+        REQUIRE(lossy.error.rmsError() < lossy.error.maxError());
+
+        // the decoded frames are as far from the originals as the stats say
+        int frameIndex = 0;
+        for (const pixelmancy::Frame& frame : pixelmancy::GifDecoder(TEST_DATA_OUTPUT_IMAGE_FOLDER + "/lossy_serial.gif"))
+        {
+            const pixelmancy::CompareResult difference = pixelmancy::compare(noisyGradient(frameIndex++), frame.image);
+            REQUIRE(difference.maxChannelError > 0);
+            REQUIRE(difference.maxChannelError <= lossy.error.maxError());
+        }
+        REQUIRE(frameIndex == 3);
+    }
+}
+
+namespace {
+
+// 16 x 16 blocks of 200 colors of their own for every frame
+pixelmancy::Image manyColors(int frameIndex)
+{
+    pixelmancy::Image img(160, 80);
+    for (int row = 0; row < img.getHeight(); row++)
+    {
+        for (int column = 0; column < img.getWidth(); column++)
+        {
+            const int color = (row / 8) * 20 + column / 8;
+            img(row, column) = pixelmancy::Color(color, frameIndex * 60, 255 - color, 255);
+        }
+    }
+    return img;
+}
+
+} // namespace
+
+TEST_CASE("[gif] Local palettes", "[gif]")
+{
+    std::vector<pixelmancy::Image> frames;
+    for (int i = 0; i < 3; i++)
+    {
+        frames.push_back(manyColors(i));
+    }
+    // more colors than any table holds
+    pixelmancy::Image gradient(300, 2);
+    for (int column = 0; column < 300; column++)
+    {
+        gradient(0, column) = pixelmancy::Color(column % 256, column / 2, 7, 255);
+        gradient(1, column) = pixelmancy::Color(column % 256, column / 2, 9, 255);
+    }
+    frames.push_back(gradient);
+    auto addFrames = [&frames](pixelmancy::Gif& gif) {
+        for (const pixelmancy::Image& frame : frames)
+        {
+            gif.addFrame(frame, 5);
+        }
+    };
+
+    const pixelmancy::GifSaveStats stats = saveOnThreads("local", addFrames);
+    REQUIRE(stats.localPalettes > 0);
+
+    // the gradient is saved with the nearest colors of the matcher
+    const pixelmancy::ColorMatcher colorMatcher;
+    frames.back().mapColors([&colorMatcher](const pixelmancy::Color& color) { return colorMatcher.getNearestColor(color); });
+    // the first frame fills the global table, the others have a table of
+    // their own that is just large enough for their colors
+    const ColorTables tables = readColorTables(readFile(TEST_DATA_OUTPUT_IMAGE_FOLDER + "/local_serial.gif"));
+    REQUIRE(tables.global == 256);
+    REQUIRE(tables.local.size() == frames.size());
+    REQUIRE(tables.local[0] == 0);
+    for (std::size_t i = 1; i < frames.size(); i++)
+    {
+        std::unordered_set<pixelmancy::Color> colors;
+        for (int row = 0; row < frames[i].getHeight(); row++)
+        {
+            for (int column = 0; column < frames[i].getWidth(); column++)
+            {
+                colors.insert(frames[i](row, column));
+            }
+        }
+        REQUIRE(tables.local[i] >= colors.size());
+        REQUIRE(tables.local[i] / 2 < colors.size());
+    }
+
+    std::size_t index = 0;
+    for (const pixelmancy::Frame& frame : pixelmancy::GifDecoder(TEST_DATA_OUTPUT_IMAGE_FOLDER + "/local_serial.gif"))
+    {
+        REQUIRE(index < frames.size());
+        // the canvas is as large as the largest frame
+        pixelmancy::Image expected(frame.image);
+        expected.copyRegion(frames[index], frames[index].bounds());
+        REQUIRE(pixelmancy::compare(expected, frame.image).matches);
+        index++;
+    }
+    REQUIRE(index == frames.size());
+
+    saveOnThreads("local_lossy", addFrames, 70);
+}
+
+TEST_CASE("[gif] Color tables ordered by usage", "[gif]")
+{
+    auto addFrames = [](pixelmancy::Gif& gif) {
+        for (int i = 0; i < 2; i++)
+        {
+            // 50 colors used by the pixels
+            pixelmancy::Image frame(80, 40);
+            for (int row = 0; row < frame.getHeight(); row++)
+            {
+                for (int column = 0; column < frame.getWidth(); column++)
+                {
+                    frame(row, column) = pixelmancy::Color((row / 8) * 20 + column / 8, i * 60, 9, 255);
+                }
+            }
+            // painted over, so 40 more colors stay in the palette unused
+            for (int shade = 0; shade < 40; shade++)
+            {
+                frame(0, 0) = pixelmancy::Color(shade, 255, i, 255);
+            }
+            frame(0, 0) = pixelmancy::Color(0, i * 60, 9, 255);
+            gif.addFrame(frame, 5);
+        }
+    };
+
+    const pixelmancy::GifSaveStats unchanged = saveOnThreads("usage_unchanged", addFrames);
+    const pixelmancy::GifSaveStats sorted =
+        saveOnThreads("usage", addFrames, pixelmancy::LOSSLESS_QUALITY, pixelmancy::PaletteOrder::ByUsage);
+    // 101 used colors fit a table of 128 instead of 256
+    REQUIRE(readColorTables(readFile(TEST_DATA_OUTPUT_IMAGE_FOLDER + "/usage_unchanged_serial.gif")).global == 256);
+    REQUIRE(readColorTables(readFile(TEST_DATA_OUTPUT_IMAGE_FOLDER + "/usage_serial.gif")).global == 128);
+    REQUIRE(sorted.compressedBytes < unchanged.compressedBytes);
+}
+
+TEST_CASE("[gif] Dithered frames", "[gif]")
+{
+    // dithering itself is covered by the dither tests
+    saveOnThreads("dither", [](pixelmancy::Gif& gif) {
+        gif.setDither(pixelmancy::Dither::FloydSteinberg);
+        gif.addFrame(manyColors(0), 5);
+        // more colors than any table holds
+        pixelmancy::Image gradient(300, 20);
+        for (int row = 0; row < 20; row++)
+        {
+            for (int column = 0; column < 300; column++)
+            {
+                gradient(row, column) = pixelmancy::Color(column % 256, column / 2, row * 10, 255);
+            }
+        }
+        gif.addFrame(gradient, 5);
+    });
+}
+
+TEST_CASE("[gif] Decoded frames match the saved ones", "[gif]")
+{
+    std::shared_ptr<pixelmancy::ColorMatcher> colorMatcher = std::make_shared<pixelmancy::ColorMatcher>();
+    std::vector<pixelmancy::Image> expected;
+    pixelmancy::Gif gif(colorMatcher);
+    for (int i = 0; i < 4; i++)
+    {
+        expected.push_back(renderMovingCircle(i));
+        gif.addFrame(expected.back(), 5);
+    }
+    // only the changed region is encoded
+    pixelmancy::Image next = expected.back();
+    next.fillRow(30, 40, 60, next.resolveColor(BLUE));
+    expected.push_back(next);
+    gif.addFrame(next, 7, pixelmancy::graphics::Rect(30, 40, 31, 61));
+    // a frame with a color table of its own
+    pixelmancy::Image gradient(120, 120);
+    for (int row = 0; row < gradient.getHeight(); row++)
+    {
+        for (int column = 0; column < gradient.getWidth(); column++)
+        {
+            gradient(row, column) = pixelmancy::Color(column / 8 * 16, row / 8 * 16, 200, 255);
+        }
+    }
+    expected.push_back(gradient);
+    gif.addFrame(gradient, 5);
+    REQUIRE(gif.save(TEST_DATA_OUTPUT_IMAGE_FOLDER + "/decoded.gif"));
+
+    pixelmancy::GifDecoder decoder(TEST_DATA_OUTPUT_IMAGE_FOLDER + "/decoded.gif");
+    REQUIRE(decoder.isOpen());
+    REQUIRE(decoder.getWidth() == 120);
+    REQUIRE(decoder.getHeight() == 120);
+    std::size_t index = 0;
+    for (const pixelmancy::Frame& frame : decoder)
+    {
+        REQUIRE(index < expected.size());
+        REQUIRE(pixelmancy::compare(expected[index], frame.image).matches);
+        // every frame is added twice and the copies merged
+        REQUIRE(frame.delay == (index == 4 ? 14 : 10));
+        REQUIRE(frame.image.getColorPalette().size() <= 256);
+        index++;
+    }
+    REQUIRE(index == expected.size());
+    REQUIRE(!decoder.failed());
+}
+
+TEST_CASE("[gif] Decoding disposal, transparency and interlacing", "[gif]")
+{
+    // 4 x 4 canvas with a black, white, red and lime global table:
+    // a red frame disposed to the background, a 2 x 2 frame at (1, 1) with
+    // the lime index transparent, and an interlaced column at (0, 3)
+    const unsigned char bytes[] = {
+        0x47, 0x49, 0x46, 0x38, 0x39, 0x61, 0x04, 0x00, 0x04, 0x00, 0x81, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0xFF, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0xFF, 0x00, 0x21, 0xF9, 0x04, 0x08, 0x0A, 0x00, 0x00,
+        0x00, 0x2C, 0x00, 0x00, 0x00, 0x00, 0x04, 0x00, 0x04, 0x00, 0x00, 0x02, 0x04, 0x94, 0x8F, 0x29,
+        0x05, 0x00, 0x21, 0xF9, 0x04, 0x05, 0x14, 0x00, 0x03, 0x00, 0x2C, 0x01, 0x00, 0x01, 0x00, 0x02,
+        0x00, 0x02, 0x00, 0x00, 0x02, 0x03, 0xCC, 0x12, 0x05, 0x00, 0x2C, 0x03, 0x00, 0x00, 0x00, 0x01,
+        0x00, 0x04, 0x00, 0x40, 0x02, 0x03, 0x54, 0x30, 0x05, 0x00, 0x3B,
+    };
+    const std::string filePath = TEST_DATA_OUTPUT_IMAGE_FOLDER + "/handmade.gif";
+    {
+        std::ofstream file(filePath, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(bytes), sizeof(bytes));
+    }
+    pixelmancy::GifDecoder decoder(filePath);
+    REQUIRE(decoder.isOpen());
+
+    std::optional<pixelmancy::Frame> frame = decoder.next();
+    REQUIRE(frame);
+    REQUIRE(frame->delay == 10);
+    REQUIRE(pixelmancy::compare(pixelmancy::Image(4, 4, RED), frame->image).matches);
+
+    frame = decoder.next();
+    REQUIRE(frame);
+    REQUIRE(frame->delay == 20);
+    pixelmancy::Image expected(4, 4, BLACK);
+    expected(1, 1) = WHITE;
+    expected(2, 1) = WHITE;
+    expected(2, 2) = WHITE;
+    REQUIRE(pixelmancy::compare(expected, frame->image).matches);
+    REQUIRE(frame->changedRegion == pixelmancy::graphics::Rect(0, 0, 4, 4));
+
+    frame = decoder.next();
+    REQUIRE(frame);
+    REQUIRE(frame->delay == 0);
+    expected(0, 3) = RED;
+    expected(2, 3) = WHITE;
+    expected(3, 3) = pixelmancy::LIME;
+    REQUIRE(pixelmancy::compare(expected, frame->image).matches);
+    REQUIRE(frame->changedRegion == pixelmancy::graphics::Rect(0, 3, 4, 4));
+
+    REQUIRE(!decoder.next());
+    REQUIRE(!decoder.failed());
+}
+
+TEST_CASE("[gif] Decoding a file that is not a gif", "[gif]")
+{
+    const std::string filePath = TEST_DATA_OUTPUT_IMAGE_FOLDER + "/not_a.gif";
+    {
+        std::ofstream file(filePath, std::ios::binary);
+        file << "PNG, not a gif";
+    }
+    pixelmancy::GifDecoder decoder(filePath);
+    REQUIRE(!decoder.isOpen());
+    REQUIRE(decoder.begin() == decoder.end());
+    REQUIRE(!pixelmancy::GifDecoder(TEST_DATA_OUTPUT_IMAGE_FOLDER + "/missing.gif").isOpen());
+}
+
+TEST_CASE("[gif] Decoding an image larger than the screen", "[gif]")
+{
+    // 4 x 4 screen with a black and white global table, and a 6 x 6 image
+    // that is white where (column + 2 * row) % 3 == 0
+    const unsigned char bytes[] = {
+        0x47, 0x49, 0x46, 0x38, 0x39, 0x61, 0x04, 0x00, 0x04, 0x00, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0xFF, 0xFF, 0xFF, 0x2C, 0x00, 0x00, 0x00, 0x00, 0x06, 0x00, 0x06, 0x00, 0x00, 0x02, 0x09, 0x0C,
+        0x60, 0x97, 0x89, 0xBA, 0xD7, 0x62, 0x0C, 0x05, 0x00, 0x3B,
+    };
+    const std::string filePath = TEST_DATA_OUTPUT_IMAGE_FOLDER + "/oversized.gif";
+    {
+        std::ofstream file(filePath, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(bytes), sizeof(bytes));
+    }
+    pixelmancy::GifDecoder decoder(filePath);
+    REQUIRE(decoder.isOpen());
+
+    // the image is clipped to the screen, like browsers do
+    std::optional<pixelmancy::Frame> frame = decoder.next();
+    REQUIRE(frame);
+    pixelmancy::Image expected(4, 4, BLACK);
+    for (int row = 0; row < 4; row++)
+    {
+        for (int column = 0; column < 4; column++)
+        {
+            if ((column + 2 * row) % 3 == 0)
+            {
+                expected(row, column) = WHITE;
+            }
+        }
+    }
+    REQUIRE(pixelmancy::compare(expected, frame->image).matches);
+    REQUIRE(frame->changedRegion == pixelmancy::graphics::Rect(0, 0, 4, 4));
+    REQUIRE(!decoder.next());
+    REQUIRE(!decoder.failed());
+}
+
+TEST_CASE("[gif] Saved to memory", "[gif]")
+{
+    std::shared_ptr<pixelmancy::ColorMatcher> colorMatcher = std::make_shared<pixelmancy::ColorMatcher>();
+    auto makeGif = [&colorMatcher](pixelmancy::ThreadPool& pool) {
+        auto gif = std::make_unique<pixelmancy::Gif>(colorMatcher);
+        gif->setThreadPool(pool);
+        for (int i = 0; i < 4; i++)
+        {
+            gif->addFrame(renderMovingCircle(i), 5);
+        }
+        return gif;
+    };
+
+    pixelmancy::ThreadPool single(1);
+    pixelmancy::ThreadPool several(4);
+    REQUIRE(makeGif(single)->save(TEST_DATA_OUTPUT_IMAGE_FOLDER + "/memory.gif"));
+    const std::vector<char> saved = readFile(TEST_DATA_OUTPUT_IMAGE_FOLDER + "/memory.gif");
+    REQUIRE(!saved.empty());
+    const std::vector<uint8_t> expected(saved.begin(), saved.end());
+
+    // cgif and the parallel writer write through the same sinks
+    for (pixelmancy::ThreadPool* pool : {&single, &several})
+    {
+        auto gif = makeGif(*pool);
+        const std::vector<uint8_t> buffer = gif->saveToBuffer();
+        REQUIRE(buffer == expected);
+        REQUIRE(gif->saveStats().compressedBytes == expected.size());
+
+        std::ostringstream stream;
+        pixelmancy::ByteSink streamSink(stream);
+        REQUIRE(makeGif(*pool)->save(streamSink));
+        REQUIRE(stream.str() == std::string(saved.begin(), saved.end()));
+
+        std::size_t pieces = 0;
+        std::vector<uint8_t> collected;
+        pixelmancy::ByteSink callback([&pieces, &collected](const uint8_t* data, std::size_t size) {
+            pieces++;
+            collected.insert(collected.end(), data, data + size);
+            return true;
+        });
+        REQUIRE(makeGif(*pool)->save(callback));
+        REQUIRE(collected == expected);
+        // the header and the frames come in pieces as they are written
+        REQUIRE(pieces > 1);
+    }
+
+    pixelmancy::ByteSink failing([](const uint8_t*, std::size_t) { return false; });
+    REQUIRE(!makeGif(several)->save(failing));
+    REQUIRE(makeGif(single)->saveToBuffer(pixelmancy::LOSSLESS_QUALITY).size() == expected.size());
+}
@@ -1,6 +1,18 @@
+#include <ByteSink.hpp>
+#include <ColorTransforms.hpp>
+#include <FramePool.hpp>
 #include <Image.hpp>
+#include <ImageCompare.hpp>
+#include <ImageHandle.hpp>
 #include <PNG.hpp>
+#include <PaletteUsage.hpp>
+#include <algorithm>
 #include <catch2/catch_test_macros.hpp>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <lodepng.h>
+#include <memory_resource>
 
 #include "common.hpp"
 
@@ -44,6 +56,7 @@ TEST_CASE("[image] Image RGB pixel", "[image]")
     pngSaver.save(TEST_DATA_OUTPUT_IMAGE_FOLDER + "/rgb.png");
     auto loadedImage = pixelmancy::Image::loadFromFile(TEST_DATA_OUTPUT_IMAGE_FOLDER + "/rgb"
                                                                                        ".png");
+    REQUIRE(pixelmancy::compare(img, loadedImage).matches);
     for (int i = 0; i < 3; i++)
     {
         pixelmancy::Color clr = loadedImage(0, i);
@@ -105,6 +118,7 @@ TEST_CASE("[image] Image RGB 5,10 pixel", "[image]")
     pngSaver.save(TEST_DATA_OUTPUT_IMAGE_FOLDER + "/rgb_5_10.png");
 
     auto loadedImage = pixelmancy::Image::loadFromFile(TEST_DATA_OUTPUT_IMAGE_FOLDER + "/rgb_5_10.png");
+    REQUIRE(pixelmancy::compare(img, loadedImage).matches);
 
     for (int i = 0; i < width; i++)
     {
@@ -178,6 +192,7 @@ TEST_CASE("[image] Image RGB large pixel", "[image]")
     img.save(TEST_DATA_OUTPUT_IMAGE_FOLDER + "/rgb_726_998.png");
 
     auto loadedImage = pixelmancy::Image::loadFromFile(TEST_DATA_OUTPUT_IMAGE_FOLDER + "/rgb_726_998.png");
+    REQUIRE(pixelmancy::compare(img, loadedImage).matches);
 
     pixelmancy::ColorPallette pallette3 = loadedImage.getColorPalette();
 
@@ -321,3 +336,352 @@ TEST_CASE("[image] reduce image size to 100x100", "[image]")
     auto img = pixelmancy::Image::loadFromFile(TEST_DATA_INPUT_IMAGE_FOLDER + "dog.png");
     img.save(TEST_DATA_OUTPUT_IMAGE_FOLDER + "/same_dog.png");
 }
+
+TEST_CASE("[image] Reset image", "[image]")
+{
+    pixelmancy::Image img(30, 20, pixelmancy::RED);
+    img(3, 4) = pixelmancy::GREEN;
+    img(5, 6) = pixelmancy::BLUE;
+
+    img.reset(10, 40, pixelmancy::WHITE);
+    REQUIRE(img == pixelmancy::Image(10, 40, pixelmancy::WHITE));
+    REQUIRE(img.getColorPalette().size() == 1);
+
+    img.reset(0, 0);
+    REQUIRE(img.isEmpty());
+}
+
+TEST_CASE("[image] Frame pool recycles images", "[image]")
+{
+    pixelmancy::FramePool pool(16, 8, pixelmancy::BLUE, 2);
+    REQUIRE(pool.available() == 0);
+
+    pixelmancy::Image frame = pool.acquire();
+    REQUIRE(frame == pixelmancy::Image(16, 8, pixelmancy::BLUE));
+    frame(1, 1) = pixelmancy::RED;
+
+    pool.release(std::move(frame));
+    REQUIRE(pool.available() == 1);
+
+    pixelmancy::Image recycled = pool.acquire();
+    REQUIRE(pool.available() == 0);
+    REQUIRE(recycled == pixelmancy::Image(16, 8, pixelmancy::BLUE));
+
+    pool.release(std::move(recycled));
+    pool.release(pixelmancy::Image(16, 8));
+    pool.release(pixelmancy::Image(16, 8));
+    REQUIRE(pool.available() == 2);
+}
+
+namespace {
+
+class CountingResource : public std::pmr::memory_resource
+{
+public:
+    std::size_t allocations = 0;
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        allocations++;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* pointer, std::size_t bytes, std::size_t alignment) override
+    {
+        std::pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+} // namespace
+
+TEST_CASE("[image] Image allocates from a memory resource", "[image]")
+{
+    CountingResource resource;
+    pixelmancy::Image img(20, 10, pixelmancy::RED, &resource);
+    img(2, 3) = pixelmancy::GREEN;
+    REQUIRE(img.resource() == &resource);
+    REQUIRE(img.getColorPalette().resource() == &resource);
+    REQUIRE(resource.allocations > 0);
+
+    pixelmancy::Image copy(img, std::pmr::get_default_resource());
+    REQUIRE(copy == img);
+    REQUIRE(copy.resource() == std::pmr::get_default_resource());
+
+    const std::size_t allocations = resource.allocations;
+    pixelmancy::Image moved(std::move(img));
+    REQUIRE(moved.resource() == &resource);
+    REQUIRE(resource.allocations == allocations);
+}
+
+namespace {
+
+// apply a color function pixel by pixel, the reference for mapColors
+template <typename F>
+pixelmancy::Image mapPixels(const pixelmancy::Image& image, F function)
+{
+    pixelmancy::Image result(image.getWidth(), image.getHeight());
+    for (int row = 0; row < image.getHeight(); row++)
+    {
+        for (int column = 0; column < image.getWidth(); column++)
+        {
+            result(row, column) = function(image(row, column));
+        }
+    }
+    return result;
+}
+
+pixelmancy::Image stripes()
+{
+    pixelmancy::Image image(37, 23, pixelmancy::BLACK);
+    const pixelmancy::Color colors[] = {pixelmancy::RED, pixelmancy::GREEN, pixelmancy::BLUE, pixelmancy::Color(10, 20, 30),
+                                        pixelmancy::Color(12, 20, 30), pixelmancy::Color(200, 100, 50, 128)};
+    for (int row = 0; row < image.getHeight(); row++)
+    {
+        for (int column = 0; column < image.getWidth(); column++)
+        {
+            image(row, column) = colors[(row + column) % 6];
+        }
+    }
+    return image;
+}
+
+} // namespace
+
+TEST_CASE("[image] Map colors through the palette", "[image]")
+{
+    const pixelmancy::Image original = stripes();
+
+    SECTION("Distinct colors keep the pixels")
+    {
+        pixelmancy::Image image = original;
+        const auto invert = [](const pixelmancy::Color& color) {
+            return pixelmancy::Color(255 - color.red, 255 - color.green, 255 - color.blue, color.alpha);
+        };
+        image.mapColors(invert);
+        REQUIRE(image.getColorPalette().size() == original.getColorPalette().size());
+        for (int row = 0; row < image.getHeight(); row++)
+        {
+            REQUIRE(std::equal(image.rowIndices(row), image.rowIndices(row) + image.getWidth(), original.rowIndices(row)));
+        }
+        REQUIRE(pixelmancy::compare(mapPixels(original, invert), image).mismatchCount == 0);
+        REQUIRE(image.getColorPalette().getColors()[1] == invert(original.getColorPalette().getColors()[1]));
+    }
+
+    SECTION("Colliding colors are merged")
+    {
+        pixelmancy::Image image = original;
+        const auto quantize = [](const pixelmancy::Color& color) {
+            return pixelmancy::Color(color.red & 0xF0, color.green & 0xF0, color.blue & 0xF0, color.alpha);
+        };
+        image.mapColors(quantize);
+        // (10, 20, 30) and (12, 20, 30) become the same color
+        REQUIRE(image.getColorPalette().size() == original.getColorPalette().size() - 1);
+        REQUIRE(pixelmancy::compare(mapPixels(original, quantize), image).mismatchCount == 0);
+
+        // the merged palette still finds its colors
+        pixelmancy::Color merged(0, 16, 16);
+        const uint16_t index = image.resolveColor(merged);
+        REQUIRE(index < image.getColorPalette().size());
+        REQUIRE(image.getColorPalette().getColor(index) == merged);
+    }
+
+    SECTION("Every color merging into one")
+    {
+        pixelmancy::Image image = original;
+        image.mapColors(pixelmancy::transforms::threshold(256));
+        REQUIRE(image.getColorPalette().size() == 2);
+        REQUIRE(pixelmancy::compare(mapPixels(original, pixelmancy::transforms::threshold(256)), image).mismatchCount == 0);
+    }
+}
+
+TEST_CASE("[image] Color transforms", "[image]")
+{
+    const pixelmancy::Image original = stripes();
+    using ColorFunction = pixelmancy::transforms::ColorFunction;
+    const std::vector<ColorFunction> functions = {pixelmancy::transforms::tint(pixelmancy::MAGENTA, 0.25),
+                                                  pixelmancy::transforms::brightness(-40),
+                                                  pixelmancy::transforms::contrast(1.5),
+                                                  pixelmancy::transforms::gamma(2.2),
+                                                  pixelmancy::transforms::threshold(100),
+                                                  pixelmancy::transforms::hueRotate(90),
+                                                  pixelmancy::transforms::histogramEqualization(original)};
+    for (const auto& function : functions)
+    {
+        pixelmancy::Image image = original;
+        image.mapColors(function);
+        REQUIRE(pixelmancy::compare(mapPixels(original, function), image).mismatchCount == 0);
+    }
+
+    REQUIRE(pixelmancy::transforms::brightness(300)(pixelmancy::RED) == pixelmancy::WHITE);
+    REQUIRE(pixelmancy::transforms::threshold(128)(pixelmancy::Color(200, 200, 200, 7)) == pixelmancy::Color(255, 255, 255, 7));
+    REQUIRE(pixelmancy::transforms::hueRotate(0)(pixelmancy::Color(10, 100, 200)) == pixelmancy::Color(10, 100, 200));
+    REQUIRE(pixelmancy::transforms::gamma(1.0)(pixelmancy::Color(10, 100, 200)) == pixelmancy::Color(10, 100, 200));
+
+    // two values in equal amounts spread to the ends of the range
+    pixelmancy::Image dark(2, 1, pixelmancy::Color(10, 10, 10));
+    dark(0, 1) = pixelmancy::Color(20, 20, 20);
+    const auto equalize = pixelmancy::transforms::histogramEqualization(dark);
+    REQUIRE(equalize(pixelmancy::Color(10, 10, 10)) == pixelmancy::Color(0, 0, 0));
+    REQUIRE(equalize(pixelmancy::Color(20, 20, 20)) == pixelmancy::WHITE);
+}
+
+TEST_CASE("[image] Import RGBA bytes", "[image]")
+{
+    const uint8_t rgba[] = {1, 2, 3, 4, 1, 2, 3, 4, 9, 9, 9, 255, 1, 2, 3, 4, 0, 0, 0, 255, 9, 9, 9, 255};
+    pixelmancy::Image image(3, 2);
+    image.importRgba(rgba);
+    REQUIRE(image(0, 0) == pixelmancy::Color(1, 2, 3, 4));
+    REQUIRE(image(0, 1) == pixelmancy::Color(1, 2, 3, 4));
+    REQUIRE(image(0, 2) == pixelmancy::Color(9, 9, 9));
+    REQUIRE(image(1, 0) == pixelmancy::Color(1, 2, 3, 4));
+    REQUIRE(image(1, 1) == pixelmancy::BLACK);
+    REQUIRE(image(1, 2) == pixelmancy::Color(9, 9, 9));
+    // black of the constructor and the two colors of the bytes
+    REQUIRE(image.getColorPalette().size() == 3);
+}
+
+TEST_CASE("[image] Palette ordered by usage", "[image]")
+{
+    SECTION("Used entries come most used first, then by neighbours")
+    {
+        pixelmancy::Image img(10, 1, pixelmancy::RED);
+        // green is painted over, so it stays in the palette unused
+        img(0, 0) = pixelmancy::GREEN;
+        img(0, 0) = pixelmancy::RED;
+        for (int column = 6; column < 10; column++)
+        {
+            img(0, column) = column < 8 ? pixelmancy::BLUE : pixelmancy::WHITE;
+        }
+        pixelmancy::PaletteUsage usage(img.getColorPalette().size());
+        usage.addImage(img);
+        const auto& colors = img.getColorPalette().getColors();
+        std::vector<pixelmancy::Color> ordered;
+        for (const uint16_t entry : usage.order())
+        {
+            ordered.push_back(colors[entry]);
+        }
+        // white only touches blue
+        REQUIRE(ordered == std::vector<pixelmancy::Color>{pixelmancy::RED, pixelmancy::BLUE, pixelmancy::WHITE});
+    }
+
+    SECTION("Sorted PNG palettes keep the pixels")
+    {
+        const auto image = pixelmancy::Image::loadFromFile(TEST_DATA_INPUT_IMAGE_FOLDER + "/lettuce.png");
+        const std::string unchangedPath = TEST_DATA_OUTPUT_IMAGE_FOLDER + "/lettuce_unchanged.png";
+        const std::string sortedPath = TEST_DATA_OUTPUT_IMAGE_FOLDER + "/lettuce_sorted.png";
+        REQUIRE(pixelmancy::PNG(image).save(unchangedPath));
+        REQUIRE(pixelmancy::PNG(image).save(sortedPath, pixelmancy::PaletteOrder::ByUsage));
+        REQUIRE(pixelmancy::compare(image, pixelmancy::Image::loadFromFile(sortedPath)).matches);
+        REQUIRE(std::filesystem::file_size(sortedPath) < std::filesystem::file_size(unchangedPath));
+
+        // translucent colors and few colors for a small bit depth
+        pixelmancy::Image translucent(13, 7, pixelmancy::Color(10, 20, 30, 255));
+        for (int column = 0; column < 13; column += 3)
+        {
+            translucent(column % 7, column) = pixelmancy::Color(200, 20, 30, 100);
+            translucent(6, column) = pixelmancy::Color(0, 0, 0, 0);
+        }
+        REQUIRE(pixelmancy::PNG(translucent).save(sortedPath, pixelmancy::PaletteOrder::ByUsage));
+        REQUIRE(pixelmancy::compare(translucent, pixelmancy::Image::loadFromFile(sortedPath)).matches);
+
+        // more colors than a PNG palette holds are written as before
+        const auto many = pixelmancy::Image::loadFromFile(TEST_DATA_INPUT_IMAGE_FOLDER + "/tree.png");
+        REQUIRE(pixelmancy::PNG(many).save(sortedPath, pixelmancy::PaletteOrder::ByUsage));
+        REQUIRE(pixelmancy::compare(many, pixelmancy::Image::loadFromFile(sortedPath)).matches);
+    }
+}
+
+TEST_CASE("[image] PNG encoded in memory", "[image]")
+{
+    pixelmancy::Image image(40, 30, pixelmancy::BLUE);
+    image.fillRow(10, 5, 30, image.resolveColor(pixelmancy::Color(200, 100, 50, 128)));
+    const std::string filePath = TEST_DATA_OUTPUT_IMAGE_FOLDER + "/in_memory.png";
+    REQUIRE(image.save(filePath));
+    std::ifstream file(filePath, std::ios::binary);
+    const std::vector<unsigned char> saved{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+
+    const std::vector<unsigned char> encoded = image.encodePng();
+    REQUIRE(!encoded.empty());
+    REQUIRE(encoded == saved);
+    unsigned width = 0;
+    unsigned height = 0;
+    std::vector<unsigned char> rgba;
+    REQUIRE(lodepng::decode(rgba, width, height, encoded) == 0);
+    REQUIRE(width == 40);
+    REQUIRE(height == 30);
+
+    // a sink appends to what the buffer holds
+    std::vector<uint8_t> buffer = {1, 2, 3};
+    pixelmancy::ByteSink sink(buffer);
+    pixelmancy::PNG png(image);
+    REQUIRE(png.save(sink));
+    REQUIRE(buffer.size() == saved.size() + 3);
+    REQUIRE(std::equal(saved.begin(), saved.end(), buffer.begin() + 3));
+    REQUIRE(sink.bytesWritten() == saved.size());
+
+    pixelmancy::ByteSink failing([](const uint8_t*, std::size_t) { return false; });
+    REQUIRE(!png.save(failing));
+    REQUIRE(failing.failed());
+}
+
+TEST_CASE("[image] Lazy image handle", "[image]")
+{
+    pixelmancy::ImageHandle handle = pixelmancy::Image::open(TEST_DATA_INPUT_IMAGE_FOLDER + "/naruto.png");
+    REQUIRE(handle.isValid());
+    REQUIRE(!handle.isDecoded());
+    REQUIRE(handle.getWidth() == 726);
+    REQUIRE(handle.getHeight() == 998);
+    REQUIRE(handle.info().colorType == LCT_RGBA);
+    REQUIRE(handle.info().bitDepth == 8);
+    REQUIRE(handle.info().paletteSize == 0);
+
+    const pixelmancy::Image loaded = pixelmancy::Image::loadFromFile(TEST_DATA_INPUT_IMAGE_FOLDER + "/naruto.png");
+    REQUIRE(pixelmancy::compare(loaded, handle.image()).matches);
+    REQUIRE(handle.isDecoded());
+    REQUIRE(&handle.image() == &handle.image());
+    handle.release();
+    REQUIRE(!handle.isDecoded());
+
+    // thumbnails keep the aspect ratio and are never larger than the file
+    const pixelmancy::Image thumbnail = handle.decodeToSize(100, 100);
+    REQUIRE(thumbnail.getHeight() == 100);
+    REQUIRE(thumbnail.getWidth() == 73);
+    REQUIRE(!handle.isDecoded());
+    const pixelmancy::Image full = handle.decodeToSize(2000, 2000);
+    REQUIRE(pixelmancy::compare(loaded, full).matches);
+
+    REQUIRE(!pixelmancy::Image::open(TEST_DATA_INPUT_IMAGE_FOLDER + "/missing.png").isValid());
+}
+
+TEST_CASE("[image] Image handle of a palette PNG", "[image]")
+{
+    // every 2 x 2 block is averaged to one pixel
+    pixelmancy::Image image(8, 6, pixelmancy::RED);
+    for (int row = 0; row < 6; row++)
+    {
+        image.fillRow(row, 5, 7, image.resolveColor(row < 2 ? pixelmancy::BLUE : pixelmancy::WHITE));
+    }
+    const std::string filePath = TEST_DATA_OUTPUT_IMAGE_FOLDER + "/handle_palette.png";
+    REQUIRE(pixelmancy::PNG(image).save(filePath, pixelmancy::PaletteOrder::ByUsage));
+
+    pixelmancy::ImageHandle handle(filePath);
+    REQUIRE(handle.isValid());
+    REQUIRE(handle.info().colorType == LCT_PALETTE);
+    REQUIRE(handle.info().paletteSize == 3);
+    REQUIRE(pixelmancy::compare(image, handle.image()).matches);
+
+    const pixelmancy::Image thumbnail = handle.decodeToSize(4, 4);
+    REQUIRE(thumbnail.getWidth() == 4);
+    REQUIRE(thumbnail.getHeight() == 3);
+    REQUIRE(pixelmancy::Color(thumbnail(0, 0)) == pixelmancy::RED);
+    REQUIRE(pixelmancy::Color(thumbnail(0, 2)) == pixelmancy::Color(128, 0, 128));
+    REQUIRE(pixelmancy::Color(thumbnail(1, 2)) == pixelmancy::Color(255, 128, 128));
+    REQUIRE(pixelmancy::Color(thumbnail(0, 3)) == pixelmancy::BLUE);
+    REQUIRE(pixelmancy::Color(thumbnail(2, 3)) == pixelmancy::WHITE);
+}
@@ -0,0 +1,325 @@
+#include <catch2/catch_test_macros.hpp>
+#include <colors/Color.hpp>
+#include <cmath>
+#include <cstring>
+#include <kernels/Kernels.hpp>
+#include <random>
+#include <vector>
+
+namespace {
+
+using pixelmancy::kernels::Isa;
+using pixelmancy::kernels::KernelTable;
+
+// lengths around the vector widths, so every variant runs its remainder loop
+const std::vector<std::size_t> LENGTHS = {0, 1, 3, 4, 7, 8, 9, 15, 16, 17, 31, 33, 100, 1027};
+
+std::vector<const KernelTable*> simdVariants()
+{
+    std::vector<const KernelTable*> variants;
+    for (Isa isa : {Isa::SSE42, Isa::AVX2})
+    {
+        if (const KernelTable* table = pixelmancy::kernels::forIsa(isa))
+        {
+            variants.push_back(table);
+        }
+    }
+    return variants;
+}
+
+const KernelTable& scalar()
+{
+    return *pixelmancy::kernels::forIsa(Isa::SCALAR);
+}
+
+std::vector<uint32_t> randomColors(std::mt19937& random, std::size_t count)
+{
+    std::vector<uint32_t> colors(count);
+    for (auto& color : colors)
+    {
+        color = static_cast<uint32_t>(random());
+    }
+    return colors;
+}
+
+std::vector<uint16_t> randomIndices(std::mt19937& random, std::size_t count, uint16_t limit)
+{
+    std::uniform_int_distribution<int> distribution(0, limit - 1);
+    std::vector<uint16_t> indices(count);
+    for (auto& index : indices)
+    {
+        index = static_cast<uint16_t>(distribution(random));
+    }
+    return indices;
+}
+
+} // namespace
+
+TEST_CASE("[kernels] Scalar kernels are always available", "[kernels]")
+{
+    REQUIRE(pixelmancy::kernels::isSupported(Isa::SCALAR));
+    REQUIRE(scalar().isa == Isa::SCALAR);
+    REQUIRE(pixelmancy::kernels::forIsa(pixelmancy::kernels::active().isa) == &pixelmancy::kernels::active());
+}
+
+TEST_CASE("[kernels] Kernel variants expand indices like the scalar kernel", "[kernels]")
+{
+    std::mt19937 random(1);
+    const std::vector<uint32_t> palette = randomColors(random, 300);
+    for (const KernelTable* variant : simdVariants())
+    {
+        for (std::size_t length : LENGTHS)
+        {
+            const auto indices = randomIndices(random, length, 300);
+            std::vector<uint32_t> expected(length);
+            std::vector<uint32_t> actual(length);
+            scalar().expandIndices(indices.data(), length, palette.data(), expected.data());
+            variant->expandIndices(indices.data(), length, palette.data(), actual.data());
+            REQUIRE(expected == actual);
+        }
+    }
+}
+
+TEST_CASE("[kernels] Kernel variants remap indices like the scalar kernel", "[kernels]")
+{
+    std::mt19937 random(2);
+    std::vector<uint32_t> table(200);
+    for (auto& entry : table)
+    {
+        entry = static_cast<uint32_t>(random() % 256);
+    }
+    for (const KernelTable* variant : simdVariants())
+    {
+        for (std::size_t length : LENGTHS)
+        {
+            // some indices are outside the table and map to 0
+            const auto indices = randomIndices(random, length, 260);
+            std::vector<uint8_t> expected(length);
+            std::vector<uint8_t> actual(length);
+            scalar().remapIndices(indices.data(), length, table.data(), table.size(), expected.data());
+            variant->remapIndices(indices.data(), length, table.data(), table.size(), actual.data());
+            REQUIRE(expected == actual);
+        }
+    }
+}
+
+TEST_CASE("[kernels] Kernel variants translate indices like the scalar kernel", "[kernels]")
+{
+    std::mt19937 random(5);
+    std::vector<uint32_t> table(500);
+    for (auto& entry : table)
+    {
+        entry = static_cast<uint32_t>(random() % 65536);
+    }
+    for (const KernelTable* variant : simdVariants())
+    {
+        for (std::size_t length : LENGTHS)
+        {
+            const auto indices = randomIndices(random, length, 500);
+            std::vector<uint16_t> expected(length);
+            scalar().translateIndices(indices.data(), length, table.data(), expected.data());
+            // in place, like Image::replaceColors
+            std::vector<uint16_t> actual = indices;
+            variant->translateIndices(actual.data(), length, table.data(), actual.data());
+            REQUIRE(expected == actual);
+        }
+    }
+}
+
+TEST_CASE("[kernels] Kernel variants fill spans like the scalar kernel", "[kernels]")
+{
+    for (const KernelTable* variant : simdVariants())
+    {
+        for (std::size_t length : LENGTHS)
+        {
+            // the word after the span must stay untouched
+            std::vector<uint16_t> expected(length + 1, 7);
+            std::vector<uint16_t> actual(length + 1, 7);
+            scalar().fillIndices(expected.data(), length, 0xBEEF);
+            variant->fillIndices(actual.data(), length, 0xBEEF);
+            REQUIRE(expected == actual);
+        }
+    }
+}
+
+TEST_CASE("[kernels] Kernel variants gather indices like the scalar kernel", "[kernels]")
+{
+    std::mt19937 random(3);
+    for (const KernelTable* variant : simdVariants())
+    {
+        for (std::size_t sourceCount : {1, 2, 9, 64})
+        {
+            const auto source = randomIndices(random, sourceCount, 0xFFFF);
+            for (std::size_t length : LENGTHS)
+            {
+                std::uniform_int_distribution<int32_t> distribution(0, static_cast<int32_t>(sourceCount) - 1);
+                std::vector<int32_t> positions(length);
+                for (auto& position : positions)
+                {
+                    position = distribution(random);
+                }
+                std::vector<uint16_t> expected(length);
+                std::vector<uint16_t> actual(length);
+                scalar().gatherIndices(source.data(), sourceCount, positions.data(), length, expected.data());
+                variant->gatherIndices(source.data(), sourceCount, positions.data(), length, actual.data());
+                REQUIRE(expected == actual);
+            }
+        }
+    }
+}
+
+TEST_CASE("[kernels] Kernel variants premultiply alpha like Color", "[kernels]")
+{
+    std::vector<uint32_t> colors;
+    std::vector<uint32_t> expected;
+    for (int alpha = 0; alpha <= 255; alpha++)
+    {
+        for (int channel : {0, 1, 77, 128, 200, 254, 255})
+        {
+            const pixelmancy::Color color(channel, 255 - channel, (channel * 7) % 256, alpha);
+            colors.push_back(pixelmancy::kernels::packRgba(color.red, color.green, color.blue, color.alpha));
+            const pixelmancy::Color premultiplied = color.getColorPreMultipliedByAlpha();
+            expected.push_back(pixelmancy::kernels::packRgba(premultiplied.red, premultiplied.green, premultiplied.blue,
+                                                             premultiplied.alpha));
+        }
+    }
+
+    std::vector<uint32_t> actual = colors;
+    scalar().premultiplyAlpha(actual.data(), actual.size());
+    REQUIRE(actual == expected);
+    for (const KernelTable* variant : simdVariants())
+    {
+        actual = colors;
+        variant->premultiplyAlpha(actual.data(), actual.size());
+        REQUIRE(actual == expected);
+    }
+}
+
+TEST_CASE("[kernels] Kernel variants measure color distance like the scalar kernel", "[kernels]")
+{
+    std::mt19937 random(4);
+    for (const KernelTable* variant : simdVariants())
+    {
+        for (std::size_t length : LENGTHS)
+        {
+            const auto left = randomColors(random, length);
+            const auto right = randomColors(random, length);
+            std::vector<uint8_t> expectedError(length);
+            std::vector<uint8_t> actualError(length);
+            const uint64_t expected = scalar().colorDistance(left.data(), right.data(), length, expectedError.data());
+            const uint64_t actual = variant->colorDistance(left.data(), right.data(), length, actualError.data());
+            REQUIRE(expected == actual);
+            REQUIRE(expectedError == actualError);
+        }
+    }
+
+    const uint32_t black = pixelmancy::kernels::packRgba(0, 0, 0, 255);
+    const uint32_t white = pixelmancy::kernels::packRgba(255, 255, 255, 255);
+    uint8_t error = 0;
+    REQUIRE(scalar().colorDistance(&black, &white, 1, &error) == 3 * 255 * 255);
+    REQUIRE(error == 255);
+}
+
+TEST_CASE("[kernels] Kernel variants convert channels like the scalar kernel", "[kernels]")
+{
+    std::mt19937 random(6);
+    std::uniform_real_distribution<float> distribution(-40.0f, 300.0f);
+    for (const KernelTable* variant : simdVariants())
+    {
+        for (std::size_t length : LENGTHS)
+        {
+            const auto colors = randomColors(random, length);
+            std::vector<float> expected(length * 4);
+            std::vector<float> actual(length * 4);
+            scalar().rgbaToChannels(colors.data(), length, expected.data());
+            variant->rgbaToChannels(colors.data(), length, actual.data());
+            REQUIRE(expected == actual);
+
+            // out of range values and halves that round to even
+            std::vector<float> channels(length * 4);
+            for (std::size_t i = 0; i < channels.size(); i++)
+            {
+                channels[i] = i % 3 == 0 ? std::floor(distribution(random)) + 0.5f : distribution(random);
+            }
+            std::vector<uint32_t> expectedColors(length);
+            std::vector<uint32_t> actualColors(length);
+            scalar().channelsToRgba(channels.data(), length, 0.75f, expectedColors.data());
+            variant->channelsToRgba(channels.data(), length, 0.75f, actualColors.data());
+            REQUIRE(expectedColors == actualColors);
+        }
+    }
+
+    float channels[8] = {0.5f, 1.5f, 2.5f, -3.0f, 255.4f, 254.6f, 999.0f, 127.0f};
+    uint32_t colors[2];
+    scalar().channelsToRgba(channels, 2, 1.0f, colors);
+    REQUIRE(colors[0] == pixelmancy::kernels::packRgba(0, 2, 2, 0));
+    REQUIRE(colors[1] == pixelmancy::kernels::packRgba(255, 255, 255, 127));
+}
+
+TEST_CASE("[kernels] Kernel variants accumulate channels like the scalar kernel", "[kernels]")
+{
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> distribution(-255.0f, 255.0f);
+    auto randomChannels = [&random, &distribution](std::size_t count) {
+        std::vector<float> channels(count);
+        for (auto& channel : channels)
+        {
+            channel = distribution(random);
+        }
+        return channels;
+    };
+    for (const KernelTable* variant : simdVariants())
+    {
+        for (std::size_t length : LENGTHS)
+        {
+            const auto sums = randomChannels(length);
+            const auto first = randomChannels(length);
+            const auto second = randomChannels(length);
+
+            std::vector<float> expected = sums;
+            std::vector<float> actual = sums;
+            scalar().accumulateChannels(expected.data(), first.data(), 0.3f, length);
+            variant->accumulateChannels(actual.data(), first.data(), 0.3f, length);
+            REQUIRE(expected == actual);
+
+            scalar().slideChannels(expected.data(), first.data(), second.data(), length);
+            variant->slideChannels(actual.data(), first.data(), second.data(), length);
+            REQUIRE(expected == actual);
+
+            scalar().channelMagnitude(first.data(), second.data(), length, expected.data());
+            variant->channelMagnitude(first.data(), second.data(), length, actual.data());
+            REQUIRE(expected == actual);
+        }
+    }
+}
+
+TEST_CASE("[kernels] Kernel variants find dither cells like the scalar kernel", "[kernels]")
+{
+    std::mt19937 random(8);
+    std::uniform_int_distribution<int32_t> distribution(-80, 80);
+    int32_t thresholds[pixelmancy::kernels::DITHER_THRESHOLDS];
+    for (auto& threshold : thresholds)
+    {
+        threshold = distribution(random);
+    }
+    for (const KernelTable* variant : simdVariants())
+    {
+        for (std::size_t length : LENGTHS)
+        {
+            const auto colors = randomColors(random, length);
+            std::vector<uint32_t> expected(length);
+            std::vector<uint32_t> actual(length);
+            scalar().ditherCells(colors.data(), length, thresholds, expected.data());
+            variant->ditherCells(colors.data(), length, thresholds, actual.data());
+            REQUIRE(expected == actual);
+        }
+    }
+
+    // channels are clamped before the low bits are dropped
+    const uint32_t colors[2] = {pixelmancy::kernels::packRgba(250, 3, 128, 7), pixelmancy::kernels::packRgba(0, 255, 64, 255)};
+    const int32_t offsets[pixelmancy::kernels::DITHER_THRESHOLDS] = {10, -10};
+    uint32_t cells[2];
+    scalar().ditherCells(colors, 2, offsets, cells);
+    REQUIRE(cells[0] == (63u << 12 | 3u << 6 | 34u));
+    REQUIRE(cells[1] == (0u << 12 | 61u << 6 | 13u));
+}
@@ -29,4 +29,67 @@ TEST_CASE("Test a simple line circle", "[lines]")
     pixelmancy::Image img(100, 100);
     circle.drawOn(img);
     img.save(TEST_DATA_OUTPUT_IMAGE_FOLDER + "/simple_circle.png");
-}
\ No newline at end of file
+}
+
+TEST_CASE("Test a circle crossing the image border", "[lines]")
+{
+    const pixelmancy::graphics::Point center = {5, 95};
+    pixelmancy::Image img(100, 100, pixelmancy::WHITE);
+    const std::size_t pixelCount = img.size();
+
+    auto circle = pixelmancy::graphics::Circle({5, 95}, 20, pixelmancy::MAGENTA);
+    circle.drawOn(img);
+
+    REQUIRE(img.size() == pixelCount);
+    REQUIRE(img.getWidth() == 100);
+    REQUIRE(img.getHeight() == 100);
+
+    // the clipped circle matches the visible part of the same circle on a larger canvas
+    pixelmancy::Image largeImg(200, 200, pixelmancy::WHITE);
+    auto shifted = pixelmancy::graphics::Circle({center.x + 50, center.y + 50}, 20, pixelmancy::MAGENTA);
+    shifted.drawOn(largeImg);
+    for (int row = 0; row < 100; row++)
+    {
+        for (int column = 0; column < 100; column++)
+        {
+            REQUIRE((img(row, column) == largeImg(row + 50, column + 50)));
+        }
+    }
+    img.save(TEST_DATA_OUTPUT_IMAGE_FOLDER + "/clipped_circle.png");
+}
+
+TEST_CASE("Test a circle outside of the image", "[lines]")
+{
+    pixelmancy::Image img(50, 50, pixelmancy::WHITE);
+    auto circle = pixelmancy::graphics::Circle({-100, -100}, 30, pixelmancy::MAGENTA);
+    circle.drawOn(img);
+
+    REQUIRE(img.size() == 50 * 50);
+    for (int row = 0; row < 50; row++)
+    {
+        for (int column = 0; column < 50; column++)
+        {
+            REQUIRE(img(row, column) == pixelmancy::WHITE);
+        }
+    }
+}
+
+TEST_CASE("Test a thick circle", "[lines]")
+{
+    auto circle = pixelmancy::graphics::Circle({50, 50}, 20, pixelmancy::MAGENTA, 5);
+    pixelmancy::Image img(100, 100, pixelmancy::WHITE);
+    circle.drawOn(img);
+
+    REQUIRE(img(50, 50) == pixelmancy::WHITE);
+    REQUIRE(img(50, 30) == pixelmancy::MAGENTA);
+    REQUIRE(img(50, 34) == pixelmancy::MAGENTA);
+    REQUIRE(img(50, 35) == pixelmancy::WHITE);
+    REQUIRE(img(70, 50) == pixelmancy::MAGENTA);
+    REQUIRE(img(71, 50) == pixelmancy::WHITE);
+
+    // a ring crossing the corner is clipped without touching the rest of the image
+    pixelmancy::Image small(30, 30, pixelmancy::WHITE);
+    circle.drawOn(small);
+    REQUIRE(small.size() == 30 * 30);
+    img.save(TEST_DATA_OUTPUT_IMAGE_FOLDER + "/thick_circle.png");
+}
@@ -0,0 +1,116 @@
+#include <Log.hpp>
+#include <catch2/catch_test_macros.hpp>
+#include <logger/async_logger.hpp>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::size_t countRecords(const std::string& text)
+{
+    std::size_t records = 0;
+    for (auto position = text.find("record "); position != std::string::npos; position = text.find("record ", position + 1))
+    {
+        records++;
+    }
+    return records;
+}
+
+} // namespace
+
+TEST_CASE("Async logger writes records in order", "[logger]")
+{
+    std::ostringstream stream;
+    {
+        pixelmancy::logger::async_logger logger(stream, pixelmancy::logger::LogLevel::DEBUG);
+        logger << pixelmancy::logger::LogLevel::INFO << pixelmancy::logger::file_t("file.cpp", 12) << "first " << 1 << "\n";
+        logger << pixelmancy::logger::LogLevel::TRACE << "filtered\n";
+        logger << pixelmancy::logger::LogLevel::WARN << "second " << 2.5 << pixelmancy::logger::endl;
+        logger.flush();
+
+        const std::string output = stream.str();
+        REQUIRE(output.find("file.cpp") != std::string::npos);
+        REQUIRE(output.find("first 1\n") != std::string::npos);
+        REQUIRE(output.find("second 2.5\n") != std::string::npos);
+        REQUIRE(output.find("filtered") == std::string::npos);
+        REQUIRE(output.find("first") < output.find("second"));
+
+        // an unfinished record is written when the logger is destroyed
+        logger << pixelmancy::logger::LogLevel::ERROR_LOG << "last";
+    }
+    REQUIRE(stream.str().find("last") != std::string::npos);
+}
+
+TEST_CASE("Async logger collects records from many threads", "[logger]")
+{
+    std::ostringstream stream;
+    const int threads = 4;
+    const int recordsPerThread = 500;
+    {
+        pixelmancy::logger::async_logger logger(stream, pixelmancy::logger::LogLevel::DEBUG, pixelmancy::logger::OverflowPolicy::BLOCK, 16);
+        std::vector<std::thread> producers;
+        for (int i = 0; i < threads; i++)
+        {
+            producers.emplace_back([&logger, i]() {
+                for (int j = 0; j < recordsPerThread; j++)
+                {
+                    logger << pixelmancy::logger::LogLevel::INFO << "thread " << i << " record " << j << "\n";
+                }
+            });
+        }
+        for (auto& producer : producers)
+        {
+            producer.join();
+        }
+        logger.flush();
+        REQUIRE(logger.droppedRecords() == 0);
+    }
+    REQUIRE(countRecords(stream.str()) == static_cast<std::size_t>(threads * recordsPerThread));
+}
+
+TEST_CASE("Async logger drops records when the ring is full", "[logger]")
+{
+    std::ostringstream stream;
+    pixelmancy::logger::async_logger logger(stream, pixelmancy::logger::LogLevel::DEBUG, pixelmancy::logger::OverflowPolicy::DROP, 2);
+    for (int j = 0; j < 10000; j++)
+    {
+        logger << pixelmancy::logger::LogLevel::INFO << "record " << j << "\n";
+    }
+    logger.flush();
+    REQUIRE(countRecords(stream.str()) + logger.droppedRecords() == 10000);
+}
+
+TEST_CASE("Log statement location is the file name", "[logger]")
+{
+    static_assert(pixelmancy::logger::fileNameOffset("/some/dir/file.cpp") == 10);
+    static_assert(pixelmancy::logger::fileNameOffset("C:\\dir\\file.cpp") == 7);
+    static_assert(pixelmancy::logger::fileNameOffset("file.cpp") == 0);
+
+    constexpr pixelmancy::logger::file_t location = P_LOG_LOCATION();
+    REQUIRE(std::string(location.fileName) == "test_logger.cpp");
+    REQUIRE(location.lineNumber == __LINE__ - 2);
+}
+
+TEST_CASE("Filtered log statements do not evaluate their arguments", "[logger]")
+{
+    const pixelmancy::logger::LogLevel previousFilter = pixelmancy::logger::Log::GetLogger()->filter();
+    pixelmancy::logger::Log::SetFilter(pixelmancy::logger::LogLevel::WARN);
+
+    int evaluations = 0;
+    auto argument = [&evaluations]() {
+        evaluations++;
+        return evaluations;
+    };
+    P_LOG_INFO() << argument() << "\n";
+    P_LOGF_DEBUG("{}\n", argument());
+    REQUIRE(evaluations == 0);
+    REQUIRE_FALSE(pixelmancy::logger::Log::IsEnabled(pixelmancy::logger::LogLevel::INFO));
+
+    P_LOG_WARN() << argument() << "\n";
+    P_LOGF_ERROR("{}\n", argument());
+    REQUIRE(evaluations == 2);
+
+    pixelmancy::logger::Log::SetFilter(previousFilter);
+}
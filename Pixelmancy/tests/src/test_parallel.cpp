@@ -0,0 +1,158 @@
+#include <catch2/catch_test_macros.hpp>
+#include <Parallel.hpp>
+#include <ThreadPool.hpp>
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+TEST_CASE("[parallel] parallelFor covers every cell once", "[parallel]")
+{
+    const pixelmancy::graphics::Rect range(3, 5, 70, 41);
+    for (std::size_t threads : {1, 2, 4})
+    {
+        pixelmancy::ThreadPool pool(threads);
+        for (pixelmancy::Grain grain : {pixelmancy::Grain{1, 0}, pixelmancy::Grain{7, 0}, pixelmancy::Grain{8, 9}, pixelmancy::Grain{100, 100}})
+        {
+            std::vector<std::atomic<int>> visits(static_cast<std::size_t>(70 * 41));
+            pixelmancy::parallelFor(
+                range, grain,
+                [&visits](const pixelmancy::graphics::Rect& tile) {
+                    for (int row = tile.minX; row < tile.maxX; row++)
+                    {
+                        for (int column = tile.minY; column < tile.maxY; column++)
+                        {
+                            visits[static_cast<std::size_t>(row * 41 + column)]++;
+                        }
+                    }
+                },
+                pool);
+            for (int row = 0; row < 70; row++)
+            {
+                for (int column = 0; column < 41; column++)
+                {
+                    const bool inside = row >= range.minX && column >= range.minY;
+                    REQUIRE(visits[static_cast<std::size_t>(row * 41 + column)] == (inside ? 1 : 0));
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("[parallel] parallelFor on one thread runs tiles in order on the caller", "[parallel]")
+{
+    pixelmancy::ThreadPool pool(1);
+    REQUIRE(pool.size() == 1);
+    const auto caller = std::this_thread::get_id();
+    std::vector<pixelmancy::graphics::Rect> tiles;
+    pixelmancy::parallelFor(
+        pixelmancy::graphics::Rect(0, 0, 4, 6), pixelmancy::Grain{2, 4},
+        [&](const pixelmancy::graphics::Rect& tile) {
+            REQUIRE(std::this_thread::get_id() == caller);
+            tiles.push_back(tile);
+        },
+        pool);
+    REQUIRE(tiles == std::vector<pixelmancy::graphics::Rect>{{0, 0, 2, 4}, {0, 4, 2, 6}, {2, 0, 4, 4}, {2, 4, 4, 6}});
+}
+
+TEST_CASE("[parallel] parallelFor passes on exceptions", "[parallel]")
+{
+    pixelmancy::ThreadPool pool(4);
+    REQUIRE_THROWS_AS(pixelmancy::parallelFor(
+                          pixelmancy::graphics::Rect(0, 0, 64, 1), pixelmancy::Grain{1, 0},
+                          [](const pixelmancy::graphics::Rect& tile) {
+                              if (tile.minX == 33)
+                              {
+                                  throw std::runtime_error("tile failed");
+                              }
+                          },
+                          pool),
+                      std::runtime_error);
+}
+
+TEST_CASE("[parallel] Task groups return results through futures", "[parallel]")
+{
+    pixelmancy::ThreadPool pool(4);
+    pixelmancy::TaskGroup group(pool);
+    std::vector<std::future<int>> results;
+    for (int i = 0; i < 100; i++)
+    {
+        results.push_back(group.run([i]() { return i * i; }));
+    }
+    auto failed = group.run([]() { throw std::logic_error("task failed"); });
+    REQUIRE_THROWS_AS(group.wait(), std::logic_error);
+    REQUIRE_THROWS_AS(failed.get(), std::logic_error);
+    for (int i = 0; i < 100; i++)
+    {
+        REQUIRE(results[static_cast<std::size_t>(i)].get() == i * i);
+    }
+    // the error is reported once
+    group.wait();
+}
+
+namespace {
+
+// a task that cannot be moved into the queue
+struct UnqueueableTask
+{
+    UnqueueableTask() = default;
+    UnqueueableTask(const UnqueueableTask&)
+    {
+        throw std::runtime_error("task cannot be copied");
+    }
+    void operator()() const
+    {
+    }
+};
+
+} // namespace
+
+TEST_CASE("[parallel] Task groups do not wait for tasks that failed to queue", "[parallel]")
+{
+    pixelmancy::ThreadPool pool(4);
+    pixelmancy::TaskGroup group(pool);
+    std::atomic<int> finished{0};
+    group.run([&finished]() { finished++; });
+    const UnqueueableTask task;
+    REQUIRE_THROWS_AS(group.run(task), std::runtime_error);
+    group.run([&finished]() { finished++; });
+    group.wait();
+    REQUIRE(finished == 2);
+}
+
+TEST_CASE("[parallel] Nested parallel loops finish on a small pool", "[parallel]")
+{
+    pixelmancy::ThreadPool pool(2);
+    std::atomic<int> cells{0};
+    pixelmancy::parallelFor(
+        pixelmancy::graphics::Rect(0, 0, 8, 1), pixelmancy::Grain{1, 0},
+        [&](const pixelmancy::graphics::Rect&) {
+            pixelmancy::parallelFor(
+                pixelmancy::graphics::Rect(0, 0, 16, 16), pixelmancy::Grain{4, 4},
+                [&](const pixelmancy::graphics::Rect& tile) { cells += tile.area(); }, pool);
+        },
+        pool);
+    REQUIRE(cells == 8 * 16 * 16);
+}
+
+TEST_CASE("[parallel] Pool of one thread runs submitted tasks immediately", "[parallel]")
+{
+    pixelmancy::ThreadPool pool(1);
+    std::vector<int> order;
+    for (int i = 0; i < 5; i++)
+    {
+        pool.submit([&order, i]() { order.push_back(i); });
+    }
+    REQUIRE(order == std::vector<int>{0, 1, 2, 3, 4});
+}
+
+TEST_CASE("[parallel] Global pool follows the configured thread count", "[parallel]")
+{
+    pixelmancy::ThreadPool::setGlobalThreadCount(3);
+    REQUIRE(pixelmancy::ThreadPool::global().size() == 3);
+    REQUIRE(pixelmancy::ThreadPool::global().submit([]() { return 7; }).get() == 7);
+    pixelmancy::ThreadPool::setGlobalThreadCount(0);
+    REQUIRE(pixelmancy::ThreadPool::global().size() == std::max(1u, std::thread::hardware_concurrency()));
+}
@@ -0,0 +1,109 @@
+#include <catch2/catch_test_macros.hpp>
+#include <profiler/Json.hpp>
+#include <profiler/Profiler.hpp>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#if PIXELMANCY_PROFILING
+
+namespace {
+
+const pixelmancy::profiler::SummaryRow* findRow(const std::vector<pixelmancy::profiler::SummaryRow>& rows, const std::string& name)
+{
+    for (const auto& row : rows)
+    {
+        if (row.name == name)
+        {
+            return &row;
+        }
+    }
+    return nullptr;
+}
+
+void innerScope()
+{
+    P_PROFILE_SCOPE("test::inner");
+    P_PROFILE_COUNTER("test.items", 3);
+}
+
+} // namespace
+
+TEST_CASE("[profiler] Profiler nests scoped timers", "[profiler]")
+{
+    pixelmancy::profiler::Profiler::Start();
+    {
+        P_PROFILE_SCOPE("test::outer");
+        innerScope();
+        innerScope();
+    }
+    pixelmancy::profiler::Profiler::Stop();
+
+    const auto rows = pixelmancy::profiler::Profiler::Summary();
+    const auto* outer = findRow(rows, "test::outer");
+    const auto* inner = findRow(rows, "test::inner");
+    REQUIRE(outer != nullptr);
+    REQUIRE(inner != nullptr);
+    REQUIRE(outer->calls == 1);
+    REQUIRE(outer->depth == 0);
+    REQUIRE(inner->calls == 2);
+    REQUIRE(inner->depth == 1);
+    // children are listed after their parent
+    REQUIRE(outer < inner);
+    REQUIRE(outer->totalNs >= inner->totalNs);
+    REQUIRE(outer->selfNs == outer->totalNs - inner->totalNs);
+
+    REQUIRE(pixelmancy::profiler::Profiler::CounterValues().at("test.items") == 6);
+}
+
+TEST_CASE("[profiler] Profiler records nothing when it is stopped", "[profiler]")
+{
+    pixelmancy::profiler::Profiler::Reset();
+    int evaluations = 0;
+    {
+        P_PROFILE_SCOPE("test::stopped");
+        P_PROFILE_COUNTER("test.stopped", ++evaluations);
+    }
+    REQUIRE(evaluations == 0);
+    REQUIRE(pixelmancy::profiler::Profiler::Summary().empty());
+    REQUIRE(pixelmancy::profiler::Profiler::CounterValues().empty());
+}
+
+TEST_CASE("[profiler] Profiler writes events of every thread to the Chrome trace", "[profiler]")
+{
+    pixelmancy::profiler::Profiler::Start();
+    {
+        P_PROFILE_SCOPE("test::main");
+        std::thread worker([]() { innerScope(); });
+        worker.join();
+    }
+    pixelmancy::profiler::Profiler::Stop();
+
+    const auto rows = pixelmancy::profiler::Profiler::Summary();
+    // the worker has its own stack of timers, so its scope is a root
+    REQUIRE(findRow(rows, "test::inner")->depth == 0);
+
+    std::ostringstream trace;
+    pixelmancy::profiler::Profiler::WriteChromeTrace(trace);
+    const std::string json = trace.str();
+    REQUIRE(json.find("\"traceEvents\"") != std::string::npos);
+    REQUIRE(json.find("\"name\":\"test::main\"") != std::string::npos);
+    REQUIRE(json.find("\"name\":\"test::inner\"") != std::string::npos);
+    REQUIRE(json.find("\"name\":\"test.items\",\"ph\":\"C\"") != std::string::npos);
+
+    std::ostringstream summary;
+    pixelmancy::profiler::Profiler::WriteSummary(summary);
+    REQUIRE(summary.str().find("test::main") != std::string::npos);
+    REQUIRE(summary.str().find("test.items") != std::string::npos);
+    pixelmancy::profiler::Profiler::Reset();
+}
+
+#endif
+
+TEST_CASE("[profiler] JSON strings escape quotes and control characters", "[profiler]")
+{
+    REQUIRE(pixelmancy::profiler::escapeJson("plain") == "plain");
+    REQUIRE(pixelmancy::profiler::escapeJson("say \"hi\" \\ bye") == "say \\\"hi\\\" \\\\ bye");
+    REQUIRE(pixelmancy::profiler::escapeJson("two\nlines\tand a tab") == "two\\nlines\\tand a tab");
+    REQUIRE(pixelmancy::profiler::escapeJson(std::string("bell\a\x1f", 6)) == "bell\\u0007\\u001f");
+}
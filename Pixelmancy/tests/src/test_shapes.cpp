@@ -1,3 +1,4 @@
+#include <Circle.hpp>
 #include <CircleObject.hpp>
 #include <Image.hpp>
 #include <Line.hpp>
@@ -31,6 +32,15 @@ TEST_CASE("50x50 circle", "[shapes]")
         circle.drawOn(img);
         img.save(TEST_DATA_OUTPUT_IMAGE_FOLDER + "/circle_in_the_middle.png");
     }
+
+    SECTION("Circle outside the image")
+    {
+        pixelmancy::Image img(50, 50);
+        pixelmancy::graphics::Circle({-20, 60}, 10, pixelmancy::RED, 3).drawOn(img);
+        pixelmancy::graphics::Circle({25, 25}, 5, pixelmancy::BLUE).drawOn(img);
+        // only the visible circle adds its color
+        REQUIRE(img.getColorPalette().size() == 2);
+    }
 }
 
 TEST_CASE("50x100 square", "[shapes]")